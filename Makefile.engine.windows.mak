@@ -6,7 +6,7 @@ ASSEMBLY := engine
 EXTENSION := .dll
 COMPILER_FLAGS := -g -MD -Wall -Werror -Wvla -Wgnu-folding-constant -Wno-missing-braces -fdeclspec #-fPIC
 INCLUDE_FLAGS := -Iengine\src -I$(VULKAN_SDK)\include
-LINKER_FLAGS := -g -shared -luser32 -lwinmm -lgdi32 -lvulkan-1 -L$(VULKAN_SDK)\Lib -L$(OBJ_DIR)\engine
+LINKER_FLAGS := -g -shared -luser32 -lwinmm -lgdi32 -ladvapi32 -lvulkan-1 -L$(VULKAN_SDK)\Lib -L$(OBJ_DIR)\engine
 DEFINES := -D_DEBUG -D_EXPORT
 
 # Make does not offer a recursive wildcard function, so here's one:
@@ -5,8 +5,8 @@ OBJ_DIR := obj
 ASSEMBLY := tests
 EXTENSION := 
 COMPILER_FLAGS := -g -MD -Werror=vla -fdeclspec -fPIC
-INCLUDE_FLAGS := -Iengine/src -I$(VULKAN_SDK)\include
-LINKER_FLAGS := -L./$(BUILD_DIR)/ -lengine -Wl,-rpath,.
+INCLUDE_FLAGS := -Iengine/src -I$(VULKAN_SDK)/include
+LINKER_FLAGS := -L./$(BUILD_DIR)/ -lengine -lvulkan -L$(VULKAN_SDK)/lib -Wl,-rpath,.
 DEFINES := -D_DEBUG -D_IMPORT
 
 # Make does not offer a recursive wildcard function, so here's one:
@@ -5,8 +5,8 @@ OBJ_DIR := obj
 ASSEMBLY := tests
 EXTENSION := .exe
 COMPILER_FLAGS := -g -MD -Werror=vla -Wno-missing-braces -fdeclspec #-fPIC
-INCLUDE_FLAGS := -Iengine\src -Itests\src 
-LINKER_FLAGS := -g -lengine.lib -L$(OBJ_DIR)\engine -L$(BUILD_DIR) #-Wl,-rpath,.
+INCLUDE_FLAGS := -Iengine\src -Itests\src -I$(VULKAN_SDK)\include
+LINKER_FLAGS := -g -lengine.lib -lvulkan-1 -L$(VULKAN_SDK)\Lib -L$(OBJ_DIR)\engine -L$(BUILD_DIR) #-Wl,-rpath,.
 DEFINES := -D_DEBUG -D_IMPORT
 
 # Make does not offer a recursive wildcard function, so here's one:
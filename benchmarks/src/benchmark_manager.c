@@ -0,0 +1,48 @@
+#include "benchmark_manager.h"
+
+#include <containers/darray.h>
+#include <core/logger.h>
+#include <time/clock.h>
+
+
+typedef struct benchmark_entry {
+    PFN_benchmark func;
+    char* desc;
+} benchmark_entry;
+
+static benchmark_entry* benchmarks;
+
+void benchmark_manager_init(void) {
+    benchmarks = darray_reserve(benchmark_entry, 16);
+}
+
+void benchmark_manager_register_benchmark(PFN_benchmark benchmark, char* desc) {
+    benchmark_entry e;
+    e.func = benchmark;
+    e.desc = desc;
+    darray_push(benchmarks, e);
+}
+
+void benchmark_manager_run_benchmarks(void) {
+    u64 count = darray_length(benchmarks);
+
+    clock total_time;
+    clock_start(&total_time);
+
+    for (u64 i = 0; i < count; ++i) {
+        MINFO("[%llu/%llu] %s", i + 1, count, benchmarks[i].desc);
+
+        clock benchmark_time;
+        clock_start(&benchmark_time);
+
+        benchmarks[i].func();
+
+        clock_update(&benchmark_time);
+        MINFO("Finished in %.6f sec", benchmark_time.elapsed);
+    }
+
+    clock_update(&total_time);
+    MINFO("Ran %llu benchmarks in %.6f sec", count, total_time.elapsed);
+
+    darray_destroy(benchmarks);
+}
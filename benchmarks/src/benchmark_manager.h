@@ -0,0 +1,11 @@
+#pragma once
+
+#include <defines.h>
+
+typedef void (*PFN_benchmark)(void);
+
+void benchmark_manager_init(void);
+
+void benchmark_manager_register_benchmark(PFN_benchmark benchmark, char* desc);
+
+void benchmark_manager_run_benchmarks(void);
@@ -0,0 +1,164 @@
+#include "concurrent_hashtable_benchmarks.h"
+#include "../benchmark_manager.h"
+
+#include <containers/concurrent_hashtable.h>
+#include <containers/u64_hashtable.h>
+#include <core/logger.h>
+#include <platform/platform.h>
+#include <threads/atomic.h>
+#include <threads/mutex.h>
+#include <threads/thread.h>
+
+#define CONCURRENT_BENCH_KEYS (1u << 16)
+#define CONCURRENT_BENCH_OPS_PER_THREAD 1000000
+#define CONCURRENT_BENCH_MAX_THREADS 64
+
+typedef enum concurrent_bench_mode {
+    // One mutex around a single u64_hashtable
+    CONCURRENT_BENCH_MODE_SINGLE_LOCK,
+    CONCURRENT_BENCH_MODE_SHARDED
+} concurrent_bench_mode;
+
+typedef struct concurrent_bench_shared {
+    concurrent_hashtable sharded;
+    u64_hashtable single;
+    mutex single_lock;
+    concurrent_bench_mode mode;
+    // Share of the operations that are sets, the rest are gets
+    u32 write_percent;
+    volatile u32 start;
+} concurrent_bench_shared;
+
+typedef struct concurrent_bench_worker {
+    concurrent_bench_shared* shared;
+    u32 seed;
+    // Keeps the reads from being optimized away
+    u64 checksum;
+} concurrent_bench_worker;
+
+static u32 xorshift32(u32* state) {
+    u32 x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static u32 concurrent_bench_thread(void* args) {
+    concurrent_bench_worker* worker = args;
+    concurrent_bench_shared* shared = worker->shared;
+    u32 seed = worker->seed;
+
+    while (!atomic_u32_load(&shared->start)) {
+        atomic_spin_pause();
+    }
+
+    u64 checksum = 0;
+    for (u32 i = 0; i < CONCURRENT_BENCH_OPS_PER_THREAD; ++i) {
+        u32 roll = xorshift32(&seed);
+        u64 key = roll % CONCURRENT_BENCH_KEYS;
+        b8 write = (roll >> 16) % 100 < shared->write_percent;
+        u64 value = i;
+        if (shared->mode == CONCURRENT_BENCH_MODE_SHARDED) {
+            if (write) {
+                concurrent_hashtable_set(&shared->sharded, key, &value);
+            } else if (concurrent_hashtable_get(&shared->sharded, key, &value)) {
+                checksum += value;
+            }
+        } else {
+            mutex_lock(&shared->single_lock);
+            if (write) {
+                u64_hashtable_set(&shared->single, key, &value);
+            } else {
+                u64* stored = u64_hashtable_get(&shared->single, key);
+                if (stored) {
+                    checksum += *stored;
+                }
+            }
+            mutex_unlock(&shared->single_lock);
+        }
+    }
+    worker->checksum = checksum;
+    return 0;
+}
+
+// Runs the operation mix on thread_count threads at once and returns the combined operations per second
+static f64 run_concurrent_bench(concurrent_bench_shared* shared, concurrent_bench_mode mode, u32 write_percent, u32 thread_count) {
+    thread threads[CONCURRENT_BENCH_MAX_THREADS];
+    concurrent_bench_worker workers[CONCURRENT_BENCH_MAX_THREADS];
+
+    shared->mode = mode;
+    shared->write_percent = write_percent;
+    atomic_u32_store(&shared->start, 0);
+    for (u32 i = 0; i < thread_count; ++i) {
+        workers[i].shared = shared;
+        workers[i].seed = 0x9E3779B9u * (i + 1);
+        workers[i].checksum = 0;
+        if (!thread_create(concurrent_bench_thread, &workers[i], false, &threads[i])) {
+            MERROR("Failed to create benchmark thread %u.", i);
+            thread_count = i;
+            break;
+        }
+    }
+
+    f64 start_time = platform_get_absolute_time();
+    atomic_u32_store(&shared->start, 1);
+    for (u32 i = 0; i < thread_count; ++i) {
+        thread_wait(&threads[i]);
+        thread_destroy(&threads[i]);
+    }
+    f64 elapsed = platform_get_absolute_time() - start_time;
+    return (f64)thread_count * CONCURRENT_BENCH_OPS_PER_THREAD / elapsed;
+}
+
+// Doubles the thread count, always finishing on exactly max_count
+static u32 next_thread_count(u32 current, u32 max_count) {
+    if (current < max_count && current * 2 > max_count) {
+        return max_count;
+    }
+    return current * 2;
+}
+
+static void concurrent_hashtable_benchmark_scaling(void) {
+    u32 processor_count = MMIN(platform_get_processor_count(), CONCURRENT_BENCH_MAX_THREADS);
+
+    concurrent_bench_shared shared = {0};
+    concurrent_hashtable_create(sizeof(u64), CONCURRENT_BENCH_KEYS, 0, &shared.sharded);
+    u64_hashtable_create(sizeof(u64), CONCURRENT_BENCH_KEYS, &shared.single);
+    mutex_create(&shared.single_lock);
+    // Every key is present, so gets always hit and sets only overwrite
+    for (u64 key = 0; key < CONCURRENT_BENCH_KEYS; ++key) {
+        concurrent_hashtable_set(&shared.sharded, key, &key);
+        u64_hashtable_set(&shared.single, key, &key);
+    }
+
+    static const u32 write_percents[] = {10, 50};
+    MINFO("%u logical processors, %u keys, %u operations per thread, %u shards", processor_count, CONCURRENT_BENCH_KEYS,
+          CONCURRENT_BENCH_OPS_PER_THREAD, shared.sharded.shard_count);
+    for (u32 w = 0; w < sizeof(write_percents) / sizeof(write_percents[0]); ++w) {
+        MINFO("%u%% sets, %u%% gets", write_percents[w], 100 - write_percents[w]);
+        MINFO("threads | single lock (Mops/s, scaling) | sharded (Mops/s, scaling)");
+        f64 base[2] = {0};
+        for (u32 thread_count = 1; thread_count <= processor_count; thread_count = next_thread_count(thread_count, processor_count)) {
+            f64 results[2];
+            for (u32 mode = CONCURRENT_BENCH_MODE_SINGLE_LOCK; mode <= CONCURRENT_BENCH_MODE_SHARDED; ++mode) {
+                results[mode] = run_concurrent_bench(&shared, mode, write_percents[w], thread_count);
+                if (thread_count == 1) {
+                    base[mode] = results[mode];
+                }
+            }
+            MINFO("%7u | %19.2f %5.2fx | %15.2f %5.2fx", thread_count,
+                  results[0] / 1000000.0, results[0] / base[0],
+                  results[1] / 1000000.0, results[1] / base[1]);
+        }
+    }
+
+    mutex_destroy(&shared.single_lock);
+    u64_hashtable_destroy(&shared.single);
+    concurrent_hashtable_destroy(&shared.sharded);
+}
+
+void concurrent_hashtable_register_benchmarks(void) {
+    benchmark_manager_register_benchmark(concurrent_hashtable_benchmark_scaling, "Concurrent hashtable scaling across threads: single lock and sharded");
+}
@@ -0,0 +1,93 @@
+#include "darray_benchmarks.h"
+#include "../benchmark_manager.h"
+
+#include <containers/darray.h>
+#include <core/logger.h>
+#include <platform/platform.h>
+
+#define DARRAY_BENCH_BATCH 256
+#define DARRAY_BENCH_FRAMES 64
+
+static f64 ns_per_op(f64 elapsed, u64 count) {
+    return elapsed * 1000000000.0 / count;
+}
+
+static b8 is_culled(const void* element, void* context) {
+    return (*(const u64*)element & 3) == 0;
+}
+
+// Per-frame draw list pattern: the list is cleared, rebuilt from batches, then a quarter of it is culled
+static void benchmark_count(u32 count) {
+    u64 batch[DARRAY_BENCH_BATCH];
+    for (u32 i = 0; i < DARRAY_BENCH_BATCH; ++i) {
+        batch[i] = i;
+    }
+
+    u64 checksum = 0;
+    u64* list = darray_create(u64);
+
+    f64 start = platform_get_absolute_time();
+    for (u32 frame = 0; frame < DARRAY_BENCH_FRAMES; ++frame) {
+        darray_clear(list);
+        for (u32 i = 0; i < count; ++i) {
+            darray_push(list, batch[i % DARRAY_BENCH_BATCH]);
+        }
+    }
+    f64 push_time = platform_get_absolute_time() - start;
+
+    start = platform_get_absolute_time();
+    for (u32 frame = 0; frame < DARRAY_BENCH_FRAMES; ++frame) {
+        darray_clear(list);
+        for (u32 i = 0; i < count; i += DARRAY_BENCH_BATCH) {
+            darray_append_range(list, batch, DARRAY_BENCH_BATCH);
+        }
+    }
+    f64 append_time = platform_get_absolute_time() - start;
+
+    // Culling one element at a time shifts the tail on every removal, so only a single frame is timed
+    start = platform_get_absolute_time();
+    for (u64 i = darray_length(list); i > 0; --i) {
+        if (is_culled(&list[i - 1], nullptr)) {
+            darray_pop_at(list, i - 1, nullptr);
+        }
+    }
+    f64 pop_at_time = platform_get_absolute_time() - start;
+    checksum += darray_length(list);
+
+    f64 remove_if_time = 0;
+    for (u32 frame = 0; frame < DARRAY_BENCH_FRAMES; ++frame) {
+        darray_clear(list);
+        for (u32 i = 0; i < count; i += DARRAY_BENCH_BATCH) {
+            darray_append_range(list, batch, DARRAY_BENCH_BATCH);
+        }
+        start = platform_get_absolute_time();
+        checksum += darray_remove_if(list, is_culled, nullptr);
+        remove_if_time += platform_get_absolute_time() - start;
+    }
+
+    // Unordered entity lists drop elements from the front, where pop_at moves the most
+    start = platform_get_absolute_time();
+    for (u32 i = 0; i < count / 4; ++i) {
+        darray_swap_remove(list, 0, nullptr);
+    }
+    f64 swap_remove_time = platform_get_absolute_time() - start;
+    checksum += list[0];
+
+    darray_destroy(list);
+
+    MINFO("%8u | %6.2f | %6.2f | %9.2f | %9.2f | %6.2f | (checksum %llu)", count, ns_per_op(push_time, (u64)count * DARRAY_BENCH_FRAMES),
+          ns_per_op(append_time, (u64)count * DARRAY_BENCH_FRAMES), ns_per_op(pop_at_time, count),
+          ns_per_op(remove_if_time, (u64)count * DARRAY_BENCH_FRAMES), ns_per_op(swap_remove_time, count / 4), checksum);
+}
+
+static void darray_benchmark_bulk(void) {
+    MINFO("ns per element of u64 darrays over %u frames. append copies batches of %u", DARRAY_BENCH_FRAMES, DARRAY_BENCH_BATCH);
+    MINFO("count    | push   | append | pop_at    | remove_if | swap   |");
+    benchmark_count(1024);
+    benchmark_count(16384);
+    benchmark_count(65536);
+}
+
+void darray_register_benchmarks(void) {
+    benchmark_manager_register_benchmark(darray_benchmark_bulk, "darray bulk operations against per-element push and pop_at");
+}
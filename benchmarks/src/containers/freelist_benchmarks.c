@@ -0,0 +1,105 @@
+#include "freelist_benchmarks.h"
+#include "../benchmark_manager.h"
+
+#include <containers/freelist.h>
+#include <core/logger.h>
+#include <memory/memory.h>
+#include <platform/platform.h>
+
+#define FREELIST_BENCH_SIZE MEBIBYTES(256)
+#define FREELIST_BENCH_LIVE_BLOCKS 16384
+#define FREELIST_BENCH_OPS 200000
+
+typedef struct freelist_bench_block {
+    u64 offset;
+    u64 size;
+} freelist_bench_block;
+
+static u32 xorshift32(u32* state) {
+    u32 x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+// Mostly small blocks with some large ones mixed in, so the list splits into many small holes
+static u64 random_block_size(u32* seed) {
+    u32 roll = xorshift32(seed);
+    if (roll % 100 < 80) {
+        return 16 + (xorshift32(seed) % 240);
+    }
+    return KIBIBYTES(4) + (xorshift32(seed) % KIBIBYTES(60));
+}
+
+typedef struct freelist_bench_result {
+    f64 ops_per_second;
+    u32 failed_allocations;
+    u64 free_space;
+} freelist_bench_result;
+
+static freelist_bench_result run_freelist_bench(freelist_flags flags) {
+    freelist_bench_result result = {0};
+
+    u64 memory_requirement = 0;
+    freelist_create_with_flags(FREELIST_BENCH_SIZE, flags, &memory_requirement, nullptr, nullptr);
+    void* memory = memory_allocate(memory_requirement, MEMORY_TAG_ENGINE);
+    freelist list;
+    freelist_create_with_flags(FREELIST_BENCH_SIZE, flags, &memory_requirement, memory, &list);
+
+    freelist_bench_block* blocks = memory_allocate(sizeof(freelist_bench_block) * FREELIST_BENCH_LIVE_BLOCKS, MEMORY_TAG_ENGINE);
+    u32 seed = 0x2545F491u;
+
+    // Fill the live set, then free every other block to start out fragmented
+    for (u32 i = 0; i < FREELIST_BENCH_LIVE_BLOCKS; ++i) {
+        blocks[i].size = random_block_size(&seed);
+        if (!freelist_allocate_block(&list, blocks[i].size, &blocks[i].offset)) {
+            blocks[i].size = 0;
+        }
+    }
+    for (u32 i = 0; i < FREELIST_BENCH_LIVE_BLOCKS; i += 2) {
+        if (blocks[i].size) {
+            freelist_free_block(&list, blocks[i].size, blocks[i].offset);
+            blocks[i].size = 0;
+        }
+    }
+
+    f64 start_time = platform_get_absolute_time();
+    for (u32 i = 0; i < FREELIST_BENCH_OPS; ++i) {
+        freelist_bench_block* block = &blocks[xorshift32(&seed) % FREELIST_BENCH_LIVE_BLOCKS];
+        if (block->size) {
+            freelist_free_block(&list, block->size, block->offset);
+        }
+        block->size = random_block_size(&seed);
+        if (!freelist_allocate_block(&list, block->size, &block->offset)) {
+            block->size = 0;
+            result.failed_allocations++;
+        }
+    }
+    f64 elapsed = platform_get_absolute_time() - start_time;
+
+    result.ops_per_second = (FREELIST_BENCH_OPS * 2.0) / elapsed;
+    result.free_space = freelist_free_space(&list);
+
+    memory_free(blocks, sizeof(freelist_bench_block) * FREELIST_BENCH_LIVE_BLOCKS, MEMORY_TAG_ENGINE);
+    freelist_destroy(&list);
+    memory_free(memory, memory_requirement, MEMORY_TAG_ENGINE);
+    return result;
+}
+
+static void freelist_benchmark_fragmented_allocation(void) {
+    MINFO("%u live blocks in %llu MiB, %u random free/allocate pairs, 80%% 16-256 B, 20%% 4-64 KiB",
+        FREELIST_BENCH_LIVE_BLOCKS, FREELIST_BENCH_SIZE / MEBIBYTES(1), FREELIST_BENCH_OPS);
+    MINFO("mode      | Mops/s | failed allocations | free at end (MiB)");
+
+    freelist_bench_result first_fit = run_freelist_bench(FREELIST_FLAG_NONE_BIT);
+    MINFO("first fit | %6.2f | %18u | %.2f", first_fit.ops_per_second / 1000000.0, first_fit.failed_allocations, (f64)first_fit.free_space / MEBIBYTES(1));
+
+    freelist_bench_result best_fit = run_freelist_bench(FREELIST_FLAG_BEST_FIT_BIT);
+    MINFO("best fit  | %6.2f | %18u | %.2f", best_fit.ops_per_second / 1000000.0, best_fit.failed_allocations, (f64)best_fit.free_space / MEBIBYTES(1));
+}
+
+void freelist_register_benchmarks(void) {
+    benchmark_manager_register_benchmark(freelist_benchmark_fragmented_allocation, "Freelist allocation under heavy fragmentation");
+}
@@ -0,0 +1,272 @@
+#include "hashtable_benchmarks.h"
+#include "../benchmark_manager.h"
+
+#include <containers/hashtable.h>
+#include <containers/u64_bst.h>
+#include <containers/u64_hashtable.h>
+#include <core/logger.h>
+#include <memory/memory.h>
+#include <platform/platform.h>
+#include <strings/name.h>
+#include <strings/string.h>
+
+// The table hashtable.c had before it stored keys: the slot is the multiply-by-97 hash modulo the
+// slot count, so colliding keys overwrite each other
+typedef struct legacy_hashtable {
+    u64* values;
+    u32 element_count;
+} legacy_hashtable;
+
+static u64 legacy_hash_key(const char* key, u32 element_count) {
+    u64 hash = 0;
+    for (const unsigned char* us = (const unsigned char*)key; *us; us++) {
+        hash = hash * 97 + *us;
+    }
+    return hash % element_count;
+}
+
+static void legacy_set(legacy_hashtable* table, const char* key, u64 value) {
+    table->values[legacy_hash_key(key, table->element_count)] = value;
+}
+
+static u64 legacy_get(legacy_hashtable* table, const char* key) {
+    return table->values[legacy_hash_key(key, table->element_count)];
+}
+
+// A prefix and 8 hex digits. Multiplying by an odd constant keeps the keys unique but spreads them out
+static void make_key(char* dst, char prefix, u32 i) {
+    static const char digits[] = "0123456789abcdef";
+    u32 x = i * 0x9E3779B1u;
+    dst[0] = prefix;
+    for (u32 d = 0; d < 8; ++d) {
+        dst[1 + d] = digits[(x >> (28 - d * 4)) & 0xF];
+    }
+    dst[9] = 0;
+}
+
+static f64 ns_per_op(f64 elapsed, u32 count) {
+    return elapsed * 1000000000.0 / count;
+}
+
+static void benchmark_size(u32 count) {
+    char key[16];
+    f64 start;
+
+    // Inserts starting from the smallest table, so every growth step is paid for. Runs first, while the
+    // heap is not yet fragmented by the larger tables below
+    hashtable table;
+    hashtable_create(sizeof(u64), 1, false, &table);
+    start = platform_get_absolute_time();
+    for (u32 i = 0; i < count; ++i) {
+        make_key(key, 'k', i);
+        u64 value = i;
+        hashtable_set(&table, key, &value);
+    }
+    f64 grow_insert = platform_get_absolute_time() - start;
+    hashtable_destroy(&table);
+
+    // Legacy table, sized to one slot per key as callers had to
+    legacy_hashtable legacy;
+    legacy.element_count = count;
+    legacy.values = memory_allocate(sizeof(u64) * count, MEMORY_TAG_HASHTABLE);
+    start = platform_get_absolute_time();
+    for (u32 i = 0; i < count; ++i) {
+        make_key(key, 'k', i);
+        legacy_set(&legacy, key, i);
+    }
+    f64 legacy_insert = platform_get_absolute_time() - start;
+
+    u32 legacy_lost = 0;
+    start = platform_get_absolute_time();
+    for (u32 i = 0; i < count; ++i) {
+        make_key(key, 'k', i);
+        legacy_lost += legacy_get(&legacy, key) != i;
+    }
+    f64 legacy_lookup = platform_get_absolute_time() - start;
+    memory_free(legacy.values, sizeof(u64) * count, MEMORY_TAG_HASHTABLE);
+
+    // Open addressing table sized up front
+    hashtable_create(sizeof(u64), count, false, &table);
+    start = platform_get_absolute_time();
+    for (u32 i = 0; i < count; ++i) {
+        make_key(key, 'k', i);
+        u64 value = i;
+        hashtable_set(&table, key, &value);
+    }
+    f64 insert = platform_get_absolute_time() - start;
+
+    u32 lost = 0;
+    start = platform_get_absolute_time();
+    for (u32 i = 0; i < count; ++i) {
+        make_key(key, 'k', i);
+        u64 value = U64_MAX;
+        hashtable_get(&table, key, &value);
+        lost += value != i;
+    }
+    f64 lookup = platform_get_absolute_time() - start;
+
+    u32 false_hits = 0;
+    start = platform_get_absolute_time();
+    for (u32 i = 0; i < count; ++i) {
+        make_key(key, 'm', i);
+        u64 value;
+        false_hits += hashtable_get(&table, key, &value);
+    }
+    f64 miss = platform_get_absolute_time() - start;
+
+    start = platform_get_absolute_time();
+    for (u32 i = 0; i < count; ++i) {
+        make_key(key, 'k', i);
+        hashtable_remove(&table, key);
+    }
+    f64 remove = platform_get_absolute_time() - start;
+    hashtable_destroy(&table);
+
+    MINFO("%8u | legacy   | %6.1f | %6.1f |      - |      - |    - | %u of %u keys lost to collisions",
+        count, ns_per_op(legacy_insert, count), ns_per_op(legacy_lookup, count), legacy_lost, count);
+    MINFO("%8u | hashtable| %6.1f | %6.1f | %6.1f | %6.1f | %4.0f | %u lost, %u false hits",
+        count, ns_per_op(insert, count), ns_per_op(lookup, count), ns_per_op(miss, count), ns_per_op(remove, count),
+        ns_per_op(grow_insert, count), lost, false_hits);
+}
+
+static void hashtable_benchmark_scaling(void) {
+    MINFO("ns per operation, 9 character keys. grown is insert starting from the smallest table");
+    MINFO("keys     | table    | insert | hit    | miss   | remove | grown | correctness");
+    benchmark_size(1000);
+    benchmark_size(100000);
+    benchmark_size(10000000);
+}
+
+#define ID_BENCH_COUNT 1000000
+#define ID_BENCH_LOOKUPS 4000000
+
+static u32 xorshift32(u32* state) {
+    u32 x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+// Looks up dense ids in random order, the way systems resolve entity and resource handles each frame
+static void hashtable_benchmark_id_lookup(void) {
+    u64* ids = memory_allocate(sizeof(u64) * ID_BENCH_COUNT, MEMORY_TAG_ENGINE);
+    for (u32 i = 0; i < ID_BENCH_COUNT; ++i) {
+        ids[i] = i;
+    }
+    // Shuffled, as the tree degenerates into a list when ids are inserted in order
+    u32 seed = 0x2545F491u;
+    for (u32 i = ID_BENCH_COUNT - 1; i > 0; --i) {
+        u32 j = xorshift32(&seed) % (i + 1);
+        u64 temp = ids[i];
+        ids[i] = ids[j];
+        ids[j] = temp;
+    }
+
+    u64_hashtable_u64 table;
+    u64_hashtable_u64_create(ID_BENCH_COUNT, &table);
+    bst_node* tree = nullptr;
+    hashtable string_table;
+    hashtable_create(sizeof(u64), ID_BENCH_COUNT, false, &string_table);
+    char key[16];
+    for (u32 i = 0; i < ID_BENCH_COUNT; ++i) {
+        u64_hashtable_u64_set(&table, ids[i], ids[i]);
+        bst_node_value value = { .u64 = ids[i] };
+        tree = u64_bst_insert(tree, ids[i], value);
+        make_key(key, 'k', (u32)ids[i]);
+        hashtable_set(&string_table, key, &ids[i]);
+    }
+
+    u64 checksum = 0;
+    seed = 0x2545F491u;
+    f64 start = platform_get_absolute_time();
+    for (u32 i = 0; i < ID_BENCH_LOOKUPS; ++i) {
+        checksum += *u64_hashtable_u64_get(&table, xorshift32(&seed) % ID_BENCH_COUNT);
+    }
+    f64 u64_table_time = platform_get_absolute_time() - start;
+
+    seed = 0x2545F491u;
+    start = platform_get_absolute_time();
+    for (u32 i = 0; i < ID_BENCH_LOOKUPS; ++i) {
+        checksum -= u64_bst_find(tree, xorshift32(&seed) % ID_BENCH_COUNT)->value.u64;
+    }
+    f64 bst_time = platform_get_absolute_time() - start;
+
+    seed = 0x2545F491u;
+    start = platform_get_absolute_time();
+    for (u32 i = 0; i < ID_BENCH_LOOKUPS; ++i) {
+        u64 value = 0;
+        make_key(key, 'k', xorshift32(&seed) % ID_BENCH_COUNT);
+        hashtable_get(&string_table, key, &value);
+        checksum += value;
+    }
+    f64 string_time = platform_get_absolute_time() - start;
+
+    MINFO("%u ids, %u random lookups (checksum %llu)", ID_BENCH_COUNT, ID_BENCH_LOOKUPS, checksum);
+    MINFO("u64_hashtable           | %6.1f ns", ns_per_op(u64_table_time, ID_BENCH_LOOKUPS));
+    MINFO("u64_bst                 | %6.1f ns", ns_per_op(bst_time, ID_BENCH_LOOKUPS));
+    MINFO("hashtable, id as string | %6.1f ns", ns_per_op(string_time, ID_BENCH_LOOKUPS));
+
+    hashtable_destroy(&string_table);
+    u64_bst_clear(tree);
+    u64_hashtable_u64_destroy(&table);
+    memory_free(ids, sizeof(u64) * ID_BENCH_COUNT, MEMORY_TAG_ENGINE);
+}
+
+#define NAME_BENCH_COUNT 4096
+#define NAME_BENCH_LOOKUPS 4000000
+
+// Asset-path-like keys looked up by string and by interned name
+static void hashtable_benchmark_prehashed_lookup(void) {
+    name_system_initialize();
+    hashtable table;
+    hashtable_create(sizeof(u64), NAME_BENCH_COUNT, false, &table);
+
+    char** paths = memory_allocate(sizeof(char*) * NAME_BENCH_COUNT, MEMORY_TAG_ENGINE);
+    name* names = memory_allocate(sizeof(name) * NAME_BENCH_COUNT, MEMORY_TAG_ENGINE);
+    for (u32 i = 0; i < NAME_BENCH_COUNT; ++i) {
+        paths[i] = cstr_format("assets/textures/environment/material_%u_albedo.png", i);
+        names[i] = name_intern(paths[i]);
+        u64 value = i;
+        hashtable_set(&table, paths[i], &value);
+    }
+
+    u64 checksum = 0;
+    u32 seed = 0x2545F491u;
+    f64 start = platform_get_absolute_time();
+    for (u32 i = 0; i < NAME_BENCH_LOOKUPS; ++i) {
+        u64 value = 0;
+        hashtable_get(&table, paths[xorshift32(&seed) % NAME_BENCH_COUNT], &value);
+        checksum += value;
+    }
+    f64 string_time = platform_get_absolute_time() - start;
+
+    seed = 0x2545F491u;
+    start = platform_get_absolute_time();
+    for (u32 i = 0; i < NAME_BENCH_LOOKUPS; ++i) {
+        u64 value = 0;
+        hashtable_key key = name_key(names[xorshift32(&seed) % NAME_BENCH_COUNT]);
+        hashtable_get_prehashed(&table, &key, &value);
+        checksum -= value;
+    }
+    f64 prehashed_time = platform_get_absolute_time() - start;
+
+    MINFO("%u keys of ~50 characters, %u random lookups (checksum %llu)", NAME_BENCH_COUNT, NAME_BENCH_LOOKUPS, checksum);
+    MINFO("string key        | %6.1f ns", ns_per_op(string_time, NAME_BENCH_LOOKUPS));
+    MINFO("interned name key | %6.1f ns", ns_per_op(prehashed_time, NAME_BENCH_LOOKUPS));
+
+    for (u32 i = 0; i < NAME_BENCH_COUNT; ++i) {
+        cstr_free(paths[i]);
+    }
+    memory_free(names, sizeof(name) * NAME_BENCH_COUNT, MEMORY_TAG_ENGINE);
+    memory_free(paths, sizeof(char*) * NAME_BENCH_COUNT, MEMORY_TAG_ENGINE);
+    hashtable_destroy(&table);
+    name_system_shutdown();
+}
+
+void hashtable_register_benchmarks(void) {
+    benchmark_manager_register_benchmark(hashtable_benchmark_scaling, "Hashtable against the legacy direct-mapped table at 1K, 100K and 10M keys");
+    benchmark_manager_register_benchmark(hashtable_benchmark_id_lookup, "Id lookups in the u64 hashtable, the u64 bst and the string hashtable");
+    benchmark_manager_register_benchmark(hashtable_benchmark_prehashed_lookup, "Hashtable lookups by string and by interned name");
+}
@@ -0,0 +1,232 @@
+#include "mpmc_queue_benchmarks.h"
+#include "../benchmark_manager.h"
+
+#include <containers/mpmc_queue.h>
+#include <containers/ring_queue.h>
+#include <core/logger.h>
+#include <platform/platform.h>
+#include <threads/atomic.h>
+#include <threads/mutex.h>
+#include <threads/thread.h>
+
+#define MPMC_BENCH_OPS_PER_PRODUCER 200000
+#define MPMC_BENCH_CAPACITY 1024
+#define MPMC_BENCH_MAX_PAIRS 32
+// Failed attempts a thread spins through before it yields, so threads sharing a core let each other run
+#define MPMC_BENCH_SPIN_LIMIT 1000
+// Latencies are counted in buckets of a quarter power of two of nanoseconds
+#define MPMC_BENCH_BUCKETS 160
+
+typedef enum mpmc_bench_mode {
+    // A ring_queue with a mutex around every call
+    MPMC_BENCH_MODE_LOCKED,
+    MPMC_BENCH_MODE_LOCK_FREE
+} mpmc_bench_mode;
+
+typedef struct mpmc_bench_shared {
+    mpmc_queue queue;
+    ring_queue locked_queue;
+    mutex lock;
+    mpmc_bench_mode mode;
+    volatile u32 start;
+} mpmc_bench_shared;
+
+typedef struct mpmc_bench_worker {
+    mpmc_bench_shared* shared;
+    u32 op_count;
+    u64 checksum;
+    // Time from the first attempt at an operation to its success
+    u64 latency_buckets[MPMC_BENCH_BUCKETS];
+} mpmc_bench_worker;
+
+static mpmc_bench_worker producers[MPMC_BENCH_MAX_PAIRS];
+static mpmc_bench_worker consumers[MPMC_BENCH_MAX_PAIRS];
+
+// The first 4 buckets hold 0-3 ns, then each power of two is split into 4
+static u32 latency_bucket(u64 ns) {
+    if (ns < 4) {
+        return (u32)ns;
+    }
+    u32 msb = 0;
+    while (ns >> (msb + 1)) {
+        msb++;
+    }
+    u32 bucket = (msb - 1) * 4 + (u32)((ns >> (msb - 2)) & 3);
+    return MMIN(bucket, (u32)MPMC_BENCH_BUCKETS - 1);
+}
+
+// Largest latency counted in the bucket
+static u64 latency_bucket_limit(u32 bucket) {
+    if (bucket < 4) {
+        return bucket;
+    }
+    u32 msb = bucket / 4 + 1;
+    return ((4ull + bucket % 4 + 1) << (msb - 2)) - 1;
+}
+
+static void backoff(u32* failures) {
+    if (++*failures < MPMC_BENCH_SPIN_LIMIT) {
+        atomic_spin_pause();
+    } else {
+        *failures = 0;
+        platform_sleep(0);
+    }
+}
+
+static b8 try_push(mpmc_bench_shared* shared, u64 value) {
+    if (shared->mode == MPMC_BENCH_MODE_LOCK_FREE) {
+        return mpmc_queue_try_push(&shared->queue, &value);
+    }
+    mutex_lock(&shared->lock);
+    b8 pushed = ring_queue_length(&shared->locked_queue) < MPMC_BENCH_CAPACITY && ring_queue_enqueue(&shared->locked_queue, &value);
+    mutex_unlock(&shared->lock);
+    return pushed;
+}
+
+static b8 try_pop(mpmc_bench_shared* shared, u64* out_value) {
+    if (shared->mode == MPMC_BENCH_MODE_LOCK_FREE) {
+        return mpmc_queue_try_pop(&shared->queue, out_value);
+    }
+    mutex_lock(&shared->lock);
+    b8 popped = ring_queue_length(&shared->locked_queue) > 0 && ring_queue_dequeue(&shared->locked_queue, out_value);
+    mutex_unlock(&shared->lock);
+    return popped;
+}
+
+static u32 mpmc_bench_producer(void* args) {
+    mpmc_bench_worker* worker = args;
+    mpmc_bench_shared* shared = worker->shared;
+    while (!atomic_u32_load(&shared->start)) {
+        atomic_spin_pause();
+    }
+
+    u32 failures = 0;
+    for (u32 i = 0; i < worker->op_count; ++i) {
+        f64 start = platform_get_absolute_time();
+        while (!try_push(shared, i)) {
+            backoff(&failures);
+        }
+        worker->latency_buckets[latency_bucket((u64)((platform_get_absolute_time() - start) * 1000000000.0))]++;
+    }
+    return 0;
+}
+
+static u32 mpmc_bench_consumer(void* args) {
+    mpmc_bench_worker* worker = args;
+    mpmc_bench_shared* shared = worker->shared;
+    while (!atomic_u32_load(&shared->start)) {
+        atomic_spin_pause();
+    }
+
+    u32 failures = 0;
+    for (u32 i = 0; i < worker->op_count; ++i) {
+        f64 start = platform_get_absolute_time();
+        u64 value;
+        while (!try_pop(shared, &value)) {
+            backoff(&failures);
+        }
+        worker->latency_buckets[latency_bucket((u64)((platform_get_absolute_time() - start) * 1000000000.0))]++;
+        worker->checksum += value;
+    }
+    return 0;
+}
+
+// Latency below which the given fraction of the workers' operations completed
+static u64 latency_percentile(const mpmc_bench_worker* workers, u32 worker_count, f64 fraction) {
+    u64 total = 0;
+    for (u32 w = 0; w < worker_count; ++w) {
+        total += workers[w].op_count;
+    }
+
+    u64 seen = 0;
+    for (u32 bucket = 0; bucket < MPMC_BENCH_BUCKETS; ++bucket) {
+        for (u32 w = 0; w < worker_count; ++w) {
+            seen += workers[w].latency_buckets[bucket];
+        }
+        if ((f64)seen >= fraction * total) {
+            return latency_bucket_limit(bucket);
+        }
+    }
+    return latency_bucket_limit(MPMC_BENCH_BUCKETS - 1);
+}
+
+// Runs pair_count producers against pair_count consumers and reports the operations per second and latencies
+static void run_mpmc_bench(mpmc_bench_shared* shared, mpmc_bench_mode mode, u32 pair_count) {
+    thread threads[MPMC_BENCH_MAX_PAIRS * 2];
+    u32 thread_count = 0;
+
+    shared->mode = mode;
+    atomic_u32_store(&shared->start, 0);
+    for (u32 i = 0; i < pair_count; ++i) {
+        producers[i] = (mpmc_bench_worker){ .shared = shared, .op_count = MPMC_BENCH_OPS_PER_PRODUCER };
+        consumers[i] = (mpmc_bench_worker){ .shared = shared, .op_count = MPMC_BENCH_OPS_PER_PRODUCER };
+    }
+    for (u32 i = 0; i < pair_count * 2; ++i) {
+        mpmc_bench_worker* worker = i % 2 ? &producers[i / 2] : &consumers[i / 2];
+        if (!thread_create(i % 2 ? mpmc_bench_producer : mpmc_bench_consumer, worker, false, &threads[thread_count])) {
+            MERROR("Failed to create benchmark thread %u.", i);
+            break;
+        }
+        thread_count++;
+    }
+
+    f64 start_time = platform_get_absolute_time();
+    atomic_u32_store(&shared->start, 1);
+    for (u32 i = 0; i < thread_count; ++i) {
+        thread_wait(&threads[i]);
+        thread_destroy(&threads[i]);
+    }
+    f64 elapsed = platform_get_absolute_time() - start_time;
+
+    u64 checksum = 0;
+    for (u32 i = 0; i < pair_count; ++i) {
+        checksum += consumers[i].checksum;
+    }
+    if (checksum != (u64)pair_count * MPMC_BENCH_OPS_PER_PRODUCER * (MPMC_BENCH_OPS_PER_PRODUCER - 1) / 2) {
+        MERROR("MPMC benchmark received the wrong items (checksum %llu).", checksum);
+    }
+
+    // Every item is pushed once and popped once
+    f64 ops_per_second = 2.0 * pair_count * MPMC_BENCH_OPS_PER_PRODUCER / elapsed;
+    MINFO("%5u | %-9s | %7.2f | %6llu %6llu %8llu | %6llu %6llu %8llu", pair_count,
+          mode == MPMC_BENCH_MODE_LOCKED ? "mutex" : "lock-free", ops_per_second / 1000000.0,
+          latency_percentile(producers, pair_count, 0.5), latency_percentile(producers, pair_count, 0.99),
+          latency_percentile(producers, pair_count, 0.999),
+          latency_percentile(consumers, pair_count, 0.5), latency_percentile(consumers, pair_count, 0.99),
+          latency_percentile(consumers, pair_count, 0.999));
+}
+
+// Doubles the thread count, always finishing on exactly max_count
+static u32 next_thread_count(u32 current, u32 max_count) {
+    if (current < max_count && current * 2 > max_count) {
+        return max_count;
+    }
+    return current * 2;
+}
+
+static void mpmc_queue_benchmark_contention(void) {
+    // Each pair is two threads, so the largest run uses every processor
+    u32 processor_count = platform_get_processor_count();
+    u32 max_pairs = MMIN(MMAX(processor_count / 2, 1u), (u32)MPMC_BENCH_MAX_PAIRS);
+
+    mpmc_bench_shared shared = {0};
+    mpmc_queue_create(sizeof(u64), MPMC_BENCH_CAPACITY, &shared.queue);
+    ring_queue_create(sizeof(u64), MPMC_BENCH_CAPACITY, nullptr, &shared.locked_queue);
+    mutex_create(&shared.lock);
+
+    MINFO("%u logical processors, %u items per producer, %u slot queues", processor_count, MPMC_BENCH_OPS_PER_PRODUCER, MPMC_BENCH_CAPACITY);
+    MINFO("Latencies in ns from the first attempt to success, including the clock reads around it");
+    MINFO("pairs | queue     | Mops/s  | push p50 p99 p99.9     | pop p50 p99 p99.9");
+    for (u32 pair_count = 1; pair_count <= max_pairs; pair_count = next_thread_count(pair_count, max_pairs)) {
+        run_mpmc_bench(&shared, MPMC_BENCH_MODE_LOCKED, pair_count);
+        run_mpmc_bench(&shared, MPMC_BENCH_MODE_LOCK_FREE, pair_count);
+    }
+
+    mutex_destroy(&shared.lock);
+    ring_queue_destroy(&shared.locked_queue);
+    mpmc_queue_destroy(&shared.queue);
+}
+
+void mpmc_queue_register_benchmarks(void) {
+    benchmark_manager_register_benchmark(mpmc_queue_benchmark_contention, "MPMC queue contention: mutex and lock-free, ops/s and latency percentiles");
+}
@@ -0,0 +1,112 @@
+#include "queue_benchmarks.h"
+#include "../benchmark_manager.h"
+
+#include <containers/queue.h>
+#include <core/logger.h>
+#include <memory/memory.h>
+#include <platform/platform.h>
+
+#define QUEUE_BENCH_BATCH 64
+
+// The queue queue.c had before it became a ring: every push grows the block by one element, and every
+// pop moves all remaining elements to the front
+typedef struct legacy_queue {
+    u64* memory;
+    u32 count;
+    u32 allocated;
+} legacy_queue;
+
+static void legacy_push(legacy_queue* q, u64 value) {
+    if (q->allocated < q->count + 1) {
+        q->memory = memory_reallocate_uninitialized(q->memory, q->allocated * sizeof(u64), (q->count + 1) * sizeof(u64), MEMORY_TAG_QUEUE);
+        q->allocated = q->count + 1;
+    }
+    q->memory[q->count++] = value;
+}
+
+static u64 legacy_pop(legacy_queue* q) {
+    u64 value = q->memory[0];
+    q->count--;
+    memory_copy(q->memory, q->memory + 1, q->count * sizeof(u64));
+    return value;
+}
+
+static f64 ns_per_op(f64 elapsed, u32 count) {
+    return elapsed * 1000000000.0 / count;
+}
+
+static void benchmark_count(u32 count, b8 run_legacy) {
+    u64 checksum = 0;
+    f64 legacy_push_time = 0;
+    f64 legacy_pop_time = 0;
+    if (run_legacy) {
+        legacy_queue legacy = {0};
+        legacy.memory = memory_allocate_uninitialized(sizeof(u64), MEMORY_TAG_QUEUE);
+        legacy.allocated = 1;
+        f64 start = platform_get_absolute_time();
+        for (u32 i = 0; i < count; ++i) {
+            legacy_push(&legacy, i);
+        }
+        legacy_push_time = platform_get_absolute_time() - start;
+
+        start = platform_get_absolute_time();
+        for (u32 i = 0; i < count; ++i) {
+            checksum += legacy_pop(&legacy);
+        }
+        legacy_pop_time = platform_get_absolute_time() - start;
+        memory_free(legacy.memory, legacy.allocated * sizeof(u64), MEMORY_TAG_QUEUE);
+    }
+
+    queue q;
+    queue_create(sizeof(u64), &q);
+    f64 start = platform_get_absolute_time();
+    for (u64 i = 0; i < count; ++i) {
+        queue_push(&q, &i);
+    }
+    f64 push_time = platform_get_absolute_time() - start;
+
+    start = platform_get_absolute_time();
+    for (u32 i = 0; i < count; ++i) {
+        u64 value;
+        queue_pop(&q, &value);
+        checksum += value;
+    }
+    f64 pop_time = platform_get_absolute_time() - start;
+
+    // Work queue pattern: a batch of jobs goes in, the consumer drains it, and the queue stays small
+    u64 batch[QUEUE_BENCH_BATCH];
+    for (u32 i = 0; i < QUEUE_BENCH_BATCH; ++i) {
+        batch[i] = i;
+    }
+    start = platform_get_absolute_time();
+    for (u32 i = 0; i < count; i += QUEUE_BENCH_BATCH) {
+        queue_push_range(&q, batch, QUEUE_BENCH_BATCH);
+        u64 out[QUEUE_BENCH_BATCH];
+        queue_pop_range(&q, out, QUEUE_BENCH_BATCH);
+        checksum += out[i % QUEUE_BENCH_BATCH];
+    }
+    f64 range_time = platform_get_absolute_time() - start;
+    queue_destroy(&q);
+
+    if (run_legacy) {
+        MINFO("%8u | %9.1f | %9.1f | %6.1f | %6.1f | %6.2f | (checksum %llu)", count, ns_per_op(legacy_push_time, count),
+              ns_per_op(legacy_pop_time, count), ns_per_op(push_time, count), ns_per_op(pop_time, count),
+              ns_per_op(range_time, count * 2), checksum);
+    } else {
+        MINFO("%8u |         - |         - | %6.1f | %6.1f | %6.2f | (checksum %llu)", count, ns_per_op(push_time, count),
+              ns_per_op(pop_time, count), ns_per_op(range_time, count * 2), checksum);
+    }
+}
+
+static void queue_benchmark_push_pop(void) {
+    MINFO("ns per element of u64 queues. Every element is pushed, then all are popped. ranges pushes and pops batches of %u", QUEUE_BENCH_BATCH);
+    MINFO("count    | old push  | old pop   | push   | pop    | ranges |");
+    benchmark_count(1024, true);
+    benchmark_count(16384, true);
+    // The old queue is quadratic, a million elements would take minutes
+    benchmark_count(1048576, false);
+}
+
+void queue_register_benchmarks(void) {
+    benchmark_manager_register_benchmark(queue_benchmark_push_pop, "Ring buffer queue against the old shifting queue");
+}
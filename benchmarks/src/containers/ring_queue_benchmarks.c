@@ -0,0 +1,143 @@
+#include "ring_queue_benchmarks.h"
+#include "../benchmark_manager.h"
+
+#include <containers/ring_queue.h>
+#include <core/logger.h>
+#include <platform/platform.h>
+#include <threads/atomic.h>
+#include <threads/mutex.h>
+#include <threads/thread.h>
+
+#define RING_BENCH_ITEM_COUNT 4000000
+#define RING_BENCH_CAPACITY 1024
+#define RING_BENCH_BATCH 32
+// Failed attempts a side spins through before it yields, so a side waiting on a thread sharing its core lets it run
+#define RING_BENCH_SPIN_LIMIT 1000
+
+typedef enum ring_bench_mode {
+    // A plain ring_queue with a mutex around every call
+    RING_BENCH_MODE_LOCKED,
+    RING_BENCH_MODE_SPSC,
+    RING_BENCH_MODE_SPSC_BATCH
+} ring_bench_mode;
+
+// Called after an attempt that moved nothing, with the count of such attempts in a row
+static void ring_bench_backoff(u32* failures) {
+    if (++*failures < RING_BENCH_SPIN_LIMIT) {
+        atomic_spin_pause();
+    } else {
+        *failures = 0;
+        platform_sleep(0);
+    }
+}
+
+typedef struct ring_bench_shared {
+    ring_queue queue;
+    mutex lock;
+    ring_bench_mode mode;
+    volatile u32 start;
+} ring_bench_shared;
+
+static u32 ring_bench_producer(void* args) {
+    ring_bench_shared* shared = args;
+    while (!atomic_u32_load(&shared->start)) {
+        atomic_spin_pause();
+    }
+
+    u64 batch[RING_BENCH_BATCH];
+    u32 failures = 0;
+    for (u64 next = 0; next < RING_BENCH_ITEM_COUNT;) {
+        u32 sent;
+        switch (shared->mode) {
+            case RING_BENCH_MODE_LOCKED:
+                mutex_lock(&shared->lock);
+                sent = ring_queue_length(&shared->queue) < RING_BENCH_CAPACITY && ring_queue_enqueue(&shared->queue, &next);
+                mutex_unlock(&shared->lock);
+                break;
+            case RING_BENCH_MODE_SPSC:
+                sent = ring_queue_enqueue(&shared->queue, &next);
+                break;
+            default:
+                for (u32 i = 0; i < RING_BENCH_BATCH; ++i) {
+                    batch[i] = next + i;
+                }
+                sent = ring_queue_enqueue_range(&shared->queue, batch, (u32)MMIN((u64)RING_BENCH_BATCH, RING_BENCH_ITEM_COUNT - next));
+                break;
+        }
+        next += sent;
+        if (!sent) {
+            ring_bench_backoff(&failures);
+        }
+    }
+    return 0;
+}
+
+// Runs a producer thread against a consumer on the calling thread and returns the items passed per second
+static f64 run_ring_bench(ring_bench_shared* shared, ring_bench_mode mode) {
+    ring_queue_create_with_flags(sizeof(u64), RING_BENCH_CAPACITY, nullptr,
+                                 mode == RING_BENCH_MODE_LOCKED ? RING_QUEUE_FLAG_NONE_BIT : RING_QUEUE_FLAG_SPSC_BIT, &shared->queue);
+    shared->mode = mode;
+    atomic_u32_store(&shared->start, 0);
+    thread producer;
+    if (!thread_create(ring_bench_producer, shared, false, &producer)) {
+        MERROR("Failed to create the producer thread.");
+        ring_queue_destroy(&shared->queue);
+        return 0;
+    }
+
+    u64 checksum = 0;
+    u64 received = 0;
+    u64 batch[RING_BENCH_BATCH];
+    u32 failures = 0;
+    f64 start_time = platform_get_absolute_time();
+    atomic_u32_store(&shared->start, 1);
+    while (received < RING_BENCH_ITEM_COUNT) {
+        u32 count;
+        switch (mode) {
+            case RING_BENCH_MODE_LOCKED:
+                mutex_lock(&shared->lock);
+                count = ring_queue_length(&shared->queue) > 0 && ring_queue_dequeue(&shared->queue, batch);
+                mutex_unlock(&shared->lock);
+                break;
+            case RING_BENCH_MODE_SPSC:
+                count = ring_queue_dequeue(&shared->queue, batch);
+                break;
+            default:
+                count = ring_queue_dequeue_range(&shared->queue, batch, RING_BENCH_BATCH);
+                break;
+        }
+        for (u32 i = 0; i < count; ++i) {
+            checksum += batch[i];
+        }
+        received += count;
+        if (!count) {
+            ring_bench_backoff(&failures);
+        }
+    }
+    thread_wait(&producer);
+    f64 elapsed = platform_get_absolute_time() - start_time;
+    thread_destroy(&producer);
+    ring_queue_destroy(&shared->queue);
+
+    if (checksum != (u64)RING_BENCH_ITEM_COUNT * (RING_BENCH_ITEM_COUNT - 1) / 2) {
+        MERROR("Ring queue benchmark received the wrong items (checksum %llu).", checksum);
+    }
+    return RING_BENCH_ITEM_COUNT / elapsed;
+}
+
+static void ring_queue_benchmark_spsc(void) {
+    ring_bench_shared shared = {0};
+    mutex_create(&shared.lock);
+
+    MINFO("%u u64 items from a producer thread to a consumer thread, %u slot queue, %u logical processors",
+          RING_BENCH_ITEM_COUNT, RING_BENCH_CAPACITY, platform_get_processor_count());
+    MINFO("mutex            | %7.2f Mitems/s", run_ring_bench(&shared, RING_BENCH_MODE_LOCKED) / 1000000.0);
+    MINFO("spsc             | %7.2f Mitems/s", run_ring_bench(&shared, RING_BENCH_MODE_SPSC) / 1000000.0);
+    MINFO("spsc, batches %2u | %7.2f Mitems/s", RING_BENCH_BATCH, run_ring_bench(&shared, RING_BENCH_MODE_SPSC_BATCH) / 1000000.0);
+
+    mutex_destroy(&shared.lock);
+}
+
+void ring_queue_register_benchmarks(void) {
+    benchmark_manager_register_benchmark(ring_queue_benchmark_spsc, "Ring queue between two threads: mutex, SPSC and SPSC batches");
+}
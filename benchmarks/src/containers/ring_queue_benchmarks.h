@@ -0,0 +1,3 @@
+#pragma once
+
+void ring_queue_register_benchmarks(void);
\ No newline at end of file
@@ -0,0 +1,120 @@
+#include "u64_btree_benchmarks.h"
+#include "../benchmark_manager.h"
+
+#include <containers/u64_bst.h>
+#include <containers/u64_btree.h>
+#include <core/logger.h>
+#include <memory/memory.h>
+#include <platform/platform.h>
+
+#define BTREE_BENCH_COUNT 1000000
+// Sorted inserts make the BST a list, so every insert walks all earlier keys recursively.
+// A million of them would take hours and overflow the stack, so that case runs on fewer keys
+#define BTREE_BENCH_BST_SORTED_COUNT 20000
+
+static u32 xorshift32(u32* state) {
+    u32 x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static f64 ns_per_op(f64 elapsed, u32 count) {
+    return elapsed * 1000000000.0 / count;
+}
+
+static void benchmark_btree(const char* pattern, const u64* keys, u32 count) {
+    u64_btree tree;
+    u64_btree_create(&tree);
+
+    f64 start = platform_get_absolute_time();
+    for (u32 i = 0; i < count; ++i) {
+        u64_btree_insert(&tree, keys[i], (bst_node_value){ .u64 = i });
+    }
+    f64 insert = platform_get_absolute_time() - start;
+
+    u64 checksum = 0;
+    u32 seed = 0x2545F491u;
+    start = platform_get_absolute_time();
+    for (u32 i = 0; i < count; ++i) {
+        checksum += u64_btree_find(&tree, keys[xorshift32(&seed) % count])->u64;
+    }
+    f64 lookup = platform_get_absolute_time() - start;
+
+    u64_btree_iterator it;
+    start = platform_get_absolute_time();
+    for (u64_btree_begin(&tree, &it); u64_btree_iterator_valid(&it); u64_btree_iterator_next(&it)) {
+        checksum += u64_btree_iterator_value(&it)->u64;
+    }
+    f64 iterate = platform_get_absolute_time() - start;
+
+    u32 height = tree.height;
+    start = platform_get_absolute_time();
+    for (u32 i = 0; i < count; ++i) {
+        u64_btree_remove(&tree, keys[i]);
+    }
+    f64 remove = platform_get_absolute_time() - start;
+    u64_btree_destroy(&tree);
+
+    MINFO("%-6s | u64_btree | %8u | %7.1f | %6.1f | %7.2f | %6.1f | height %u (checksum %llu)",
+          pattern, count, ns_per_op(insert, count), ns_per_op(lookup, count), ns_per_op(iterate, count),
+          ns_per_op(remove, count), height, checksum);
+}
+
+static void benchmark_bst(const char* pattern, const u64* keys, u32 count) {
+    bst_node* tree = nullptr;
+
+    f64 start = platform_get_absolute_time();
+    for (u32 i = 0; i < count; ++i) {
+        tree = u64_bst_insert(tree, keys[i], (bst_node_value){ .u64 = i });
+    }
+    f64 insert = platform_get_absolute_time() - start;
+
+    u64 checksum = 0;
+    u32 seed = 0x2545F491u;
+    start = platform_get_absolute_time();
+    for (u32 i = 0; i < count; ++i) {
+        checksum += u64_bst_find(tree, keys[xorshift32(&seed) % count])->value.u64;
+    }
+    f64 lookup = platform_get_absolute_time() - start;
+
+    start = platform_get_absolute_time();
+    for (u32 i = 0; i < count; ++i) {
+        tree = u64_bst_delete(tree, keys[i]);
+    }
+    f64 remove = platform_get_absolute_time() - start;
+    u64_bst_clear(tree);
+
+    MINFO("%-6s | u64_bst   | %8u | %7.1f | %6.1f |       - | %6.1f | (checksum %llu)",
+          pattern, count, ns_per_op(insert, count), ns_per_op(lookup, count), ns_per_op(remove, count), checksum);
+}
+
+static void u64_btree_benchmark_patterns(void) {
+    u64* keys = memory_allocate(sizeof(u64) * BTREE_BENCH_COUNT, MEMORY_TAG_ENGINE);
+
+    MINFO("ns per operation. Lookups pick stored keys at random, iterate is per key of a full in-order walk");
+    MINFO("keys   | tree      | count    | insert  | lookup | iterate | remove |");
+
+    // Increasing ids, the way handles are usually handed out
+    for (u32 i = 0; i < BTREE_BENCH_COUNT; ++i) {
+        keys[i] = i;
+    }
+    benchmark_btree("sorted", keys, BTREE_BENCH_COUNT);
+    benchmark_bst("sorted", keys, BTREE_BENCH_BST_SORTED_COUNT);
+
+    // Random 32 bit keys, duplicates just overwrite
+    u32 seed = 0x9E3779B9u;
+    for (u32 i = 0; i < BTREE_BENCH_COUNT; ++i) {
+        keys[i] = xorshift32(&seed);
+    }
+    benchmark_btree("random", keys, BTREE_BENCH_COUNT);
+    benchmark_bst("random", keys, BTREE_BENCH_COUNT);
+
+    memory_free(keys, sizeof(u64) * BTREE_BENCH_COUNT, MEMORY_TAG_ENGINE);
+}
+
+void u64_btree_register_benchmarks(void) {
+    benchmark_manager_register_benchmark(u64_btree_benchmark_patterns, "u64_btree against u64_bst with sorted and random keys");
+}
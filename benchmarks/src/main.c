@@ -0,0 +1,45 @@
+#include "benchmark_manager.h"
+
+#include <memory/memory.h>
+
+#include "memory/memory_benchmarks.h"
+#include "memory/pool_allocator_benchmarks.h"
+#include "memory/linear_allocator_benchmarks.h"
+#include "containers/darray_benchmarks.h"
+#include "containers/freelist_benchmarks.h"
+#include "containers/hashtable_benchmarks.h"
+#include "containers/queue_benchmarks.h"
+#include "containers/ring_queue_benchmarks.h"
+#include "containers/mpmc_queue_benchmarks.h"
+#include "containers/concurrent_hashtable_benchmarks.h"
+#include "containers/u64_btree_benchmarks.h"
+
+
+int main() {
+    memory_system_config memory_config = {0};
+    // Room for the 10M key hashtable benchmark, which holds a table while growing into one twice its size
+    memory_config.total_alloc_size = GIBIBYTES(2);
+    if (!memory_system_initialize(memory_config)) {
+        return -1;
+    }
+
+    benchmark_manager_init();
+
+    memory_register_benchmarks();
+    pool_allocator_register_benchmarks();
+    linear_allocator_register_benchmarks();
+    darray_register_benchmarks();
+    freelist_register_benchmarks();
+    hashtable_register_benchmarks();
+    queue_register_benchmarks();
+    ring_queue_register_benchmarks();
+    mpmc_queue_register_benchmarks();
+    concurrent_hashtable_register_benchmarks();
+    u64_btree_register_benchmarks();
+
+    benchmark_manager_run_benchmarks();
+
+    memory_system_shutdown();
+
+    return 0;
+}
@@ -0,0 +1,128 @@
+#include "linear_allocator_benchmarks.h"
+#include "../benchmark_manager.h"
+
+#include <core/logger.h>
+#include <memory/memory.h>
+#include <memory/allocators/linear_allocator.h>
+#include <platform/platform.h>
+#include <threads/atomic.h>
+#include <threads/mutex.h>
+#include <threads/thread.h>
+
+#define LINEAR_BENCH_ALLOCS_PER_THREAD 1000000
+#define LINEAR_BENCH_MAX_SIZE 64
+#define LINEAR_BENCH_CHUNK_SIZE KIBIBYTES(16)
+#define LINEAR_BENCH_MAX_THREADS 64
+
+typedef enum linear_bench_mode {
+    LINEAR_BENCH_MODE_LOCKED,
+    LINEAR_BENCH_MODE_ATOMIC,
+    LINEAR_BENCH_MODE_CHUNKED
+} linear_bench_mode;
+
+typedef struct linear_bench_shared {
+    linear_allocator allocator;
+    mutex lock;
+    linear_bench_mode mode;
+    volatile u32 start;
+} linear_bench_shared;
+
+static u32 linear_bench_thread(void* args) {
+    linear_bench_shared* shared = args;
+    linear_allocator_chunk chunk;
+    linear_allocator_chunk_begin(&shared->allocator, LINEAR_BENCH_CHUNK_SIZE, &chunk);
+
+    while (!atomic_u32_load(&shared->start)) {
+        atomic_spin_pause();
+    }
+
+    for (u32 i = 0; i < LINEAR_BENCH_ALLOCS_PER_THREAD; ++i) {
+        u64 size = 16 + (i * 7) % (LINEAR_BENCH_MAX_SIZE - 16);
+        u8* block;
+        switch (shared->mode) {
+            case LINEAR_BENCH_MODE_LOCKED:
+                mutex_lock(&shared->lock);
+                block = linear_allocator_allocate_aligned(&shared->allocator, size, 16);
+                mutex_unlock(&shared->lock);
+                break;
+            case LINEAR_BENCH_MODE_ATOMIC:
+                block = linear_allocator_allocate(&shared->allocator, get_aligned(size, 16));
+                break;
+            default:
+                block = linear_allocator_chunk_allocate(&chunk, size, 16);
+                break;
+        }
+        block[0] = (u8)i;
+    }
+    return 0;
+}
+
+// Runs the allocation loop on thread_count threads at once and returns the combined allocations per second
+static f64 run_linear_bench(linear_bench_shared* shared, linear_bench_mode mode, u32 thread_count) {
+    thread threads[LINEAR_BENCH_MAX_THREADS];
+
+    shared->mode = mode;
+    linear_allocator_free_all(&shared->allocator, false);
+    atomic_u32_store(&shared->start, 0);
+    for (u32 i = 0; i < thread_count; ++i) {
+        if (!thread_create(linear_bench_thread, shared, false, &threads[i])) {
+            MERROR("Failed to create benchmark thread %u.", i);
+            thread_count = i;
+            break;
+        }
+    }
+
+    f64 start_time = platform_get_absolute_time();
+    atomic_u32_store(&shared->start, 1);
+    for (u32 i = 0; i < thread_count; ++i) {
+        thread_wait(&threads[i]);
+        thread_destroy(&threads[i]);
+    }
+    f64 elapsed = platform_get_absolute_time() - start_time;
+    return (f64)thread_count * LINEAR_BENCH_ALLOCS_PER_THREAD / elapsed;
+}
+
+// Doubles the thread count, always finishing on exactly max_count
+static u32 next_thread_count(u32 current, u32 max_count) {
+    if (current < max_count && current * 2 > max_count) {
+        return max_count;
+    }
+    return current * 2;
+}
+
+static void linear_allocator_benchmark_scaling(void) {
+    u32 processor_count = MMIN(platform_get_processor_count(), LINEAR_BENCH_MAX_THREADS);
+    // Room for every thread's allocations, including the padding and the chunk tails left unused
+    u64 arena_size = (u64)processor_count * LINEAR_BENCH_ALLOCS_PER_THREAD * (LINEAR_BENCH_MAX_SIZE + 16);
+
+    linear_bench_shared shared = {0};
+    void* memory = memory_allocate_uninitialized(arena_size, MEMORY_TAG_LINEAR_ALLOCATOR);
+    linear_allocator_create_with_flags(arena_size, memory, LINEAR_ALLOCATOR_FLAG_CONCURRENT_BIT, &shared.allocator);
+    mutex_create(&shared.lock);
+
+    MINFO("%u logical processors, %u allocations of 16-%u B per thread", processor_count, LINEAR_BENCH_ALLOCS_PER_THREAD, LINEAR_BENCH_MAX_SIZE);
+    MINFO("threads | mutex (Mallocs/s, scaling) | atomic (Mallocs/s, scaling) | chunks (Mallocs/s, scaling)");
+
+    f64 base[3] = {0};
+    for (u32 thread_count = 1; thread_count <= processor_count; thread_count = next_thread_count(thread_count, processor_count)) {
+        f64 results[3];
+        for (u32 mode = LINEAR_BENCH_MODE_LOCKED; mode <= LINEAR_BENCH_MODE_CHUNKED; ++mode) {
+            results[mode] = run_linear_bench(&shared, mode, thread_count);
+            if (thread_count == 1) {
+                base[mode] = results[mode];
+            }
+        }
+        MINFO("%7u | %13.2f %5.2fx | %14.2f %5.2fx | %14.2f %5.2fx", thread_count,
+              results[0] / 1000000.0, results[0] / base[0],
+              results[1] / 1000000.0, results[1] / base[1],
+              results[2] / 1000000.0, results[2] / base[2]);
+    }
+
+    mutex_destroy(&shared.lock);
+    linear_allocator_destroy(&shared.allocator);
+    memory_free(memory, arena_size, MEMORY_TAG_LINEAR_ALLOCATOR);
+}
+
+void linear_allocator_register_benchmarks(void) {
+    benchmark_manager_register_benchmark(linear_allocator_benchmark_scaling, "Linear allocator scaling across threads: mutex, atomic and chunks");
+}
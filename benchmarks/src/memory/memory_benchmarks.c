@@ -0,0 +1,530 @@
+#include "memory_benchmarks.h"
+#include "../benchmark_manager.h"
+
+#include <core/logger.h>
+#include <memory/memory.h>
+#include <containers/darray.h>
+#include <memory/allocators/dynamic_allocator.h>
+#include <memory/allocators/scratch_allocator.h>
+#include <platform/platform.h>
+#include <strings/string.h>
+#include <threads/atomic.h>
+#include <threads/mutex.h>
+#include <threads/thread.h>
+
+#include <string.h>
+
+#define ALLOC_BENCH_OPS_PER_THREAD 200000
+#define ALLOC_BENCH_LIVE_BLOCKS 64
+#define ALLOC_BENCH_MAX_SIZE 512
+#define ALLOC_BENCH_MAX_THREADS 64
+
+typedef struct alloc_bench_shared {
+    volatile u32 start;
+    // When set, allocations go straight to a single mutex-guarded dynamic allocator,
+    // which is how memory_allocate behaved before the per-thread caches
+    b8 use_locked_heap;
+    dynamic_allocator locked_heap;
+    mutex heap_mutex;
+} alloc_bench_shared;
+
+typedef struct alloc_bench_worker {
+    alloc_bench_shared* shared;
+    u32 seed;
+} alloc_bench_worker;
+
+static u32 xorshift32(u32* state) {
+    u32 x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static void* bench_allocate(alloc_bench_shared* shared, u64 size) {
+    if (!shared->use_locked_heap) {
+        return memory_allocate(size, MEMORY_TAG_GAME);
+    }
+
+    mutex_lock(&shared->heap_mutex);
+    void* block = dynamic_allocator_allocate(&shared->locked_heap, size);
+    mutex_unlock(&shared->heap_mutex);
+    memory_zero(block, size);
+    return block;
+}
+
+static void bench_free(alloc_bench_shared* shared, void* block, u64 size) {
+    if (!shared->use_locked_heap) {
+        memory_free(block, size, MEMORY_TAG_GAME);
+        return;
+    }
+
+    mutex_lock(&shared->heap_mutex);
+    dynamic_allocator_free(&shared->locked_heap, block);
+    mutex_unlock(&shared->heap_mutex);
+}
+
+static u32 alloc_bench_thread(void* args) {
+    alloc_bench_worker* worker = args;
+    alloc_bench_shared* shared = worker->shared;
+
+    void* blocks[ALLOC_BENCH_LIVE_BLOCKS] = {0};
+    u64 sizes[ALLOC_BENCH_LIVE_BLOCKS] = {0};
+
+    while (!atomic_u32_load(&shared->start)) {
+        atomic_spin_pause();
+    }
+
+    for (u32 i = 0; i < ALLOC_BENCH_OPS_PER_THREAD; ++i) {
+        u32 slot = i % ALLOC_BENCH_LIVE_BLOCKS;
+        if (blocks[slot]) {
+            bench_free(shared, blocks[slot], sizes[slot]);
+        }
+        sizes[slot] = 8 + (xorshift32(&worker->seed) % (ALLOC_BENCH_MAX_SIZE - 8));
+        blocks[slot] = bench_allocate(shared, sizes[slot]);
+        ((u8*)blocks[slot])[0] = (u8)i;
+    }
+
+    for (u32 i = 0; i < ALLOC_BENCH_LIVE_BLOCKS; ++i) {
+        if (blocks[i]) {
+            bench_free(shared, blocks[i], sizes[i]);
+        }
+    }
+
+    if (!shared->use_locked_heap) {
+        memory_thread_cache_flush();
+    }
+    return 0;
+}
+
+// Runs the alloc/free loop on thread_count threads at once and returns the combined operations per second
+static f64 run_alloc_bench(alloc_bench_shared* shared, u32 thread_count) {
+    thread threads[ALLOC_BENCH_MAX_THREADS];
+    alloc_bench_worker workers[ALLOC_BENCH_MAX_THREADS];
+
+    atomic_u32_store(&shared->start, 0);
+    for (u32 i = 0; i < thread_count; ++i) {
+        workers[i].shared = shared;
+        workers[i].seed = 0x9E3779B9u * (i + 1);
+        if (!thread_create(alloc_bench_thread, &workers[i], false, &threads[i])) {
+            MERROR("Failed to create benchmark thread %u.", i);
+            thread_count = i;
+            break;
+        }
+    }
+
+    f64 start_time = platform_get_absolute_time();
+    atomic_u32_store(&shared->start, 1);
+    for (u32 i = 0; i < thread_count; ++i) {
+        thread_wait(&threads[i]);
+        thread_destroy(&threads[i]);
+    }
+    f64 elapsed = platform_get_absolute_time() - start_time;
+
+    // One allocation and one free per iteration
+    f64 total_ops = (f64)thread_count * ALLOC_BENCH_OPS_PER_THREAD * 2.0;
+    return total_ops / elapsed;
+}
+
+// Doubles the thread count, always finishing on exactly max_count
+static u32 next_thread_count(u32 current, u32 max_count) {
+    if (current < max_count && current * 2 > max_count) {
+        return max_count;
+    }
+    return current * 2;
+}
+
+static void memory_benchmark_multithreaded_allocation(void) {
+    alloc_bench_shared shared = {0};
+
+    u64 heap_requirement = 0;
+    const u64 heap_size = MEBIBYTES(64);
+    dynamic_allocator_create(heap_size, &heap_requirement, nullptr, nullptr);
+    void* heap_memory = memory_allocate(heap_requirement, MEMORY_TAG_ENGINE);
+    dynamic_allocator_create(heap_size, &heap_requirement, heap_memory, &shared.locked_heap);
+    mutex_create(&shared.heap_mutex);
+
+    u32 processor_count = MMIN(platform_get_processor_count(), ALLOC_BENCH_MAX_THREADS);
+    MINFO("%u logical processors, %u alloc/free pairs per thread, sizes 8-%u B", processor_count, ALLOC_BENCH_OPS_PER_THREAD, ALLOC_BENCH_MAX_SIZE);
+    MINFO("threads | locked heap (Mops/s, scaling) | thread caches (Mops/s, scaling)");
+
+    f64 locked_base = 0.0;
+    f64 cached_base = 0.0;
+    for (u32 thread_count = 1; thread_count <= processor_count; thread_count = next_thread_count(thread_count, processor_count)) {
+        shared.use_locked_heap = true;
+        f64 locked = run_alloc_bench(&shared, thread_count);
+        shared.use_locked_heap = false;
+        f64 cached = run_alloc_bench(&shared, thread_count);
+        if (thread_count == 1) {
+            locked_base = locked;
+            cached_base = cached;
+        }
+
+        MINFO("%7u | %10.2f %5.2fx | %10.2f %5.2fx", thread_count, locked / 1000000.0, locked / locked_base, cached / 1000000.0, cached / cached_base);
+    }
+
+    mutex_destroy(&shared.heap_mutex);
+    dynamic_allocator_destroy(&shared.locked_heap);
+    memory_free(heap_memory, heap_requirement, MEMORY_TAG_ENGINE);
+}
+
+#define GROWTH_BENCH_MAX_ARRAYS 4
+#define GROWTH_BENCH_START_SIZE KIBIBYTES(4)
+#define GROWTH_BENCH_FINAL_SIZE MEBIBYTES(32)
+#define GROWTH_BENCH_LINEAR_STEP KIBIBYTES(256)
+
+typedef struct growth_bench_result {
+    u64 bytes_copied;
+    u32 moves;
+    u32 grows;
+    f64 seconds;
+} growth_bench_result;
+
+// Grows array_count interleaved arrays up to GROWTH_BENCH_FINAL_SIZE, either doubling or by a fixed step.
+// Without reallocate, every growth allocates a new block, copies and frees, as the containers used to
+static growth_bench_result run_growth_bench(u32 array_count, b8 doubling, b8 reallocate) {
+    growth_bench_result result = {0};
+    void* arrays[GROWTH_BENCH_MAX_ARRAYS] = {0};
+    u64 sizes[GROWTH_BENCH_MAX_ARRAYS] = {0};
+    for (u32 i = 0; i < array_count; ++i) {
+        sizes[i] = GROWTH_BENCH_START_SIZE;
+        arrays[i] = memory_allocate(sizes[i], MEMORY_TAG_DARRAY);
+    }
+
+    f64 start_time = platform_get_absolute_time();
+    b8 growing = true;
+    while (growing) {
+        growing = false;
+        for (u32 i = 0; i < array_count; ++i) {
+            if (sizes[i] >= GROWTH_BENCH_FINAL_SIZE) {
+                continue;
+            }
+            growing = true;
+
+            u64 new_size = doubling ? sizes[i] * 2 : sizes[i] + GROWTH_BENCH_LINEAR_STEP;
+            void* grown = nullptr;
+            if (reallocate) {
+                grown = memory_reallocate(arrays[i], sizes[i], new_size, MEMORY_TAG_DARRAY);
+            } else {
+                grown = memory_allocate(new_size, MEMORY_TAG_DARRAY);
+                memory_copy(grown, arrays[i], sizes[i]);
+                memory_free(arrays[i], sizes[i], MEMORY_TAG_DARRAY);
+            }
+
+            if (grown != arrays[i]) {
+                result.bytes_copied += sizes[i];
+                result.moves++;
+            }
+            result.grows++;
+            arrays[i] = grown;
+            sizes[i] = new_size;
+        }
+    }
+    result.seconds = platform_get_absolute_time() - start_time;
+
+    for (u32 i = 0; i < array_count; ++i) {
+        memory_free(arrays[i], sizes[i], MEMORY_TAG_DARRAY);
+    }
+    return result;
+}
+
+static void memory_benchmark_array_growth(void) {
+    MINFO("Arrays grown from %llu KiB to %llu MiB", GROWTH_BENCH_START_SIZE / KIBIBYTES(1), GROWTH_BENCH_FINAL_SIZE / MEBIBYTES(1));
+    MINFO("pattern          | arrays | copy always (MiB copied, ms) | reallocate (MiB copied, moves/grows, ms)");
+
+    for (u32 pattern = 0; pattern < 2; ++pattern) {
+        b8 doubling = pattern == 0;
+        for (u32 array_count = 1; array_count <= GROWTH_BENCH_MAX_ARRAYS; array_count *= GROWTH_BENCH_MAX_ARRAYS) {
+            growth_bench_result copied = run_growth_bench(array_count, doubling, false);
+            growth_bench_result reallocated = run_growth_bench(array_count, doubling, true);
+            MINFO("%-16s | %6u | %10.1f %8.2f        | %10.1f %4u/%-4u %8.2f",
+                doubling ? "doubling" : "+256 KiB steps", array_count,
+                (f64)copied.bytes_copied / MEBIBYTES(1), copied.seconds * 1000.0,
+                (f64)reallocated.bytes_copied / MEBIBYTES(1), reallocated.moves, reallocated.grows, reallocated.seconds * 1000.0);
+        }
+    }
+}
+
+#define SCRATCH_BENCH_ITERATIONS 200000
+
+typedef struct scratch_bench_result {
+    f64 seconds;
+    u64 heap_allocations;
+} scratch_bench_result;
+
+static u64 total_heap_allocations(void) {
+    memory_thread_cache_flush();
+    memory_stats stats;
+    memory_get_stats(&stats);
+    u64 total = 0;
+    for (u32 i = 0; i < MEMORY_TAG_MAX_TAGS; ++i) {
+        total += stats.tags[i].total_allocation_count;
+    }
+    return total;
+}
+
+// Formats a line and splits it again, the way logging and config parsing use short-lived strings
+static scratch_bench_result run_scratch_bench(b8 use_scratch) {
+    u64 allocations_before = total_heap_allocations();
+    f64 start = platform_get_absolute_time();
+
+    u64 checksum = 0;
+    for (u32 i = 0; i < SCRATCH_BENCH_ITERATIONS; ++i) {
+        if (use_scratch) {
+            scratch_arena scratch = scratch_begin();
+            char* line = cstr_format_with_allocator(scratch.allocator, "[INFO]: frame %u, %s, %f ms", i, "entity,transform,mesh", 16.6);
+            char** parts = darray_reserve_with_allocator(char*, 4, scratch.allocator);
+            checksum += cstr_split_with_allocator(line, ',', &parts, true, false, scratch.allocator);
+            scratch_end(scratch);
+        } else {
+            char* line = cstr_format("[INFO]: frame %u, %s, %f ms", i, "entity,transform,mesh", 16.6);
+            char** parts = darray_reserve(char*, 4);
+            checksum += cstr_split(line, ',', &parts, true, false);
+            cstr_cleanup_split_darray(parts);
+            darray_destroy(parts);
+            cstr_free(line);
+        }
+    }
+
+    scratch_bench_result result;
+    result.seconds = platform_get_absolute_time() - start;
+    result.heap_allocations = total_heap_allocations() - allocations_before;
+    if (checksum != (u64)SCRATCH_BENCH_ITERATIONS * 5) {
+        MERROR("Unexpected split result %llu", checksum);
+    }
+    return result;
+}
+
+static void memory_benchmark_scratch_strings(void) {
+    MINFO("%u format + split round trips", SCRATCH_BENCH_ITERATIONS);
+    MINFO("backing  | ns/op   | heap allocations/op");
+
+    scratch_bench_result heap = run_scratch_bench(false);
+    scratch_bench_result scratch = run_scratch_bench(true);
+    MINFO("heap     | %7.1f | %6.2f", heap.seconds * 1e9 / SCRATCH_BENCH_ITERATIONS, (f64)heap.heap_allocations / SCRATCH_BENCH_ITERATIONS);
+    MINFO("scratch  | %7.1f | %6.2f", scratch.seconds * 1e9 / SCRATCH_BENCH_ITERATIONS, (f64)scratch.heap_allocations / SCRATCH_BENCH_ITERATIONS);
+}
+
+#define CHASE_BENCH_STEPS 10000000
+#define CHASE_BENCH_HEAP_SIZE GIBIBYTES(1)
+
+typedef struct chase_node {
+    struct chase_node* next;
+    u8 payload[56];
+} chase_node;
+
+typedef struct chase_heap {
+    dynamic_allocator allocator;
+    void* block;
+    u64 block_size;
+} chase_heap;
+
+// Sets up a heap the way the memory system does, on regular or transparent huge pages
+static b8 chase_heap_create(b8 huge_pages, chase_heap* out_heap) {
+    dynamic_allocator_flags flags = DYNAMIC_ALLOCATOR_FLAG_LAZY_COMMIT_BIT;
+    if (huge_pages) {
+        flags |= DYNAMIC_ALLOCATOR_FLAG_HUGE_GRANULES_BIT;
+    }
+    u64 requirement = 0;
+    dynamic_allocator_create_with_flags(CHASE_BENCH_HEAP_SIZE, flags, &requirement, nullptr, nullptr);
+    out_heap->block_size = requirement + DYNAMIC_ALLOCATOR_HUGE_COMMIT_GRANULARITY;
+    out_heap->block = platform_memory_reserve(out_heap->block_size);
+    if (!out_heap->block) {
+        return false;
+    }
+    void* aligned = (void*)get_aligned((u64)out_heap->block, DYNAMIC_ALLOCATOR_HUGE_COMMIT_GRANULARITY);
+    if ((huge_pages && !platform_memory_advise_huge(aligned, requirement)) ||
+        !dynamic_allocator_create_with_flags(CHASE_BENCH_HEAP_SIZE, flags, &requirement, aligned, &out_heap->allocator)) {
+        platform_memory_release(out_heap->block, out_heap->block_size);
+        return false;
+    }
+    return true;
+}
+
+static void chase_heap_destroy(chase_heap* heap) {
+    dynamic_allocator_destroy(&heap->allocator);
+    platform_memory_release(heap->block, heap->block_size);
+}
+
+// Links node_count heap nodes into one random cycle and returns nanoseconds per dependent load while walking it
+static f64 run_chase_bench(dynamic_allocator* allocator, u64 node_count) {
+    chase_node** nodes = dynamic_allocator_allocate(allocator, sizeof(chase_node*) * node_count);
+    for (u64 i = 0; i < node_count; ++i) {
+        nodes[i] = dynamic_allocator_allocate_aligned(allocator, sizeof(chase_node), 16);
+    }
+
+    u32 seed = 0x1234567;
+    for (u64 i = node_count - 1; i > 0; --i) {
+        u64 j = (((u64)xorshift32(&seed) << 32) | xorshift32(&seed)) % (i + 1);
+        chase_node* tmp = nodes[i];
+        nodes[i] = nodes[j];
+        nodes[j] = tmp;
+    }
+    for (u64 i = 0; i < node_count; ++i) {
+        nodes[i]->next = nodes[(i + 1) % node_count];
+    }
+
+    chase_node* node = nodes[0];
+    f64 start = platform_get_absolute_time();
+    for (u32 i = 0; i < CHASE_BENCH_STEPS; ++i) {
+        node = node->next;
+    }
+    f64 elapsed = platform_get_absolute_time() - start;
+    if (!node) {
+        MERROR("Pointer chase ended on a null node!");
+    }
+
+    for (u64 i = 0; i < node_count; ++i) {
+        dynamic_allocator_free_aligned(allocator, nodes[i]);
+    }
+    dynamic_allocator_free(allocator, nodes);
+    return elapsed * 1000000000.0 / CHASE_BENCH_STEPS;
+}
+
+static void memory_benchmark_huge_page_chase(void) {
+    MINFO("%u dependent loads over randomly linked %llu B heap nodes", CHASE_BENCH_STEPS, (u64)sizeof(chase_node));
+    MINFO("nodes       | regular pages (ns/load) | transparent huge pages (ns/load)");
+
+    chase_heap regular;
+    chase_heap huge;
+    if (!chase_heap_create(false, &regular)) {
+        MERROR("Unable to create the benchmark heap.");
+        return;
+    }
+    b8 has_huge = chase_heap_create(true, &huge);
+    if (!has_huge) {
+        MWARN("Transparent huge pages are unavailable, only regular pages are measured.");
+    }
+
+    for (u64 bytes = MEBIBYTES(4); bytes <= MEBIBYTES(512); bytes *= 4) {
+        u64 node_count = bytes / sizeof(chase_node);
+        f64 regular_ns = run_chase_bench(&regular.allocator, node_count);
+        f64 huge_ns = has_huge ? run_chase_bench(&huge.allocator, node_count) : 0.0;
+        MINFO("%7llu MiB | %23.2f | %32.2f", bytes / MEBIBYTES(1), regular_ns, huge_ns);
+    }
+
+    if (has_huge) {
+        chase_heap_destroy(&huge);
+    }
+    chase_heap_destroy(&regular);
+}
+
+#define OVERHEAD_BENCH_BLOCKS 100000
+#define OVERHEAD_BENCH_HEAP_SIZE MEBIBYTES(64)
+
+// Fills a fresh allocator with same sized blocks and returns the bytes each one took from it
+static f64 run_overhead_bench(void* memory, u64 size, u16 alignment) {
+    dynamic_allocator allocator;
+    u64 requirement = 0;
+    dynamic_allocator_create(OVERHEAD_BENCH_HEAP_SIZE, &requirement, memory, &allocator);
+    for (u32 i = 0; i < OVERHEAD_BENCH_BLOCKS; ++i) {
+        dynamic_allocator_allocate_aligned(&allocator, size, alignment);
+    }
+    u64 used = OVERHEAD_BENCH_HEAP_SIZE - dynamic_allocator_free_space(&allocator);
+    dynamic_allocator_destroy(&allocator);
+    return (f64)used / OVERHEAD_BENCH_BLOCKS;
+}
+
+static void memory_benchmark_allocation_overhead(void) {
+    u64 requirement = 0;
+    dynamic_allocator_create(OVERHEAD_BENCH_HEAP_SIZE, &requirement, nullptr, nullptr);
+    void* memory = memory_allocate_uninitialized(requirement, MEMORY_TAG_ENGINE);
+
+    static const u64 sizes[] = {8, 16, 24, 32, 48, 64, 128, 256};
+    static const u16 alignments[] = {1, 8, 16};
+    MINFO("%u blocks per size, bytes taken per block (overhead, density)", OVERHEAD_BENCH_BLOCKS);
+    MINFO("size  | alignment 1           | alignment 8           | alignment 16");
+    for (u32 s = 0; s < sizeof(sizes) / sizeof(u64); ++s) {
+        f64 per_block[3];
+        for (u32 a = 0; a < 3; ++a) {
+            per_block[a] = run_overhead_bench(memory, sizes[s], alignments[a]);
+        }
+        MINFO("%5llu | %5.1f (%5.1f, %3.0f%%) | %5.1f (%5.1f, %3.0f%%) | %5.1f (%5.1f, %3.0f%%)", sizes[s],
+              per_block[0], per_block[0] - sizes[s], sizes[s] * 100.0 / per_block[0],
+              per_block[1], per_block[1] - sizes[s], sizes[s] * 100.0 / per_block[1],
+              per_block[2], per_block[2] - sizes[s], sizes[s] * 100.0 / per_block[2]);
+    }
+
+    memory_free(memory, requirement, MEMORY_TAG_ENGINE);
+}
+
+#define BANDWIDTH_BENCH_MIN_SIZE 16
+#define BANDWIDTH_BENCH_MAX_SIZE MEBIBYTES(256)
+#define BANDWIDTH_BENCH_BYTES_PER_RUN GIBIBYTES(1)
+
+typedef enum bandwidth_bench_op {
+    BANDWIDTH_BENCH_LIBC_COPY,
+    BANDWIDTH_BENCH_ENGINE_COPY,
+    BANDWIDTH_BENCH_LIBC_ZERO,
+    BANDWIDTH_BENCH_ENGINE_ZERO,
+    BANDWIDTH_BENCH_OP_COUNT
+} bandwidth_bench_op;
+
+// Returns GiB/s for repeating the operation on the same size block until BANDWIDTH_BENCH_BYTES_PER_RUN bytes are written
+static f64 run_bandwidth_bench(bandwidth_bench_op op, u8* dst, const u8* src, u64 size) {
+    u64 iterations = MMAX(BANDWIDTH_BENCH_BYTES_PER_RUN / size, (u64)1);
+    f64 start = platform_get_absolute_time();
+    switch (op) {
+        case BANDWIDTH_BENCH_LIBC_COPY:
+            for (u64 i = 0; i < iterations; ++i) {
+                memcpy(dst, src, size);
+            }
+            break;
+        case BANDWIDTH_BENCH_ENGINE_COPY:
+            for (u64 i = 0; i < iterations; ++i) {
+                memory_copy(dst, src, size);
+            }
+            break;
+        case BANDWIDTH_BENCH_LIBC_ZERO:
+            for (u64 i = 0; i < iterations; ++i) {
+                memset(dst, 0, size);
+            }
+            break;
+        default:
+            for (u64 i = 0; i < iterations; ++i) {
+                memory_zero(dst, size);
+            }
+            break;
+    }
+    f64 elapsed = platform_get_absolute_time() - start;
+    return ((f64)iterations * size / GIBIBYTES(1)) / elapsed;
+}
+
+static void memory_benchmark_bandwidth(void) {
+    u8* src = platform_memory_reserve(BANDWIDTH_BENCH_MAX_SIZE);
+    u8* dst = platform_memory_reserve(BANDWIDTH_BENCH_MAX_SIZE);
+    if (!src || !dst || !platform_memory_commit(src, BANDWIDTH_BENCH_MAX_SIZE) || !platform_memory_commit(dst, BANDWIDTH_BENCH_MAX_SIZE)) {
+        MERROR("Unable to obtain the benchmark buffers.");
+        return;
+    }
+    // Fault every page in up front so the first sizes don't pay for it
+    memset(src, 0x5A, BANDWIDTH_BENCH_MAX_SIZE);
+    memset(dst, 0, BANDWIDTH_BENCH_MAX_SIZE);
+
+    MINFO("Streaming kernel: %s, streaming from %llu KiB", memory_get_streaming_kernel_name(), memory_get_streaming_threshold() / KIBIBYTES(1));
+    MINFO("size        | memcpy (GiB/s) | memory_copy (GiB/s) | memset (GiB/s) | memory_zero (GiB/s)");
+    for (u64 size = BANDWIDTH_BENCH_MIN_SIZE; size <= BANDWIDTH_BENCH_MAX_SIZE; size *= 4) {
+        f64 results[BANDWIDTH_BENCH_OP_COUNT];
+        for (u32 op = 0; op < BANDWIDTH_BENCH_OP_COUNT; ++op) {
+            results[op] = run_bandwidth_bench(op, dst, src, size);
+        }
+        const char* unit = size >= MEBIBYTES(1) ? "MiB" : size >= KIBIBYTES(1) ? "KiB" : "B";
+        u64 amount = size >= MEBIBYTES(1) ? size / MEBIBYTES(1) : size >= KIBIBYTES(1) ? size / KIBIBYTES(1) : size;
+        MINFO("%7llu %-3s | %14.2f | %19.2f | %14.2f | %19.2f", amount, unit,
+              results[BANDWIDTH_BENCH_LIBC_COPY], results[BANDWIDTH_BENCH_ENGINE_COPY],
+              results[BANDWIDTH_BENCH_LIBC_ZERO], results[BANDWIDTH_BENCH_ENGINE_ZERO]);
+    }
+
+    platform_memory_release(src, BANDWIDTH_BENCH_MAX_SIZE);
+    platform_memory_release(dst, BANDWIDTH_BENCH_MAX_SIZE);
+}
+
+void memory_register_benchmarks(void) {
+    benchmark_manager_register_benchmark(memory_benchmark_multithreaded_allocation, "Multi-threaded small allocation throughput");
+    benchmark_manager_register_benchmark(memory_benchmark_array_growth, "Bytes copied while growing arrays");
+    benchmark_manager_register_benchmark(memory_benchmark_scratch_strings, "Short-lived strings on the heap and in scratch arenas");
+    benchmark_manager_register_benchmark(memory_benchmark_allocation_overhead, "Dynamic allocator overhead per allocation");
+    benchmark_manager_register_benchmark(memory_benchmark_bandwidth, "Copy and zero bandwidth from 16 B to 256 MiB");
+    benchmark_manager_register_benchmark(memory_benchmark_huge_page_chase, "Pointer chasing across heap nodes on regular and huge pages");
+}
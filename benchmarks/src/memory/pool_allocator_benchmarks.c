@@ -0,0 +1,98 @@
+#include "pool_allocator_benchmarks.h"
+#include "../benchmark_manager.h"
+
+#include <containers/u64_bst.h>
+#include <core/logger.h>
+#include <memory/memory.h>
+#include <memory/allocators/dynamic_allocator.h>
+#include <memory/allocators/pool_allocator.h>
+#include <platform/platform.h>
+
+#define POOL_BENCH_OBJECTS 100000
+#define POOL_BENCH_ROUNDS 10
+#define POOL_BENCH_BST_KEYS 1000000
+
+static u32 xorshift32(u32* state) {
+    u32 x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+// Allocates and frees POOL_BENCH_OBJECTS BST sized objects per round and returns nanoseconds per allocate/free pair
+static f64 run_object_bench(pool_allocator* pool, void** objects) {
+    f64 start_time = platform_get_absolute_time();
+    for (u32 round = 0; round < POOL_BENCH_ROUNDS; ++round) {
+        for (u32 i = 0; i < POOL_BENCH_OBJECTS; ++i) {
+            objects[i] = pool ? pool_allocator_allocate(pool) : memory_allocate(sizeof(bst_node), MEMORY_TAG_BST);
+        }
+        for (u32 i = 0; i < POOL_BENCH_OBJECTS; ++i) {
+            if (pool) {
+                pool_allocator_free(pool, objects[i]);
+            } else {
+                memory_free(objects[i], sizeof(bst_node), MEMORY_TAG_BST);
+            }
+        }
+    }
+    f64 elapsed = platform_get_absolute_time() - start_time;
+    return elapsed * 1000000000.0 / ((f64)POOL_BENCH_OBJECTS * POOL_BENCH_ROUNDS);
+}
+
+// Inserts, looks up and clears POOL_BENCH_BST_KEYS random keys, returning the elapsed seconds
+static f64 run_bst_bench(frame_allocator_int* allocator) {
+    u32 seed = 0x1234567u;
+    f64 start_time = platform_get_absolute_time();
+
+    bst_node* root = nullptr;
+    for (u32 i = 0; i < POOL_BENCH_BST_KEYS; ++i) {
+        bst_node_value value;
+        value.u64 = i;
+        root = u64_bst_insert_with_allocator(root, xorshift32(&seed), value, allocator);
+    }
+    seed = 0x1234567u;
+    u64 found = 0;
+    for (u32 i = 0; i < POOL_BENCH_BST_KEYS; ++i) {
+        found += u64_bst_find(root, xorshift32(&seed)) != nullptr;
+    }
+    u64_bst_clear_with_allocator(root, allocator);
+
+    f64 elapsed = platform_get_absolute_time() - start_time;
+    if (found != POOL_BENCH_BST_KEYS) {
+        MERROR("BST lookups found %llu of %u keys.", found, POOL_BENCH_BST_KEYS);
+    }
+    return elapsed;
+}
+
+static void pool_allocator_benchmark_bst_nodes(void) {
+    void** objects = memory_allocate(sizeof(void*) * POOL_BENCH_OBJECTS, MEMORY_TAG_ENGINE);
+
+    pool_allocator pool;
+    pool_allocator_create(sizeof(bst_node), 8, 4096, POOL_ALLOCATOR_FLAG_NONE_BIT, &pool);
+    pool_allocator shared_pool;
+    pool_allocator_create(sizeof(bst_node), 8, 4096, POOL_ALLOCATOR_FLAG_THREAD_CACHE_BIT, &shared_pool);
+
+    MINFO("%llu B objects, %u allocations then %u frees, %u rounds", sizeof(bst_node), POOL_BENCH_OBJECTS, POOL_BENCH_OBJECTS, POOL_BENCH_ROUNDS);
+    MINFO("memory_allocate           | %6.1f ns per allocate/free", run_object_bench(nullptr, objects));
+    MINFO("pool                      | %6.1f ns per allocate/free", run_object_bench(&pool, objects));
+    MINFO("pool with thread caches   | %6.1f ns per allocate/free", run_object_bench(&shared_pool, objects));
+
+    // Small heap blocks are 16 byte aligned and carry the allocator header.
+    // Pool objects only carry their share of the chunk header
+    u64 heap_footprint = dynamic_allocator_block_footprint(sizeof(bst_node), 16);
+    MINFO("Bytes per node: heap %llu, pool %.2f", heap_footprint, (f64)pool.chunk_size / pool.objects_per_chunk);
+
+    frame_allocator_int pool_interface;
+    pool_allocator_get_interface(&pool, &pool_interface);
+    MINFO("u64_bst %u random keys insert/find/clear: memory_allocate %.3f sec, pool %.3f sec",
+        POOL_BENCH_BST_KEYS, run_bst_bench(nullptr), run_bst_bench(&pool_interface));
+
+    pool_allocator_destroy(&shared_pool);
+    pool_allocator_destroy(&pool);
+    memory_free(objects, sizeof(void*) * POOL_BENCH_OBJECTS, MEMORY_TAG_ENGINE);
+}
+
+void pool_allocator_register_benchmarks(void) {
+    benchmark_manager_register_benchmark(pool_allocator_benchmark_bst_nodes, "Pool allocator against the heap for BST nodes");
+}
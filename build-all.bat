@@ -15,4 +15,8 @@ REM Tests
 make -f "Makefile.tests.windows.mak" all
 IF %ERRORLEVEL% NEQ 0 (echo Error:%ERRORLEVEL% && exit)
 
+REM Benchmarks
+make -f "Makefile.benchmarks.windows.mak" all
+IF %ERRORLEVEL% NEQ 0 (echo Error:%ERRORLEVEL% && exit)
+
 ECHO "All assemblies built successfully."
\ No newline at end of file
@@ -15,4 +15,8 @@ REM Tests
 make -f "Makefile.tests.windows.mak" clean
 IF %ERRORLEVEL% NEQ 0 (echo Error:%ERRORLEVEL% && exit)
 
+REM Benchmarks
+make -f "Makefile.benchmarks.windows.mak" clean
+IF %ERRORLEVEL% NEQ 0 (echo Error:%ERRORLEVEL% && exit)
+
 ECHO "All assemblies cleaned successfully."
\ No newline at end of file
@@ -27,11 +27,11 @@ b8 game_initialize(game* instance) {
     return true;
 }
 
-b8 game_update(game* instance, f32 dt) {
+b8 game_update(game* instance, f32 dt, const frame_data* frame) {
     return true;
 }
 
-b8 game_render(game* instance, f32 dt) {
+b8 game_render(game* instance, f32 dt, const frame_data* frame) {
     return true;
 }
 
@@ -43,6 +43,8 @@ b8 create_game(game* out_game) {
     out_game->config.app_name = "My game";
     out_game->config.window_width = 900;
     out_game->config.window_height = 600;
+    out_game->config.frame_allocator_size = MEBIBYTES(8);
+    out_game->config.fragmentation_report_interval = 0;
 
     out_game->initialize = game_initialize;
     out_game->update = game_update;
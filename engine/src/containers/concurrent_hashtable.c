@@ -0,0 +1,120 @@
+#include "concurrent_hashtable.h"
+
+#include "core/hash.h"
+#include "memory/memory.h"
+#include "core/logger.h"
+
+#define SHARD_ALIGNMENT 64
+
+// The shard comes from the top bits of the hash, as the shard's own table indexes with the low bits
+static inline concurrent_hashtable_shard* shard_for(concurrent_hashtable* table, u64 key) {
+    return &table->shards[(hash_u64(key) >> 32) & (table->shard_count - 1)];
+}
+
+b8 concurrent_hashtable_create(u64 value_size, u32 element_count, u32 shard_count, concurrent_hashtable* out_table) {
+    if (!value_size || !element_count) {
+        MERROR("concurrent_hashtable_create - value_size and element_count must be a positive non-zero value!");
+        return false;
+    }
+
+    if (!out_table) {
+        MERROR("concurrent_hashtable_create - Required a valid pointer to out_table!");
+        return false;
+    }
+
+    u32 count = 1;
+    u32 requested = shard_count ? shard_count : CONCURRENT_HASHTABLE_DEFAULT_SHARD_COUNT;
+    while (count < requested && count < (1u << 16)) {
+        count *= 2;
+    }
+
+    memory_zero(out_table, sizeof(concurrent_hashtable));
+    out_table->value_size = value_size;
+    out_table->shard_count = count;
+    // Zeroed, so every shard starts unlocked
+    out_table->shards = memory_allocate_aligned(sizeof(concurrent_hashtable_shard) * count, SHARD_ALIGNMENT, MEMORY_TAG_HASHTABLE);
+    if (!out_table->shards) {
+        MERROR("concurrent_hashtable_create - Failed to allocate %u shards.", count);
+        return false;
+    }
+
+    // Sized so the keys fit without growing when they spread evenly
+    u32 shard_element_count = MMAX(element_count / count + element_count / (count * 4) + 1, 1u);
+    for (u32 i = 0; i < count; ++i) {
+        concurrent_hashtable_shard* shard = &out_table->shards[i];
+        if (!u64_hashtable_create(value_size, shard_element_count, &shard->table)) {
+            MERROR("concurrent_hashtable_create - Failed to create shard %u.", i);
+            out_table->shard_count = i + 1;
+            concurrent_hashtable_destroy(out_table);
+            return false;
+        }
+    }
+    return true;
+}
+
+void concurrent_hashtable_destroy(concurrent_hashtable* table) {
+    if (!table || !table->shards) {
+        return;
+    }
+
+    for (u32 i = 0; i < table->shard_count; ++i) {
+        concurrent_hashtable_shard* shard = &table->shards[i];
+        u64_hashtable_destroy(&shard->table);
+    }
+    memory_free_aligned(table->shards, sizeof(concurrent_hashtable_shard) * table->shard_count, SHARD_ALIGNMENT, MEMORY_TAG_HASHTABLE);
+    memory_zero(table, sizeof(concurrent_hashtable));
+}
+
+b8 concurrent_hashtable_set(concurrent_hashtable* table, u64 key, const void* value) {
+    concurrent_hashtable_shard* shard = shard_for(table, key);
+    spinlock_lock(&shard->lock);
+    b8 result = u64_hashtable_set(&shard->table, key, value);
+    spinlock_unlock(&shard->lock);
+    return result;
+}
+
+b8 concurrent_hashtable_get(concurrent_hashtable* table, u64 key, void* out_value) {
+    concurrent_hashtable_shard* shard = shard_for(table, key);
+    spinlock_lock(&shard->lock);
+    void* value = u64_hashtable_get(&shard->table, key);
+    if (value) {
+        memory_copy(out_value, value, table->value_size);
+    }
+    spinlock_unlock(&shard->lock);
+    return value != nullptr;
+}
+
+b8 concurrent_hashtable_remove(concurrent_hashtable* table, u64 key) {
+    concurrent_hashtable_shard* shard = shard_for(table, key);
+    spinlock_lock(&shard->lock);
+    b8 result = u64_hashtable_remove(&shard->table, key);
+    spinlock_unlock(&shard->lock);
+    return result;
+}
+
+b8 concurrent_hashtable_insert_if_absent(concurrent_hashtable* table, u64 key, const void* value, void* out_existing) {
+    concurrent_hashtable_shard* shard = shard_for(table, key);
+    spinlock_lock(&shard->lock);
+    b8 inserted = false;
+    void* existing = u64_hashtable_get(&shard->table, key);
+    if (existing) {
+        if (out_existing) {
+            memory_copy(out_existing, existing, table->value_size);
+        }
+    } else {
+        inserted = u64_hashtable_set(&shard->table, key, value);
+    }
+    spinlock_unlock(&shard->lock);
+    return inserted;
+}
+
+u64 concurrent_hashtable_count(concurrent_hashtable* table) {
+    u64 count = 0;
+    for (u32 i = 0; i < table->shard_count; ++i) {
+        concurrent_hashtable_shard* shard = &table->shards[i];
+        spinlock_lock(&shard->lock);
+        count += shard->table.count;
+        spinlock_unlock(&shard->lock);
+    }
+    return count;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "defines.h"
+#include "containers/u64_hashtable.h"
+#include "threads/spinlock.h"
+
+// Shards used when 0 is passed to concurrent_hashtable_create. Enough that threads on different keys rarely meet
+#define CONCURRENT_HASHTABLE_DEFAULT_SHARD_COUNT 64
+
+// One lock and table per shard, each on its own cache line so threads working in
+// different shards do not contend on the line holding the lock. The lock word lives in the
+// shard itself, as a platform mutex would be a separate heap block sharing lines with others
+typedef struct concurrent_hashtable_shard {
+    u64_hashtable table;
+    spinlock lock;
+    u8 padding[64 - sizeof(u64_hashtable) - sizeof(spinlock)];
+} concurrent_hashtable_shard;
+
+STATIC_ASSERT(sizeof(concurrent_hashtable_shard) == 64, "Expected a concurrent_hashtable_shard to fill one cache line.");
+
+// u64-keyed table safe to use from any number of threads. Keys are spread over lock-striped shards,
+// so operations on keys in different shards never wait on each other. Values are copied in and out
+// under the shard lock, as a pointer into a shard could be invalidated by another thread at any time
+typedef struct concurrent_hashtable {
+    u32 value_size;
+    // Always a power of two
+    u32 shard_count;
+    concurrent_hashtable_shard* shards;
+} concurrent_hashtable;
+
+// Creates a table holding element_count keys without growing. A shard_count of 0 uses the default,
+// other counts are rounded up to a power of two
+MAPI b8 concurrent_hashtable_create(u64 value_size, u32 element_count, u32 shard_count, concurrent_hashtable* out_table);
+
+// Must not race with any other use of the table
+MAPI void concurrent_hashtable_destroy(concurrent_hashtable* table);
+
+// Inserts the key or overwrites its value
+MAPI b8 concurrent_hashtable_set(concurrent_hashtable* table, u64 key, const void* value);
+
+// Copies the value of the key into out_value. Returns false when the key is not stored
+MAPI b8 concurrent_hashtable_get(concurrent_hashtable* table, u64 key, void* out_value);
+
+// Returns false when the key was not stored
+MAPI b8 concurrent_hashtable_remove(concurrent_hashtable* table, u64 key);
+
+// Inserts the key only if it is not stored yet, and returns true when this call inserted it. Otherwise the
+// stored value is copied into out_existing when it is not nullptr. Exactly one of several racing calls wins
+MAPI b8 concurrent_hashtable_insert_if_absent(concurrent_hashtable* table, u64 key, const void* value, void* out_existing);
+
+// Keys stored across all shards. Only a snapshot while other threads change the table
+MAPI u64 concurrent_hashtable_count(concurrent_hashtable* table);
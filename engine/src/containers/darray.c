@@ -6,24 +6,35 @@
 
 
 void* _darray_create(u64 length, u64 stride, struct frame_allocator_int* allocator) {
+    return _darray_create_with_flags(length, stride, DARRAY_FLAG_NONE_BIT, allocator);
+}
+
+void* _darray_create_with_flags(u64 length, u64 stride, darray_flags flags, struct frame_allocator_int* allocator) {
     if (length == 0) {
         MERROR("darray created with zero length!");
     }
 
     u64 header_size = sizeof(darray_header);
     u64 array_size = length * stride;
+    b8 zero = (flags & DARRAY_FLAG_UNINITIALIZED_BIT) == 0;
     void* new_array = nullptr;
     if (allocator) {
-        new_array = allocator->allocate(header_size + array_size);
-    } else {
+        new_array = allocator->allocate(allocator->context, header_size + array_size);
+        if (zero) {
+            memory_zero((u8*)new_array + header_size, array_size);
+        }
+    } else if (zero) {
+        // The heap already hands back zeroed memory
         new_array = memory_allocate(header_size + array_size, MEMORY_TAG_DARRAY);
+    } else {
+        new_array = memory_allocate_uninitialized(header_size + array_size, MEMORY_TAG_DARRAY);
     }
-    memory_zero(new_array, header_size + array_size);
 
     darray_header* header = (darray_header*)new_array;
     header->capacity = length;
     header->length = 0;
-    header->stride = stride;
+    header->stride = (u32)stride;
+    header->flags = flags;
     header->allocator = allocator;
 
     return (void*)((u8*)new_array + header_size);
@@ -33,7 +44,7 @@ void darray_destroy(void* arr) {
     darray_header* header = (darray_header*)((u8*)arr - sizeof(darray_header));
     u64 total_size = sizeof(darray_header) + header->capacity * header->stride;
     if (header->allocator) {
-        header->allocator->free(header, total_size);
+        header->allocator->free(header->allocator->context, header, total_size);
     } else {
         memory_free(header, total_size, MEMORY_TAG_DARRAY);
     }
@@ -42,7 +53,21 @@ void darray_destroy(void* arr) {
 void* darray_resize(void* arr, u64 size) {
     darray_header* header = (darray_header*)((u8*)arr - sizeof(darray_header));
 
-    void* temp = _darray_create(size, header->stride, header->allocator);
+    if (!header->allocator) {
+        // Reallocating lets the heap grow the array in place when the memory after it is free
+        u64 old_size = sizeof(darray_header) + header->capacity * header->stride;
+        u64 new_size = sizeof(darray_header) + size * header->stride;
+        if (header->flags & DARRAY_FLAG_UNINITIALIZED_BIT) {
+            header = memory_reallocate_uninitialized(header, old_size, new_size, MEMORY_TAG_DARRAY);
+        } else {
+            header = memory_reallocate(header, old_size, new_size, MEMORY_TAG_DARRAY);
+        }
+        header->capacity = size;
+        header->length = MMIN(header->length, size);
+        return (void*)((u8*)header + sizeof(darray_header));
+    }
+
+    void* temp = _darray_create_with_flags(size, header->stride, header->flags, header->allocator);
 
     darray_header* new_header = (darray_header*)((u8*)temp - sizeof(darray_header));
     new_header->length = header->length;
@@ -53,6 +78,16 @@ void* darray_resize(void* arr, u64 size) {
     return temp;
 }
 
+// Grows the array once so it holds at least required elements, doubling when that is larger
+static void* ensure_capacity(void* arr, u64 required) {
+    darray_header* header = (darray_header*)((u8*)arr - sizeof(darray_header));
+    if (required <= header->capacity) {
+        return arr;
+    }
+    u64 grown = header->capacity * DARRAY_RESIZE_FACTOR;
+    return darray_resize(arr, MMAX(required, grown));
+}
+
 void* _darray_push(void* arr, const void* value_ptr) {
     darray_header* header = (darray_header*)((u8*)arr - sizeof(darray_header));
     if (header->length >= header->capacity) {
@@ -98,7 +133,7 @@ void* _darray_insert_at(void* arr, u64 index, void* value_ptr) {
     }
 
     u64 addr = (u64)arr;
-    memory_copy(
+    memory_move(
         (void*)(addr + ((index + 1) * header->stride)),
         (void*)(addr + (index * header->stride)),
         header->stride * (header->length - index)
@@ -130,7 +165,7 @@ void darray_pop_at(void* arr, u64 index, void* dst) {
     }
 
     if (index != header->length - 1) {
-        memory_copy(
+        memory_move(
             (void*)(addr + (index * header->stride)),
             (void*)(addr + ((index + 1) * header->stride)),
             header->stride * (header->length - (index + 1))
@@ -140,14 +175,108 @@ void darray_pop_at(void* arr, u64 index, void* dst) {
     header->length--;
 }
 
+void* _darray_append_range(void* arr, const void* values, u64 count) {
+    if (!count) {
+        return arr;
+    }
+
+    darray_header* header = (darray_header*)((u8*)arr - sizeof(darray_header));
+    arr = ensure_capacity(arr, header->length + count);
+    header = (darray_header*)((u8*)arr - sizeof(darray_header));
+
+    memory_copy((u8*)arr + header->length * header->stride, values, count * header->stride);
+    header->length += count;
+    return arr;
+}
+
+void* _darray_insert_range(void* arr, u64 index, const void* values, u64 count) {
+    darray_header* header = (darray_header*)((u8*)arr - sizeof(darray_header));
+
+    if (index > header->length) {
+        MERROR("darray_insert_range - Index outside the bounds of this array! Length: %llu, index: %llu", header->length, index);
+        return arr;
+    }
+
+    if (!count) {
+        return arr;
+    }
+
+    arr = ensure_capacity(arr, header->length + count);
+    header = (darray_header*)((u8*)arr - sizeof(darray_header));
+
+    u8* at = (u8*)arr + index * header->stride;
+    memory_move(at + count * header->stride, at, (header->length - index) * header->stride);
+    memory_copy(at, values, count * header->stride);
+    header->length += count;
+    return arr;
+}
+
+void darray_swap_remove(void* arr, u64 index, void* dst) {
+    darray_header* header = (darray_header*)((u8*)arr - sizeof(darray_header));
+
+    if (index >= header->length) {
+        MERROR("darray_swap_remove - Index outside of the bounds of this array! Length: %llu, index: %llu", header->length, index);
+        return;
+    }
+
+    u8* slot = (u8*)arr + index * header->stride;
+    if (dst) {
+        memory_copy(dst, slot, header->stride);
+    }
+
+    header->length--;
+    if (index != header->length) {
+        memory_copy(slot, (u8*)arr + header->length * header->stride, header->stride);
+    }
+}
+
+void darray_remove_range(void* arr, u64 index, u64 count) {
+    darray_header* header = (darray_header*)((u8*)arr - sizeof(darray_header));
+
+    if (index > header->length || count > header->length - index) {
+        MERROR("darray_remove_range - Range outside of the bounds of this array! Length: %llu, index: %llu, count: %llu", header->length, index, count);
+        return;
+    }
+
+    u8* at = (u8*)arr + index * header->stride;
+    memory_move(at, at + count * header->stride, (header->length - index - count) * header->stride);
+    header->length -= count;
+}
+
+u64 darray_remove_if(void* arr, b8 (*predicate)(const void* element, void* context), void* context) {
+    darray_header* header = (darray_header*)((u8*)arr - sizeof(darray_header));
+    u64 stride = header->stride;
+
+    // Runs of kept elements are moved down together once the first removal opens a gap
+    u64 kept = 0;
+    u64 run_start = 0;
+    for (u64 i = 0; i < header->length; ++i) {
+        if (predicate((u8*)arr + i * stride, context)) {
+            if (kept != run_start) {
+                memory_move((u8*)arr + kept * stride, (u8*)arr + run_start * stride, (i - run_start) * stride);
+            }
+            kept += i - run_start;
+            run_start = i + 1;
+        }
+    }
+    if (kept != run_start) {
+        memory_move((u8*)arr + kept * stride, (u8*)arr + run_start * stride, (header->length - run_start) * stride);
+    }
+    kept += header->length - run_start;
+
+    u64 removed = header->length - kept;
+    header->length = kept;
+    return removed;
+}
+
 void* darray_duplicate(void* arr) {
     darray_header* src_header = (darray_header*)((u8*)arr - sizeof(darray_header));
 
-    void* copy = _darray_create(src_header->capacity, src_header->stride, src_header->allocator);
+    // Every slot is overwritten by the copy below, so skip zeroing it first
+    void* copy = _darray_create_with_flags(src_header->capacity, src_header->stride, src_header->flags | DARRAY_FLAG_UNINITIALIZED_BIT, src_header->allocator);
     darray_header* dst_header = (darray_header*)((u8*)copy - sizeof(darray_header));
-    dst_header->stride = src_header->stride;
     dst_header->length = src_header->length;
-    dst_header->allocator = src_header->allocator;
+    dst_header->flags = src_header->flags;
 
     memory_copy(copy, arr, dst_header->capacity * dst_header->stride);
 
@@ -175,6 +304,11 @@ u64 darray_stride(void* arr) {
     return header->stride;
 }
 
+darray_flags darray_get_flags(void* arr) {
+    darray_header* header = (darray_header*)((u8*)arr - sizeof(darray_header));
+    return header->flags;
+}
+
 
 void _kdarray_init(u32 length, u32 stride, u32 capacity, struct frame_allocator_int* allocator, u32* out_length, u32* out_stride, u32* out_capacity, void** block, struct frame_allocator_int** out_allocator) {
     *out_length = length;
@@ -182,15 +316,16 @@ void _kdarray_init(u32 length, u32 stride, u32 capacity, struct frame_allocator_
     *out_capacity = capacity;
     *out_allocator = allocator;
     if (allocator) {
-        *block = allocator->allocate(capacity * stride);
+        *block = allocator->allocate(allocator->context, capacity * stride);
     } else {
-        *block = memory_allocate(capacity * stride, MEMORY_TAG_DARRAY);
+        // Typed arrays always write a slot before reading it, so the storage is not zeroed
+        *block = memory_allocate_uninitialized(capacity * stride, MEMORY_TAG_DARRAY);
     }
 }
 
 void _kdarray_free(u32* length, u32* capacity, u32* stride, void** block, struct frame_allocator_int** out_allocator) {
     if (*out_allocator) {
-        (*out_allocator)->free(*block, (*capacity) * (*stride));
+        (*out_allocator)->free((*out_allocator)->context, *block, (*capacity) * (*stride));
     } else {
         memory_free(*block, (*capacity) * (*stride), MEMORY_TAG_DARRAY);
     }
@@ -205,18 +340,41 @@ void _kdarray_ensure_size(u32 required_length, u32 stride, u32* out_capacity, st
     if (required_length > *out_capacity) {
         u32 new_capacity = MMAX(required_length, (*out_capacity) * DARRAY_RESIZE_FACTOR);
         if (allocator) {
-            void* new_block = allocator->allocate(new_capacity * stride);
+            void* new_block = allocator->allocate(allocator->context, new_capacity * stride);
             memory_copy(new_block, *block, (*out_capacity) * stride);
-            allocator->free(*block, (*out_capacity) * stride);
+            allocator->free(allocator->context, *block, (*out_capacity) * stride);
             *block = new_block;
         } else {
-            *block = memory_reallocate(*block, (*out_capacity) * stride, new_capacity * stride, MEMORY_TAG_DARRAY);
+            *block = memory_reallocate_uninitialized(*block, (*out_capacity) * stride, new_capacity * stride, MEMORY_TAG_DARRAY);
         }
         *base_block = *block;
         *out_capacity = new_capacity;
     }
 }
 
+void _kdarray_insert_range(u32 index, const void* values, u32 count, u32* length, u32 stride, u32* out_capacity, struct frame_allocator_int* allocator, void** block, void** base_block) {
+    if (!count) {
+        return;
+    }
+
+    _kdarray_ensure_size(*length + count, stride, out_capacity, allocator, block, base_block);
+    u8* at = (u8*)*block + (u64)index * stride;
+    if (index < *length) {
+        memory_move(at + (u64)count * stride, at, (u64)(*length - index) * stride);
+    }
+    memory_copy(at, values, (u64)count * stride);
+    *length += count;
+}
+
+void _kdarray_remove_range(u32 index, u32 count, u32* length, u32 stride, void* block) {
+    u8* at = (u8*)block + (u64)index * stride;
+    u32 tail = *length - index - count;
+    if (tail) {
+        memory_move(at, at + (u64)count * stride, (u64)tail * stride);
+    }
+    *length -= count;
+}
+
 darray_iterator darray_iterator_begin(darray_base* arr) {
     darray_iterator it;
     it.arr = arr;
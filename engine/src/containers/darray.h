@@ -4,19 +4,36 @@
 
 struct frame_allocator_int;
 
+typedef enum darray_flag_bits {
+    DARRAY_FLAG_NONE_BIT = 0x00,
+    // Slots past the length are left uninitialized on create and on growth instead of being zeroed
+    DARRAY_FLAG_UNINITIALIZED_BIT = 0x01
+} darray_flag_bits;
+
+typedef u32 darray_flags;
+
 typedef struct darray_header {
     u64 capacity;
     u64 length;
-    u64 stride;
+    u32 stride;
+    darray_flags flags;
     struct frame_allocator_int* allocator;
 } darray_header;
 
 MAPI void* _darray_create(u64 length, u64 stride, struct frame_allocator_int* allocator);
 
+MAPI void* _darray_create_with_flags(u64 length, u64 stride, darray_flags flags, struct frame_allocator_int* allocator);
+
 MAPI void* _darray_push(void* arr, const void* value_ptr);
 
 MAPI void* _darray_insert_at(void* arr, u64 index, void* value_ptr);
 
+// Appends count elements with a single copy, growing the array at most once
+MAPI void* _darray_append_range(void* arr, const void* values, u64 count);
+
+// Inserts count elements before index, which may be the length to append
+MAPI void* _darray_insert_range(void* arr, u64 index, const void* values, u64 count);
+
 MAPI void* darray_duplicate(void* arr);
 
 #define DARRAY_DEFAULT_CAPACITY 1
@@ -30,6 +47,10 @@ MAPI void* darray_duplicate(void* arr);
 
 #define darray_reserve_with_allocator(type, capacity, allocator) _darray_create(capacity, sizeof(type), allocator)
 
+#define darray_create_with_flags(type, flags) _darray_create_with_flags(DARRAY_DEFAULT_CAPACITY, sizeof(type), flags, nullptr)
+
+#define darray_reserve_with_flags(type, capacity, flags) _darray_create_with_flags(capacity, sizeof(type), flags, nullptr)
+
 MAPI void darray_destroy(void* arr);
 
 #define darray_push(arr, value) \
@@ -42,6 +63,26 @@ MAPI void darray_pop(void* arr, void* dst);
 
 MAPI void darray_pop_at(void* arr, u64 index, void* dst);
 
+// Removes the element at index in O(1) by moving the last element into its slot, so the order is not kept
+MAPI void darray_swap_remove(void* arr, u64 index, void* dst);
+
+// Removes count elements starting at index, shifting the rest down once
+MAPI void darray_remove_range(void* arr, u64 index, u64 count);
+
+// Removes every element the predicate returns true for in a single pass, keeping the order of the rest.
+// Returns the number of elements removed
+MAPI u64 darray_remove_if(void* arr, b8 (*predicate)(const void* element, void* context), void* context);
+
+#define darray_append_range(arr, values, count) \
+    { \
+        arr = _darray_append_range(arr, values, count); \
+    }
+
+#define darray_insert_range(arr, index, values, count) \
+    { \
+        arr = _darray_insert_range(arr, index, values, count); \
+    }
+
 #define darray_insert_at(arr, index, value) \
     { \
         typeof(value) __tmp_value__ = value; \
@@ -58,11 +99,17 @@ MAPI u64 darray_length(void* arr);
 
 MAPI u64 darray_stride(void* arr);
 
+MAPI darray_flags darray_get_flags(void* arr);
+
 // New darray
 
 MAPI void _kdarray_init(u32 length, u32 stride, u32 capacity, struct frame_allocator_int* allocator, u32* out_length, u32* out_stride, u32* out_capacity, void** block, struct frame_allocator_int** out_allocator);
 MAPI void _kdarray_free(u32* length, u32* capacity, u32* stride, void** block, struct frame_allocator_int** out_allocator);
 MAPI void _kdarray_ensure_size(u32 required_length, u32 stride, u32* out_capacity, struct frame_allocator_int* allocator, void** block, void** base_block);
+// Opens a gap of count elements before index and copies the values into it. index must not exceed the length
+MAPI void _kdarray_insert_range(u32 index, const void* values, u32 count, u32* length, u32 stride, u32* out_capacity, struct frame_allocator_int* allocator, void** block, void** base_block);
+// Closes the gap left by count elements starting at index. The range must be within the length
+MAPI void _kdarray_remove_range(u32 index, u32 count, u32* length, u32 stride, void* block);
 
 typedef struct darray_base {
     u32 length;
@@ -154,26 +201,63 @@ MAPI void darray_iterator_prev(darray_iterator* it);
             return false;                                                                                                                                                   \
         }                                                                                                                                                                   \
         *out_value = arr->data[index];                                                                                                                                      \
-        for (u32 i = index; i < arr->base.length; ++i) {                                                                                                                    \
-            arr->data[i] = arr->data[i + 1];                                                                                                                                \
+        _kdarray_remove_range(index, 1, &arr->base.length, arr->base.stride, arr->data);                                                                                    \
+        return true;                                                                                                                                                        \
+    }                                                                                                                                                                       \
+                                                                                                                                                                            \
+    MINLINE b8 darray_##name##_insert_range(darray_##name* arr, u32 index, const type* values, u32 count) {                                                                 \
+        if (index > arr->base.length) {                                                                                                                                     \
+            return false;                                                                                                                                                   \
         }                                                                                                                                                                   \
-        arr->base.length--;                                                                                                                                                 \
+        _kdarray_insert_range(index, values, count, &arr->base.length, arr->base.stride, &arr->base.capacity,                                                               \
+                              arr->base.allocator, (void**)&arr->data, (void**)&arr->base.p_data);                                                                          \
         return true;                                                                                                                                                        \
     }                                                                                                                                                                       \
                                                                                                                                                                             \
     MINLINE b8 darray_##name##_insert_at(darray_##name* arr, u32 index, type data) {                                                                                        \
-        if (index > arr->base.length) {                                                                                                                                     \
+        return darray_##name##_insert_range(arr, index, &data, 1);                                                                                                          \
+    }                                                                                                                                                                       \
+                                                                                                                                                                            \
+    MINLINE darray_##name* darray_##name##_append_range(darray_##name* arr, const type* values, u32 count) {                                                                \
+        darray_##name##_insert_range(arr, arr->base.length, values, count);                                                                                                 \
+        return arr;                                                                                                                                                         \
+    }                                                                                                                                                                       \
+                                                                                                                                                                            \
+    MINLINE b8 darray_##name##_swap_remove(darray_##name* arr, u32 index, type* out_value) {                                                                                \
+        if (index >= arr->base.length) {                                                                                                                                    \
             return false;                                                                                                                                                   \
         }                                                                                                                                                                   \
-        _kdarray_ensure_size(arr->base.length + 1, arr->base.stride, &arr->base.capacity, arr->base.allocator, (void**)&arr->data, (void**)&arr->base.p_data);              \
-        arr->base.length++;                                                                                                                                                 \
-        for (u32 i = arr->base.length; i > index; --i) {                                                                                                                    \
-            arr->data[i] = arr->data[i - 1];                                                                                                                                \
+        if (out_value) {                                                                                                                                                    \
+            *out_value = arr->data[index];                                                                                                                                  \
+        }                                                                                                                                                                   \
+        arr->base.length--;                                                                                                                                                 \
+        arr->data[index] = arr->data[arr->base.length];                                                                                                                     \
+        return true;                                                                                                                                                        \
+    }                                                                                                                                                                       \
+                                                                                                                                                                            \
+    MINLINE b8 darray_##name##_remove_range(darray_##name* arr, u32 index, u32 count) {                                                                                     \
+        if (index > arr->base.length || count > arr->base.length - index) {                                                                                                 \
+            return false;                                                                                                                                                   \
         }                                                                                                                                                                   \
-        arr->data[index] = data;                                                                                                                                            \
+        _kdarray_remove_range(index, count, &arr->base.length, arr->base.stride, arr->data);                                                                                \
         return true;                                                                                                                                                        \
     }                                                                                                                                                                       \
                                                                                                                                                                             \
+    MINLINE u32 darray_##name##_remove_if(darray_##name* arr, b8 (*predicate)(const type* value, void* context), void* context) {                                           \
+        u32 kept = 0;                                                                                                                                                       \
+        for (u32 i = 0; i < arr->base.length; ++i) {                                                                                                                        \
+            if (!predicate(&arr->data[i], context)) {                                                                                                                       \
+                if (kept != i) {                                                                                                                                            \
+                    arr->data[kept] = arr->data[i];                                                                                                                         \
+                }                                                                                                                                                           \
+                kept++;                                                                                                                                                     \
+            }                                                                                                                                                               \
+        }                                                                                                                                                                   \
+        u32 removed = arr->base.length - kept;                                                                                                                              \
+        arr->base.length = kept;                                                                                                                                            \
+        return removed;                                                                                                                                                     \
+    }                                                                                                                                                                       \
+                                                                                                                                                                            \
     MINLINE darray_##name* darray_##name##_clear(darray_##name* arr) {                                                                                                      \
         arr->base.length = 0;                                                                                                                                               \
         return arr;                                                                                                                                                         \
@@ -3,29 +3,258 @@
 #include "memory/memory.h"
 #include "core/logger.h"
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// One size class per power of two. A free range of size s lives in bin floor(log2(s))
+#define FREELIST_BIN_COUNT FREELIST_SIZE_CLASS_COUNT
+
 typedef struct freelist_node {
     u64 offset;
     u64 size;
+    // Neighbouring free ranges in address order. Unused nodes are stacked through next
     struct freelist_node* next;
+    struct freelist_node* prev;
+    // Neighbouring free ranges of the same size class
+    struct freelist_node* bin_next;
+    struct freelist_node* bin_prev;
+    // Children in the offset ordered treap used to find where a freed block goes
+    struct freelist_node* left;
+    struct freelist_node* right;
 } freelist_node;
 
 typedef struct internal_state {
     u64 total_size;
     u64 max_entries;
+    // Nodes at and above this index have never been handed out, so the
+    // node array doesn't need to be zeroed (and paged in) up front
+    u64 nodes_high_water;
+    freelist_flags flags;
+    u64 free_space;
     freelist_node* head;
+    freelist_node* root;
+    // Nodes returned by merges and exact fits, reused before touching the high water mark
+    freelist_node* unused_nodes;
+    // Bit i is set when bins[i] holds at least one range
+    u64 bin_mask;
+    freelist_node* bins[FREELIST_BIN_COUNT];
+    u64 bin_counts[FREELIST_BIN_COUNT];
     freelist_node* nodes;
 } internal_state;
 
-static freelist_node* get_node(freelist* list);
-static void return_node(freelist_node* node);
+static freelist_node* get_node(internal_state* state);
+static void return_node(internal_state* state, freelist_node* node);
 
+MINLINE u32 bin_index(u64 size) {
+    if (size == 0) {
+        return 0;
+    }
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse64(&index, size);
+    return (u32)index;
+#else
+    return 63 - (u32)__builtin_clzll(size);
+#endif
+}
 
-void freelist_create(u64 total_size, u64* memory_requirement, void* memory, freelist* out_list) {
+MINLINE u32 lowest_bit(u64 mask) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, mask);
+    return (u32)index;
+#else
+    return (u32)__builtin_ctzll(mask);
+#endif
+}
+
+static void bin_insert(internal_state* state, freelist_node* node) {
+    u32 bin = bin_index(node->size);
+    node->bin_prev = nullptr;
+    node->bin_next = state->bins[bin];
+    if (node->bin_next) {
+        node->bin_next->bin_prev = node;
+    }
+    state->bins[bin] = node;
+    state->bin_mask |= (u64)1 << bin;
+    state->bin_counts[bin]++;
+}
+
+static void bin_remove(internal_state* state, freelist_node* node) {
+    u32 bin = bin_index(node->size);
+    if (node->bin_prev) {
+        node->bin_prev->bin_next = node->bin_next;
+    } else {
+        state->bins[bin] = node->bin_next;
+        if (!state->bins[bin]) {
+            state->bin_mask &= ~((u64)1 << bin);
+        }
+    }
+    if (node->bin_next) {
+        node->bin_next->bin_prev = node->bin_prev;
+    }
+    node->bin_next = nullptr;
+    node->bin_prev = nullptr;
+    state->bin_counts[bin]--;
+}
+
+// Treap priorities are derived from the node address, so they cost no storage
+MINLINE u32 node_priority(freelist_node* node) {
+    u64 x = (u64)node;
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdull;
+    x ^= x >> 33;
+    return (u32)x;
+}
+
+static void tree_insert(internal_state* state, freelist_node* node) {
+    u32 priority = node_priority(node);
+    freelist_node** link = &state->root;
+    while (*link && node_priority(*link) >= priority) {
+        link = node->offset < (*link)->offset ? &(*link)->left : &(*link)->right;
+    }
+
+    // Split the subtree the node takes over around its offset
+    freelist_node* subtree = *link;
+    freelist_node** left = &node->left;
+    freelist_node** right = &node->right;
+    while (subtree) {
+        if (subtree->offset < node->offset) {
+            *left = subtree;
+            left = &subtree->right;
+            subtree = subtree->right;
+        } else {
+            *right = subtree;
+            right = &subtree->left;
+            subtree = subtree->left;
+        }
+    }
+    *left = nullptr;
+    *right = nullptr;
+    *link = node;
+}
+
+static void tree_remove(internal_state* state, freelist_node* node) {
+    freelist_node** link = &state->root;
+    while (*link != node) {
+        link = node->offset < (*link)->offset ? &(*link)->left : &(*link)->right;
+    }
+
+    // Merge the children in place of the node. Everything on the left is below everything on the right
+    freelist_node* left = node->left;
+    freelist_node* right = node->right;
+    while (left && right) {
+        if (node_priority(left) > node_priority(right)) {
+            *link = left;
+            link = &left->right;
+            left = left->right;
+        } else {
+            *link = right;
+            link = &right->left;
+            right = right->left;
+        }
+    }
+    *link = left ? left : right;
+    node->left = nullptr;
+    node->right = nullptr;
+}
+
+// Finds the last free range starting before offset
+static freelist_node* tree_find_previous(internal_state* state, u64 offset) {
+    freelist_node* previous = nullptr;
+    freelist_node* node = state->root;
+    while (node) {
+        if (node->offset < offset) {
+            previous = node;
+            node = node->right;
+        } else {
+            node = node->left;
+        }
+    }
+    return previous;
+}
+
+// Updates the range of a free node, moving it to its new size class.
+// Ranges never overlap, so the node keeps its place in address order
+static void set_node_range(internal_state* state, freelist_node* node, u64 offset, u64 size) {
+    bin_remove(state, node);
+    node->offset = offset;
+    node->size = size;
+    bin_insert(state, node);
+}
+
+// Links a new free range after previous in address order, or at the head if previous is null
+static void insert_free_node(internal_state* state, freelist_node* previous, freelist_node* node) {
+    node->prev = previous;
+    node->next = previous ? previous->next : state->head;
+    if (node->next) {
+        node->next->prev = node;
+    }
+    if (previous) {
+        previous->next = node;
+    } else {
+        state->head = node;
+    }
+    bin_insert(state, node);
+    tree_insert(state, node);
+}
+
+static void remove_free_node(internal_state* state, freelist_node* node) {
+    bin_remove(state, node);
+    tree_remove(state, node);
+    if (node->prev) {
+        node->prev->next = node->next;
+    } else {
+        state->head = node->next;
+    }
+    if (node->next) {
+        node->next->prev = node->prev;
+    }
+    return_node(state, node);
+}
+
+static u64 get_max_entries(u64 total_size) {
     u64 max_entries = (total_size / (sizeof(void*) * sizeof(freelist_node)));
 
     if (max_entries < 20) {
         max_entries = 20;
     }
+    return max_entries;
+}
+
+// Sets up an empty state in memory. The caller adds the free ranges
+static internal_state* reset_state(void* memory, u64 total_size, u64 max_entries, freelist_flags flags) {
+    memory_zero(memory, sizeof(internal_state));
+    internal_state* state = memory;
+    state->nodes = (void*)(memory + sizeof(internal_state));
+    state->max_entries = max_entries;
+    state->total_size = total_size;
+    state->flags = flags;
+    state->nodes_high_water = 0;
+    return state;
+}
+
+// Appends a free range at the end of the address order, merging it with the last range if they touch
+static void append_free_range(internal_state* state, freelist_node** tail, u64 offset, u64 size) {
+    if (*tail && (*tail)->offset + (*tail)->size == offset) {
+        set_node_range(state, *tail, (*tail)->offset, (*tail)->size + size);
+    } else {
+        freelist_node* node = get_node(state);
+        node->offset = offset;
+        node->size = size;
+        insert_free_node(state, *tail, node);
+        *tail = node;
+    }
+    state->free_space += size;
+}
+
+void freelist_create(u64 total_size, u64* memory_requirement, void* memory, freelist* out_list) {
+    freelist_create_with_flags(total_size, FREELIST_FLAG_NONE_BIT, memory_requirement, memory, out_list);
+}
+
+void freelist_create_with_flags(u64 total_size, freelist_flags flags, u64* memory_requirement, void* memory, freelist* out_list) {
+    u64 max_entries = get_max_entries(total_size);
 
     *memory_requirement = sizeof(internal_state) + (sizeof(freelist_node) * max_entries);
     if (!memory) {
@@ -34,160 +263,211 @@ void freelist_create(u64 total_size, u64* memory_requirement, void* memory, free
 
     out_list->memory = memory;
 
-    memory_zero(out_list->memory, *memory_requirement);
-    internal_state* state = out_list->memory;
-    state->nodes = (void*)(out_list->memory + sizeof(internal_state));
-    state->max_entries = max_entries;
-    state->total_size = total_size;
-
-    memory_zero(state->nodes, sizeof(freelist_node) * state->max_entries);
-
-    state->head = &state->nodes[0];
-    state->head->offset = 0;
-    state->head->size = total_size;
-    state->head->next = nullptr;
+    internal_state* state = reset_state(out_list->memory, total_size, max_entries, flags);
+    freelist_node* tail = nullptr;
+    append_free_range(state, &tail, 0, total_size);
 }
 
 void freelist_destroy(freelist* list) {
     if (list && list->memory) {
         internal_state* state = list->memory;
-        memory_zero(list->memory, sizeof(internal_state) + sizeof(freelist_node) * state->max_entries);
+        memory_zero(list->memory, sizeof(internal_state) + sizeof(freelist_node) * state->nodes_high_water);
         list->memory = nullptr;
     }
 }
 
+// Finds the lowest addressed range that fits
+static freelist_node* find_first_fit(internal_state* state, u64 size) {
+    freelist_node* node = state->head;
+    while (node && node->size < size) {
+        node = node->next;
+    }
+    return node;
+}
+
+// Finds the tightest range in the size class of the request. Failing that, every range
+// of a larger class fits, so the first one of the smallest non-empty class is taken
+static freelist_node* find_best_fit(internal_state* state, u64 size) {
+    u32 bin = bin_index(size);
+    freelist_node* best = nullptr;
+    for (freelist_node* node = state->bins[bin]; node; node = node->bin_next) {
+        if (node->size >= size && (!best || node->size < best->size)) {
+            best = node;
+            if (node->size == size) {
+                break;
+            }
+        }
+    }
+    if (best) {
+        return best;
+    }
+
+    u64 larger_bins = bin + 1 < FREELIST_BIN_COUNT ? state->bin_mask & (~(u64)0 << (bin + 1)) : 0;
+    if (larger_bins) {
+        return state->bins[lowest_bit(larger_bins)];
+    }
+    return nullptr;
+}
+
 b8 freelist_allocate_block(freelist* list, u64 size, u64* out_offset) {
     if (!list || !out_offset || !list->memory) {
         return false;
     }
 
     internal_state* state = list->memory;
-    freelist_node* node = state->head;
-    freelist_node* previous = nullptr;
-    while (node) {
+    freelist_node* node = (state->flags & FREELIST_FLAG_BEST_FIT_BIT) ? find_best_fit(state, size) : find_first_fit(state, size);
+    if (node) {
+        *out_offset = node->offset;
         if (node->size == size) {
-            // Exact match. Just return the node
-            *out_offset = node->offset;
-            freelist_node* node_to_return = nullptr;
-            if (previous) {
-                previous->next = node->next;
-                node_to_return = node;
-            } else {
-                // This node is the head of the list. Reassgn the head
-                // and return the previous head node
-                node_to_return = state->head;
-                state->head = node->next;
-            }
-            return_node(node_to_return);
-            return true;
-        } else if (node->size > size) {
-            // Node is larger. Deduct the memory from it and movev the offset by that amount
-            *out_offset = node->offset;
-            node->size -= size;
-            node->offset += size;
+            // Exact match. The whole range is taken
+            remove_free_node(state, node);
+        } else {
+            // Node is larger. Deduct the memory from it and move the offset by that amount
+            set_node_range(state, node, node->offset + size, node->size - size);
+        }
+        state->free_space -= size;
+        return true;
+    }
+
+    MWARN("freelist_find_block, no block with enough free space found (requested: %lluB, available: %lluB)", size, state->free_space);
+    return false;
+}
+
+// Finds the lowest addressed range that holds the block at an aligned offset
+static freelist_node* find_aligned_fit(internal_state* state, u64 size, u64 alignment, u64* out_offset) {
+    for (freelist_node* node = state->head; node; node = node->next) {
+        u64 offset = get_aligned(node->offset, alignment);
+        if (offset - node->offset < node->size && node->size - (offset - node->offset) >= size) {
+            *out_offset = offset;
+            return node;
+        }
+    }
+    return nullptr;
+}
+
+b8 freelist_allocate_block_aligned(freelist* list, u64 size, u64 alignment, u64* out_offset) {
+    if (alignment <= 1) {
+        return freelist_allocate_block(list, size, out_offset);
+    }
+
+    if (!list || !out_offset || !list->memory) {
+        return false;
+    }
+
+    // Any range of the size plus the worst case padding holds the block, and the size classes find one quickly.
+    // A smaller range can still hold it when it starts close enough to an aligned offset, such as a range sized
+    // exactly for the block, so those are searched in address order before giving up
+    internal_state* state = list->memory;
+    u64 padded_size = size + alignment - 1;
+    freelist_node* padded = (state->flags & FREELIST_FLAG_BEST_FIT_BIT) ? find_best_fit(state, padded_size) : find_first_fit(state, padded_size);
+    if (!padded) {
+        u64 offset = 0;
+        if (find_aligned_fit(state, size, alignment, &offset) && freelist_allocate_block_at(list, size, offset)) {
+            *out_offset = offset;
             return true;
         }
+        MWARN("freelist_allocate_block_aligned, no block with enough free space found (requested: %lluB aligned to %llu, available: %lluB)", size, alignment, state->free_space);
+        return false;
+    }
 
-        previous = node;
-        node = node->next;
+    u64 range_offset = 0;
+    if (!freelist_allocate_block(list, padded_size, &range_offset)) {
+        return false;
     }
 
-    u64 free_space = freelist_free_space(list);
-    MWARN("freelist_find_block, no block with enough free space found (requested: %lluB, available: %lluB)", size, free_space);
-    return false;
+    // Give back what lies before and after the aligned block. The tail touches the rest of the range it came
+    // from, so it merges back. The head may need a node of its own, and stays allocated if none is left
+    u64 offset = get_aligned(range_offset, alignment);
+    u64 tail_offset = offset + size;
+    u64 tail_size = range_offset + padded_size - tail_offset;
+    if (tail_size) {
+        freelist_free_block(list, tail_size, tail_offset);
+    }
+    if (offset > range_offset) {
+        freelist_free_block(list, offset - range_offset, range_offset);
+    }
+
+    *out_offset = offset;
+    return true;
 }
 
-b8 freelist_free_block(freelist* list, u64 size, u64 offset) {
+b8 freelist_allocate_block_at(freelist* list, u64 size, u64 offset) {
     if (!list || !list->memory || !size) {
         return false;
     }
 
     internal_state* state = list->memory;
-    freelist_node* node = state->head;
-    freelist_node* previous = nullptr;
+    // The only range that can hold the block is the last one starting at or before it
+    freelist_node* node = tree_find_previous(state, offset + 1);
+    if (!node || node->offset + node->size < offset + size) {
+        return false;
+    }
 
-    if (!node) {
-        // Check for the case where the entire thing is allocated
-        // In this case a new node is needed at the head
-        freelist_node* new_node = get_node(list);
-        new_node->offset = offset;
-        new_node->size = size;
-        new_node->next = nullptr;
-        state->head = new_node;
-        return true;
+    u64 end = node->offset + node->size;
+    if (node->offset == offset && node->size == size) {
+        remove_free_node(state, node);
+    } else if (node->offset == offset) {
+        set_node_range(state, node, offset + size, node->size - size);
+    } else if (end == offset + size) {
+        set_node_range(state, node, node->offset, node->size - size);
     } else {
-        while (node) {
-            if (node->offset + node->size == offset) {
-                // Can be appended to the rigth of this node
-                node->size += size;
-
-                // Check if this then connects the range between this and the next
-                // node, and if so, combine them and return the second node
-                if (node->next && node->next->offset == node->offset + node->size) {
-                    node->size += node->next->size;
-                    freelist_node* next = node->next;
-                    node->next = node->next->next;
-                    return_node(next);
-                }
-                return true;
-            } else if (node->offset == offset) {
-                // If there is an exact match, this means the exact block of memory
-                // that is already free is being freed again
-                MFATAL("Attempting to free already-freed block of memory at offset %llu", node->offset);
-                return false;
-            } else if (node->offset > offset) {
-                // Iterated beyound the space to be freed. Need a new node
-                freelist_node* new_node = get_node(list);
-                new_node->offset = offset;
-                new_node->size = size;
-
-                // If there is a previous node, the new node shoud be inserted between this and it
-                if (previous) {
-                    previous->next = new_node;
-                    new_node->next = node;
-                } else {
-                    // Otherwise, the new node becomes the head
-                    new_node->next = node;
-                    state->head = new_node;
-                }
-
-                // Double-check next node to see if it can be joined
-                if (new_node->next && new_node->offset + new_node->size == new_node->next->offset) {
-                    new_node->size += new_node->next->size;
-                    freelist_node* rubbish = new_node->next;
-                    new_node->next = rubbish->next;
-                    return_node(rubbish);
-                }
-
-                // Double-check previous node to see if the new_node can be joined to it
-                if (previous && previous->offset + previous->size == new_node->offset) {
-                    previous->size += new_node->size;
-                    freelist_node* rubbish = new_node;
-                    previous->next = rubbish->next;
-                    return_node(rubbish);
-                }
-
-                return true;
-            }
+        // The block sits inside the range, split off what follows it
+        freelist_node* tail = get_node(state);
+        if (!tail) {
+            return false;
+        }
+        tail->offset = offset + size;
+        tail->size = end - tail->offset;
+        set_node_range(state, node, node->offset, offset - node->offset);
+        insert_free_node(state, node, tail);
+    }
 
-            // If on the last node and the last node's offset + size < the free space,
-            // a new node is required
-            if (!node->next && node->offset + node->size < offset) {
-                freelist_node* new_node = get_node(list);
-                new_node->offset = offset;
-                new_node->size = size;
-                new_node->next = nullptr;
-                node->next = new_node;
-                return true;
-            }
+    state->free_space -= size;
+    return true;
+}
 
-            previous = node;
-            node = node->next;
+b8 freelist_free_block(freelist* list, u64 size, u64 offset) {
+    if (!list || !list->memory || !size) {
+        return false;
+    }
+
+    internal_state* state = list->memory;
+
+    // Find the free ranges surrounding the block
+    freelist_node* previous = tree_find_previous(state, offset);
+    freelist_node* node = previous ? previous->next : state->head;
+
+    if (node && node->offset == offset) {
+        // If there is an exact match, this means the exact block of memory
+        // that is already free is being freed again
+        MFATAL("Attempting to free already-freed block of memory at offset %llu", node->offset);
+        return false;
+    }
+
+    b8 joins_previous = previous && previous->offset + previous->size == offset;
+    b8 joins_next = node && offset + size == node->offset;
+    if (joins_previous && joins_next) {
+        // The block closes the gap between two free ranges, combine all three
+        u64 next_size = node->size;
+        remove_free_node(state, node);
+        set_node_range(state, previous, previous->offset, previous->size + size + next_size);
+    } else if (joins_previous) {
+        set_node_range(state, previous, previous->offset, previous->size + size);
+    } else if (joins_next) {
+        set_node_range(state, node, offset, size + node->size);
+    } else {
+        freelist_node* new_node = get_node(state);
+        if (!new_node) {
+            MERROR("freelist_free_block - Out of nodes to track the freed block! The block is leaked");
+            return false;
         }
+        new_node->offset = offset;
+        new_node->size = size;
+        insert_free_node(state, previous, new_node);
     }
 
-    MWARN("Unable to find block to be freed! Corruption possible?");
-    return false;
+    state->free_space += size;
+    return true;
 }
 
 b8 freelist_resize(freelist* list, u64* memory_requirement, void* new_memory, u64 new_size, void** out_old_memory) {
@@ -196,13 +476,9 @@ b8 freelist_resize(freelist* list, u64* memory_requirement, void* new_memory, u6
     }
 
     // Enough space to hold state, plus array for all nodes
-    u64 max_entries = (new_size / sizeof(void*));
+    u64 max_entries = get_max_entries(new_size);
 
-    if (max_entries < 20) {
-        max_entries = 20;
-    }
-
-    *memory_requirement = sizeof(internal_state) * (sizeof(freelist_node) * max_entries);
+    *memory_requirement = sizeof(internal_state) + (sizeof(freelist_node) * max_entries);
     if (!new_memory) {
         return true;
     }
@@ -210,61 +486,16 @@ b8 freelist_resize(freelist* list, u64* memory_requirement, void* new_memory, u6
     *out_old_memory = list->memory;
 
     internal_state* old_state = (internal_state*)list->memory;
-    u64 size_diff = new_size - old_state->total_size;
-
     list->memory = new_memory;
+    internal_state* state = reset_state(list->memory, new_size, max_entries, old_state->flags);
 
-    memory_zero(list->memory, *memory_requirement);
-
-    internal_state* state = (internal_state*)list->memory;
-    state->nodes = (void*)(list->memory + sizeof(internal_state));
-    state->max_entries = max_entries;
-    state->total_size = new_size;
-
-    memory_zero(state->nodes, sizeof(freelist_node) * state->max_entries);
-
-    state->head = &state->nodes[0];
-
-    // Copy over the nodes
-    freelist_node* new_list_node = state->head;
-    freelist_node* old_node = old_state->head;
-    if (!old_node) {
-        // If there is no head, then the entire list is allocated. In this case,
-        // the head should be set to the difference of the space now available,
-        // and at the end of the list
-        state->head->offset = old_state->total_size;
-        state->head->size = size_diff;
-        state->head->next = nullptr;
-    } else {
-        while (old_node) {
-            // Get a new node, copy the offset/size, and set next to it
-            freelist_node* new_node = get_node(list);
-            new_node->offset = old_node->offset;
-            new_node->size = old_node->size;
-            new_node->next = nullptr;
-            new_list_node->next = new_node;
-            // Move to the next entry
-            new_list_node = new_list_node->next;
-
-            if (old_node->next) {
-                // If there is another node, move on
-                old_node = old_node->next;
-            } else {
-                // Reached the end of the list
-                // Check if it extends to the end of the block, If so,
-                // just append to the size. Otherwise, create a new node and attach to it
-                if (old_node->offset + old_node->size == old_state->total_size) {
-                    new_node->size += size_diff;
-                } else {
-                    freelist_node* new_node_end = get_node(list);
-                    new_node_end->offset = old_state->total_size;
-                    new_node_end->size = size_diff;
-                    new_node_end->next = nullptr;
-                    new_node->next = new_node_end;
-                }
-                break;
-            }
-        }
+    // Copy over the ranges in address order, then add the new space at the end
+    freelist_node* tail = nullptr;
+    for (freelist_node* old_node = old_state->head; old_node; old_node = old_node->next) {
+        append_free_range(state, &tail, old_node->offset, old_node->size);
+    }
+    if (new_size > old_state->total_size) {
+        append_free_range(state, &tail, old_state->total_size, new_size - old_state->total_size);
     }
 
     return true;
@@ -276,45 +507,75 @@ void freelist_clear(freelist* list) {
     }
 
     internal_state* state = list->memory;
-    memory_zero(state->nodes, sizeof(freelist_node) * state->max_entries);
+    memory_zero(state->nodes, sizeof(freelist_node) * state->nodes_high_water);
+    reset_state(list->memory, state->total_size, state->max_entries, state->flags);
 
-    // state->head = &state->nodes[0];
-    state->head->offset = 0;
-    state->head->size = state->total_size;
-    state->head->next = nullptr;
+    freelist_node* tail = nullptr;
+    append_free_range(state, &tail, 0, state->total_size);
 }
 
 u64 freelist_free_space(freelist* list) {
-    if (!list | !list->memory) {
+    if (!list || !list->memory) {
         return 0;
     }
 
-    u64 running_total = 0;
     internal_state* state = list->memory;
-    freelist_node* node = state->head;
-    while (node) {
-        running_total += node->size;
-        node = node->next;
-    }
-
-    return running_total;
+    return state->free_space;
 }
 
-static freelist_node* get_node(freelist* list) {
+b8 freelist_get_fragmentation(freelist* list, freelist_fragmentation* out_fragmentation) {
+    if (!list || !list->memory || !out_fragmentation) {
+        return false;
+    }
+
     internal_state* state = list->memory;
-    for (u64 i = 1; i < state->max_entries; ++i) {
-        if (state->nodes[i].size == 0) {
-            state->nodes[i].next = nullptr;
-            state->nodes[i].offset = 0;
-            return &state->nodes[i];
+    out_fragmentation->free_space = state->free_space;
+    out_fragmentation->free_range_count = 0;
+    out_fragmentation->largest_free_range = 0;
+    for (u32 i = 0; i < FREELIST_BIN_COUNT; ++i) {
+        out_fragmentation->range_histogram[i] = state->bin_counts[i];
+        out_fragmentation->free_range_count += state->bin_counts[i];
+    }
+
+    // The largest range is in the highest non-empty size class
+    if (state->bin_mask) {
+        u32 highest = bin_index(state->bin_mask);
+        for (freelist_node* node = state->bins[highest]; node; node = node->bin_next) {
+            out_fragmentation->largest_free_range = MMAX(out_fragmentation->largest_free_range, node->size);
         }
     }
 
-    return nullptr;
+    out_fragmentation->external_fragmentation = state->free_space
+        ? 1.0f - (f32)((f64)out_fragmentation->largest_free_range / (f64)state->free_space)
+        : 0.0f;
+    return true;
 }
 
-static void return_node(freelist_node* node) {
+static freelist_node* get_node(internal_state* state) {
+    freelist_node* node = state->unused_nodes;
+    if (node) {
+        state->unused_nodes = node->next;
+    } else if (state->nodes_high_water < state->max_entries) {
+        node = &state->nodes[state->nodes_high_water++];
+    } else {
+        return nullptr;
+    }
+
     node->offset = 0;
     node->size = 0;
     node->next = nullptr;
-}
\ No newline at end of file
+    node->prev = nullptr;
+    node->bin_next = nullptr;
+    node->bin_prev = nullptr;
+    node->left = nullptr;
+    node->right = nullptr;
+    return node;
+}
+
+static void return_node(internal_state* state, freelist_node* node) {
+    node->offset = 0;
+    node->size = 0;
+    node->prev = nullptr;
+    node->next = state->unused_nodes;
+    state->unused_nodes = node;
+}
@@ -7,17 +7,51 @@ typedef struct freelist {
     void* memory;
 } freelist;
 
+typedef enum freelist_flag_bits {
+    FREELIST_FLAG_NONE_BIT = 0x00,
+    // Allocations take the tightest free range of the smallest size class that fits,
+    // instead of the first range in address order. Lookups no longer walk every free range
+    FREELIST_FLAG_BEST_FIT_BIT = 0x01
+} freelist_flag_bits;
+
+typedef u32 freelist_flags;
+
+// Free ranges are counted per power of two. Bucket i holds ranges of [2^i, 2^(i+1)) bytes
+#define FREELIST_SIZE_CLASS_COUNT 64
+
+typedef struct freelist_fragmentation {
+    u64 free_space;
+    u64 free_range_count;
+    u64 largest_free_range;
+    // 1 - largest_free_range / free_space. 0 while all free space is one range,
+    // approaching 1 as it gets scattered into many small ones
+    f32 external_fragmentation;
+    u64 range_histogram[FREELIST_SIZE_CLASS_COUNT];
+} freelist_fragmentation;
 
 MAPI void freelist_create(u64 total_size, u64* memory_requirement, void* memory, freelist* out_list);
 
+MAPI void freelist_create_with_flags(u64 total_size, freelist_flags flags, u64* memory_requirement, void* memory, freelist* out_list);
+
 MAPI void freelist_destroy(freelist* list);
 
 MAPI b8 freelist_allocate_block(freelist* list, u64 size, u64* out_offset);
 
+// Allocates a block whose offset is a multiple of alignment, which must be a power of two. The padding needed
+// to find such an offset is returned to the list right away, so the block takes exactly size from it.
+// A range only needs room for the block past its first aligned offset, so a range sized exactly for it works
+MAPI b8 freelist_allocate_block_aligned(freelist* list, u64 size, u64 alignment, u64* out_offset);
+
+// Claims exactly the given range if all of it is free. Used to grow blocks in place
+MAPI b8 freelist_allocate_block_at(freelist* list, u64 size, u64 offset);
+
 MAPI b8 freelist_free_block(freelist* list, u64 size, u64 offset);
 
 MAPI b8 freelist_resize(freelist* list, u64* memory_requirement, void* new_memory, u64 new_size, void** out_old_memory);
 
 MAPI void freelist_clear(freelist* list);
 
-MAPI u64 freelist_free_space(freelist* list);
\ No newline at end of file
+MAPI u64 freelist_free_space(freelist* list);
+
+// Gathers how the free space is split up. Runs in time proportional to the ranges of the largest size class
+MAPI b8 freelist_get_fragmentation(freelist* list, freelist_fragmentation* out_fragmentation);
@@ -1,64 +1,403 @@
 #include "hashtable.h"
 
+#include "core/hash.h"
 #include "memory/memory.h"
+#include "strings/string.h"
 #include "core/logger.h"
 
-static u64 hash_key(const char* key, u32 element_count) {
-    static const u64 multiplier = 97;
+#if defined(__SSE2__) || defined(_M_X64)
+#   define HASHTABLE_USE_SSE2 1
+#   include <emmintrin.h>
+#else
+#   define HASHTABLE_USE_SSE2 0
+#endif
 
-    unsigned const char* us;
-    u64 hash = 0;
+// Full slots store the low 7 bits of their hash, so only empty and deleted slots have the sign bit set
+#define CONTROL_EMPTY ((i8)-128)
+#define CONTROL_DELETED ((i8)-2)
 
-    for (us = (unsigned const char*)key; *us; us++) {
-        hash = hash * multiplier + *us;
+#define GROUP_WIDTH 16
+#define MIN_CAPACITY GROUP_WIDTH
+#define MAX_CAPACITY (1u << 31)
+#define MIN_KEY_CAPACITY 256
+
+typedef struct hashtable_slot {
+    u64 hash;
+    u32 key_offset;
+    u32 key_length;
+} hashtable_slot;
+
+// Tables are kept at most 7/8 full
+static inline u32 max_load(u32 capacity) {
+    return capacity - capacity / 8;
+}
+
+static inline u64 control_size(u32 capacity) {
+    return get_aligned(capacity + GROUP_WIDTH - 1, 8);
+}
+
+static inline u64 table_size(const hashtable* table, u32 capacity) {
+    return control_size(capacity) + (u64)capacity * table->slot_size;
+}
+
+static inline hashtable_slot* slot_at(const hashtable* table, u32 index) {
+    return (hashtable_slot*)((u8*)table->memory + (u64)index * table->slot_size);
+}
+
+static inline void* slot_value(hashtable_slot* slot) {
+    return (u8*)slot + sizeof(hashtable_slot);
+}
+
+static inline u32 group_match(const i8* group, i8 value) {
+#if HASHTABLE_USE_SSE2
+    __m128i bytes = _mm_loadu_si128((const __m128i*)group);
+    return (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(value)));
+#else
+    u32 mask = 0;
+    for (u32 i = 0; i < GROUP_WIDTH; ++i) {
+        mask |= (u32)(group[i] == value) << i;
+    }
+    return mask;
+#endif
+}
+
+static inline u32 group_match_empty_or_deleted(const i8* group) {
+#if HASHTABLE_USE_SSE2
+    return (u32)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)group));
+#else
+    u32 mask = 0;
+    for (u32 i = 0; i < GROUP_WIDTH; ++i) {
+        mask |= (u32)(group[i] < 0) << i;
+    }
+    return mask;
+#endif
+}
+
+static inline void set_control(hashtable* table, u32 index, i8 value) {
+    table->control[index] = value;
+    // Also writes the copy past the end when the slot is in the first group
+    table->control[((index - (GROUP_WIDTH - 1)) & (table->capacity - 1)) + (GROUP_WIDTH - 1)] = value;
+}
+
+// Returns the slot holding the key, or INVALID_ID
+static u32 find_slot(const hashtable* table, u64 hash, const char* key, u32 length) {
+    u32 mask = table->capacity - 1;
+    u32 position = (u32)(hash >> 7) & mask;
+    i8 fingerprint = (i8)(hash & 0x7F);
+
+    // Steps grow by a group each time, which visits every group of a power of two table
+    for (u32 step = GROUP_WIDTH;; step += GROUP_WIDTH) {
+        const i8* group = table->control + position;
+        u32 matches = group_match(group, fingerprint);
+        while (matches) {
+            u32 index = (position + __builtin_ctz(matches)) & mask;
+            hashtable_slot* slot = slot_at(table, index);
+            if (slot->hash == hash && slot->key_length == length && memory_compare(table->keys + slot->key_offset, key, length) == 0) {
+                return index;
+            }
+            matches &= matches - 1;
+        }
+
+        // The key would have gone into the first empty slot, so it is not stored past one
+        if (group_match(group, CONTROL_EMPTY)) {
+            return INVALID_ID;
+        }
+        position = (position + step) & mask;
+    }
+}
+
+static u32 find_insert_slot(const hashtable* table, u64 hash) {
+    u32 mask = table->capacity - 1;
+    u32 position = (u32)(hash >> 7) & mask;
+
+    for (u32 step = GROUP_WIDTH;; step += GROUP_WIDTH) {
+        u32 matches = group_match_empty_or_deleted(table->control + position);
+        if (matches) {
+            return (position + __builtin_ctz(matches)) & mask;
+        }
+        position = (position + step) & mask;
+    }
+}
+
+static b8 table_allocate(hashtable* table, u32 capacity) {
+    i8* control = memory_allocate_uninitialized(table_size(table, capacity), MEMORY_TAG_HASHTABLE);
+    if (!control) {
+        MERROR("hashtable - Failed to allocate a table of %u slots.", capacity);
+        return false;
+    }
+    memory_set(control, CONTROL_EMPTY, control_size(capacity));
+
+    table->control = control;
+    table->memory = control + control_size(capacity);
+    table->capacity = capacity;
+    table->growth_left = max_load(capacity) - table->count;
+    return true;
+}
+
+// Moves every key into a table of new_capacity slots, which also clears out deleted slots
+static b8 table_rehash(hashtable* table, u32 new_capacity) {
+    hashtable old = *table;
+    if (!table_allocate(table, new_capacity)) {
+        *table = old;
+        return false;
+    }
+
+    for (u32 i = 0; i < old.capacity; ++i) {
+        if (old.control[i] < 0) {
+            continue;
+        }
+        hashtable_slot* slot = slot_at(&old, i);
+        u32 index = find_insert_slot(table, slot->hash);
+        set_control(table, index, (i8)(slot->hash & 0x7F));
+        memory_copy(slot_at(table, index), slot, table->slot_size);
+    }
+
+    memory_free(old.control, table_size(&old, old.capacity), MEMORY_TAG_HASHTABLE);
+    table->element_count = MMAX(table->element_count, max_load(new_capacity));
+    return true;
+}
+
+// Copies the live keys into new storage of the given size, dropping the holes left by removed ones
+static b8 keys_compact(hashtable* table, u64 new_capacity) {
+    char* keys = memory_allocate_uninitialized(new_capacity, MEMORY_TAG_HASHTABLE);
+    if (!keys) {
+        MERROR("hashtable - Failed to allocate %llu bytes of key storage.", new_capacity);
+        return false;
+    }
+
+    u64 size = 0;
+    for (u32 i = 0; i < table->capacity; ++i) {
+        if (table->control[i] < 0) {
+            continue;
+        }
+        hashtable_slot* slot = slot_at(table, i);
+        memory_copy(keys + size, table->keys + slot->key_offset, slot->key_length + 1);
+        slot->key_offset = (u32)size;
+        size += slot->key_length + 1;
+    }
+
+    if (table->keys) {
+        memory_free(table->keys, table->key_capacity, MEMORY_TAG_HASHTABLE);
+    }
+    table->keys = keys;
+    table->key_size = size;
+    table->key_capacity = new_capacity;
+    table->key_dead_size = 0;
+    return true;
+}
+
+static b8 key_store(hashtable* table, const char* key, u32 length, u32* out_offset) {
+    u64 required = (u64)length + 1;
+    if (table->key_size + required > table->key_capacity) {
+        // Reclaims the holes first, and only grows when the live keys fill more than half the storage
+        u64 live_size = table->key_size - table->key_dead_size;
+        u64 new_capacity = MMAX(table->key_capacity, (u64)MIN_KEY_CAPACITY);
+        while (new_capacity < (live_size + required) * 2) {
+            new_capacity *= 2;
+        }
+        if (!keys_compact(table, new_capacity)) {
+            return false;
+        }
+    }
+
+    if (table->key_size + required > U32_MAX) {
+        MERROR("hashtable - Key storage is limited to 4 GiB.");
+        return false;
+    }
+
+    memory_copy(table->keys + table->key_size, key, required);
+    *out_offset = (u32)table->key_size;
+    table->key_size += required;
+    return true;
+}
+
+// Returns the value of the key, inserting it with an uninitialized value if it is not stored yet
+static void* find_or_insert(hashtable* table, const hashtable_key* key) {
+    if (key->length >= U32_MAX) {
+        MERROR("hashtable - Key is too long.");
+        return nullptr;
+    }
+
+    u32 index = find_slot(table, key->hash, key->str, (u32)key->length);
+    if (index != INVALID_ID) {
+        return slot_value(slot_at(table, index));
+    }
+
+    index = find_insert_slot(table, key->hash);
+    if (table->growth_left == 0 && table->control[index] == CONTROL_EMPTY) {
+        // Mostly deleted slots are cleaned out in place, otherwise the table doubles
+        u32 new_capacity = table->count < max_load(table->capacity) / 2 ? table->capacity : table->capacity * 2;
+        if (new_capacity > MAX_CAPACITY) {
+            MERROR("hashtable - Table can not grow past %u slots.", MAX_CAPACITY);
+            return nullptr;
+        }
+        if (!table_rehash(table, new_capacity)) {
+            return nullptr;
+        }
+        index = find_insert_slot(table, key->hash);
+    }
+
+    u32 key_offset = 0;
+    if (!key_store(table, key->str, (u32)key->length, &key_offset)) {
+        return nullptr;
+    }
+
+    if (table->control[index] == CONTROL_EMPTY) {
+        table->growth_left--;
+    }
+    set_control(table, index, (i8)(key->hash & 0x7F));
+    table->count++;
+
+    hashtable_slot* slot = slot_at(table, index);
+    slot->hash = key->hash;
+    slot->key_offset = key_offset;
+    slot->key_length = (u32)key->length;
+    return slot_value(slot);
+}
+
+static void* find_value(const hashtable* table, const hashtable_key* key) {
+    if (key->length >= U32_MAX) {
+        return nullptr;
     }
+    u32 index = find_slot(table, key->hash, key->str, (u32)key->length);
+    return index != INVALID_ID ? slot_value(slot_at(table, index)) : nullptr;
+}
+
+static void remove_slot(hashtable* table, u32 index) {
+    hashtable_slot* slot = slot_at(table, index);
+    table->key_dead_size += slot->key_length + 1;
+    table->count--;
+
+    // Probes only go past groups without an empty slot. If no run of a group's width around this
+    // slot was ever full, no probe passed it and it can be marked empty instead of deleted
+    u32 mask = table->capacity - 1;
+    u32 empty_before = group_match(table->control + ((index - GROUP_WIDTH) & mask), CONTROL_EMPTY);
+    u32 empty_after = group_match(table->control + index, CONTROL_EMPTY);
+    b8 was_never_full = empty_before && empty_after &&
+        (u32)(__builtin_ctz(empty_after) + (__builtin_clz(empty_before) - (32 - GROUP_WIDTH))) < GROUP_WIDTH;
 
-    return hash % element_count;
+    if (was_never_full) {
+        set_control(table, index, CONTROL_EMPTY);
+        table->growth_left++;
+    } else {
+        set_control(table, index, CONTROL_DELETED);
+    }
 }
 
-b8 hashtable_create(u64 element_size, u32 element_count, b8 is_pointer_type, void* memory, hashtable* out_table) {
+b8 hashtable_create(u64 element_size, u32 element_count, b8 is_pointer_type, hashtable* out_table) {
     if (!element_size || !element_count) {
         MERROR("hashtable_create - element_size and element_count must be a positive non-zero value!");
         return false;
     }
 
-    if (!memory || !out_table) {
-        MERROR("hashtable_create - Required valid pointers to memory and out_table!");
+    if (!out_table) {
+        MERROR("hashtable_create - Required a valid pointer to out_table!");
         return false;
     }
 
-    out_table->memory = memory;
-    out_table->element_count = element_count;
+    u32 capacity = MIN_CAPACITY;
+    while (capacity < MAX_CAPACITY && max_load(capacity) < element_count) {
+        capacity *= 2;
+    }
+
+    memory_zero(out_table, sizeof(hashtable));
     out_table->element_size = element_size;
+    out_table->element_count = element_count;
     out_table->is_pointer_type = is_pointer_type;
-    memory_zero(out_table->memory, element_size * element_count);
+    out_table->slot_size = get_aligned(sizeof(hashtable_slot) + element_size, 8);
+    if (!table_allocate(out_table, capacity)) {
+        memory_zero(out_table, sizeof(hashtable));
+        return false;
+    }
     return true;
 }
 
 void hashtable_destroy(hashtable* table) {
     if (table) {
+        if (table->control) {
+            memory_free(table->control, table_size(table, table->capacity), MEMORY_TAG_HASHTABLE);
+        }
+        if (table->keys) {
+            memory_free(table->keys, table->key_capacity, MEMORY_TAG_HASHTABLE);
+        }
         memory_zero(table, sizeof(hashtable));
     }
 }
 
+hashtable_key hashtable_key_from_str(const char* str) {
+    hashtable_key key;
+    key.str = str;
+    key.length = cstr_len(str);
+    key.hash = hash_bytes(str, key.length, HASH_DEFAULT_SEED);
+    return key;
+}
+
 b8 hashtable_set(hashtable* table, const char* key, void* value) {
     if (!table || !key || !value) {
         MERROR("hashtable_set requires table, key and value to exist.");
         return false;
     }
+    hashtable_key hashed = hashtable_key_from_str(key);
+    return hashtable_set_prehashed(table, &hashed, value);
+}
+
+b8 hashtable_set_ptr(hashtable* table, const char* key, void** value) {
+    if (!table || !key) {
+        MERROR("hashtable_set_ptr requires table and key to exist.");
+        return false;
+    }
+    hashtable_key hashed = hashtable_key_from_str(key);
+    return hashtable_set_ptr_prehashed(table, &hashed, value);
+}
+
+b8 hashtable_get(hashtable* table, const char* key, void* out_value) {
+    if (!table || !key || !out_value) {
+        MERROR("hashtable_get requires table, key and out_value to exist.");
+        return false;
+    }
+    hashtable_key hashed = hashtable_key_from_str(key);
+    return hashtable_get_prehashed(table, &hashed, out_value);
+}
+
+b8 hashtable_get_ptr(hashtable* table, const char* key, void** out_value) {
+    if (!table || !key || !out_value) {
+        MERROR("hashtable_get_ptr requires table, key and out_value to exist.");
+        return false;
+    }
+    hashtable_key hashed = hashtable_key_from_str(key);
+    return hashtable_get_ptr_prehashed(table, &hashed, out_value);
+}
+
+b8 hashtable_remove(hashtable* table, const char* key) {
+    if (!table || !key) {
+        MERROR("hashtable_remove requires table and key to exist.");
+        return false;
+    }
+    hashtable_key hashed = hashtable_key_from_str(key);
+    return hashtable_remove_prehashed(table, &hashed);
+}
+
+b8 hashtable_set_prehashed(hashtable* table, const hashtable_key* key, void* value) {
+    if (!table || !key || !key->str || !value) {
+        MERROR("hashtable_set requires table, key and value to exist.");
+        return false;
+    }
 
     if (table->is_pointer_type) {
         MERROR("hashtable_set should not be used with tables that have pointer types. Use hashtable_set_ptr instead.");
         return false;
     }
 
-    u64 hash = hash_key(key, table->element_count);
-    memory_copy(table->memory + (table->element_size * hash), value, table->element_size);
+    void* slot = find_or_insert(table, key);
+    if (!slot) {
+        return false;
+    }
+    memory_copy(slot, value, table->element_size);
     return true;
 }
 
-b8 hashtable_set_ptr(hashtable* table, const char* key, void** value) {
-    if (!table || !key) {
+b8 hashtable_set_ptr_prehashed(hashtable* table, const hashtable_key* key, void** value) {
+    if (!table || !key || !key->str) {
         MERROR("hashtable_set_ptr requires table and key to exist.");
         return false;
     }
@@ -68,13 +407,21 @@ b8 hashtable_set_ptr(hashtable* table, const char* key, void** value) {
         return false;
     }
 
-    u64 hash = hash_key(key, table->element_count);
-    ((void**)table->memory)[hash] = value ? *value : nullptr;
+    if (!value || !*value) {
+        hashtable_remove_prehashed(table, key);
+        return true;
+    }
+
+    void** slot = find_or_insert(table, key);
+    if (!slot) {
+        return false;
+    }
+    *slot = *value;
     return true;
 }
 
-b8 hashtable_get(hashtable* table, const char* key, void* out_value) {
-    if (!table || !key || !out_value) {
+b8 hashtable_get_prehashed(hashtable* table, const hashtable_key* key, void* out_value) {
+    if (!table || !key || !key->str || !out_value) {
         MERROR("hashtable_get requires table, key and out_value to exist.");
         return false;
     }
@@ -84,13 +431,16 @@ b8 hashtable_get(hashtable* table, const char* key, void* out_value) {
         return false;
     }
 
-    u64 hash = hash_key(key, table->element_count);
-    memory_copy(out_value, table->memory + (table->element_size * hash), table->element_size);
+    void* slot = find_value(table, key);
+    if (!slot) {
+        return false;
+    }
+    memory_copy(out_value, slot, table->element_size);
     return true;
 }
 
-b8 hashtable_get_ptr(hashtable* table, const char* key, void** out_value) {
-    if (!table || !key || !out_value) {
+b8 hashtable_get_ptr_prehashed(hashtable* table, const hashtable_key* key, void** out_value) {
+    if (!table || !key || !key->str || !out_value) {
         MERROR("hashtable_get_ptr requires table, key and out_value to exist.");
         return false;
     }
@@ -100,11 +450,28 @@ b8 hashtable_get_ptr(hashtable* table, const char* key, void** out_value) {
         return false;
     }
 
-    u64 hash = hash_key(key, table->element_count);
-    *out_value = ((void**)table->memory)[hash];
+    void** slot = find_value(table, key);
+    *out_value = slot ? *slot : nullptr;
     return *out_value != nullptr;
 }
 
+b8 hashtable_remove_prehashed(hashtable* table, const hashtable_key* key) {
+    if (!table || !key || !key->str) {
+        MERROR("hashtable_remove requires table and key to exist.");
+        return false;
+    }
+
+    if (key->length >= U32_MAX) {
+        return false;
+    }
+    u32 index = find_slot(table, key->hash, key->str, (u32)key->length);
+    if (index == INVALID_ID) {
+        return false;
+    }
+    remove_slot(table, index);
+    return true;
+}
+
 b8 hashtable_fill(hashtable* table, void* value) {
     if (!table || !value) {
         MERROR("hashtable_fill requires table and value to exist.");
@@ -116,9 +483,11 @@ b8 hashtable_fill(hashtable* table, void* value) {
         return false;
     }
 
-    for (u32 i = 0; i < table->element_count; ++i) {
-        memory_copy(table->memory + (table->element_size * i), value, table->element_size);
+    for (u32 i = 0; i < table->capacity; ++i) {
+        if (table->control[i] >= 0) {
+            memory_copy(slot_value(slot_at(table, i)), value, table->element_size);
+        }
     }
 
     return true;
-}
\ No newline at end of file
+}
@@ -3,24 +3,74 @@
 #include "defines.h"
 
 
+// Open addressing table keyed by strings. Keys are copied into the table, so they need not outlive it.
+// Each slot has a control byte holding 7 bits of its hash, or marking it empty or deleted, and lookups
+// compare a group of 16 control bytes at once before touching any keys
 typedef struct hashtable {
     u32 element_size;
+    // Entries the table was sized for. Grows along with the table
     u32 element_count;
     b8 is_pointer_type;
+    // Keys currently stored
+    u32 count;
+    // Slot count, always a power of two
+    u32 capacity;
+    // Inserts into empty slots left before the table has to rehash
+    u32 growth_left;
+    u32 slot_size;
+    // One control byte per slot, followed by a copy of the first group so probes can read past the end
+    i8* control;
+    // The slots, each the key hash and location followed by the value
     void* memory;
+    // Copies of the keys. Removed keys leave holes that are reclaimed when the storage fills up
+    char* keys;
+    u64 key_size;
+    u64 key_capacity;
+    u64 key_dead_size;
 } hashtable;
 
+// A key with its length and hash computed up front, for keys that are looked up repeatedly.
+// The hash must be hash_bytes(str, length, HASH_DEFAULT_SEED), which is what hashtable_key_from_str
+// and interned names provide
+typedef struct hashtable_key {
+    const char* str;
+    u64 length;
+    u64 hash;
+} hashtable_key;
 
-MAPI b8 hashtable_create(u64 element_size, u32 element_count, b8 is_pointer_type, void* memory, hashtable* out_table);
+
+// Creates a table sized for element_count entries without growing. The table allocates its own memory
+MAPI b8 hashtable_create(u64 element_size, u32 element_count, b8 is_pointer_type, hashtable* out_table);
 
 MAPI void hashtable_destroy(hashtable* table);
 
+// Inserts the key or overwrites its value
 MAPI b8 hashtable_set(hashtable* table, const char* key, void* value);
 
+// Inserts the key or overwrites its pointer. A nullptr value removes the key
 MAPI b8 hashtable_set_ptr(hashtable* table, const char* key, void** value);
 
+// Returns false and leaves out_value untouched when the key is not stored
 MAPI b8 hashtable_get(hashtable* table, const char* key, void* out_value);
 
+// Returns false and sets out_value to nullptr when the key is not stored
 MAPI b8 hashtable_get_ptr(hashtable* table, const char* key, void** out_value);
 
-MAPI b8 hashtable_fill(hashtable* table, void* value);
\ No newline at end of file
+// Returns false when the key was not stored
+MAPI b8 hashtable_remove(hashtable* table, const char* key);
+
+// Overwrites the value of every stored key
+MAPI b8 hashtable_fill(hashtable* table, void* value);
+
+MAPI hashtable_key hashtable_key_from_str(const char* str);
+
+// Variants of the functions above taking a prehashed key, so the key string is not hashed again
+MAPI b8 hashtable_set_prehashed(hashtable* table, const hashtable_key* key, void* value);
+
+MAPI b8 hashtable_set_ptr_prehashed(hashtable* table, const hashtable_key* key, void** value);
+
+MAPI b8 hashtable_get_prehashed(hashtable* table, const hashtable_key* key, void* out_value);
+
+MAPI b8 hashtable_get_ptr_prehashed(hashtable* table, const hashtable_key* key, void** out_value);
+
+MAPI b8 hashtable_remove_prehashed(hashtable* table, const hashtable_key* key);
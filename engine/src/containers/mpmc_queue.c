@@ -0,0 +1,177 @@
+#include "mpmc_queue.h"
+
+#include "memory/memory.h"
+#include "threads/atomic.h"
+#include "core/logger.h"
+
+#define MPMC_QUEUE_CELL_ALIGNMENT 64
+// Pauses a blocked thread spins through before it calls the wait hook
+#define MPMC_QUEUE_SPIN_COUNT 128
+
+static inline volatile u64* cell_at(const mpmc_queue* q, u64 position) {
+    return (volatile u64*)((u8*)q->cells + (position & q->mask) * q->cell_size);
+}
+
+b8 mpmc_queue_create(u32 stride, u32 capacity, mpmc_queue* out_queue) {
+    if (!out_queue) {
+        MERROR("mpmc_queue_create requires a valid pointer to hold the queue!");
+        return false;
+    }
+
+    // A single cell can not tell the lap being written from the one being read
+    if (!stride || capacity < 2 || (capacity & (capacity - 1)) != 0) {
+        MERROR("mpmc_queue_create - Needs a non-zero stride and a power of two capacity of at least 2, got %u.", capacity);
+        return false;
+    }
+
+    memory_zero(out_queue, sizeof(mpmc_queue));
+    out_queue->stride = stride;
+    out_queue->cell_size = sizeof(u64) + get_aligned(stride, sizeof(u64));
+    out_queue->capacity = capacity;
+    out_queue->mask = capacity - 1;
+    out_queue->cells = memory_allocate_aligned_uninitialized((u64)capacity * out_queue->cell_size, MPMC_QUEUE_CELL_ALIGNMENT, MEMORY_TAG_RING_QUEUE);
+    if (!out_queue->cells) {
+        MERROR("mpmc_queue_create - Failed to allocate %u cells.", capacity);
+        return false;
+    }
+
+    // Cell i is first written by the push claiming position i
+    for (u64 i = 0; i < capacity; ++i) {
+        *cell_at(out_queue, i) = i;
+    }
+    return true;
+}
+
+void mpmc_queue_destroy(mpmc_queue* q) {
+    if (q) {
+        if (q->cells) {
+            memory_free_aligned(q->cells, (u64)q->capacity * q->cell_size, MPMC_QUEUE_CELL_ALIGNMENT, MEMORY_TAG_RING_QUEUE);
+        }
+        memory_zero(q, sizeof(mpmc_queue));
+    }
+}
+
+// Called after a cell changed state. Pairs with the fence a blocking push or pop issues once registered, so
+// either its last try sees the cell or this sees it waiting
+static inline void notify_waiters(const ring_queue_wait_hooks* hooks, volatile u32* waiters) {
+    if (hooks->notify) {
+        atomic_thread_fence_seq_cst();
+        if (atomic_u32_load(waiters)) {
+            hooks->notify(hooks->context);
+        }
+    }
+}
+
+b8 mpmc_queue_try_push(mpmc_queue* q, const void* value) {
+    u64 position = atomic_u64_load(&q->enqueue_position);
+    volatile u64* cell;
+    for (;;) {
+        cell = cell_at(q, position);
+        i64 difference = (i64)(atomic_u64_load(cell) - position);
+        if (difference == 0) {
+            // The cell is free in this lap, so whoever moves the position past it owns it
+            if (atomic_u64_compare_exchange(&q->enqueue_position, &position, position + 1)) {
+                break;
+            }
+        } else if (difference < 0) {
+            // The cell still holds the element pushed a lap ago
+            return false;
+        } else {
+            position = atomic_u64_load(&q->enqueue_position);
+        }
+    }
+
+    memory_copy((void*)(cell + 1), value, q->stride);
+    // Marks the element readable by the pop claiming this position
+    atomic_u64_store(cell, position + 1);
+    notify_waiters(&q->not_empty_hooks, &q->pop_waiters);
+    return true;
+}
+
+b8 mpmc_queue_try_pop(mpmc_queue* q, void* out_value) {
+    u64 position = atomic_u64_load(&q->dequeue_position);
+    volatile u64* cell;
+    for (;;) {
+        cell = cell_at(q, position);
+        i64 difference = (i64)(atomic_u64_load(cell) - (position + 1));
+        if (difference == 0) {
+            if (atomic_u64_compare_exchange(&q->dequeue_position, &position, position + 1)) {
+                break;
+            }
+        } else if (difference < 0) {
+            // Nothing has been pushed to this cell in this lap yet
+            return false;
+        } else {
+            position = atomic_u64_load(&q->dequeue_position);
+        }
+    }
+
+    memory_copy(out_value, (const void*)(cell + 1), q->stride);
+    // Frees the cell for the push one lap ahead
+    atomic_u64_store(cell, position + q->capacity);
+    notify_waiters(&q->not_full_hooks, &q->push_waiters);
+    return true;
+}
+
+void mpmc_queue_set_wait_hooks(mpmc_queue* q, const ring_queue_wait_hooks* not_full, const ring_queue_wait_hooks* not_empty) {
+    if (q) {
+        if (not_full) {
+            q->not_full_hooks = *not_full;
+        } else {
+            memory_zero(&q->not_full_hooks, sizeof(ring_queue_wait_hooks));
+        }
+        if (not_empty) {
+            q->not_empty_hooks = *not_empty;
+        } else {
+            memory_zero(&q->not_empty_hooks, sizeof(ring_queue_wait_hooks));
+        }
+    }
+}
+
+void mpmc_queue_push(mpmc_queue* q, const void* value) {
+    for (u32 spin = 0; !mpmc_queue_try_push(q, value); ++spin) {
+        if (spin < MPMC_QUEUE_SPIN_COUNT || !q->not_full_hooks.wait) {
+            atomic_spin_pause();
+            continue;
+        }
+
+        // Registers before the last try, so a pop freeing a cell after that try sees this thread waiting
+        atomic_u32_fetch_add(&q->push_waiters, 1);
+        atomic_thread_fence_seq_cst();
+        b8 pushed = mpmc_queue_try_push(q, value);
+        if (!pushed) {
+            q->not_full_hooks.wait(q->not_full_hooks.context);
+        }
+        atomic_u32_fetch_sub(&q->push_waiters, 1);
+        if (pushed) {
+            return;
+        }
+    }
+}
+
+void mpmc_queue_pop(mpmc_queue* q, void* out_value) {
+    for (u32 spin = 0; !mpmc_queue_try_pop(q, out_value); ++spin) {
+        if (spin < MPMC_QUEUE_SPIN_COUNT || !q->not_empty_hooks.wait) {
+            atomic_spin_pause();
+            continue;
+        }
+
+        atomic_u32_fetch_add(&q->pop_waiters, 1);
+        atomic_thread_fence_seq_cst();
+        b8 popped = mpmc_queue_try_pop(q, out_value);
+        if (!popped) {
+            q->not_empty_hooks.wait(q->not_empty_hooks.context);
+        }
+        atomic_u32_fetch_sub(&q->pop_waiters, 1);
+        if (popped) {
+            return;
+        }
+    }
+}
+
+u32 mpmc_queue_length(mpmc_queue* q) {
+    u64 dequeue_position = atomic_u64_load(&q->dequeue_position);
+    u64 enqueue_position = atomic_u64_load(&q->enqueue_position);
+    // Positions read at different times can briefly disagree
+    return enqueue_position > dequeue_position ? (u32)MMIN(enqueue_position - dequeue_position, (u64)q->capacity) : 0;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "defines.h"
+#include "containers/ring_queue.h"
+
+// Bounded queue any number of threads can push to and pop from at once without a lock. Every cell
+// carries a sequence number telling whether it is ready to be written or read in the current lap of
+// the ring, so a push or pop only contends on one atomic position and then works on its own cell
+typedef struct mpmc_queue {
+    u32 stride;
+    // The sequence number followed by the element, padded to 8 bytes
+    u32 cell_size;
+    // Always a power of two
+    u32 capacity;
+    u64 mask;
+    void* cells;
+    // Used by the blocking variants. Not tied to ring_queue otherwise
+    ring_queue_wait_hooks not_full_hooks;
+    ring_queue_wait_hooks not_empty_hooks;
+
+    // The positions producers and consumers claim, each a full cache line away from everything else
+    u8 enqueue_padding[RING_QUEUE_CACHE_LINE_SIZE];
+    volatile u64 enqueue_position;
+    u8 dequeue_padding[RING_QUEUE_CACHE_LINE_SIZE];
+    volatile u64 dequeue_position;
+    // Threads blocked in the wait hooks. Every push and pop reads these, only blocked threads write them
+    u8 waiter_padding[RING_QUEUE_CACHE_LINE_SIZE];
+    volatile u32 push_waiters;
+    volatile u32 pop_waiters;
+    u8 end_padding[RING_QUEUE_CACHE_LINE_SIZE];
+} mpmc_queue;
+
+// capacity must be a power of two, at least 2
+MAPI b8 mpmc_queue_create(u32 stride, u32 capacity, mpmc_queue* out_queue);
+
+// Must not race with any other use of the queue
+MAPI void mpmc_queue_destroy(mpmc_queue* q);
+
+// Returns false without waiting when the queue is full
+MAPI b8 mpmc_queue_try_push(mpmc_queue* q, const void* value);
+
+// Returns false without waiting when the queue is empty
+MAPI b8 mpmc_queue_try_pop(mpmc_queue* q, void* out_value);
+
+// Must be set before any thread starts using the queue. Blocked pushes wait on not_full and blocked pops on
+// not_empty, either may be null. notify is only called while a thread waits on that hook and must wake all of them
+MAPI void mpmc_queue_set_wait_hooks(mpmc_queue* q, const ring_queue_wait_hooks* not_full, const ring_queue_wait_hooks* not_empty);
+
+// Block until there is room or an element, waiting through the hooks when they are set
+MAPI void mpmc_queue_push(mpmc_queue* q, const void* value);
+
+MAPI void mpmc_queue_pop(mpmc_queue* q, void* out_value);
+
+// Elements currently queued. Only a snapshot while other threads use the queue
+MAPI u32 mpmc_queue_length(mpmc_queue* q);
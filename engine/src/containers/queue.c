@@ -3,16 +3,66 @@
 #include "memory/memory.h"
 #include "core/logger.h"
 
-static void queue_ensure_allocated(queue* q, u32 count) {
-    if (q->allocated < q->stride * count) {
-        void* tmp = memory_allocate(count * q->stride, MEMORY_TAG_QUEUE);
-        if (q->memory) {
-            memory_copy(tmp, q->memory, q->allocated);
-            memory_free(q->memory, q->allocated, MEMORY_TAG_QUEUE);
-        }
-        q->memory = tmp;
-        q->allocated = count * q->stride;
+#define QUEUE_MIN_CAPACITY 8
+#define QUEUE_MAX_CAPACITY (1u << 31)
+
+static inline u8* slot_at(const queue* q, u32 index) {
+    return (u8*)q->memory + (u64)(index & (q->capacity - 1)) * q->stride;
+}
+
+static b8 queue_ensure_allocated(queue* q, u64 count) {
+    if (count <= q->capacity) {
+        return true;
     }
+
+    if (count > QUEUE_MAX_CAPACITY) {
+        MERROR("queue - Can not hold %llu elements, the limit is %u.", count, QUEUE_MAX_CAPACITY);
+        return false;
+    }
+
+    u32 capacity = q->capacity ? q->capacity : QUEUE_MIN_CAPACITY;
+    while (capacity < count) {
+        capacity *= 2;
+    }
+
+    // Slots are always written before they are read, so new memory is left uninitialized
+    u64 old_size = (u64)q->capacity * q->stride;
+    u64 new_size = (u64)capacity * q->stride;
+    void* memory = q->memory
+        ? memory_reallocate_uninitialized(q->memory, old_size, new_size, MEMORY_TAG_QUEUE)
+        : memory_allocate_uninitialized(new_size, MEMORY_TAG_QUEUE);
+    if (!memory) {
+        MERROR("queue - Failed to grow to %u elements.", capacity);
+        return false;
+    }
+
+    // Elements that wrapped past the old end move to the end of the new block. It is at least twice
+    // the old size, so the ranges never overlap
+    u32 old_capacity = q->capacity;
+    q->memory = memory;
+    if (q->head + q->count > old_capacity) {
+        u32 head_run = old_capacity - q->head;
+        u32 new_head = capacity - head_run;
+        memory_copy((u8*)memory + (u64)new_head * q->stride, (u8*)memory + (u64)q->head * q->stride, (u64)head_run * q->stride);
+        q->head = new_head;
+    }
+    q->capacity = capacity;
+    return true;
+}
+
+// Copies count elements between the ring, starting at index, and a contiguous buffer, in at most two runs
+static void copy_out(const queue* q, u32 index, void* dst, u32 count) {
+    u32 start = index & (q->capacity - 1);
+    u32 first = MMIN(count, q->capacity - start);
+    memory_copy(dst, slot_at(q, start), (u64)first * q->stride);
+    memory_copy((u8*)dst + (u64)first * q->stride, q->memory, (u64)(count - first) * q->stride);
+}
+
+static void copy_in(queue* q, u32 index, const void* src, u32 count) {
+    u32 start = index & (q->capacity - 1);
+    u32 first = MMIN(count, q->capacity - start);
+    memory_copy(slot_at(q, start), src, (u64)first * q->stride);
+    memory_copy(q->memory, (const u8*)src + (u64)first * q->stride, (u64)(count - first) * q->stride);
 }
 
 b8 queue_create(u32 stride, queue* out_queue) {
@@ -21,17 +71,20 @@ b8 queue_create(u32 stride, queue* out_queue) {
         return false;
     }
 
+    if (!stride) {
+        MERROR("queue_create - stride must be a positive non-zero value!");
+        return false;
+    }
+
     memory_zero(out_queue, sizeof(queue));
     out_queue->stride = stride;
-    out_queue->count = 0;
-    queue_ensure_allocated(out_queue, 1);
-    return true;
+    return queue_ensure_allocated(out_queue, QUEUE_MIN_CAPACITY);
 }
 
 void queue_destroy(queue* q) {
     if (q) {
         if (q->memory) {
-            memory_free(q->memory, q->allocated, MEMORY_TAG_QUEUE);
+            memory_free(q->memory, (u64)q->capacity * q->stride, MEMORY_TAG_QUEUE);
         }
         memory_zero(q, sizeof(queue));
     }
@@ -49,8 +102,11 @@ b8 queue_push(queue* q, void* data) {
         return false;
     }
 
-    queue_ensure_allocated(q, q->count + 1);
-    memory_copy((void*)((u64*)q->memory + (q->count * q->stride)), data, q->stride);
+    if (q->count == q->capacity && !queue_ensure_allocated(q, (u64)q->count + 1)) {
+        return false;
+    }
+
+    memory_copy(slot_at(q, q->head + q->count), data, q->stride);
     q->count++;
     return true;
 }
@@ -66,7 +122,7 @@ b8 queue_peek(queue* q, void* out_data) {
         return false;
     }
 
-    memory_copy(out_data, q->memory, q->stride);
+    memory_copy(out_data, slot_at(q, q->head), q->stride);
     return true;
 }
 
@@ -81,11 +137,36 @@ b8 queue_pop(queue* q, void* out_data) {
         return false;
     }
 
-    memory_copy(out_data, q->memory, q->stride);
+    memory_copy(out_data, slot_at(q, q->head), q->stride);
+    q->head = (q->head + 1) & (q->capacity - 1);
+    q->count--;
+    return true;
+}
 
-    memory_copy(q->memory, (void*)(((u64*)q->memory) + q->stride), q->stride * (q->count - 1));
+b8 queue_push_range(queue* q, const void* data, u32 count) {
+    if (!q || (!data && count)) {
+        MERROR("queue_push_range requires a pointer to a valid queue and to the element data!");
+        return false;
+    }
 
-    q->count--;
+    if (!queue_ensure_allocated(q, (u64)q->count + count)) {
+        return false;
+    }
 
+    copy_in(q, q->head + q->count, data, count);
+    q->count += count;
     return true;
-}
\ No newline at end of file
+}
+
+u32 queue_pop_range(queue* q, void* out_data, u32 max_count) {
+    if (!q || !out_data) {
+        MERROR("queue_pop_range requires a pointer to a valid queue and to hold element data output!");
+        return 0;
+    }
+
+    u32 count = MMIN(max_count, q->count);
+    copy_out(q, q->head, out_data, count);
+    q->head = (q->head + count) & (q->capacity - 1);
+    q->count -= count;
+    return count;
+}
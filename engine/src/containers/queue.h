@@ -2,10 +2,16 @@
 
 #include "defines.h"
 
+// FIFO of fixed-size elements in a circular buffer. The capacity is a power of two that doubles when
+// full, so pushes and pops are amortized O(1) and slots are found by masking instead of a modulo
 typedef struct queue {
     u32 stride;
+    // Elements currently queued
     u32 count;
-    u32 allocated;
+    // Slots, always a power of two
+    u32 capacity;
+    // Slot of the front element
+    u32 head;
     void* memory;
 } queue;
 
@@ -13,10 +19,17 @@ MAPI b8 queue_create(u32 stride, queue* out_queue);
 
 MAPI void queue_destroy(queue* q);
 
+// Grows the queue to hold at least count elements without growing again
 MAPI void queue_reserve(queue* q, u32 count);
 
 MAPI b8 queue_push(queue* q, void* data);
 
 MAPI b8 queue_peek(queue* q, void* out_data);
 
-MAPI b8 queue_pop(queue* q, void* out_data);
\ No newline at end of file
+MAPI b8 queue_pop(queue* q, void* out_data);
+
+// Pushes count elements stored contiguously in data, growing at most once
+MAPI b8 queue_push_range(queue* q, const void* data, u32 count);
+
+// Pops up to max_count elements into out_data and returns how many were popped. An empty queue pops none
+MAPI u32 queue_pop_range(queue* q, void* out_data, u32 max_count);
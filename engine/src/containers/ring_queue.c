@@ -1,25 +1,85 @@
 #include "ring_queue.h"
 
 #include "memory/memory.h"
+#include "threads/atomic.h"
 #include "core/logger.h"
 
+// Pauses a blocked side spins through before it calls the wait hook
+#define RING_QUEUE_SPIN_COUNT 128
+
+static inline u64 slot_index(const ring_queue* q, u64 counter) {
+    return q->mask ? counter & q->mask : counter % q->capacity;
+}
+
+static inline u8* slot_at(const ring_queue* q, u64 counter) {
+    return (u8*)q->block + slot_index(q, counter) * q->stride;
+}
+
+// Copies count elements between the ring, starting at counter, and a contiguous buffer, in at most two runs
+static void copy_in(ring_queue* q, u64 counter, const void* src, u32 count) {
+    u32 first = (u32)MMIN((u64)count, q->capacity - slot_index(q, counter));
+    memory_copy(slot_at(q, counter), src, (u64)first * q->stride);
+    memory_copy(q->block, (const u8*)src + (u64)first * q->stride, (u64)(count - first) * q->stride);
+}
+
+static void copy_out(const ring_queue* q, u64 counter, void* dst, u32 count) {
+    u32 first = (u32)MMIN((u64)count, q->capacity - slot_index(q, counter));
+    memory_copy(dst, slot_at(q, counter), (u64)first * q->stride);
+    memory_copy((u8*)dst + (u64)first * q->stride, q->block, (u64)(count - first) * q->stride);
+}
+
+// Room the producer can fill. Only touches head when the last view of it says the queue is full
+static inline u32 spsc_free_count(ring_queue* q, u64 tail) {
+    u64 free_count = q->capacity - (tail - q->cached_head);
+    if (free_count == 0) {
+        q->cached_head = atomic_u64_load(&q->head);
+        free_count = q->capacity - (tail - q->cached_head);
+    }
+    return (u32)free_count;
+}
+
+// Elements the consumer can take. Only touches tail when the last view of it says the queue is empty
+static inline u32 spsc_used_count(ring_queue* q, u64 head) {
+    u64 used_count = q->cached_tail - head;
+    if (used_count == 0) {
+        q->cached_tail = atomic_u64_load(&q->tail);
+        used_count = q->cached_tail - head;
+    }
+    return (u32)used_count;
+}
+
 b8 ring_queue_create(u32 stride, u32 capacity, void* memory, ring_queue* out_queue) {
+    return ring_queue_create_with_flags(stride, capacity, memory, RING_QUEUE_FLAG_NONE_BIT, out_queue);
+}
+
+b8 ring_queue_create_with_flags(u32 stride, u32 capacity, void* memory, ring_queue_flags flags, ring_queue* out_queue) {
     if (!out_queue) {
         MERROR("ring_queue_create requires a valid pointer to hold the queue!");
         return false;
     }
 
-    out_queue->length = 0;
+    if (!stride || !capacity) {
+        MERROR("ring_queue_create - stride and capacity must be a positive non-zero value!");
+        return false;
+    }
+
+    b8 power_of_two = (capacity & (capacity - 1)) == 0;
+    if ((flags & RING_QUEUE_FLAG_SPSC_BIT) && !power_of_two) {
+        MERROR("ring_queue_create - SPSC queues need a power of two capacity, got %u.", capacity);
+        return false;
+    }
+
+    memory_zero(out_queue, sizeof(ring_queue));
     out_queue->capacity = capacity;
     out_queue->stride = stride;
-    out_queue->head = 0;
-    out_queue->tail = -1;
+    out_queue->mask = power_of_two ? capacity - 1 : 0;
+    out_queue->flags = flags;
     if (memory) {
         out_queue->owns_memory = false;
         out_queue->block = memory;
     } else {
         out_queue->owns_memory = true;
-        out_queue->block = memory_allocate(capacity * stride, MEMORY_TAG_RING_QUEUE);
+        out_queue->block = memory_allocate_uninitialized((u64)capacity * stride, MEMORY_TAG_RING_QUEUE);
     }
 
     return true;
@@ -28,28 +88,38 @@ b8 ring_queue_create(u32 stride, u32 capacity, void* memory, ring_queue* out_que
 void ring_queue_destroy(ring_queue* q) {
     if (q) {
         if (q->owns_memory) {
-            memory_free(q->block, q->capacity * q->stride, MEMORY_TAG_RING_QUEUE);
+            memory_free(q->block, (u64)q->capacity * q->stride, MEMORY_TAG_RING_QUEUE);
         }
         memory_zero(q, sizeof(ring_queue));
     }
 }
 
+u32 ring_queue_length(ring_queue* q) {
+    if (q->flags & RING_QUEUE_FLAG_SPSC_BIT) {
+        u64 head = atomic_u64_load(&q->head);
+        return (u32)(atomic_u64_load(&q->tail) - head);
+    }
+    return (u32)(q->tail - q->head);
+}
+
 b8 ring_queue_enqueue(ring_queue* q, void* value) {
     if (!q || !value) {
         MERROR("ring_queue_enqueue requires valid pointers to queue and value!");
         return false;
     }
 
-    if (q->length == q->capacity) {
+    if (q->flags & RING_QUEUE_FLAG_SPSC_BIT) {
+        return ring_queue_enqueue_range(q, value, 1) == 1;
+    }
+
+    if (q->tail - q->head == q->capacity) {
         MERROR("ring_queue_enqueue - Attempted to enqueue value in full ring queue: %p", q);
         return false;
     }
 
-    q->tail = (q->tail + 1) % q->capacity;
+    memory_copy(slot_at(q, q->tail), value, q->stride);
+    q->tail++;
 
-    memory_copy(q->block + (q->tail * q->stride), value, q->stride);
-    q->length++;
-    
     return true;
 }
 
@@ -59,30 +129,149 @@ b8 ring_queue_dequeue(ring_queue* q, void* out_value) {
         return false;
     }
 
-    if (q->length == 0) {
+    if (q->flags & RING_QUEUE_FLAG_SPSC_BIT) {
+        return ring_queue_dequeue_range(q, out_value, 1) == 1;
+    }
+
+    if (q->tail == q->head) {
         MERROR("ring_queue_dequeue - Attempted to dequeue value in empty ring queue: %p", q);
         return false;
     }
 
-    memory_copy(out_value, q->block + (q->head * q->stride), q->stride);
-    q->head = (q->head + 1) % q->capacity;
-    q->length--;
+    memory_copy(out_value, slot_at(q, q->head), q->stride);
+    q->head++;
 
     return true;
 }
 
-b8 ring_queue_peek(const ring_queue* q, void* out_value) {
+b8 ring_queue_peek(ring_queue* q, void* out_value) {
     if (!q || !out_value) {
         MERROR("ring_queue_peek requires valid pointers to queue and out_value!");
         return false;
     }
 
-    if (q->length == 0) {
+    if (q->flags & RING_QUEUE_FLAG_SPSC_BIT) {
+        if (!spsc_used_count(q, q->head)) {
+            return false;
+        }
+    } else if (q->tail == q->head) {
         MERROR("ring_queue_peek - Attempted to dequeue value in empty ring queue: %p", q);
         return false;
     }
 
-    memory_copy(out_value, q->block + (q->head * q->stride), q->stride);
+    memory_copy(out_value, slot_at(q, q->head), q->stride);
 
     return true;
-}
\ No newline at end of file
+}
+
+u32 ring_queue_enqueue_range(ring_queue* q, const void* values, u32 count) {
+    if (!q || (!values && count)) {
+        MERROR("ring_queue_enqueue_range requires valid pointers to queue and values!");
+        return 0;
+    }
+
+    u64 tail = q->tail;
+    if (!(q->flags & RING_QUEUE_FLAG_SPSC_BIT)) {
+        count = (u32)MMIN((u64)count, q->capacity - (tail - q->head));
+        copy_in(q, tail, values, count);
+        q->tail = tail + count;
+        return count;
+    }
+
+    u32 free_count = spsc_free_count(q, tail);
+    count = MMIN(count, free_count);
+    if (!count) {
+        return 0;
+    }
+
+    copy_in(q, tail, values, count);
+    // Publishes the elements. The release store orders the copies above before it
+    atomic_u64_store(&q->tail, tail + count);
+
+    if (q->hooks.notify) {
+        // Orders the tail store before the head load. Without it both sides can read the other's
+        // old index, the consumer waits on an empty queue and this side skips the notify
+        atomic_thread_fence_seq_cst();
+        // The consumer does not move head while it waits on an empty queue, so it is seen here
+        if (atomic_u64_load(&q->head) == tail) {
+            q->hooks.notify(q->hooks.context);
+        }
+    }
+    return count;
+}
+
+u32 ring_queue_dequeue_range(ring_queue* q, void* out_values, u32 max_count) {
+    if (!q || !out_values) {
+        MERROR("ring_queue_dequeue_range requires valid pointers to queue and out_values!");
+        return 0;
+    }
+
+    u64 head = q->head;
+    if (!(q->flags & RING_QUEUE_FLAG_SPSC_BIT)) {
+        u32 count = (u32)MMIN((u64)max_count, q->tail - head);
+        copy_out(q, head, out_values, count);
+        q->head = head + count;
+        return count;
+    }
+
+    u32 used_count = spsc_used_count(q, head);
+    u32 count = MMIN(max_count, used_count);
+    if (!count) {
+        return 0;
+    }
+
+    copy_out(q, head, out_values, count);
+    // Hands the slots back to the producer once they have been read
+    atomic_u64_store(&q->head, head + count);
+
+    if (q->hooks.notify) {
+        // Same pairing as in enqueue, so a producer waiting on a full queue is not missed
+        atomic_thread_fence_seq_cst();
+        if (atomic_u64_load(&q->tail) - head == q->capacity) {
+            q->hooks.notify(q->hooks.context);
+        }
+    }
+    return count;
+}
+
+void ring_queue_set_wait_hooks(ring_queue* q, const ring_queue_wait_hooks* hooks) {
+    if (q) {
+        if (hooks) {
+            q->hooks = *hooks;
+        } else {
+            memory_zero(&q->hooks, sizeof(ring_queue_wait_hooks));
+        }
+    }
+}
+
+b8 ring_queue_enqueue_wait(ring_queue* q, void* value) {
+    if (!q || !value || !(q->flags & RING_QUEUE_FLAG_SPSC_BIT)) {
+        MERROR("ring_queue_enqueue_wait requires valid pointers to an SPSC queue and value!");
+        return false;
+    }
+
+    for (u32 spin = 0; !ring_queue_enqueue_range(q, value, 1); ++spin) {
+        if (spin >= RING_QUEUE_SPIN_COUNT && q->hooks.wait) {
+            q->hooks.wait(q->hooks.context);
+        } else {
+            atomic_spin_pause();
+        }
+    }
+    return true;
+}
+
+b8 ring_queue_dequeue_wait(ring_queue* q, void* out_value) {
+    if (!q || !out_value || !(q->flags & RING_QUEUE_FLAG_SPSC_BIT)) {
+        MERROR("ring_queue_dequeue_wait requires valid pointers to an SPSC queue and out_value!");
+        return false;
+    }
+
+    for (u32 spin = 0; !ring_queue_dequeue_range(q, out_value, 1); ++spin) {
+        if (spin >= RING_QUEUE_SPIN_COUNT && q->hooks.wait) {
+            q->hooks.wait(q->hooks.context);
+        } else {
+            atomic_spin_pause();
+        }
+    }
+    return true;
+}
@@ -2,22 +2,75 @@
 
 #include "defines.h"
 
+typedef enum ring_queue_flag_bits {
+    RING_QUEUE_FLAG_NONE_BIT = 0x00,
+    // One producer thread and one consumer thread may use the queue at the same time without a lock.
+    // Only the producer may enqueue and only the consumer may dequeue or peek. The capacity must be a power of two
+    RING_QUEUE_FLAG_SPSC_BIT = 0x01
+} ring_queue_flag_bits;
+
+typedef u32 ring_queue_flags;
+
+// Lets a blocked SPSC side sleep instead of spinning, for example on an event or semaphore.
+// wait must return once notify has been called since the previous wait, and may return early
+typedef struct ring_queue_wait_hooks {
+    // Called by a side that still can not make progress after spinning for a while
+    void (*wait)(void* context);
+    // Called after an enqueue into an empty queue or a dequeue from a full one
+    void (*notify)(void* context);
+    void* context;
+} ring_queue_wait_hooks;
+
+#define RING_QUEUE_CACHE_LINE_SIZE 64
+
 typedef struct ring_queue {
-    u32 length;
     u32 stride;
     u32 capacity;
+    // capacity - 1 when the capacity is a power of two, 0 otherwise
+    u64 mask;
     void* block;
     b8 owns_memory;
-    i32 head;
-    i32 tail;
+    ring_queue_flags flags;
+    ring_queue_wait_hooks hooks;
+
+    // Each side's counters sit a full cache line away from everything the other side writes.
+    // head and tail count every element ever dequeued and enqueued, so they never wrap
+    u8 consumer_padding[RING_QUEUE_CACHE_LINE_SIZE];
+    volatile u64 head;
+    // The consumer's last view of tail, refreshed only when the queue looks empty
+    u64 cached_tail;
+    u8 producer_padding[RING_QUEUE_CACHE_LINE_SIZE];
+    volatile u64 tail;
+    // The producer's last view of head, refreshed only when the queue looks full
+    u64 cached_head;
+    u8 end_padding[RING_QUEUE_CACHE_LINE_SIZE];
 } ring_queue;
 
 MAPI b8 ring_queue_create(u32 stride, u32 capacity, void* memory, ring_queue* out_queue);
 
+MAPI b8 ring_queue_create_with_flags(u32 stride, u32 capacity, void* memory, ring_queue_flags flags, ring_queue* out_queue);
+
 MAPI void ring_queue_destroy(ring_queue* q);
 
+// Elements currently queued. Only a snapshot while the other side of an SPSC queue is running
+MAPI u32 ring_queue_length(ring_queue* q);
+
 MAPI b8 ring_queue_enqueue(ring_queue* q, void* value);
 
 MAPI b8 ring_queue_dequeue(ring_queue* q, void* out_value);
 
-MAPI b8 ring_queue_peek(const ring_queue* q, void* out_value);
\ No newline at end of file
+MAPI b8 ring_queue_peek(ring_queue* q, void* out_value);
+
+// Enqueues as many of the count elements stored contiguously in values as fit, and returns how many
+MAPI u32 ring_queue_enqueue_range(ring_queue* q, const void* values, u32 count);
+
+// Dequeues up to max_count elements into out_values and returns how many were dequeued
+MAPI u32 ring_queue_dequeue_range(ring_queue* q, void* out_values, u32 max_count);
+
+// Must be set before either side starts using the queue
+MAPI void ring_queue_set_wait_hooks(ring_queue* q, const ring_queue_wait_hooks* hooks);
+
+// SPSC only. Block until there is room or an element, waiting through the hooks when they are set
+MAPI b8 ring_queue_enqueue_wait(ring_queue* q, void* value);
+
+MAPI b8 ring_queue_dequeue_wait(ring_queue* q, void* out_value);
@@ -5,12 +5,8 @@
 
 static void stack_ensure_allocated(stack* s, u32 count) {
     if (s->allocated < s->stride * count) {
-        void* tmp = memory_allocate(count * s->stride, MEMORY_TAG_STACK);
-        if (s->memory) {
-            memory_copy(tmp, s->memory, s->allocated);
-            memory_free(s->memory, s->allocated, MEMORY_TAG_STACK);
-        }
-        s->memory = tmp;
+        // Slots are always written before they are read, so new memory is left uninitialized
+        s->memory = memory_reallocate_uninitialized(s->memory, s->allocated, count * s->stride, MEMORY_TAG_STACK);
         s->allocated = count * s->stride;
     }
 }
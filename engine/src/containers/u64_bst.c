@@ -1,10 +1,20 @@
 #include "u64_bst.h"
 
 #include "memory/memory.h"
+#include "core/logger.h"
 
 
-static bst_node* node_create(u64 key, bst_node_value value) {
-    bst_node* node = memory_allocate(sizeof(bst_node), MEMORY_TAG_BST);
+static bst_node* node_create(u64 key, bst_node_value value, frame_allocator_int* allocator) {
+    bst_node* node = nullptr;
+    if (allocator) {
+        node = allocator->allocate(allocator->context, sizeof(bst_node));
+    } else {
+        node = memory_allocate(sizeof(bst_node), MEMORY_TAG_BST);
+    }
+    if (!node) {
+        MERROR("u64_bst - Failed to allocate a node for key %llu.", key);
+        return nullptr;
+    }
     node->key = key;
     node->value = value;
     node->left = nullptr;
@@ -12,6 +22,14 @@ static bst_node* node_create(u64 key, bst_node_value value) {
     return node;
 }
 
+static void node_destroy(bst_node* node, frame_allocator_int* allocator) {
+    if (allocator) {
+        allocator->free(allocator->context, node, sizeof(bst_node));
+    } else {
+        memory_free(node, sizeof(bst_node), MEMORY_TAG_BST);
+    }
+}
+
 static bst_node* find_min(bst_node* root) {
     if (!root) {
         return nullptr;
@@ -23,30 +41,47 @@ static bst_node* find_min(bst_node* root) {
 
 
 bst_node* u64_bst_insert(bst_node* root, u64 key, bst_node_value value) {
+    return u64_bst_insert_with_allocator(root, key, value, nullptr);
+}
+
+bst_node* u64_bst_insert_with_allocator(bst_node* root, u64 key, bst_node_value value, frame_allocator_int* allocator) {
     if (!root) {
-        return node_create(key, value);
+        return node_create(key, value, allocator);
     }
 
+    // Children are only replaced once the insert below them succeeded, so a failure leaves the tree as it was
     if (key < root->key) {
-        root->left = u64_bst_insert(root->left, key, value);
+        bst_node* left = u64_bst_insert_with_allocator(root->left, key, value, allocator);
+        if (!left) {
+            return nullptr;
+        }
+        root->left = left;
     } else if (key > root->key) {
-        root->right = u64_bst_insert(root->right, key, value);
+        bst_node* right = u64_bst_insert_with_allocator(root->right, key, value, allocator);
+        if (!right) {
+            return nullptr;
+        }
+        root->right = right;
     }
     return root;
 }
 
 bst_node* u64_bst_delete(bst_node* root, u64 key) {
+    return u64_bst_delete_with_allocator(root, key, nullptr);
+}
+
+bst_node* u64_bst_delete_with_allocator(bst_node* root, u64 key, frame_allocator_int* allocator) {
     if (!root) {
         return nullptr;
     }
 
     if (key > root->key) {
-        root->right = u64_bst_delete(root->right, key);
+        root->right = u64_bst_delete_with_allocator(root->right, key, allocator);
     } else if (key < root->key) {
-        root->left = u64_bst_delete(root->left, key);
+        root->left = u64_bst_delete_with_allocator(root->left, key, allocator);
     } else {
         if (!root->left && !root->right) {
-            memory_free(root, sizeof(bst_node), MEMORY_TAG_BST);
+            node_destroy(root, allocator);
             return nullptr;
         } else if (!root || !root->right) {
             bst_node* tmp;
@@ -55,12 +90,13 @@ bst_node* u64_bst_delete(bst_node* root, u64 key) {
             } else {
                 tmp = root->left;
             }
-            memory_free(root, sizeof(bst_node), MEMORY_TAG_BST);
+            node_destroy(root, allocator);
             return tmp;
         } else {
             bst_node* tmp = find_min(root->right);
             root->key = tmp->key;
-            root->right = u64_bst_delete(root->right, tmp->key);
+            root->value = tmp->value;
+            root->right = u64_bst_delete_with_allocator(root->right, tmp->key, allocator);
         }
     }
     return root;
@@ -78,15 +114,19 @@ const bst_node* u64_bst_find(const bst_node* root, u64 key) {
 }
 
 void u64_bst_clear(bst_node* root) {
+    u64_bst_clear_with_allocator(root, nullptr);
+}
+
+void u64_bst_clear_with_allocator(bst_node* root, frame_allocator_int* allocator) {
     if (root) {
         if (root->left) {
-            u64_bst_clear(root->left);
+            u64_bst_clear_with_allocator(root->left, allocator);
             root->left = nullptr;
         }
         if (root->right) {
-            u64_bst_clear(root->right);
+            u64_bst_clear_with_allocator(root->right, allocator);
             root->right = nullptr;
         }
-        memory_free(root, sizeof(bst_node), MEMORY_TAG_BST);
+        node_destroy(root, allocator);
     }
 }
\ No newline at end of file
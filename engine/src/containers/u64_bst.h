@@ -2,6 +2,8 @@
 
 #include "defines.h"
 
+struct frame_allocator_int;
+
 typedef union bst_node_value {
     void* ptr;
     const char* str;
@@ -24,10 +26,21 @@ typedef struct bst_node {
     struct bst_node* right;
 } bst_node;
 
+// The tree is never rebalanced and every operation recurses, so keys inserted in order turn it into a list.
+// u64_btree stays balanced and should be preferred for new code
+// Returns the new root, or nullptr without touching the tree when a node could not be allocated
 MAPI bst_node* u64_bst_insert(bst_node* root, u64 key, bst_node_value value);
 
 MAPI bst_node* u64_bst_delete(bst_node* root, u64 key);
 
 MAPI const bst_node* u64_bst_find(const bst_node* root, u64 key);
 
-MAPI void u64_bst_clear(bst_node* root);
\ No newline at end of file
+MAPI void u64_bst_clear(bst_node* root);
+
+// Variants taking the allocator nodes are obtained from, such as a pool_allocator interface.
+// A tree must use the same allocator for every insert, delete and clear
+MAPI bst_node* u64_bst_insert_with_allocator(bst_node* root, u64 key, bst_node_value value, struct frame_allocator_int* allocator);
+
+MAPI bst_node* u64_bst_delete_with_allocator(bst_node* root, u64 key, struct frame_allocator_int* allocator);
+
+MAPI void u64_bst_clear_with_allocator(bst_node* root, struct frame_allocator_int* allocator);
\ No newline at end of file
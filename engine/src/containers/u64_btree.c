@@ -0,0 +1,441 @@
+#include "u64_btree.h"
+
+#include "memory/memory.h"
+#include "core/logger.h"
+
+// Even, so a full node plus the key being inserted splits into halves of MIN_KEYS and MIN_KEYS + 1
+#define MAX_KEYS 30
+// Removals refill or merge nodes below this. Splits while appending can leave rightmost nodes with fewer
+#define MIN_KEYS (MAX_KEYS / 2)
+// Nodes left of the rightmost ones have at least MIN_KEYS + 1 children, so this covers any tree that fits in memory
+#define MAX_DEPTH 16
+#define NODE_ALIGNMENT 64
+#define NODES_PER_CHUNK 128
+
+typedef struct u64_btree_node {
+    u32 count;
+    b8 is_leaf;
+    // In a leaf the stored keys. In an internal node keys[i] is the smallest key under children[i + 1]
+    u64 keys[MAX_KEYS];
+    union {
+        struct {
+            bst_node_value values[MAX_KEYS];
+            struct u64_btree_node* next;
+        } leaf;
+        struct u64_btree_node* children[MAX_KEYS + 1];
+    };
+} u64_btree_node;
+
+// A node on the way down from the root and the child taken from it
+typedef struct node_path {
+    u64_btree_node* nodes[MAX_DEPTH];
+    u32 indices[MAX_DEPTH];
+} node_path;
+
+// Index of the first key >= key
+static inline u32 lower_bound(const u64_btree_node* node, u64 key) {
+    u32 low = 0;
+    u32 high = node->count;
+    while (low < high) {
+        u32 mid = (low + high) / 2;
+        if (node->keys[mid] < key) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+// Index of the child holding key, the number of separators <= key
+static inline u32 child_index(const u64_btree_node* node, u64 key) {
+    u32 low = 0;
+    u32 high = node->count;
+    while (low < high) {
+        u32 mid = (low + high) / 2;
+        if (node->keys[mid] <= key) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+static u64_btree_node* node_create(u64_btree* tree, b8 is_leaf) {
+    u64_btree_node* node = pool_allocator_allocate(&tree->node_pool);
+    if (!node) {
+        MERROR("u64_btree - Failed to allocate a node.");
+        return nullptr;
+    }
+    node->count = 0;
+    node->is_leaf = is_leaf;
+    if (is_leaf) {
+        node->leaf.next = nullptr;
+    }
+    return node;
+}
+
+static void node_destroy(u64_btree* tree, u64_btree_node* node) {
+    pool_allocator_free(&tree->node_pool, node);
+}
+
+// Descends to the leaf that holds or would hold the key, recording the path when one is given
+static u64_btree_node* find_leaf(const u64_btree* tree, u64 key, node_path* path) {
+    u64_btree_node* node = tree->root;
+    for (u32 level = 0; !node->is_leaf; ++level) {
+        u32 index = child_index(node, key);
+        if (path) {
+            path->nodes[level] = node;
+            path->indices[level] = index;
+        }
+        node = node->children[index];
+    }
+    return node;
+}
+
+b8 u64_btree_create(u64_btree* out_tree) {
+    if (!out_tree) {
+        MERROR("u64_btree_create - Required a valid pointer to out_tree!");
+        return false;
+    }
+
+    memory_zero(out_tree, sizeof(u64_btree));
+    if (!pool_allocator_create(sizeof(u64_btree_node), NODE_ALIGNMENT, NODES_PER_CHUNK, POOL_ALLOCATOR_FLAG_NONE_BIT, &out_tree->node_pool)) {
+        MERROR("u64_btree_create - Failed to create the node pool.");
+        return false;
+    }
+    return true;
+}
+
+void u64_btree_destroy(u64_btree* tree) {
+    if (tree) {
+        pool_allocator_destroy(&tree->node_pool);
+        memory_zero(tree, sizeof(u64_btree));
+    }
+}
+
+b8 u64_btree_insert(u64_btree* tree, u64 key, bst_node_value value) {
+    if (!tree) {
+        MERROR("u64_btree_insert requires tree to exist.");
+        return false;
+    }
+
+    if (!tree->root) {
+        tree->root = node_create(tree, true);
+        if (!tree->root) {
+            return false;
+        }
+        tree->height = 1;
+    }
+
+    node_path path;
+    u64_btree_node* leaf = find_leaf(tree, key, &path);
+    u32 index = lower_bound(leaf, key);
+    if (index < leaf->count && leaf->keys[index] == key) {
+        leaf->leaf.values[index] = value;
+        return true;
+    }
+
+    if (leaf->count < MAX_KEYS) {
+        memory_move(&leaf->keys[index + 1], &leaf->keys[index], sizeof(u64) * (leaf->count - index));
+        memory_move(&leaf->leaf.values[index + 1], &leaf->leaf.values[index], sizeof(bst_node_value) * (leaf->count - index));
+        leaf->keys[index] = key;
+        leaf->leaf.values[index] = value;
+        leaf->count++;
+        tree->count++;
+        return true;
+    }
+
+    // Every node split on the way up needs a new node, so they are all taken before anything changes
+    u32 split_count = 1;
+    for (i32 level = (i32)tree->height - 2; level >= 0 && path.nodes[level]->count == MAX_KEYS; --level) {
+        split_count++;
+    }
+    u64_btree_node* spare[MAX_DEPTH + 1];
+    u32 spare_needed = split_count + (split_count == tree->height ? 1 : 0);
+    for (u32 i = 0; i < spare_needed; ++i) {
+        spare[i] = pool_allocator_allocate(&tree->node_pool);
+        if (!spare[i]) {
+            MERROR("u64_btree_insert - Failed to allocate a node.");
+            while (i--) {
+                node_destroy(tree, spare[i]);
+            }
+            return false;
+        }
+    }
+
+    // The full leaf and the new key, split into a left half kept in place and a right half in a new leaf
+    u64 keys[MAX_KEYS + 1];
+    bst_node_value values[MAX_KEYS + 1];
+    memory_copy(keys, leaf->keys, sizeof(u64) * index);
+    memory_copy(values, leaf->leaf.values, sizeof(bst_node_value) * index);
+    keys[index] = key;
+    values[index] = value;
+    memory_copy(&keys[index + 1], &leaf->keys[index], sizeof(u64) * (MAX_KEYS - index));
+    memory_copy(&values[index + 1], &leaf->leaf.values[index], sizeof(bst_node_value) * (MAX_KEYS - index));
+
+    // Appending past the largest key, as increasing ids do, leaves the left nodes full instead of half
+    // full. Nothing will be inserted into them, so an even split would only waste their other half
+    b8 appending = index == MAX_KEYS && !leaf->leaf.next;
+    u32 left_count = appending ? MAX_KEYS : MIN_KEYS;
+    u64_btree_node* right = spare[--spare_needed];
+    right->is_leaf = true;
+    right->count = MAX_KEYS + 1 - left_count;
+    memory_copy(right->keys, &keys[left_count], sizeof(u64) * right->count);
+    memory_copy(right->leaf.values, &values[left_count], sizeof(bst_node_value) * right->count);
+    right->leaf.next = leaf->leaf.next;
+    leaf->count = left_count;
+    memory_copy(leaf->keys, keys, sizeof(u64) * left_count);
+    memory_copy(leaf->leaf.values, values, sizeof(bst_node_value) * left_count);
+    leaf->leaf.next = right;
+    tree->count++;
+
+    // Hands the separator and the new right node to the parent, splitting full parents on the way up
+    u64 separator = right->keys[0];
+    for (i32 level = (i32)tree->height - 2; level >= 0; --level) {
+        u64_btree_node* node = path.nodes[level];
+        u32 at = path.indices[level];
+        if (node->count < MAX_KEYS) {
+            memory_move(&node->keys[at + 1], &node->keys[at], sizeof(u64) * (node->count - at));
+            memory_move(&node->children[at + 2], &node->children[at + 1], sizeof(u64_btree_node*) * (node->count - at));
+            node->keys[at] = separator;
+            node->children[at + 1] = right;
+            node->count++;
+            return true;
+        }
+
+        u64_btree_node* children[MAX_KEYS + 2];
+        memory_copy(keys, node->keys, sizeof(u64) * at);
+        keys[at] = separator;
+        memory_copy(&keys[at + 1], &node->keys[at], sizeof(u64) * (MAX_KEYS - at));
+        memory_copy(children, node->children, sizeof(u64_btree_node*) * (at + 1));
+        children[at + 1] = right;
+        memory_copy(&children[at + 2], &node->children[at + 1], sizeof(u64_btree_node*) * (MAX_KEYS - at));
+
+        // The key after the left half moves up instead of staying in either half. When appending the
+        // right node keeps a key, as a node without one would have no sibling to merge with
+        left_count = appending ? MAX_KEYS - 1 : MIN_KEYS;
+        right = spare[--spare_needed];
+        right->is_leaf = false;
+        right->count = MAX_KEYS - left_count;
+        memory_copy(right->keys, &keys[left_count + 1], sizeof(u64) * right->count);
+        memory_copy(right->children, &children[left_count + 1], sizeof(u64_btree_node*) * (right->count + 1));
+        node->count = left_count;
+        memory_copy(node->keys, keys, sizeof(u64) * left_count);
+        memory_copy(node->children, children, sizeof(u64_btree_node*) * (left_count + 1));
+        separator = keys[left_count];
+    }
+
+    // The root split, so the tree grows a level
+    u64_btree_node* root = spare[--spare_needed];
+    root->is_leaf = false;
+    root->count = 1;
+    root->keys[0] = separator;
+    root->children[0] = tree->root;
+    root->children[1] = right;
+    tree->root = root;
+    tree->height++;
+    return true;
+}
+
+bst_node_value* u64_btree_find(const u64_btree* tree, u64 key) {
+    if (!tree || !tree->root) {
+        return nullptr;
+    }
+
+    u64_btree_node* leaf = find_leaf(tree, key, nullptr);
+    u32 index = lower_bound(leaf, key);
+    if (index < leaf->count && leaf->keys[index] == key) {
+        return &leaf->leaf.values[index];
+    }
+    return nullptr;
+}
+
+// Refills a leaf that fell below MIN_KEYS from a sibling, or merges it with one. Returns true when the
+// parent lost a child
+static b8 rebalance_leaf(u64_btree* tree, u64_btree_node* parent, u32 at) {
+    u64_btree_node* node = parent->children[at];
+    u64_btree_node* left = at > 0 ? parent->children[at - 1] : nullptr;
+    u64_btree_node* right = at < parent->count ? parent->children[at + 1] : nullptr;
+
+    if (left && left->count > MIN_KEYS) {
+        memory_move(&node->keys[1], node->keys, sizeof(u64) * node->count);
+        memory_move(&node->leaf.values[1], node->leaf.values, sizeof(bst_node_value) * node->count);
+        left->count--;
+        node->keys[0] = left->keys[left->count];
+        node->leaf.values[0] = left->leaf.values[left->count];
+        node->count++;
+        parent->keys[at - 1] = node->keys[0];
+        return false;
+    }
+
+    if (right && right->count > MIN_KEYS) {
+        node->keys[node->count] = right->keys[0];
+        node->leaf.values[node->count] = right->leaf.values[0];
+        node->count++;
+        right->count--;
+        memory_move(right->keys, &right->keys[1], sizeof(u64) * right->count);
+        memory_move(right->leaf.values, &right->leaf.values[1], sizeof(bst_node_value) * right->count);
+        parent->keys[at] = right->keys[0];
+        return false;
+    }
+
+    // Merges the right one of the pair into the left one
+    if (!left) {
+        left = node;
+        node = right;
+        at++;
+    }
+    memory_copy(&left->keys[left->count], node->keys, sizeof(u64) * node->count);
+    memory_copy(&left->leaf.values[left->count], node->leaf.values, sizeof(bst_node_value) * node->count);
+    left->count += node->count;
+    left->leaf.next = node->leaf.next;
+    node_destroy(tree, node);
+
+    memory_move(&parent->keys[at - 1], &parent->keys[at], sizeof(u64) * (parent->count - at));
+    memory_move(&parent->children[at], &parent->children[at + 1], sizeof(u64_btree_node*) * (parent->count - at));
+    parent->count--;
+    return true;
+}
+
+// Same as rebalance_leaf for internal nodes, where the separator in the parent rotates through
+static b8 rebalance_internal(u64_btree* tree, u64_btree_node* parent, u32 at) {
+    u64_btree_node* node = parent->children[at];
+    u64_btree_node* left = at > 0 ? parent->children[at - 1] : nullptr;
+    u64_btree_node* right = at < parent->count ? parent->children[at + 1] : nullptr;
+
+    if (left && left->count > MIN_KEYS) {
+        memory_move(&node->keys[1], node->keys, sizeof(u64) * node->count);
+        memory_move(&node->children[1], node->children, sizeof(u64_btree_node*) * (node->count + 1));
+        node->keys[0] = parent->keys[at - 1];
+        node->children[0] = left->children[left->count];
+        node->count++;
+        parent->keys[at - 1] = left->keys[left->count - 1];
+        left->count--;
+        return false;
+    }
+
+    if (right && right->count > MIN_KEYS) {
+        node->keys[node->count] = parent->keys[at];
+        node->children[node->count + 1] = right->children[0];
+        node->count++;
+        parent->keys[at] = right->keys[0];
+        right->count--;
+        memory_move(right->keys, &right->keys[1], sizeof(u64) * right->count);
+        memory_move(right->children, &right->children[1], sizeof(u64_btree_node*) * (right->count + 1));
+        return false;
+    }
+
+    if (!left) {
+        left = node;
+        node = right;
+        at++;
+    }
+    left->keys[left->count] = parent->keys[at - 1];
+    memory_copy(&left->keys[left->count + 1], node->keys, sizeof(u64) * node->count);
+    memory_copy(&left->children[left->count + 1], node->children, sizeof(u64_btree_node*) * (node->count + 1));
+    left->count += node->count + 1;
+    node_destroy(tree, node);
+
+    memory_move(&parent->keys[at - 1], &parent->keys[at], sizeof(u64) * (parent->count - at));
+    memory_move(&parent->children[at], &parent->children[at + 1], sizeof(u64_btree_node*) * (parent->count - at));
+    parent->count--;
+    return true;
+}
+
+b8 u64_btree_remove(u64_btree* tree, u64 key) {
+    if (!tree) {
+        MERROR("u64_btree_remove requires tree to exist.");
+        return false;
+    }
+
+    if (!tree->root) {
+        return false;
+    }
+
+    node_path path;
+    u64_btree_node* leaf = find_leaf(tree, key, &path);
+    u32 index = lower_bound(leaf, key);
+    if (index >= leaf->count || leaf->keys[index] != key) {
+        return false;
+    }
+
+    leaf->count--;
+    memory_move(&leaf->keys[index], &leaf->keys[index + 1], sizeof(u64) * (leaf->count - index));
+    memory_move(&leaf->leaf.values[index], &leaf->leaf.values[index + 1], sizeof(bst_node_value) * (leaf->count - index));
+    tree->count--;
+
+    // Separators equal to the removed key stay valid bounds, so only underfull nodes need fixing
+    i32 level = (i32)tree->height - 2;
+    if (level >= 0 && leaf->count < MIN_KEYS && rebalance_leaf(tree, path.nodes[level], path.indices[level])) {
+        for (--level; level >= 0 && path.nodes[level + 1]->count < MIN_KEYS; --level) {
+            if (!rebalance_internal(tree, path.nodes[level], path.indices[level])) {
+                break;
+            }
+        }
+    }
+
+    // A root left with a single child hands the tree to it, and an empty root leaf goes away
+    u64_btree_node* root = tree->root;
+    if (!root->is_leaf && root->count == 0) {
+        tree->root = root->children[0];
+        tree->height--;
+        node_destroy(tree, root);
+    } else if (root->is_leaf && root->count == 0) {
+        tree->root = nullptr;
+        tree->height = 0;
+        node_destroy(tree, root);
+    }
+    return true;
+}
+
+void u64_btree_clear(u64_btree* tree) {
+    if (tree) {
+        pool_allocator_free_all(&tree->node_pool);
+        tree->root = nullptr;
+        tree->count = 0;
+        tree->height = 0;
+    }
+}
+
+void u64_btree_begin(const u64_btree* tree, u64_btree_iterator* out_iterator) {
+    u64_btree_range(tree, 0, U64_MAX, out_iterator);
+}
+
+void u64_btree_range(const u64_btree* tree, u64 min_key, u64 max_key, u64_btree_iterator* out_iterator) {
+    out_iterator->leaf = nullptr;
+    out_iterator->index = 0;
+    out_iterator->max_key = max_key;
+    if (!tree || !tree->root) {
+        return;
+    }
+
+    out_iterator->leaf = find_leaf(tree, min_key, nullptr);
+    out_iterator->index = lower_bound(out_iterator->leaf, min_key);
+    // The key may be past the end of its leaf, so move to the next one
+    if (out_iterator->index == out_iterator->leaf->count) {
+        out_iterator->leaf = out_iterator->leaf->leaf.next;
+        out_iterator->index = 0;
+    }
+}
+
+b8 u64_btree_iterator_valid(const u64_btree_iterator* iterator) {
+    return iterator->leaf && iterator->leaf->keys[iterator->index] <= iterator->max_key;
+}
+
+void u64_btree_iterator_next(u64_btree_iterator* iterator) {
+    iterator->index++;
+    if (iterator->index == iterator->leaf->count) {
+        iterator->leaf = iterator->leaf->leaf.next;
+        iterator->index = 0;
+    }
+}
+
+u64 u64_btree_iterator_key(const u64_btree_iterator* iterator) {
+    return iterator->leaf->keys[iterator->index];
+}
+
+bst_node_value* u64_btree_iterator_value(const u64_btree_iterator* iterator) {
+    return &iterator->leaf->leaf.values[iterator->index];
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "defines.h"
+#include "containers/u64_bst.h"
+#include "memory/allocators/pool_allocator.h"
+
+struct u64_btree_node;
+
+// Ordered map keyed by u64. A B+tree with nodes of up to 30 keys, so a lookup touches a handful of
+// cache lines per level and sorted inserts keep it balanced. Values live in the leaves, which are
+// linked in key order for iteration. Nodes come from a pool owned by the tree. Not thread safe
+typedef struct u64_btree {
+    struct u64_btree_node* root;
+    // Keys currently stored
+    u64 count;
+    // Levels from the root to the leaves, 0 when the tree is empty
+    u32 height;
+    pool_allocator node_pool;
+} u64_btree;
+
+// Walks the leaves in key order, up to and including max_key
+typedef struct u64_btree_iterator {
+    struct u64_btree_node* leaf;
+    u32 index;
+    u64 max_key;
+} u64_btree_iterator;
+
+MAPI b8 u64_btree_create(u64_btree* out_tree);
+
+MAPI void u64_btree_destroy(u64_btree* tree);
+
+// Inserts the key or overwrites its value
+MAPI b8 u64_btree_insert(u64_btree* tree, u64 key, bst_node_value value);
+
+// Returns the value stored for the key, or nullptr. It is valid until the tree is next changed
+MAPI bst_node_value* u64_btree_find(const u64_btree* tree, u64 key);
+
+// Returns false when the key was not stored
+MAPI b8 u64_btree_remove(u64_btree* tree, u64 key);
+
+// Removes every key. Nodes are kept in the pool for reuse
+MAPI void u64_btree_clear(u64_btree* tree);
+
+// Positions the iterator on the smallest key
+MAPI void u64_btree_begin(const u64_btree* tree, u64_btree_iterator* out_iterator);
+
+// Positions the iterator on the smallest key >= min_key, and stops it after max_key
+MAPI void u64_btree_range(const u64_btree* tree, u64 min_key, u64 max_key, u64_btree_iterator* out_iterator);
+
+// False once the iterator has passed the last key of its range. Changing the tree invalidates iterators
+MAPI b8 u64_btree_iterator_valid(const u64_btree_iterator* iterator);
+
+MAPI void u64_btree_iterator_next(u64_btree_iterator* iterator);
+
+MAPI u64 u64_btree_iterator_key(const u64_btree_iterator* iterator);
+
+MAPI bst_node_value* u64_btree_iterator_value(const u64_btree_iterator* iterator);
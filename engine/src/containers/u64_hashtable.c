@@ -0,0 +1,177 @@
+#include "u64_hashtable.h"
+
+#include "memory/memory.h"
+#include "core/logger.h"
+
+#define MIN_CAPACITY 8
+#define MAX_CAPACITY (1u << 31)
+
+static inline u8* slot_at(const u64_hashtable* table, u64 index) {
+    return (u8*)table->slots + index * table->slot_size;
+}
+
+static inline u64 slot_key(const u8* slot) {
+    return *(const u64*)slot;
+}
+
+static b8 table_allocate(u64_hashtable* table, u32 capacity) {
+    void* slots = memory_allocate_uninitialized((u64)capacity * table->slot_size, MEMORY_TAG_HASHTABLE);
+    if (!slots) {
+        MERROR("u64_hashtable - Failed to allocate a table of %u slots.", capacity);
+        return false;
+    }
+
+    table->slots = slots;
+    table->capacity = capacity;
+    table->max_count = capacity - capacity / 4;
+    u64_hashtable_clear(table);
+    return true;
+}
+
+// Returns the slot holding the key, or the empty slot it would go into
+static inline u64 probe(const u64_hashtable* table, u64 key) {
+    u64 mask = table->capacity - 1;
+    u64 index = hash_u64(key) & mask;
+    for (;;) {
+        u64 stored = slot_key(slot_at(table, index));
+        if (stored == key || stored == U64_HASHTABLE_EMPTY_KEY) {
+            return index;
+        }
+        index = (index + 1) & mask;
+    }
+}
+
+static b8 table_grow(u64_hashtable* table) {
+    if (table->capacity >= MAX_CAPACITY) {
+        MERROR("u64_hashtable - Table can not grow past %u slots.", MAX_CAPACITY);
+        return false;
+    }
+
+    u64_hashtable old = *table;
+    if (!table_allocate(table, old.capacity * 2)) {
+        *table = old;
+        return false;
+    }
+
+    for (u32 i = 0; i < old.capacity; ++i) {
+        u8* slot = slot_at(&old, i);
+        if (slot_key(slot) != U64_HASHTABLE_EMPTY_KEY) {
+            memory_copy(slot_at(table, probe(table, slot_key(slot))), slot, table->slot_size);
+        }
+    }
+    table->count = old.count;
+
+    memory_free(old.slots, (u64)old.capacity * old.slot_size, MEMORY_TAG_HASHTABLE);
+    return true;
+}
+
+b8 u64_hashtable_create(u64 value_size, u32 element_count, u64_hashtable* out_table) {
+    if (!value_size || !element_count) {
+        MERROR("u64_hashtable_create - value_size and element_count must be a positive non-zero value!");
+        return false;
+    }
+
+    if (!out_table) {
+        MERROR("u64_hashtable_create - Required a valid pointer to out_table!");
+        return false;
+    }
+
+    u32 capacity = MIN_CAPACITY;
+    while (capacity < MAX_CAPACITY && capacity - capacity / 4 < element_count) {
+        capacity *= 2;
+    }
+
+    memory_zero(out_table, sizeof(u64_hashtable));
+    out_table->value_size = value_size;
+    out_table->slot_size = U64_HASHTABLE_SLOT_SIZE(value_size);
+    if (!table_allocate(out_table, capacity)) {
+        memory_zero(out_table, sizeof(u64_hashtable));
+        return false;
+    }
+    return true;
+}
+
+void u64_hashtable_destroy(u64_hashtable* table) {
+    if (table) {
+        if (table->slots) {
+            memory_free(table->slots, (u64)table->capacity * table->slot_size, MEMORY_TAG_HASHTABLE);
+        }
+        memory_zero(table, sizeof(u64_hashtable));
+    }
+}
+
+b8 u64_hashtable_set(u64_hashtable* table, u64 key, const void* value) {
+    if (!table || !value) {
+        MERROR("u64_hashtable_set requires table and value to exist.");
+        return false;
+    }
+
+    if (key == U64_HASHTABLE_EMPTY_KEY) {
+        MERROR("u64_hashtable_set - INVALID_ID_U64 can not be used as a key.");
+        return false;
+    }
+
+    u64 index = probe(table, key);
+    u8* slot = slot_at(table, index);
+    if (slot_key(slot) == U64_HASHTABLE_EMPTY_KEY) {
+        if (table->count >= table->max_count) {
+            if (!table_grow(table)) {
+                return false;
+            }
+            slot = slot_at(table, probe(table, key));
+        }
+        *(u64*)slot = key;
+        table->count++;
+    }
+
+    memory_copy(slot + sizeof(u64), value, table->value_size);
+    return true;
+}
+
+b8 u64_hashtable_remove(u64_hashtable* table, u64 key) {
+    if (!table) {
+        MERROR("u64_hashtable_remove requires table to exist.");
+        return false;
+    }
+
+    if (key == U64_HASHTABLE_EMPTY_KEY) {
+        return false;
+    }
+
+    u64 mask = table->capacity - 1;
+    u64 hole = probe(table, key);
+    if (slot_key(slot_at(table, hole)) == U64_HASHTABLE_EMPTY_KEY) {
+        return false;
+    }
+
+    // Moves back every following entry of the run that the hole would otherwise cut off from its home slot
+    for (u64 index = (hole + 1) & mask;; index = (index + 1) & mask) {
+        u8* slot = slot_at(table, index);
+        u64 stored = slot_key(slot);
+        if (stored == U64_HASHTABLE_EMPTY_KEY) {
+            break;
+        }
+
+        // Distances are measured from the hole, so the wrap around the end needs no special case
+        u64 home = hash_u64(stored) & mask;
+        if (((index - home) & mask) >= ((index - hole) & mask)) {
+            memory_copy(slot_at(table, hole), slot, table->slot_size);
+            hole = index;
+        }
+    }
+
+    *(u64*)slot_at(table, hole) = U64_HASHTABLE_EMPTY_KEY;
+    table->count--;
+    return true;
+}
+
+void u64_hashtable_clear(u64_hashtable* table) {
+    if (!table) {
+        return;
+    }
+
+    for (u32 i = 0; i < table->capacity; ++i) {
+        *(u64*)slot_at(table, i) = U64_HASHTABLE_EMPTY_KEY;
+    }
+    table->count = 0;
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "defines.h"
+#include "core/hash.h"
+
+// Marks an empty slot, so it can not be used as a key. Matches the invalid id of the handles used as keys
+#define U64_HASHTABLE_EMPTY_KEY INVALID_ID_U64
+
+// Each slot is the key followed by the value, padded to 8 bytes. Values need at most 8 byte alignment
+#define U64_HASHTABLE_SLOT_SIZE(value_size) (sizeof(u64) + (((value_size) + 7) & ~(u64)7))
+
+// Linear probing table keyed by u64, with keys and values stored inline in the slots. Removal shifts
+// the following entries back instead of leaving tombstones, so a lookup stops at the first empty slot
+typedef struct u64_hashtable {
+    u32 value_size;
+    u32 slot_size;
+    // Keys currently stored
+    u32 count;
+    // Slot count, always a power of two
+    u32 capacity;
+    // Keys stored before the table grows, 3/4 of the capacity
+    u32 max_count;
+    void* slots;
+} u64_hashtable;
+
+// Creates a table holding element_count keys without growing
+MAPI b8 u64_hashtable_create(u64 value_size, u32 element_count, u64_hashtable* out_table);
+
+MAPI void u64_hashtable_destroy(u64_hashtable* table);
+
+// Inserts the key or overwrites its value
+MAPI b8 u64_hashtable_set(u64_hashtable* table, u64 key, const void* value);
+
+// Returns false when the key was not stored
+MAPI b8 u64_hashtable_remove(u64_hashtable* table, u64 key);
+
+MAPI void u64_hashtable_clear(u64_hashtable* table);
+
+// Returns the value stored for the key, or nullptr. slot_size is passed in so typed tables get a constant stride
+MINLINE void* _u64_hashtable_find(const u64_hashtable* table, u64 key, u64 slot_size) {
+    if (key == U64_HASHTABLE_EMPTY_KEY) {
+        return nullptr;
+    }
+
+    u64 mask = table->capacity - 1;
+    u64 index = hash_u64(key) & mask;
+    for (;;) {
+        u8* slot = (u8*)table->slots + index * slot_size;
+        u64 stored = *(u64*)slot;
+        if (stored == key) {
+            return slot + sizeof(u64);
+        }
+        if (stored == U64_HASHTABLE_EMPTY_KEY) {
+            return nullptr;
+        }
+        index = (index + 1) & mask;
+    }
+}
+
+// Returns a pointer to the value stored for the key, or nullptr. It is valid until the table is next changed
+MINLINE void* u64_hashtable_get(const u64_hashtable* table, u64 key) {
+    return _u64_hashtable_find(table, key, table->slot_size);
+}
+
+#define U64_HASHTABLE_TYPE_NAMED(type, name)                                                                       \
+    typedef struct u64_hashtable_##name {                                                                          \
+        u64_hashtable base;                                                                                        \
+    } u64_hashtable_##name;                                                                                        \
+                                                                                                                   \
+    MINLINE b8 u64_hashtable_##name##_create(u32 element_count, u64_hashtable_##name* out_table) {                 \
+        return u64_hashtable_create(sizeof(type), element_count, &out_table->base);                                \
+    }                                                                                                              \
+                                                                                                                   \
+    MINLINE void u64_hashtable_##name##_destroy(u64_hashtable_##name* table) {                                     \
+        u64_hashtable_destroy(&table->base);                                                                       \
+    }                                                                                                              \
+                                                                                                                   \
+    MINLINE b8 u64_hashtable_##name##_set(u64_hashtable_##name* table, u64 key, type value) {                      \
+        return u64_hashtable_set(&table->base, key, &value);                                                       \
+    }                                                                                                              \
+                                                                                                                   \
+    MINLINE type* u64_hashtable_##name##_get(const u64_hashtable_##name* table, u64 key) {                         \
+        return (type*)_u64_hashtable_find(&table->base, key, U64_HASHTABLE_SLOT_SIZE(sizeof(type)));               \
+    }                                                                                                              \
+                                                                                                                   \
+    MINLINE b8 u64_hashtable_##name##_try_get(const u64_hashtable_##name* table, u64 key, type* out_value) {       \
+        type* value = (type*)_u64_hashtable_find(&table->base, key, U64_HASHTABLE_SLOT_SIZE(sizeof(type)));        \
+        if (!value) {                                                                                              \
+            return false;                                                                                          \
+        }                                                                                                          \
+        *out_value = *value;                                                                                       \
+        return true;                                                                                               \
+    }                                                                                                              \
+                                                                                                                   \
+    MINLINE b8 u64_hashtable_##name##_remove(u64_hashtable_##name* table, u64 key) {                               \
+        return u64_hashtable_remove(&table->base, key);                                                            \
+    }                                                                                                              \
+                                                                                                                   \
+    MINLINE void u64_hashtable_##name##_clear(u64_hashtable_##name* table) {                                       \
+        u64_hashtable_clear(&table->base);                                                                         \
+    }
+
+// Create a table type with values of the given type. For pointers, use U64_HASHTABLE_TYPE_NAMED directly.
+#define U64_HASHTABLE_TYPE(type) U64_HASHTABLE_TYPE_NAMED(type, type)
+
+// Create table types for well-known types
+
+U64_HASHTABLE_TYPE(u32);
+U64_HASHTABLE_TYPE(u64);
+
+U64_HASHTABLE_TYPE_NAMED(void*, ptr);
@@ -4,8 +4,11 @@
 #include "game_types.h"
 #include "platform/platform.h"
 #include "memory/memory.h"
+#include "memory/allocators/linear_allocator.h"
+#include "memory/memory_profiler.h"
 #include "core/event.h"
 #include "core/input.h"
+#include "strings/name.h"
 
 #include "renderer/renderer_frontend.h"
 
@@ -20,6 +23,14 @@ typedef struct engine_state {
 
     f64 last_time;
 
+    // Double-buffered arenas for transient data. A frame's arena is reset when the frame starts,
+    // so data allocated during one frame is still valid during the next
+    void* frame_arena_block;
+    linear_allocator frame_arenas[2];
+    frame_allocator_int frame_allocators[2];
+    u64 frame_number;
+    u64 frame_allocator_peak;
+
     game* game_instance;
 } engine_state;
 
@@ -50,13 +61,71 @@ b8 engine_on_event(u16 code, void* sender, void* listener, event_context ctx) {
     return true;
 }
 
+// Frame allocations are rounded up so every block stays 16 byte aligned
+#define FRAME_ALLOCATOR_ALIGNMENT 16
+
+static void* frame_allocator_allocate(void* context, u64 size) {
+    return linear_allocator_allocate(context, get_aligned(size, FRAME_ALLOCATOR_ALIGNMENT));
+}
+
+static void frame_allocator_free(void* context, void* block, u64 size) {
+    // NOTE: Intentional no-op, the whole arena is released at once
+}
+
+static void frame_allocator_free_all(void* context) {
+    linear_allocator_free_all(context, false);
+}
+
+static b8 frame_allocators_create(u64 arena_size) {
+    arena_size = get_aligned(arena_size, FRAME_ALLOCATOR_ALIGNMENT);
+    state.frame_arena_block = memory_allocate_aligned(arena_size * 2, FRAME_ALLOCATOR_ALIGNMENT, MEMORY_TAG_ENGINE);
+    if (!state.frame_arena_block) {
+        MERROR("Failed to allocate %llu bytes for the frame allocators.", arena_size * 2);
+        return false;
+    }
+    for (u32 i = 0; i < 2; ++i) {
+        // Concurrent, so jobs working on the frame can allocate from its arena too
+        linear_allocator_create_with_flags(arena_size, (u8*)state.frame_arena_block + arena_size * i, LINEAR_ALLOCATOR_FLAG_CONCURRENT_BIT, &state.frame_arenas[i]);
+        state.frame_allocators[i].allocate = frame_allocator_allocate;
+        state.frame_allocators[i].free = frame_allocator_free;
+        state.frame_allocators[i].free_all = frame_allocator_free_all;
+        state.frame_allocators[i].context = &state.frame_arenas[i];
+    }
+    state.frame_number = 0;
+    state.frame_allocator_peak = 0;
+    return true;
+}
+
+static void frame_allocators_destroy(void) {
+    u64 arena_size = state.frame_arenas[0].total_size;
+    MINFO("Frame allocator peak usage: %llu of %llu bytes per frame.", state.frame_allocator_peak, arena_size);
+
+    for (u32 i = 0; i < 2; ++i) {
+        linear_allocator_destroy(&state.frame_arenas[i]);
+    }
+    memory_free_aligned(state.frame_arena_block, arena_size * 2, FRAME_ALLOCATOR_ALIGNMENT, MEMORY_TAG_ENGINE);
+    state.frame_arena_block = nullptr;
+}
+
 b8 engine_initialize(game* game_instance) {
     state.game_instance = game_instance;
     state.main_window = nullptr;
 
     // Initialize subsystems
-    memory_system_initialize();
+    memory_system_config memory_config = {0};
+    memory_config.total_alloc_size = GIBIBYTES(1);
+    if (!memory_system_initialize(memory_config)) {
+        return false;
+    }
     logging_system_initialize();
+    name_system_initialize();
+
+    u64 frame_allocator_size = game_instance->config.frame_allocator_size;
+    if (!frame_allocators_create(frame_allocator_size ? frame_allocator_size : ENGINE_DEFAULT_FRAME_ALLOCATOR_SIZE)) {
+        MFATAL("Failed to create the frame allocators!");
+        return false;
+    }
+
     event_system_initialize();
     input_system_initialize();
 
@@ -107,14 +176,34 @@ b8 engine_run() {
             state.is_running = false;
         }
 
-        if (!state.game_instance->update(state.game_instance, 0.0f)) {
+        u32 arena_index = state.frame_number % 2;
+        linear_allocator* arena = &state.frame_arenas[arena_index];
+        frame_allocator_free_all(arena);
+
+        frame_data frame;
+        frame.allocator = &state.frame_allocators[arena_index];
+        frame.frame_number = state.frame_number;
+
+        if (!state.game_instance->update(state.game_instance, 0.0f, &frame)) {
             MERROR("game_update failed!");
         }
 
-        if (!state.game_instance->render(state.game_instance, 0.0f)) {
+        if (!state.game_instance->render(state.game_instance, 0.0f, &frame)) {
             MERROR("game_render failed!");
         }
 
+        if (arena->allocated > state.frame_allocator_peak) {
+            state.frame_allocator_peak = arena->allocated;
+        }
+#if MEMORY_PROFILER_ENABLED
+        memory_profiler_sample();
+#endif
+        u32 report_interval = state.game_instance->config.fragmentation_report_interval;
+        if (report_interval && state.frame_number % report_interval == 0) {
+            memory_log_fragmentation();
+        }
+        state.frame_number++;
+
     }
 
     state.is_running = false;
@@ -127,10 +216,21 @@ b8 engine_run() {
     platform_system_shutdown();
     input_system_shutdown();
     event_system_shutdown();
+    frame_allocators_destroy();
+    name_system_shutdown();
     logging_system_shutdown();
     memory_system_shutdown();
 
     MTRACE("Goodbye!");
 
     return true;
+}
+
+void engine_get_frame_allocator_usage(u64* out_peak, u64* out_capacity) {
+    if (out_peak) {
+        *out_peak = state.frame_allocator_peak;
+    }
+    if (out_capacity) {
+        *out_capacity = state.frame_arenas[0].total_size;
+    }
 }
\ No newline at end of file
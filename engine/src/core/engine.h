@@ -4,11 +4,21 @@
 
 struct game;
 
+// Size of each per-frame arena when engine_config.frame_allocator_size is 0
+#define ENGINE_DEFAULT_FRAME_ALLOCATOR_SIZE MEBIBYTES(8)
+
 typedef struct engine_config {
     const char* app_name;
     u32 window_width;
     u32 window_height;
+    // Size in bytes of each of the two arenas backing the per-frame allocator
+    u64 frame_allocator_size;
+    // Frames between heap fragmentation reports in the log. 0 disables them
+    u32 fragmentation_report_interval;
 } engine_config;
 
 MAPI b8 engine_initialize(struct game* game_instance);
-MAPI b8 engine_run();
\ No newline at end of file
+MAPI b8 engine_run();
+
+// Gets the most bytes any single frame has taken from the frame allocator, and the size of one arena
+MAPI void engine_get_frame_allocator_usage(u64* out_peak, u64* out_capacity);
\ No newline at end of file
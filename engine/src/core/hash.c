@@ -0,0 +1,90 @@
+#include "hash.h"
+
+#include "memory/memory.h"
+#include "strings/string.h"
+
+
+static const u64 hash_secret[4] = {
+    0xa0761d6478bd642full,
+    0xe7037ed1a0b428dbull,
+    0x8ebc6af09c88c6e3ull,
+    0x589965cc75374cc3ull
+};
+
+static inline void multiply(u64* a, u64* b) {
+    __uint128_t product = (__uint128_t)*a * *b;
+    *a = (u64)product;
+    *b = (u64)(product >> 64);
+}
+
+static inline u64 mix(u64 a, u64 b) {
+    multiply(&a, &b);
+    return a ^ b;
+}
+
+static inline u64 read_u64(const u8* p) {
+    u64 value;
+    MEMORY_FIXED_COPY(&value, p, sizeof(u64));
+    return value;
+}
+
+static inline u64 read_u32(const u8* p) {
+    u32 value;
+    MEMORY_FIXED_COPY(&value, p, sizeof(u32));
+    return value;
+}
+
+// Reads 1 to 3 bytes
+static inline u64 read_small(const u8* p, u64 size) {
+    return (((u64)p[0]) << 16) | (((u64)p[size >> 1]) << 8) | p[size - 1];
+}
+
+u64 hash_bytes(const void* data, u64 size, u64 seed) {
+    const u8* p = data;
+    seed ^= mix(seed ^ hash_secret[0], hash_secret[1]);
+    u64 a;
+    u64 b;
+
+    if (size <= 16) {
+        if (size >= 4) {
+            u64 middle = (size >> 3) << 2;
+            a = (read_u32(p) << 32) | read_u32(p + middle);
+            b = (read_u32(p + size - 4) << 32) | read_u32(p + size - 4 - middle);
+        } else if (size > 0) {
+            a = read_small(p, size);
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        u64 remaining = size;
+        if (remaining > 48) {
+            u64 seed1 = seed;
+            u64 seed2 = seed;
+            do {
+                seed = mix(read_u64(p) ^ hash_secret[1], read_u64(p + 8) ^ seed);
+                seed1 = mix(read_u64(p + 16) ^ hash_secret[2], read_u64(p + 24) ^ seed1);
+                seed2 = mix(read_u64(p + 32) ^ hash_secret[3], read_u64(p + 40) ^ seed2);
+                p += 48;
+                remaining -= 48;
+            } while (remaining > 48);
+            seed ^= seed1 ^ seed2;
+        }
+        while (remaining > 16) {
+            seed = mix(read_u64(p) ^ hash_secret[1], read_u64(p + 8) ^ seed);
+            p += 16;
+            remaining -= 16;
+        }
+        a = read_u64(p + remaining - 16);
+        b = read_u64(p + remaining - 8);
+    }
+
+    a ^= hash_secret[1];
+    b ^= seed;
+    multiply(&a, &b);
+    return mix(a ^ hash_secret[0] ^ size, b ^ hash_secret[1]);
+}
+
+u64 hash_string(const char* str) {
+    return hash_bytes(str, cstr_len(str), HASH_DEFAULT_SEED);
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "defines.h"
+
+// wyhash (final version 4). Fast on short keys and passes SMHasher, so it is used for every hashed container
+#define HASH_DEFAULT_SEED 0
+
+MAPI u64 hash_bytes(const void* data, u64 size, u64 seed);
+
+MAPI u64 hash_string(const char* str);
+
+// Mixes a 64 bit integer key. Use this in place of hash_bytes for integer keys
+MINLINE u64 hash_u64(u64 key) {
+    __uint128_t product = (__uint128_t)(key ^ 0xa0761d6478bd642full) * (key ^ 0xe7037ed1a0b428dbull);
+    u64 low = (u64)product ^ 0xa0761d6478bd642full;
+    u64 high = (u64)(product >> 64) ^ 0xe7037ed1a0b428dbull;
+    product = (__uint128_t)low * high;
+    return (u64)product ^ (u64)(product >> 64);
+}
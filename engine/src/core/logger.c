@@ -6,6 +6,7 @@
 
 #include "asserts.h"
 
+#include "memory/allocators/scratch_allocator.h"
 #include "platform/platform.h"
 
 #include "strings/string.h"
@@ -29,7 +30,24 @@ void log_output(log_level level, const char* msg, ...) {
         "[TRACE]: "
     };
 
+    // Messages are formatted in the thread's scratch arena, so logging does not touch the heap.
+    // Only messages too large for the arena fall back to heap allocations
     __builtin_va_list arg_ptr;
+    scratch_arena scratch = scratch_begin();
+    if (scratch.allocator) {
+        va_start(arg_ptr, msg);
+        char* formatted = cstr_format_v_with_allocator(scratch.allocator, msg, arg_ptr);
+        va_end(arg_ptr);
+
+        char* out_msg = formatted ? cstr_format_with_allocator(scratch.allocator, "%s%s\n", level_strings[level], formatted) : nullptr;
+        if (out_msg) {
+            platform_console_write(level, out_msg);
+            scratch_end(scratch);
+            return;
+        }
+        scratch_end(scratch);
+    }
+
     va_start(arg_ptr, msg);
     char* formatted = cstr_format_v(msg, arg_ptr);
     va_end(arg_ptr);
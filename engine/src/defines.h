@@ -67,6 +67,13 @@
 #define MNOINLINE
 #endif
 
+// Thread-local storage
+#if defined(_MSC_VER)
+#define MTHREAD_LOCAL __declspec(thread)
+#else
+#define MTHREAD_LOCAL _Thread_local
+#endif
+
 // Deprecation
 #if defined(__clang__) || defined(__gcc__)
 #define MDEPRECATED(msg) __attribute__((deprecated(msg)))
@@ -6,7 +6,7 @@
 extern b8 create_game(game* out_game);
 
 int main(int argc, char* argv[]) {
-    game g;
+    game g = {0};
 
     if (!create_game(&g)) {
         return -1;
@@ -1,15 +1,23 @@
 #pragma once
 
 #include "core/engine.h"
+#include "memory/memory.h"
+
+typedef struct frame_data {
+    // Allocator for transient data, where freeing is a no-op. Allocations stay valid through
+    // the next frame and are released when the frame after that starts. Any thread may allocate from it
+    frame_allocator_int* allocator;
+    u64 frame_number;
+} frame_data;
 
 typedef struct game {
     engine_config config;
 
     b8 (*initialize)(struct game* instance);
     
-    b8 (*update)(struct game* instance, f32 dt);
+    b8 (*update)(struct game* instance, f32 dt, const frame_data* frame);
     
-    b8 (*render)(struct game* instance, f32 dt);
+    b8 (*render)(struct game* instance, f32 dt, const frame_data* frame);
     
     void (*on_resize)(struct game* instance, u32 width, u32 height);
 
@@ -4,45 +4,118 @@
 #include "core/asserts.h"
 #include "memory/memory.h"
 #include "containers/freelist.h"
+#include "platform/platform.h"
 
 
 typedef struct dynamic_allocator_state {
     u64 total_size;
+    dynamic_allocator_flags flags;
     freelist list;
     void* freelist_block;
     void* memory_block;
+
+    // Lazy commit bookkeeping, one entry per commit_granularity chunk of memory_block
+    u64 commit_granularity;
+    u64 granule_count;
+    u32* granule_usage;
+    b8* granule_committed;
+    // Set while a committed granule holds nothing but the zeroes the OS handed it out with
+    b8* granule_pristine;
+    u64 committed_size;
+    u64 empty_committed_size;
 } dynamic_allocator_state;
 
+// Sits right before every block. The range taken from the freelist starts padding bytes before the header
 typedef struct alloc_header {
-    void* start;
+    u32 size;
     u16 alignment;
+    u16 padding;
 } alloc_header;
 
-#define KSIZE_STORAGE sizeof(u32)
+// Ranges are taken from the freelist in multiples of this, so every range and every header starts 8 byte aligned,
+// and alignments up to 8 never need padding
+#define ALLOCATION_GRANULE 8
+
+static b8 commit_range(dynamic_allocator_state* state, u64 offset, u64 size, b8* out_zeroed);
+static void release_range(dynamic_allocator_state* state, u64 offset, u64 size);
+
+// Bytes taken from the freelist for a block, enough for the header and the worst case padding
+MINLINE u64 block_footprint(u64 size, u16 alignment) {
+    u64 max_padding = alignment > ALLOCATION_GRANULE ? alignment - ALLOCATION_GRANULE : 0;
+    return get_aligned(sizeof(alloc_header) + max_padding + size, ALLOCATION_GRANULE);
+}
+
+MINLINE alloc_header* get_header(void* block) {
+    return (alloc_header*)((u8*)block - sizeof(alloc_header));
+}
 
 b8 dynamic_allocator_create(u64 total_size, u64* memory_requirement, void* memory, dynamic_allocator* out_allocator) {
+    return dynamic_allocator_create_with_flags(total_size, DYNAMIC_ALLOCATOR_FLAG_NONE_BIT, memory_requirement, memory, out_allocator);
+}
+
+b8 dynamic_allocator_create_with_flags(u64 total_size, dynamic_allocator_flags flags, u64* memory_requirement, void* memory, dynamic_allocator* out_allocator) {
     if (total_size < 1) {
         MERROR("dynamic_allocator_create - Cannot have a total_size of 0! Creation failed!");
         return false;
     }
 
+    b8 lazy_commit = (flags & DYNAMIC_ALLOCATOR_FLAG_LAZY_COMMIT_BIT) != 0;
+
     u64 freelist_requirement = 0;
-    freelist_create(total_size, &freelist_requirement, nullptr, nullptr);
+    freelist_create_with_flags(total_size, FREELIST_FLAG_BEST_FIT_BIT, &freelist_requirement, nullptr, nullptr);
+
+    u64 granularity = (flags & DYNAMIC_ALLOCATOR_FLAG_HUGE_GRANULES_BIT) ? DYNAMIC_ALLOCATOR_HUGE_COMMIT_GRANULARITY : DYNAMIC_ALLOCATOR_COMMIT_GRANULARITY;
+    u64 granule_count = 0;
+    // Leaves room to start the memory block on an allocation granule, wherever the provided memory starts
+    u64 header_requirement = sizeof(dynamic_allocator_state) + freelist_requirement + ALLOCATION_GRANULE - 1;
+    u64 block_requirement = total_size;
+    if (lazy_commit) {
+        // The memory block is committed in whole granules, so it must start and end on a granule boundary
+        granule_count = get_aligned(total_size, granularity) / granularity;
+        header_requirement += (sizeof(u32) + sizeof(b8) * 2) * granule_count;
+        header_requirement = get_aligned(header_requirement, granularity);
+        block_requirement = granule_count * granularity;
+    }
 
-    *memory_requirement = freelist_requirement + sizeof(dynamic_allocator_state) + total_size;
+    *memory_requirement = header_requirement + block_requirement;
     if (!memory) {
         return true;
     }
 
+    if (lazy_commit && !platform_memory_commit(memory, header_requirement)) {
+        MERROR("dynamic_allocator_create - Unable to commit memory for allocator state! Creation failed!");
+        return false;
+    }
+
     out_allocator->memory = memory;
     dynamic_allocator_state* state = out_allocator->memory;
     state->total_size = total_size;
+    state->flags = flags;
     state->freelist_block = (void*)(out_allocator->memory + sizeof(dynamic_allocator_state));
-    state->memory_block = (void*)(state->freelist_block + freelist_requirement);
-
-    freelist_create(total_size, &freelist_requirement, state->freelist_block, &state->list);
-
-    memory_zero(state->memory_block, total_size);
+    state->memory_block = lazy_commit
+        ? (void*)(out_allocator->memory + header_requirement)
+        : (void*)(get_aligned((u64)out_allocator->memory + header_requirement - (ALLOCATION_GRANULE - 1), ALLOCATION_GRANULE));
+
+    freelist_create_with_flags(total_size, FREELIST_FLAG_BEST_FIT_BIT, &freelist_requirement, state->freelist_block, &state->list);
+
+    state->commit_granularity = granularity;
+    state->granule_count = granule_count;
+    state->empty_committed_size = 0;
+    if (lazy_commit) {
+        // Freshly committed pages are already zeroed, so the tables start out empty
+        state->granule_usage = (u32*)(state->freelist_block + freelist_requirement);
+        state->granule_committed = (b8*)(state->granule_usage + granule_count);
+        state->granule_pristine = state->granule_committed + granule_count;
+        state->committed_size = 0;
+    } else {
+        state->granule_usage = nullptr;
+        state->granule_committed = nullptr;
+        state->granule_pristine = nullptr;
+        state->committed_size = total_size;
+        if (!(flags & DYNAMIC_ALLOCATOR_FLAG_ZEROED_MEMORY_BIT)) {
+            memory_zero(state->memory_block, total_size);
+        }
+    }
     return true;
 }
 
@@ -50,7 +123,13 @@ b8 dynamic_allocator_destroy(dynamic_allocator* allocator) {
     if (allocator) {
         dynamic_allocator_state* state = allocator->memory;
         freelist_destroy(&state->list);
-        memory_zero(state->memory_block, state->total_size);
+        if (state->flags & DYNAMIC_ALLOCATOR_FLAG_LAZY_COMMIT_BIT) {
+            // Return everything to the OS, the owner releases the address space itself
+            platform_memory_decommit(state->memory_block, state->granule_count * state->commit_granularity);
+            state->committed_size = 0;
+        } else {
+            memory_zero(state->memory_block, state->total_size);
+        }
         state->total_size = 0;
         allocator->memory = nullptr;
         return true;
@@ -65,44 +144,91 @@ void* dynamic_allocator_allocate(dynamic_allocator* allocator, u64 size) {
 }
 
 void* dynamic_allocator_allocate_aligned(dynamic_allocator* allocator, u64 size, u16 alignment) {
+    return dynamic_allocator_allocate_aligned_check_zeroed(allocator, size, alignment, nullptr);
+}
+
+void* dynamic_allocator_allocate_aligned_check_zeroed(dynamic_allocator* allocator, u64 size, u16 alignment, b8* out_zeroed) {
+    if (out_zeroed) {
+        *out_zeroed = false;
+    }
+
     if (!allocator || !size || !alignment) {
         MERROR("dynamic_allocator_allocate_aligned requires a valid allocator, size and alignment!");
         return nullptr;
     }
     dynamic_allocator_state* state = allocator->memory;
 
-    u64 header_size = sizeof(alloc_header);
-    u64 storage_size = KSIZE_STORAGE;
-    u64 required_size = alignment + header_size + storage_size + size;
+    u64 required_size = block_footprint(size, alignment);
 
     MASSERT_MSG(required_size < 4294967295U, "dynamic_allocator_allocate_aligned called with required size > 4 GiB. Don't do that.");
 
     u64 base_offset = 0;
     if (freelist_allocate_block(&state->list, required_size, &base_offset)) {
-        void* ptr = (void*)((u64)state->memory_block + base_offset);
-
-        u64 aligned_block_offset = get_aligned((u64)ptr + KSIZE_STORAGE, alignment);
-
-        u32* block_size = (u32*)(aligned_block_offset - KSIZE_STORAGE);
-        *block_size = (u32)size;
+        if ((state->flags & DYNAMIC_ALLOCATOR_FLAG_LAZY_COMMIT_BIT) && !commit_range(state, base_offset, required_size, out_zeroed)) {
+            MERROR("dynamic_allocator_allocate_aligned unable to commit memory for the allocation.");
+            freelist_free_block(&state->list, required_size, base_offset);
+            return nullptr;
+        }
 
-        alloc_header* header = (alloc_header*)(aligned_block_offset + size);
-        header->start = ptr;
+        u64 start = (u64)state->memory_block + base_offset;
+        u64 aligned_block_offset = get_aligned(start + sizeof(alloc_header), alignment);
 
-        MASSERT_MSG(header->start, "dynamic_allocator_allocate_aligned got a null pointer (0x0). Memory corruption likely as this should always be nonzero.");
+        alloc_header* header = get_header((void*)aligned_block_offset);
+        header->size = (u32)size;
         header->alignment = alignment;
-        MASSERT_MSG(header->alignment, "dynamic_allocator_allocate_aligned got an alignment of 0. Memory corruption likely as this should always be nonzero.");
+        header->padding = (u16)(aligned_block_offset - sizeof(alloc_header) - start);
 
         return (void*)aligned_block_offset;
     }
 
     MERROR("dynamic_allocator_allocate_aligned no blocks of memory large enough to allocate from.");
-    u64 available = freelist_free_space(&state->list);
-    MERROR("Requested size: %llu, total space available: %llu", size, available);
-    // TODO: Report fragmentation?
+    freelist_fragmentation fragmentation;
+    freelist_get_fragmentation(&state->list, &fragmentation);
+    MERROR("Requested size: %llu, total space available: %llu, largest free block: %llu across %llu free ranges (%.1f%% fragmented)",
+           size, fragmentation.free_space, fragmentation.largest_free_range, fragmentation.free_range_count,
+           fragmentation.external_fragmentation * 100.0f);
     return nullptr;
 }
 
+b8 dynamic_allocator_try_extend(dynamic_allocator* allocator, void* block, u64 new_size) {
+    if (!allocator || !block) {
+        return false;
+    }
+
+    dynamic_allocator_state* state = allocator->memory;
+    if (block < state->memory_block || block >= state->memory_block + state->total_size) {
+        return false;
+    }
+
+    alloc_header* header = get_header(block);
+    u64 old_size = header->size;
+    if (new_size <= old_size) {
+        return false;
+    }
+
+    u64 old_required = block_footprint(old_size, header->alignment);
+    u64 new_required = block_footprint(new_size, header->alignment);
+    if (new_required >= 4294967295U) {
+        return false;
+    }
+
+    // The range handed out ends right after the rounded up block, so growing it only needs the free space past that
+    u64 offset = (u64)header - header->padding - (u64)state->memory_block;
+    u64 growth = new_required - old_required;
+    if (growth) {
+        if (!freelist_allocate_block_at(&state->list, growth, offset + old_required)) {
+            return false;
+        }
+        if ((state->flags & DYNAMIC_ALLOCATOR_FLAG_LAZY_COMMIT_BIT) && !commit_range(state, offset + old_required, growth, nullptr)) {
+            freelist_free_block(&state->list, growth, offset + old_required);
+            return false;
+        }
+    }
+
+    header->size = (u32)new_size;
+    return true;
+}
+
 b8 dynamic_allocator_free(dynamic_allocator* allocator, void* block) {
     return dynamic_allocator_free_aligned(allocator, block);
 }
@@ -120,15 +246,18 @@ b8 dynamic_allocator_free_aligned(dynamic_allocator* allocator, void* block) {
         return false;
     }
 
-    u32* block_size = (u32*)((u64)block - KSIZE_STORAGE);
-    alloc_header* header = (alloc_header*)((u64)block + *block_size);
-    u64 required_size = header->alignment + sizeof(alloc_header) + KSIZE_STORAGE + *block_size;
-    u64 offset = (u64)header->start - (u64)state->memory_block;
+    alloc_header* header = get_header(block);
+    u64 required_size = block_footprint(header->size, header->alignment);
+    u64 offset = (u64)header - header->padding - (u64)state->memory_block;
     if (!freelist_free_block(&state->list, required_size, offset)) {
         MERROR("dynamic_allocator_free_aligned failed.");
         return false;
     }
 
+    if (state->flags & DYNAMIC_ALLOCATOR_FLAG_LAZY_COMMIT_BIT) {
+        release_range(state, offset, required_size);
+    }
+
     return true;
 }
 
@@ -140,11 +269,11 @@ b8 dynamic_allocator_get_size_alignment(dynamic_allocator* allocator, void* bloc
     }
 
     // Get the header.
-    *out_size = *(u32*)((u64)block - KSIZE_STORAGE);
+    alloc_header* header = get_header(block);
+    *out_size = header->size;
     MASSERT_MSG(*out_size, "dynamic_allocator_get_size_alignment found an out_size of 0. Memory corruption likely.");
-    alloc_header* header = (alloc_header*)((u64)block + *out_size);
     *out_alignment = header->alignment;
-    MASSERT_MSG(header->start, "dynamic_allocator_get_size_alignment found a header->start of 0. Memory corruption likely as this should always be at least 1.");
+    MASSERT_MSG(header->padding < header->alignment, "dynamic_allocator_get_size_alignment found a padding past the alignment. Memory corruption likely.");
     MASSERT_MSG(header->alignment, "dynamic_allocator_get_size_alignment found a header->alignment of 0. Memory corruption likely as this should always be at least 1.");
     return true;
 }
@@ -160,5 +289,114 @@ u64 dynamic_allocator_total_space(dynamic_allocator* allocator) {
 }
 
 u64 dynamic_allocator_header_size(void) {
-    return sizeof(alloc_header) + KSIZE_STORAGE;
-}
\ No newline at end of file
+    return sizeof(alloc_header);
+}
+
+u64 dynamic_allocator_block_footprint(u64 size, u16 alignment) {
+    return block_footprint(size, alignment);
+}
+
+u64 dynamic_allocator_committed_space(dynamic_allocator* allocator) {
+    dynamic_allocator_state* state = allocator->memory;
+    return state->committed_size;
+}
+
+b8 dynamic_allocator_get_fragmentation(dynamic_allocator* allocator, freelist_fragmentation* out_fragmentation) {
+    if (!allocator || !allocator->memory) {
+        return false;
+    }
+
+    dynamic_allocator_state* state = allocator->memory;
+    return freelist_get_fragmentation(&state->list, out_fragmentation);
+}
+
+static void decommit_run(dynamic_allocator_state* state, u64 first, u64 count) {
+    platform_memory_decommit(state->memory_block + (first * state->commit_granularity), count * state->commit_granularity);
+    state->committed_size -= count * state->commit_granularity;
+}
+
+static b8 commit_range(dynamic_allocator_state* state, u64 offset, u64 size, b8* out_zeroed) {
+    const u64 granularity = state->commit_granularity;
+    u64 first = offset / granularity;
+    u64 last = (offset + size - 1) / granularity;
+
+    // Commit any missing granules, coalescing neighbours into a single call
+    u64 run_start = INVALID_ID_U64;
+    for (u64 i = first; i <= last + 1; ++i) {
+        b8 needs_commit = i <= last && !state->granule_committed[i];
+        if (needs_commit && run_start == INVALID_ID_U64) {
+            run_start = i;
+        } else if (!needs_commit && run_start != INVALID_ID_U64) {
+            u64 run_size = (i - run_start) * granularity;
+            if (!platform_memory_commit(state->memory_block + (run_start * granularity), run_size)) {
+                return false;
+            }
+            for (u64 j = run_start; j < i; ++j) {
+                state->granule_committed[j] = true;
+                state->granule_pristine[j] = true;
+            }
+            // Newly committed granules count as empty until the usage below lands on them
+            state->committed_size += run_size;
+            state->empty_committed_size += run_size;
+            run_start = INVALID_ID_U64;
+        }
+    }
+
+    u64 end = offset + size;
+    b8 zeroed = true;
+    for (u64 i = first; i <= last; ++i) {
+        u64 granule_start = i * granularity;
+        u64 granule_end = granule_start + granularity;
+        u64 overlap = MMIN(end, granule_end) - MMAX(offset, granule_start);
+        if (state->granule_usage[i] == 0) {
+            state->empty_committed_size -= granularity;
+        }
+        state->granule_usage[i] += (u32)overlap;
+        zeroed = zeroed && state->granule_pristine[i];
+        state->granule_pristine[i] = false;
+    }
+
+    if (out_zeroed) {
+        *out_zeroed = zeroed;
+    }
+
+    return true;
+}
+
+static void release_range(dynamic_allocator_state* state, u64 offset, u64 size) {
+    const u64 granularity = state->commit_granularity;
+    u64 first = offset / granularity;
+    u64 last = (offset + size - 1) / granularity;
+    u64 end = offset + size;
+
+    for (u64 i = first; i <= last; ++i) {
+        u64 granule_start = i * granularity;
+        u64 granule_end = granule_start + granularity;
+        u64 overlap = MMIN(end, granule_end) - MMAX(offset, granule_start);
+        MASSERT_MSG(state->granule_usage[i] >= overlap, "dynamic_allocator release_range found a granule with less usage than freed. Memory corruption likely.");
+        state->granule_usage[i] -= (u32)overlap;
+        if (state->granule_usage[i] == 0) {
+            state->empty_committed_size += granularity;
+        }
+    }
+
+    if (state->empty_committed_size < DYNAMIC_ALLOCATOR_DECOMMIT_THRESHOLD) {
+        return;
+    }
+
+    // Enough memory is sitting unused, sweep every empty granule back to the OS
+    u64 run_start = INVALID_ID_U64;
+    for (u64 i = 0; i <= state->granule_count; ++i) {
+        b8 is_empty = i < state->granule_count && state->granule_committed[i] && state->granule_usage[i] == 0;
+        if (is_empty) {
+            state->granule_committed[i] = false;
+            if (run_start == INVALID_ID_U64) {
+                run_start = i;
+            }
+        } else if (run_start != INVALID_ID_U64) {
+            decommit_run(state, run_start, i - run_start);
+            run_start = INVALID_ID_U64;
+        }
+    }
+    state->empty_committed_size = 0;
+}
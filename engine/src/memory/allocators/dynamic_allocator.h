@@ -1,19 +1,53 @@
 #pragma once
 
 #include "defines.h"
+#include "containers/freelist.h"
 
 typedef struct dynamic_allocator {
     void* memory;
 } dynamic_allocator;
 
+typedef enum dynamic_allocator_flag_bits {
+    DYNAMIC_ALLOCATOR_FLAG_NONE_BIT = 0x00,
+    // The provided memory is address space obtained from platform_memory_reserve.
+    // Pages are committed as allocations land on them and decommitted once enough of them become free.
+    DYNAMIC_ALLOCATOR_FLAG_LAZY_COMMIT_BIT = 0x01,
+    // Lazy commit works in DYNAMIC_ALLOCATOR_HUGE_COMMIT_GRANULARITY chunks, so every committed chunk can be
+    // backed by a single huge page. The provided memory must then be aligned to that granularity
+    DYNAMIC_ALLOCATOR_FLAG_HUGE_GRANULES_BIT = 0x02,
+    // The provided memory is known to hold only zeroes, so creating the allocator does not clear it
+    DYNAMIC_ALLOCATOR_FLAG_ZEROED_MEMORY_BIT = 0x04
+} dynamic_allocator_flag_bits;
+
+typedef u32 dynamic_allocator_flags;
+
+// Size of the chunks the lazy commit mode commits and decommits memory in
+#define DYNAMIC_ALLOCATOR_COMMIT_GRANULARITY KIBIBYTES(64)
+
+// Size of the chunks committed with DYNAMIC_ALLOCATOR_FLAG_HUGE_GRANULES_BIT, the size of an x86-64 huge page
+#define DYNAMIC_ALLOCATOR_HUGE_COMMIT_GRANULARITY MEBIBYTES(2)
+
+// Amount of committed but unused memory a lazy committing allocator keeps before returning it to the OS
+#define DYNAMIC_ALLOCATOR_DECOMMIT_THRESHOLD MEBIBYTES(32)
+
 MAPI b8 dynamic_allocator_create(u64 total_size, u64* memory_requirement, void* memory, dynamic_allocator* out_allocator);
 
+MAPI b8 dynamic_allocator_create_with_flags(u64 total_size, dynamic_allocator_flags flags, u64* memory_requirement, void* memory, dynamic_allocator* out_allocator);
+
 MAPI b8 dynamic_allocator_destroy(dynamic_allocator* allocator);
 
 MAPI void* dynamic_allocator_allocate(dynamic_allocator* allocator, u64 size);
 
 MAPI void* dynamic_allocator_allocate_aligned(dynamic_allocator* allocator, u64 size, u16 alignment);
 
+// Same as dynamic_allocator_allocate_aligned, also reporting whether the block is known to hold only zeroes.
+// That is the case when it lies entirely on pages freshly committed in lazy commit mode
+MAPI void* dynamic_allocator_allocate_aligned_check_zeroed(dynamic_allocator* allocator, u64 size, u16 alignment, b8* out_zeroed);
+
+// Grows block to new_size without moving it, if the memory following it is free.
+// Returns false and leaves the block untouched otherwise
+MAPI b8 dynamic_allocator_try_extend(dynamic_allocator* allocator, void* block, u64 new_size);
+
 MAPI b8 dynamic_allocator_free(dynamic_allocator* allocator, void* block);
 
 MAPI b8 dynamic_allocator_free_aligned(dynamic_allocator* allocator, void* block);
@@ -24,4 +58,14 @@ MAPI u64 dynamic_allocator_free_space(dynamic_allocator* allocator);
 
 MAPI u64 dynamic_allocator_total_space(dynamic_allocator* allocator);
 
-MAPI u64 dynamic_allocator_header_size(void);
\ No newline at end of file
+// Gets the amount of memory currently committed by the OS for this allocator.
+// Equals the total space unless DYNAMIC_ALLOCATOR_FLAG_LAZY_COMMIT_BIT is set
+MAPI u64 dynamic_allocator_committed_space(dynamic_allocator* allocator);
+
+MAPI u64 dynamic_allocator_header_size(void);
+
+// Gets the bytes a block of the given size and alignment takes from the allocator, header and padding included
+MAPI u64 dynamic_allocator_block_footprint(u64 size, u16 alignment);
+
+// Gathers how the free space of the allocator is split up. Sizes include the per-block headers
+MAPI b8 dynamic_allocator_get_fragmentation(dynamic_allocator* allocator, freelist_fragmentation* out_fragmentation);
\ No newline at end of file
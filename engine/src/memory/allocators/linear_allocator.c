@@ -2,11 +2,17 @@
 
 #include "memory/memory.h"
 #include "core/logger.h"
+#include "threads/atomic.h"
 
 
 void linear_allocator_create(u64 total_size, void* memory, linear_allocator* out_allocator) {
+    linear_allocator_create_with_flags(total_size, memory, LINEAR_ALLOCATOR_FLAG_NONE_BIT, out_allocator);
+}
+
+void linear_allocator_create_with_flags(u64 total_size, void* memory, linear_allocator_flags flags, linear_allocator* out_allocator) {
     out_allocator->total_size = total_size;
     out_allocator->allocated = 0;
+    out_allocator->flags = flags;
     if (memory) {
         out_allocator->memory = memory;
         out_allocator->owns_memory = false;
@@ -28,15 +34,31 @@ void linear_allocator_destroy(linear_allocator* allocator) {
     }
 }
 
+static void report_out_of_space(linear_allocator* allocator, u64 size, u64 position) {
+    u64 remaining = position < allocator->total_size ? allocator->total_size - position : 0;
+    MERROR("linear_allocator_allocate - Tried to allocate %lluB, only %lluB remaining!", size, remaining);
+}
+
 void* linear_allocator_allocate(linear_allocator* allocator, u64 size) {
     if (!allocator || !allocator->memory) {
         MERROR("linear_allocator_allocate - Provided allocator not initialized!");
         return nullptr;
     }
 
+    if (allocator->flags & LINEAR_ALLOCATOR_FLAG_CONCURRENT_BIT) {
+        // Only positions that fit are published, so a request that does not fit never makes a racing one fail
+        u64 offset = atomic_u64_load(&allocator->allocated);
+        do {
+            if (size > allocator->total_size - offset) {
+                report_out_of_space(allocator, size, offset);
+                return nullptr;
+            }
+        } while (!atomic_u64_compare_exchange(&allocator->allocated, &offset, offset + size));
+        return ((u8*)allocator->memory) + offset;
+    }
+
     if (allocator->allocated + size > allocator->total_size) {
-        u64 remaining = allocator->total_size - allocator->allocated;
-        MERROR("linear_allocator_allocate - Tried to allocate %lluB, only %lluB remaining!", size, remaining);
+        report_out_of_space(allocator, size, allocator->allocated);
         return nullptr;
     }
 
@@ -45,11 +67,82 @@ void* linear_allocator_allocate(linear_allocator* allocator, u64 size) {
     return block;
 }
 
+void* linear_allocator_allocate_aligned(linear_allocator* allocator, u64 size, u16 alignment) {
+    if (!allocator || !allocator->memory) {
+        MERROR("linear_allocator_allocate_aligned - Provided allocator not initialized!");
+        return nullptr;
+    }
+
+    // Alignment is relative to the address rather than the offset, so any backing memory works
+    u64 base = (u64)allocator->memory;
+    u64 current = atomic_u64_load(&allocator->allocated);
+    for (;;) {
+        u64 offset = get_aligned(base + current, alignment) - base;
+        if (offset + size > allocator->total_size) {
+            report_out_of_space(allocator, size, offset);
+            return nullptr;
+        }
+
+        if (!(allocator->flags & LINEAR_ALLOCATOR_FLAG_CONCURRENT_BIT)) {
+            allocator->allocated = offset + size;
+            return (void*)(base + offset);
+        }
+        // The padding depends on the position, so claim the range only if nobody moved it in the meantime
+        if (atomic_u64_compare_exchange(&allocator->allocated, &current, offset + size)) {
+            return (void*)(base + offset);
+        }
+    }
+}
+
 void linear_allocator_free_all(linear_allocator* allocator, b8 clear) {
     if (allocator && allocator->memory) {
-        allocator->allocated = 0;
+        atomic_u64_store(&allocator->allocated, 0);
         if (clear) {
             memory_zero(allocator->memory, allocator->total_size);
         }
     }
-}
\ No newline at end of file
+}
+
+u64 linear_allocator_get_marker(linear_allocator* allocator) {
+    return allocator ? atomic_u64_load(&allocator->allocated) : 0;
+}
+
+void linear_allocator_free_to_marker(linear_allocator* allocator, u64 marker) {
+    if (!allocator) {
+        return;
+    }
+
+    if (marker > allocator->allocated) {
+        MERROR("linear_allocator_free_to_marker - Marker %llu is past the current position %llu!", marker, allocator->allocated);
+        return;
+    }
+
+    allocator->allocated = marker;
+}
+
+void linear_allocator_chunk_begin(linear_allocator* allocator, u64 chunk_size, linear_allocator_chunk* out_chunk) {
+    out_chunk->parent = allocator;
+    out_chunk->chunk_size = chunk_size;
+    out_chunk->cursor = nullptr;
+    out_chunk->end = nullptr;
+}
+
+void* linear_allocator_chunk_allocate(linear_allocator_chunk* chunk, u64 size, u16 alignment) {
+    u8* block = (u8*)get_aligned((u64)chunk->cursor, alignment);
+    if (chunk->cursor && block + size <= chunk->end) {
+        chunk->cursor = block + size;
+        return block;
+    }
+
+    if (size > chunk->chunk_size / 2) {
+        return linear_allocator_allocate_aligned(chunk->parent, size, alignment);
+    }
+
+    u8* range = linear_allocator_allocate_aligned(chunk->parent, chunk->chunk_size, alignment);
+    if (!range) {
+        return nullptr;
+    }
+    chunk->cursor = range + size;
+    chunk->end = range + chunk->chunk_size;
+    return range;
+}
@@ -2,18 +2,54 @@
 
 #include "defines.h"
 
+typedef enum linear_allocator_flag_bits {
+    LINEAR_ALLOCATOR_FLAG_NONE_BIT = 0x00,
+    // Allocations bump the position atomically, so any number of threads can allocate from the same allocator
+    // without a lock. free_all and free_to_marker must still not race with allocations
+    LINEAR_ALLOCATOR_FLAG_CONCURRENT_BIT = 0x01
+} linear_allocator_flag_bits;
+
+typedef u32 linear_allocator_flags;
 
 typedef struct linear_allocator {
     u64 total_size;
     u64 allocated;
     void* memory;
     b8 owns_memory;
+    linear_allocator_flags flags;
 } linear_allocator;
 
+// A range reserved from a concurrent linear allocator by one thread, which then allocates from it without atomics.
+// When the range runs out another one of chunk_size is reserved, and whatever was left of the old one is unused
+typedef struct linear_allocator_chunk {
+    linear_allocator* parent;
+    u64 chunk_size;
+    u8* cursor;
+    u8* end;
+} linear_allocator_chunk;
+
 MAPI void linear_allocator_create(u64 total_size, void* memory, linear_allocator* out_allocator);
 
+MAPI void linear_allocator_create_with_flags(u64 total_size, void* memory, linear_allocator_flags flags, linear_allocator* out_allocator);
+
 MAPI void linear_allocator_destroy(linear_allocator* allocator);
 
 MAPI void* linear_allocator_allocate(linear_allocator* allocator, u64 size);
 
+// Same as linear_allocator_allocate, but the block starts at a multiple of alignment, which must be a power of 2
+MAPI void* linear_allocator_allocate_aligned(linear_allocator* allocator, u64 size, u16 alignment);
+
 MAPI void linear_allocator_free_all(linear_allocator* allocator, b8 clear);
+
+// Gets the current position of the allocator, to be rolled back to with linear_allocator_free_to_marker
+MAPI u64 linear_allocator_get_marker(linear_allocator* allocator);
+
+// Frees every allocation made after the marker was taken
+MAPI void linear_allocator_free_to_marker(linear_allocator* allocator, u64 marker);
+
+// Prepares a per-thread chunk of the given allocator. Nothing is reserved until the first allocation
+MAPI void linear_allocator_chunk_begin(linear_allocator* allocator, u64 chunk_size, linear_allocator_chunk* out_chunk);
+
+// Allocates from the chunk, reserving a new one from the parent allocator when it runs out.
+// Blocks larger than half the chunk size are allocated from the parent allocator directly
+MAPI void* linear_allocator_chunk_allocate(linear_allocator_chunk* chunk, u64 size, u16 alignment);
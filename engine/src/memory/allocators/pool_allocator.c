@@ -0,0 +1,289 @@
+#include "pool_allocator.h"
+
+#include "memory/memory.h"
+#include "threads/atomic.h"
+#include "core/logger.h"
+
+// Objects a thread cache moves from or to the shared free list at once
+#define POOL_THREAD_CACHE_BATCH 32
+
+typedef struct pool_thread_cache {
+    volatile u32 lock;
+    u32 count;
+    void* head;
+    // Keep every cache on its own cache line
+    u8 padding[64 - sizeof(u32) * 2 - sizeof(void*)];
+} pool_thread_cache;
+
+// Index of the cache the calling thread uses in every pool, assigned on first use
+static MTHREAD_LOCAL u32 thread_cache_index = INVALID_ID;
+static volatile u32 next_thread_cache_index;
+
+MINLINE void* object_next(void* object) {
+    return *(void**)object;
+}
+
+MINLINE void object_set_next(void* object, void* next) {
+    *(void**)object = next;
+}
+
+static u64 chunk_header_size(pool_allocator* allocator) {
+    return get_aligned(sizeof(void*), allocator->object_alignment);
+}
+
+// Takes an object from the shared free list, or carves one out of the newest chunk, growing if needed.
+// Callers sharing the pool between threads must hold the pool mutex
+static void* pool_take(pool_allocator* allocator) {
+    void* object = allocator->free_list;
+    if (object) {
+        allocator->free_list = object_next(object);
+        return object;
+    }
+
+    if (allocator->bump == allocator->bump_end) {
+        void* chunk = memory_allocate_aligned(allocator->chunk_size, allocator->object_alignment, MEMORY_TAG_POOL_ALLOCATOR);
+        if (!chunk) {
+            return nullptr;
+        }
+        object_set_next(chunk, allocator->chunks);
+        allocator->chunks = chunk;
+        allocator->chunk_count++;
+        allocator->bump = (u8*)chunk + chunk_header_size(allocator);
+        allocator->bump_end = (u8*)chunk + allocator->chunk_size;
+    }
+
+    object = allocator->bump;
+    allocator->bump += allocator->object_size;
+    return object;
+}
+
+static void lock_cache(pool_thread_cache* cache) {
+    u32 expected = 0;
+    while (!atomic_u32_compare_exchange(&cache->lock, &expected, 1)) {
+        expected = 0;
+        atomic_spin_pause();
+    }
+}
+
+static pool_thread_cache* lock_thread_cache(pool_allocator* allocator) {
+    if (thread_cache_index == INVALID_ID) {
+        thread_cache_index = atomic_u32_fetch_add(&next_thread_cache_index, 1) % POOL_ALLOCATOR_THREAD_CACHE_COUNT;
+    }
+
+    // Uncontended unless more threads than caches use the pool
+    pool_thread_cache* cache = &allocator->thread_caches[thread_cache_index];
+    lock_cache(cache);
+    return cache;
+}
+
+MINLINE void unlock_thread_cache(pool_thread_cache* cache) {
+    atomic_u32_store(&cache->lock, 0);
+}
+
+b8 pool_allocator_create(u64 object_size, u16 alignment, u64 objects_per_chunk, pool_allocator_flags flags, pool_allocator* out_allocator) {
+    if (!out_allocator || object_size == 0 || objects_per_chunk == 0) {
+        MERROR("pool_allocator_create - Requires a valid allocator, object size and objects per chunk. Creation failed!");
+        return false;
+    }
+
+    if (alignment == 0 || (alignment & (alignment - 1)) != 0) {
+        MERROR("pool_allocator_create - Alignment must be a power of two, got %u. Creation failed!", alignment);
+        return false;
+    }
+
+    memory_zero(out_allocator, sizeof(pool_allocator));
+    // Free objects store the free list link in place
+    out_allocator->object_alignment = MMAX(alignment, sizeof(void*));
+    out_allocator->object_size = get_aligned(MMAX(object_size, sizeof(void*)), out_allocator->object_alignment);
+    out_allocator->objects_per_chunk = objects_per_chunk;
+    out_allocator->chunk_size = chunk_header_size(out_allocator) + out_allocator->object_size * objects_per_chunk;
+    out_allocator->flags = flags;
+
+    if (flags & POOL_ALLOCATOR_FLAG_THREAD_CACHE_BIT) {
+        if (!mutex_create(&out_allocator->pool_mutex)) {
+            MERROR("pool_allocator_create - Unable to create pool mutex. Creation failed!");
+            return false;
+        }
+        out_allocator->thread_caches = memory_allocate_aligned(sizeof(pool_thread_cache) * POOL_ALLOCATOR_THREAD_CACHE_COUNT, 64, MEMORY_TAG_POOL_ALLOCATOR);
+        if (!out_allocator->thread_caches) {
+            MERROR("pool_allocator_create - Unable to allocate the thread caches. Creation failed!");
+            mutex_destroy(&out_allocator->pool_mutex);
+            memory_zero(out_allocator, sizeof(pool_allocator));
+            return false;
+        }
+    }
+    return true;
+}
+
+void pool_allocator_destroy(pool_allocator* allocator) {
+    if (!allocator) {
+        return;
+    }
+
+    void* chunk = allocator->chunks;
+    while (chunk) {
+        void* next = object_next(chunk);
+        memory_free_aligned(chunk, allocator->chunk_size, allocator->object_alignment, MEMORY_TAG_POOL_ALLOCATOR);
+        chunk = next;
+    }
+
+    if (allocator->thread_caches) {
+        memory_free_aligned(allocator->thread_caches, sizeof(pool_thread_cache) * POOL_ALLOCATOR_THREAD_CACHE_COUNT, 64, MEMORY_TAG_POOL_ALLOCATOR);
+        mutex_destroy(&allocator->pool_mutex);
+    }
+
+    memory_zero(allocator, sizeof(pool_allocator));
+}
+
+void* pool_allocator_allocate(pool_allocator* allocator) {
+    if (!allocator || !allocator->object_size) {
+        MERROR("pool_allocator_allocate - Provided allocator not initialized!");
+        return nullptr;
+    }
+
+    void* object = nullptr;
+    if (!allocator->thread_caches) {
+        object = pool_take(allocator);
+        if (object) {
+            allocator->allocated_count++;
+        }
+    } else {
+        pool_thread_cache* cache = lock_thread_cache(allocator);
+        if (!cache->head) {
+            // Refill a batch under a single lock
+            mutex_lock(&allocator->pool_mutex);
+            for (u32 i = 0; i < POOL_THREAD_CACHE_BATCH; ++i) {
+                void* taken = pool_take(allocator);
+                if (!taken) {
+                    break;
+                }
+                object_set_next(taken, cache->head);
+                cache->head = taken;
+                cache->count++;
+            }
+            mutex_unlock(&allocator->pool_mutex);
+        }
+
+        object = cache->head;
+        if (object) {
+            cache->head = object_next(object);
+            cache->count--;
+            atomic_u64_fetch_add(&allocator->allocated_count, 1);
+        }
+        unlock_thread_cache(cache);
+    }
+
+    if (!object) {
+        MERROR("pool_allocator_allocate - Unable to grow the pool by %lluB!", allocator->chunk_size);
+    }
+    return object;
+}
+
+void pool_allocator_free(pool_allocator* allocator, void* block) {
+    if (!allocator || !block) {
+        return;
+    }
+
+    if (!allocator->thread_caches) {
+        object_set_next(block, allocator->free_list);
+        allocator->free_list = block;
+        allocator->allocated_count--;
+        return;
+    }
+
+    pool_thread_cache* cache = lock_thread_cache(allocator);
+    object_set_next(block, cache->head);
+    cache->head = block;
+    cache->count++;
+
+    if (cache->count >= POOL_THREAD_CACHE_BATCH * 2) {
+        // Hand a batch back so objects freed on one thread can be reused by others
+        mutex_lock(&allocator->pool_mutex);
+        for (u32 i = 0; i < POOL_THREAD_CACHE_BATCH; ++i) {
+            void* object = cache->head;
+            cache->head = object_next(object);
+            object_set_next(object, allocator->free_list);
+            allocator->free_list = object;
+        }
+        cache->count -= POOL_THREAD_CACHE_BATCH;
+        mutex_unlock(&allocator->pool_mutex);
+    }
+    atomic_u64_fetch_sub(&allocator->allocated_count, 1);
+    unlock_thread_cache(cache);
+}
+
+void pool_allocator_free_all(pool_allocator* allocator) {
+    if (!allocator) {
+        return;
+    }
+
+    if (allocator->thread_caches) {
+        // Cache locks are taken before the pool mutex, in the same order allocate and free take them
+        for (u32 i = 0; i < POOL_ALLOCATOR_THREAD_CACHE_COUNT; ++i) {
+            lock_cache(&allocator->thread_caches[i]);
+        }
+        mutex_lock(&allocator->pool_mutex);
+        for (u32 i = 0; i < POOL_ALLOCATOR_THREAD_CACHE_COUNT; ++i) {
+            allocator->thread_caches[i].head = nullptr;
+            allocator->thread_caches[i].count = 0;
+        }
+    }
+
+    // Every chunk becomes free. The newest one is reused through the bump pointer,
+    // the objects of the older ones are threaded onto the free list
+    allocator->free_list = nullptr;
+    allocator->bump = nullptr;
+    allocator->bump_end = nullptr;
+    u64 header_size = chunk_header_size(allocator);
+    void* chunk = allocator->chunks;
+    if (chunk) {
+        allocator->bump = (u8*)chunk + header_size;
+        allocator->bump_end = (u8*)chunk + allocator->chunk_size;
+        chunk = object_next(chunk);
+    }
+    while (chunk) {
+        u8* object = (u8*)chunk + header_size;
+        for (u64 i = 0; i < allocator->objects_per_chunk; ++i) {
+            object_set_next(object, allocator->free_list);
+            allocator->free_list = object;
+            object += allocator->object_size;
+        }
+        chunk = object_next(chunk);
+    }
+    allocator->allocated_count = 0;
+
+    if (allocator->thread_caches) {
+        mutex_unlock(&allocator->pool_mutex);
+        for (u32 i = 0; i < POOL_ALLOCATOR_THREAD_CACHE_COUNT; ++i) {
+            unlock_thread_cache(&allocator->thread_caches[i]);
+        }
+    }
+}
+
+u64 pool_allocator_allocated_count(pool_allocator* allocator) {
+    return allocator ? atomic_u64_load(&allocator->allocated_count) : 0;
+}
+
+static void* interface_allocate(void* context, u64 size) {
+    pool_allocator* allocator = context;
+    if (size > allocator->object_size) {
+        MERROR("pool_allocator - Requested %lluB from a pool of %lluB objects!", size, allocator->object_size);
+        return nullptr;
+    }
+    return pool_allocator_allocate(allocator);
+}
+
+static void interface_free(void* context, void* block, u64 size) {
+    pool_allocator_free(context, block);
+}
+
+static void interface_free_all(void* context) {
+    pool_allocator_free_all(context);
+}
+
+void pool_allocator_get_interface(pool_allocator* allocator, frame_allocator_int* out_interface) {
+    out_interface->allocate = interface_allocate;
+    out_interface->free = interface_free;
+    out_interface->free_all = interface_free_all;
+    out_interface->context = allocator;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "defines.h"
+#include "threads/mutex.h"
+
+struct frame_allocator_int;
+struct pool_thread_cache;
+
+typedef enum pool_allocator_flag_bits {
+    POOL_ALLOCATOR_FLAG_NONE_BIT = 0x00,
+    // Every thread works on its own cache of free objects and only takes the pool mutex to refill or
+    // flush it, so the pool can be shared between threads. Without it the pool is not thread safe
+    POOL_ALLOCATOR_FLAG_THREAD_CACHE_BIT = 0x01
+} pool_allocator_flag_bits;
+
+typedef u32 pool_allocator_flags;
+
+// Number of per-thread caches a pool keeps. Threads beyond this count share caches
+#define POOL_ALLOCATOR_THREAD_CACHE_COUNT 16
+
+// Hands out fixed-size objects in O(1). Memory is obtained in chunks of objects_per_chunk objects
+// and only returned when the pool is destroyed. Freed objects are kept in an intrusive free list
+typedef struct pool_allocator {
+    u64 object_size;
+    u64 object_alignment;
+    u64 objects_per_chunk;
+    u64 chunk_size;
+    pool_allocator_flags flags;
+
+    // Chunks are linked through their first bytes
+    void* chunks;
+    u64 chunk_count;
+    // Next never used object of the newest chunk, and the end of that chunk
+    u8* bump;
+    u8* bump_end;
+    // Freed objects are linked through their first bytes
+    void* free_list;
+    // Objects currently handed out, including those held by thread caches
+    u64 allocated_count;
+
+    mutex pool_mutex;
+    struct pool_thread_cache* thread_caches;
+} pool_allocator;
+
+MAPI b8 pool_allocator_create(u64 object_size, u16 alignment, u64 objects_per_chunk, pool_allocator_flags flags, pool_allocator* out_allocator);
+
+MAPI void pool_allocator_destroy(pool_allocator* allocator);
+
+// Gets an object from the pool. The contents are undefined
+MAPI void* pool_allocator_allocate(pool_allocator* allocator);
+
+MAPI void pool_allocator_free(pool_allocator* allocator, void* block);
+
+// Returns every object to the pool at once. Chunks are kept for reuse.
+// Safe to call while other threads allocate and free, though any object they still hold becomes invalid
+MAPI void pool_allocator_free_all(pool_allocator* allocator);
+
+// Gets the number of objects currently allocated from the pool
+MAPI u64 pool_allocator_allocated_count(pool_allocator* allocator);
+
+// Fills out_interface so containers taking a frame_allocator_int allocate from this pool.
+// Requests larger than the object size fail
+MAPI void pool_allocator_get_interface(pool_allocator* allocator, struct frame_allocator_int* out_interface);
@@ -0,0 +1,98 @@
+#include "scratch_allocator.h"
+
+#include "memory/memory.h"
+#include "memory/allocators/linear_allocator.h"
+#include "platform/platform.h"
+
+// Lives at the start of the arena's own pages
+typedef struct scratch_thread_state {
+    linear_allocator arena;
+    frame_allocator_int allocator;
+} scratch_thread_state;
+
+static MTHREAD_LOCAL scratch_thread_state* thread_scratch;
+
+static void* interface_allocate(void* context, u64 size) {
+    linear_allocator* arena = context;
+    size = get_aligned(size, SCRATCH_ARENA_ALIGNMENT);
+    // No error logging here, since the logger itself allocates from the scratch arena
+    if (size > arena->total_size - arena->allocated) {
+        return nullptr;
+    }
+    return linear_allocator_allocate(arena, size);
+}
+
+static void interface_free(void* context, void* block, u64 size) {
+    // NOTE: intentional No-op here. Scratch memory is released by scratch_end.
+}
+
+static void interface_free_all(void* context) {
+    // NOTE: intentional No-op here. Clearing the arena would release the scopes of every caller up the stack.
+}
+
+static scratch_thread_state* get_thread_state(void) {
+    if (thread_scratch) {
+        return thread_scratch;
+    }
+
+    void* block = platform_memory_reserve(SCRATCH_ARENA_SIZE);
+    if (!block) {
+        return nullptr;
+    }
+    if (!platform_memory_commit(block, SCRATCH_ARENA_SIZE)) {
+        platform_memory_release(block, SCRATCH_ARENA_SIZE);
+        return nullptr;
+    }
+
+    scratch_thread_state* state = block;
+    u64 state_size = get_aligned(sizeof(scratch_thread_state), SCRATCH_ARENA_ALIGNMENT);
+    linear_allocator_create(SCRATCH_ARENA_SIZE - state_size, (u8*)block + state_size, &state->arena);
+    state->allocator.allocate = interface_allocate;
+    state->allocator.free = interface_free;
+    state->allocator.free_all = interface_free_all;
+    state->allocator.context = &state->arena;
+
+    thread_scratch = state;
+    return state;
+}
+
+scratch_arena scratch_begin(void) {
+    scratch_arena scratch = {0};
+    scratch_thread_state* state = get_thread_state();
+    if (state) {
+        scratch.allocator = &state->allocator;
+        scratch.marker = linear_allocator_get_marker(&state->arena);
+    }
+    return scratch;
+}
+
+void scratch_end(scratch_arena scratch) {
+    if (scratch.allocator) {
+        linear_allocator_free_to_marker(scratch.allocator->context, scratch.marker);
+    }
+}
+
+void* scratch_allocate(scratch_arena* scratch, u64 size) {
+    if (!scratch || !scratch->allocator) {
+        return nullptr;
+    }
+    return interface_allocate(scratch->allocator->context, size);
+}
+
+void scratch_get_usage(u64* out_used, u64* out_capacity) {
+    scratch_thread_state* state = thread_scratch;
+    if (out_used) {
+        *out_used = state ? state->arena.allocated : 0;
+    }
+    if (out_capacity) {
+        *out_capacity = state ? state->arena.total_size : 0;
+    }
+}
+
+void scratch_thread_release(void) {
+    if (thread_scratch) {
+        linear_allocator_destroy(&thread_scratch->arena);
+        platform_memory_release(thread_scratch, SCRATCH_ARENA_SIZE);
+        thread_scratch = nullptr;
+    }
+}
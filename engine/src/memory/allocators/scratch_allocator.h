@@ -0,0 +1,36 @@
+#pragma once
+
+#include "defines.h"
+
+struct frame_allocator_int;
+
+// Size of the address range reserved for every thread's scratch arena
+#define SCRATCH_ARENA_SIZE MEBIBYTES(2)
+
+// Scratch allocations are rounded up to this many bytes, so every block is aligned to it
+#define SCRATCH_ARENA_ALIGNMENT 16
+
+// A scope on the calling thread's scratch arena. Everything allocated through it is released at once
+// by scratch_end. Scopes nest like a stack: inner scopes must end before the scopes around them
+typedef struct scratch_arena {
+    // Allocates from the thread's arena. Can be passed to containers and any _with_allocator function.
+    // Frees are no-ops, and allocations return nullptr instead of logging once the arena is full
+    struct frame_allocator_int* allocator;
+    u64 marker;
+} scratch_arena;
+
+// Opens a scope on the calling thread's scratch arena, creating the arena on first use.
+// The arena lives outside the memory system, so it works before it is initialized
+MAPI scratch_arena scratch_begin(void);
+
+// Releases everything allocated since the matching scratch_begin
+MAPI void scratch_end(scratch_arena scratch);
+
+// Allocates from the scope. The contents are undefined. Returns nullptr when the arena is full
+MAPI void* scratch_allocate(scratch_arena* scratch, u64 size);
+
+// Gets the number of bytes in use and the capacity of the calling thread's arena
+MAPI void scratch_get_usage(u64* out_used, u64* out_capacity);
+
+// Releases the calling thread's arena. Threads started with thread_create call this when their function returns
+MAPI void scratch_thread_release(void);
@@ -5,6 +5,9 @@
 #include <stdio.h>
 
 #include "memory/allocators/dynamic_allocator.h"
+#include "memory/memory_profiler.h"
+#include "platform/platform.h"
+#include "threads/atomic.h"
 #include "threads/mutex.h"
 
 #include "core/logger.h"
@@ -24,6 +27,189 @@
 #   endif
 #endif
 
+#if MEMORY_PROFILER_ENABLED
+// The public entry points capture their caller, so allocations are attributed to the code calling into the memory system
+#   if defined(_MSC_VER)
+#       include <intrin.h>
+#       define MEMORY_CALL_SITE() _ReturnAddress()
+#   else
+#       define MEMORY_CALL_SITE() __builtin_return_address(0)
+#   endif
+#else
+#   define MEMORY_CALL_SITE() nullptr
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64)
+#   define MEMORY_STREAMING_X64 1
+#   include <immintrin.h>
+#   if defined(_MSC_VER)
+#       include <intrin.h>
+#       define MEMORY_TARGET_AVX2
+#   else
+#       include <cpuid.h>
+#       define MEMORY_TARGET_AVX2 __attribute__((target("avx2")))
+#   endif
+#else
+#   define MEMORY_STREAMING_X64 0
+#endif
+
+// Kernels used by memory_copy_large and memory_set_large once a block reaches the streaming threshold.
+// They write whole aligned vectors with non-temporal stores, so large copies and clears don't evict the working set
+typedef struct memory_streaming_kernel {
+    const char* name;
+    void (*copy)(u8* dst, const u8* src, u64 size);
+    void (*set)(u8* dst, u8 value, u64 size);
+} memory_streaming_kernel;
+
+#if MEMORY_STREAMING_X64
+static void sse2_stream_copy(u8* dst, const u8* src, u64 size) {
+    u64 head = get_aligned((u64)dst, 16) - (u64)dst;
+    memcpy(dst, src, head);
+    dst += head;
+    src += head;
+    size -= head;
+    for (; size >= 64; size -= 64, dst += 64, src += 64) {
+        __m128i a = _mm_loadu_si128((const __m128i*)src);
+        __m128i b = _mm_loadu_si128((const __m128i*)(src + 16));
+        __m128i c = _mm_loadu_si128((const __m128i*)(src + 32));
+        __m128i d = _mm_loadu_si128((const __m128i*)(src + 48));
+        _mm_stream_si128((__m128i*)dst, a);
+        _mm_stream_si128((__m128i*)(dst + 16), b);
+        _mm_stream_si128((__m128i*)(dst + 32), c);
+        _mm_stream_si128((__m128i*)(dst + 48), d);
+    }
+    _mm_sfence();
+    memcpy(dst, src, size);
+}
+
+static void sse2_stream_set(u8* dst, u8 value, u64 size) {
+    u64 head = get_aligned((u64)dst, 16) - (u64)dst;
+    memset(dst, value, head);
+    dst += head;
+    size -= head;
+    __m128i v = _mm_set1_epi8((char)value);
+    for (; size >= 64; size -= 64, dst += 64) {
+        _mm_stream_si128((__m128i*)dst, v);
+        _mm_stream_si128((__m128i*)(dst + 16), v);
+        _mm_stream_si128((__m128i*)(dst + 32), v);
+        _mm_stream_si128((__m128i*)(dst + 48), v);
+    }
+    _mm_sfence();
+    memset(dst, value, size);
+}
+
+MEMORY_TARGET_AVX2 static void avx2_stream_copy(u8* dst, const u8* src, u64 size) {
+    u64 head = get_aligned((u64)dst, 32) - (u64)dst;
+    memcpy(dst, src, head);
+    dst += head;
+    src += head;
+    size -= head;
+    for (; size >= 128; size -= 128, dst += 128, src += 128) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)src);
+        __m256i b = _mm256_loadu_si256((const __m256i*)(src + 32));
+        __m256i c = _mm256_loadu_si256((const __m256i*)(src + 64));
+        __m256i d = _mm256_loadu_si256((const __m256i*)(src + 96));
+        _mm256_stream_si256((__m256i*)dst, a);
+        _mm256_stream_si256((__m256i*)(dst + 32), b);
+        _mm256_stream_si256((__m256i*)(dst + 64), c);
+        _mm256_stream_si256((__m256i*)(dst + 96), d);
+    }
+    _mm_sfence();
+    memcpy(dst, src, size);
+}
+
+MEMORY_TARGET_AVX2 static void avx2_stream_set(u8* dst, u8 value, u64 size) {
+    u64 head = get_aligned((u64)dst, 32) - (u64)dst;
+    memset(dst, value, head);
+    dst += head;
+    size -= head;
+    __m256i v = _mm256_set1_epi8((char)value);
+    for (; size >= 128; size -= 128, dst += 128) {
+        _mm256_stream_si256((__m256i*)dst, v);
+        _mm256_stream_si256((__m256i*)(dst + 32), v);
+        _mm256_stream_si256((__m256i*)(dst + 64), v);
+        _mm256_stream_si256((__m256i*)(dst + 96), v);
+    }
+    _mm_sfence();
+    memset(dst, value, size);
+}
+
+// AVX2 needs both the instructions and an OS that saves the YMM registers
+static b8 cpu_supports_avx2(void) {
+    u32 regs[4] = {0};
+#   if defined(_MSC_VER)
+    __cpuid((int*)regs, 0);
+    if (regs[0] < 7) {
+        return false;
+    }
+    __cpuid((int*)regs, 1);
+    b8 os_saves_ymm = (regs[2] & (1u << 27)) && (_xgetbv(0) & 0x6) == 0x6;
+    __cpuidex((int*)regs, 7, 0);
+#   else
+    if (!__get_cpuid(1, &regs[0], &regs[1], &regs[2], &regs[3])) {
+        return false;
+    }
+    b8 os_saves_ymm = false;
+    if (regs[2] & (1u << 27)) {
+        u32 xcr0_low, xcr0_high;
+        __asm__ volatile("xgetbv" : "=a"(xcr0_low), "=d"(xcr0_high) : "c"(0));
+        os_saves_ymm = (xcr0_low & 0x6) == 0x6;
+    }
+    if (!__get_cpuid_count(7, 0, &regs[0], &regs[1], &regs[2], &regs[3])) {
+        return false;
+    }
+#   endif
+    return os_saves_ymm && (regs[1] & (1u << 5));
+}
+
+static const memory_streaming_kernel avx2_kernel = {"avx2", avx2_stream_copy, avx2_stream_set};
+static const memory_streaming_kernel sse2_kernel = {"sse2", sse2_stream_copy, sse2_stream_set};
+#else
+static void plain_copy(u8* dst, const u8* src, u64 size) {
+    memcpy(dst, src, size);
+}
+
+static void plain_set(u8* dst, u8 value, u64 size) {
+    memset(dst, value, size);
+}
+
+static const memory_streaming_kernel plain_kernel = {"none", plain_copy, plain_set};
+#endif
+
+// Chosen on first use, as memory_copy and friends work before the memory system is initialized.
+// Racing threads all pick the same kernel, so the selection needs no lock
+static const memory_streaming_kernel* streaming_kernel = nullptr;
+static u64 streaming_threshold = MEMORY_DEFAULT_STREAMING_THRESHOLD;
+
+static void streaming_kernel_select(void) {
+#if MEMORY_STREAMING_X64
+    streaming_kernel = cpu_supports_avx2() ? &avx2_kernel : &sse2_kernel;
+#else
+    streaming_kernel = &plain_kernel;
+#endif
+}
+
+#if USE_CUSTOM_MEMORY_ALLOCATOR
+// Small allocations are served from per-thread magazines of power-of-two size classes.
+// Only refills, flushes and blocks larger than the biggest class take the allocation mutex
+#define MEMORY_CACHE_MIN_SIZE 16
+#define MEMORY_CACHE_MAX_SIZE 1024
+#define MEMORY_CACHE_CLASS_COUNT 7
+#define MEMORY_CACHE_ALIGNMENT 16
+// Number of blocks a single magazine holds. Refills and flushes move half of it at once
+#define MEMORY_CACHE_MAGAZINE_SIZE 64
+
+typedef struct memory_magazine {
+    u32 count;
+    void* blocks[MEMORY_CACHE_MAGAZINE_SIZE];
+} memory_magazine;
+
+typedef struct memory_thread_cache {
+    memory_magazine magazines[MEMORY_CACHE_CLASS_COUNT];
+} memory_thread_cache;
+
+static MTHREAD_LOCAL memory_thread_cache thread_cache;
+#endif
 
 static char* memory_tag_strings[MEMORY_TAG_MAX_TAGS] = {
     "UNKNOWN     ",
@@ -33,9 +219,11 @@ static char* memory_tag_strings[MEMORY_TAG_MAX_TAGS] = {
     "RING_QUEUE  ",
     "STACK       ",
     "BST         ",
+    "HASHTABLE   ",
     "STRING      ",
 
     "LINEAR_ALLOC",
+    "POOL_ALLOC  ",
 
     "ENGINE      ",
     "PLATFORM    ",
@@ -47,42 +235,248 @@ static char* memory_tag_strings[MEMORY_TAG_MAX_TAGS] = {
     "VULKAN      "
 };
 
+// Statistics are counted per thread and only folded into the shared counters once a thread's
+// pending change for a tag reaches a batch limit, so tracking never contends on a shared cache line.
+// Peaks are checked on every allocation against the folded counter plus the allocating thread's pending
+// change, so they only miss what other threads have not folded yet, at most a batch per thread
+#define MEMORY_STATS_BATCH_BYTES KIBIBYTES(256)
+#define MEMORY_STATS_BATCH_COUNT 256
+
+typedef struct memory_stats_shard {
+    struct memory_stats_shard* next;
+    // Links the shard into the free list once its thread has exited
+    struct memory_stats_shard* next_free;
+    // Signed changes not yet folded into the shared counters, stored two's complement.
+    // Only the owning thread writes these, other threads read them when gathering stats
+    volatile u64 pending_bytes[MEMORY_TAG_MAX_TAGS];
+    volatile u64 pending_counts[MEMORY_TAG_MAX_TAGS];
+    // Allocations ever made by the owning thread
+    volatile u64 total_counts[MEMORY_TAG_MAX_TAGS];
+} memory_stats_shard;
+
+// Shards are never freed, as a thread may still hold one after the system shuts down.
+// They are reset on initialize instead. A thread hands its shard back when it flushes on exit, so the
+// list only grows with the number of threads alive at once
+static memory_stats_shard* volatile stats_shards;
+static memory_stats_shard* volatile free_stats_shards;
+static MTHREAD_LOCAL memory_stats_shard* thread_stats_shard;
+
 typedef struct memory_system_state {
-    u64 allocation_count;
-    u64 total_allocated;
+    memory_system_config config;
+    // Folded counters. Changes still pending in the thread shards are not included
     u64 tagged_allocations[MEMORY_TAG_MAX_TAGS];
+    u64 tagged_counts[MEMORY_TAG_MAX_TAGS];
+    u64 tagged_peaks[MEMORY_TAG_MAX_TAGS];
+    // Allocations ever made by threads whose shards went back to the free list
+    u64 retired_total_counts[MEMORY_TAG_MAX_TAGS];
 
     u64 allocator_memory_requirement;
     dynamic_allocator allocator;
     void* allocator_block;
+    // The range obtained from the platform. Larger than the allocator block when it had to be aligned
+    void* reserved_block;
+    u64 reserved_size;
+    memory_page_mode page_mode;
 
     mutex allocation_mutex;
 } memory_system_state;
 
 static memory_system_state* state_ptr;
 
-b8 memory_system_initialize() {
+static void stats_reset(void) {
+    memory_zero(&state_ptr->tagged_allocations, sizeof(u64) * MEMORY_TAG_MAX_TAGS);
+    memory_zero(&state_ptr->tagged_counts, sizeof(u64) * MEMORY_TAG_MAX_TAGS);
+    memory_zero(&state_ptr->tagged_peaks, sizeof(u64) * MEMORY_TAG_MAX_TAGS);
+    memory_zero(&state_ptr->retired_total_counts, sizeof(u64) * MEMORY_TAG_MAX_TAGS);
+
+    memory_stats_shard* shard = atomic_ptr_load((void* volatile*)&stats_shards);
+    while (shard) {
+        memory_stats_shard* next = shard->next;
+        memory_zero((void*)shard->pending_bytes, sizeof(shard->pending_bytes));
+        memory_zero((void*)shard->pending_counts, sizeof(shard->pending_counts));
+        memory_zero((void*)shard->total_counts, sizeof(shard->total_counts));
+        shard = next;
+    }
+}
+
+// Pushes a chain of shards, linked through next_free, onto the free list
+static void stats_free_list_push(memory_stats_shard* first, memory_stats_shard* last) {
+    void* head = atomic_ptr_load((void* volatile*)&free_stats_shards);
+    do {
+        last->next_free = head;
+    } while (!atomic_ptr_compare_exchange((void* volatile*)&free_stats_shards, &head, first));
+}
+
+// Takes the whole free list and puts back all but its first shard. Popping a single shard would
+// compare against a next_free pointer another thread may have reused in the meantime
+static memory_stats_shard* stats_free_list_pop(void) {
+    void* head = atomic_ptr_load((void* volatile*)&free_stats_shards);
+    while (head && !atomic_ptr_compare_exchange((void* volatile*)&free_stats_shards, &head, nullptr)) {
+    }
+    memory_stats_shard* shard = head;
+    if (shard && shard->next_free) {
+        memory_stats_shard* last = shard->next_free;
+        while (last->next_free) {
+            last = last->next_free;
+        }
+        stats_free_list_push(shard->next_free, last);
+    }
+    return shard;
+}
+
+static memory_stats_shard* stats_thread_shard(void) {
+    if (thread_stats_shard) {
+        return thread_stats_shard;
+    }
+
+    // Shards on the free list are already on the shared list, and hold no counts
+    memory_stats_shard* shard = stats_free_list_pop();
+    if (shard) {
+        shard->next_free = nullptr;
+        thread_stats_shard = shard;
+        return shard;
+    }
+
+    shard = calloc(1, sizeof(memory_stats_shard));
+    if (!shard) {
+        return nullptr;
+    }
+
+    void* head = atomic_ptr_load((void* volatile*)&stats_shards);
+    do {
+        shard->next = head;
+    } while (!atomic_ptr_compare_exchange((void* volatile*)&stats_shards, &head, shard));
+
+    thread_stats_shard = shard;
+    return shard;
+}
+
+// The peak is only written when it rises, so the common case is a read of a shared cache line
+static void stats_raise_peak(memory_tag tag, u64 allocated) {
+    u64 peak = atomic_u64_load(&state_ptr->tagged_peaks[tag]);
+    while ((i64)allocated > (i64)peak && !atomic_u64_compare_exchange(&state_ptr->tagged_peaks[tag], &peak, allocated)) {
+    }
+}
+
+// Moves the pending changes of a tag into the shared counters and raises its peak if needed
+static void stats_fold(memory_stats_shard* shard, memory_tag tag) {
+    u64 bytes = shard->pending_bytes[tag];
+    u64 count = shard->pending_counts[tag];
+    atomic_u64_store(&shard->pending_bytes[tag], 0);
+    atomic_u64_store(&shard->pending_counts[tag], 0);
+
+    u64 allocated = atomic_u64_fetch_add(&state_ptr->tagged_allocations[tag], bytes) + bytes;
+    atomic_u64_fetch_add(&state_ptr->tagged_counts[tag], count);
+    stats_raise_peak(tag, allocated);
+}
+
+static void stats_track(memory_tag tag, u64 size, b8 is_allocation) {
+    memory_stats_shard* shard = stats_thread_shard();
+    if (!shard) {
+        return;
+    }
+
+    // Unsigned wrap-around makes the subtraction safe, the values are read back as signed
+    u64 bytes = shard->pending_bytes[tag] + (is_allocation ? size : (u64)0 - size);
+    u64 count = shard->pending_counts[tag] + (is_allocation ? 1 : (u64)0 - 1);
+    atomic_u64_store(&shard->pending_bytes[tag], bytes);
+    atomic_u64_store(&shard->pending_counts[tag], count);
+    if (is_allocation) {
+        atomic_u64_store(&shard->total_counts[tag], shard->total_counts[tag] + 1);
+        // A spike that drains again within one batch never reaches a fold
+        stats_raise_peak(tag, atomic_u64_load(&state_ptr->tagged_allocations[tag]) + bytes);
+    }
+
+    if ((i64)bytes >= (i64)MEMORY_STATS_BATCH_BYTES || (i64)bytes <= -(i64)MEMORY_STATS_BATCH_BYTES ||
+        (i64)count >= MEMORY_STATS_BATCH_COUNT || (i64)count <= -MEMORY_STATS_BATCH_COUNT) {
+        stats_fold(shard, tag);
+    }
+}
+
+// Folds the calling thread's counts into the shared ones and hands its shard to the free list.
+// A thread that keeps allocating afterwards simply picks up a shard again
+static void stats_retire_thread(void) {
+    memory_stats_shard* shard = thread_stats_shard;
+    if (!shard) {
+        return;
+    }
+    thread_stats_shard = nullptr;
+
+    // Without a running system there is nothing to fold into, and initialize resets every shard
+    if (state_ptr) {
+        for (u32 i = 0; i < MEMORY_TAG_MAX_TAGS; ++i) {
+            stats_fold(shard, i);
+            // Counted in the retired total first, so a concurrent memory_get_stats can only briefly see it twice
+            atomic_u64_fetch_add(&state_ptr->retired_total_counts[i], shard->total_counts[i]);
+            atomic_u64_store(&shard->total_counts[i], 0);
+        }
+    }
+    stats_free_list_push(shard, shard);
+}
+
 #if USE_CUSTOM_MEMORY_ALLOCATOR
-    u64 state_memory_requirement = sizeof(memory_system_state);
+// Sets up the heap's dynamic allocator on pages of the requested kind, falling back to smaller pages when needed
+static b8 heap_create(memory_page_mode page_mode, u64 total_size) {
+    u64 huge_page_size = platform_memory_huge_page_size();
+    if (page_mode == MEMORY_PAGE_MODE_HUGE && huge_page_size) {
+        // Pool pages are committed and zeroed by the OS up front, so there is nothing to commit lazily
+        dynamic_allocator_flags flags = DYNAMIC_ALLOCATOR_FLAG_ZEROED_MEMORY_BIT;
+        u64 requirement = 0;
+        dynamic_allocator_create_with_flags(total_size, flags, &requirement, nullptr, nullptr);
+        u64 reserved_size = get_aligned(requirement, huge_page_size);
+        void* block = platform_memory_allocate_huge(reserved_size);
+        if (block && dynamic_allocator_create_with_flags(total_size, flags, &requirement, block, &state_ptr->allocator)) {
+            state_ptr->allocator_memory_requirement = requirement;
+            state_ptr->allocator_block = block;
+            state_ptr->reserved_block = block;
+            state_ptr->reserved_size = reserved_size;
+            state_ptr->page_mode = MEMORY_PAGE_MODE_HUGE;
+            return true;
+        }
+        platform_memory_release(block, reserved_size);
+        MWARN("Huge pages are unavailable for %llu bytes of heap, falling back to transparent huge pages.", reserved_size);
+        page_mode = MEMORY_PAGE_MODE_TRANSPARENT_HUGE;
+    }
 
+    if (page_mode == MEMORY_PAGE_MODE_TRANSPARENT_HUGE) {
+        // Commit in huge page sized chunks from a huge page aligned block, so every chunk can be a single page
+        dynamic_allocator_flags flags = DYNAMIC_ALLOCATOR_FLAG_LAZY_COMMIT_BIT | DYNAMIC_ALLOCATOR_FLAG_HUGE_GRANULES_BIT;
+        u64 requirement = 0;
+        dynamic_allocator_create_with_flags(total_size, flags, &requirement, nullptr, nullptr);
+        u64 reserved_size = requirement + DYNAMIC_ALLOCATOR_HUGE_COMMIT_GRANULARITY;
+        void* block = platform_memory_reserve(reserved_size);
+        void* aligned_block = block ? (void*)get_aligned((u64)block, DYNAMIC_ALLOCATOR_HUGE_COMMIT_GRANULARITY) : nullptr;
+        if (aligned_block && platform_memory_advise_huge(aligned_block, requirement) &&
+            dynamic_allocator_create_with_flags(total_size, flags, &requirement, aligned_block, &state_ptr->allocator)) {
+            state_ptr->allocator_memory_requirement = requirement;
+            state_ptr->allocator_block = aligned_block;
+            state_ptr->reserved_block = block;
+            state_ptr->reserved_size = reserved_size;
+            state_ptr->page_mode = MEMORY_PAGE_MODE_TRANSPARENT_HUGE;
+            return true;
+        }
+        platform_memory_release(block, reserved_size);
+        MWARN("Transparent huge pages are unavailable, the heap falls back to regular pages.");
+    }
+
+    // Only reserve address space for the heap. The allocator commits pages as they are handed out,
+    // so startup cost and resident memory follow actual usage rather than total_alloc_size
     u64 alloc_requirement = 0;
-    dynamic_allocator_create(GIBIBYTES(1), &alloc_requirement, nullptr, nullptr);
+    dynamic_allocator_create_with_flags(total_size, DYNAMIC_ALLOCATOR_FLAG_LAZY_COMMIT_BIT, &alloc_requirement, nullptr, nullptr);
 
-    void* block = malloc(state_memory_requirement + alloc_requirement);
-    if (!block) {
-        MFATAL("Memory system allocation failed and the system cannot continue!");
+    state_ptr->allocator_memory_requirement = alloc_requirement;
+    state_ptr->allocator_block = platform_memory_reserve(alloc_requirement);
+    if (!state_ptr->allocator_block) {
+        MFATAL("Memory system is unable to reserve %llu bytes of address space. Application cannot continue!", alloc_requirement);
         return false;
     }
+    state_ptr->reserved_block = state_ptr->allocator_block;
+    state_ptr->reserved_size = alloc_requirement;
+    state_ptr->page_mode = MEMORY_PAGE_MODE_DEFAULT;
 
-    state_ptr = (memory_system_state*)block;
-    state_ptr->allocation_count = 0;
-    state_ptr->allocator_memory_requirement = alloc_requirement;
-    state_ptr->total_allocated = 0;
-    memory_zero(&state_ptr->tagged_allocations, sizeof(u64) * MEMORY_TAG_MAX_TAGS);
-    state_ptr->allocator_block = ((void*)block + state_memory_requirement);
-
-    if (!dynamic_allocator_create(
-        GIBIBYTES(1),
+    if (!dynamic_allocator_create_with_flags(
+        total_size,
+        DYNAMIC_ALLOCATOR_FLAG_LAZY_COMMIT_BIT,
         &state_ptr->allocator_memory_requirement,
         state_ptr->allocator_block,
         &state_ptr->allocator
@@ -90,13 +484,31 @@ b8 memory_system_initialize() {
         MFATAL("Memory system is unable to setup internal allocator. Application cannot continue!");
         return false;
     }
+    return true;
+}
+#endif
+
+b8 memory_system_initialize(memory_system_config config) {
+#if USE_CUSTOM_MEMORY_ALLOCATOR
+    state_ptr = malloc(sizeof(memory_system_state));
+    if (!state_ptr) {
+        MFATAL("Memory system allocation failed and the system cannot continue!");
+        return false;
+    }
+
+    state_ptr->config = config;
+    stats_reset();
+
+    if (!heap_create(config.page_mode, config.total_alloc_size)) {
+        return false;
+    }
 #else
     state_ptr = maligned_alloc(sizeof(memory_system_state), 16);
-    state_ptr->allocation_count = 0;
+    state_ptr->config = config;
+    stats_reset();
     state_ptr->allocator_memory_requirement = 0;
-    state_ptr->total_allocated = 0;
-    memory_zero(&state_ptr->tagged_allocations, sizeof(u64) * MEMORY_TAG_MAX_TAGS);
     state_ptr->allocator_block = nullptr;
+    state_ptr->page_mode = MEMORY_PAGE_MODE_DEFAULT;
 #endif
 
     if (!mutex_create(&state_ptr->allocation_mutex)) {
@@ -104,14 +516,27 @@ b8 memory_system_initialize() {
         return false;
     }
 
+#if MEMORY_PROFILER_ENABLED
+    if (!memory_profiler_initialize()) {
+        MWARN("Memory profiler failed to initialize, allocations will not be profiled.");
+    }
+#endif
+
     return true;
 }
 
 void memory_system_shutdown() {
     if (state_ptr) {
+#if MEMORY_PROFILER_ENABLED
+        memory_profiler_shutdown();
+#endif
+#if USE_CUSTOM_MEMORY_ALLOCATOR
+        memory_thread_cache_flush();
+#endif
         mutex_destroy(&state_ptr->allocation_mutex);
 #if USE_CUSTOM_MEMORY_ALLOCATOR
         dynamic_allocator_destroy(&state_ptr->allocator);
+        platform_memory_release(state_ptr->reserved_block, state_ptr->reserved_size);
         free(state_ptr);
 #else
         maligned_free(state_ptr);
@@ -120,39 +545,140 @@ void memory_system_shutdown() {
     }
 }
 
-void* memory_allocate(u64 size, memory_tag tag) {
-    return memory_allocate_aligned(size, 1, tag);
-}
+#if USE_CUSTOM_MEMORY_ALLOCATOR
+// Gets the cache size class for the given request, or INVALID_ID if it must go to the global allocator
+static u32 cache_class_index(u64 size, u16 alignment) {
+    if (size > MEMORY_CACHE_MAX_SIZE || alignment > MEMORY_CACHE_ALIGNMENT) {
+        return INVALID_ID;
+    }
 
-void* memory_allocate_aligned(u64 size, u16 alignment, memory_tag tag) {
-    if (tag == MEMORY_TAG_UNKNOWN) {
-        MWARN("memory_allocate_aligned - Called using MEMORY_TAG_UNKNOWN. Re-class this allocation!");
+    u32 index = 0;
+    u64 class_size = MEMORY_CACHE_MIN_SIZE;
+    while (class_size < size) {
+        class_size <<= 1;
+        index++;
     }
+    return index;
+}
 
-    void* block = nullptr;
-    if (state_ptr) {
+MINLINE u64 cache_class_size(u32 class_index) {
+    return (u64)MEMORY_CACHE_MIN_SIZE << class_index;
+}
+
+static void* cache_allocate(u32 class_index) {
+    memory_magazine* magazine = &thread_cache.magazines[class_index];
+    if (magazine->count == 0) {
+        // Refill half of the magazine under a single lock
         if (!mutex_lock(&state_ptr->allocation_mutex)) {
             MFATAL("Error obtaining mutex lock during allocation!");
             return nullptr;
         }
+        u64 class_size = cache_class_size(class_index);
+        for (u32 i = 0; i < MEMORY_CACHE_MAGAZINE_SIZE / 2; ++i) {
+            void* block = dynamic_allocator_allocate_aligned(&state_ptr->allocator, class_size, MEMORY_CACHE_ALIGNMENT);
+            if (!block) {
+                break;
+            }
+            magazine->blocks[magazine->count++] = block;
+        }
+        mutex_unlock(&state_ptr->allocation_mutex);
+
+        if (magazine->count == 0) {
+            return nullptr;
+        }
+    }
+
+    return magazine->blocks[--magazine->count];
+}
+
+static void cache_free(u32 class_index, void* block) {
+    memory_magazine* magazine = &thread_cache.magazines[class_index];
+    if (magazine->count == MEMORY_CACHE_MAGAZINE_SIZE) {
+        // Flush the older half of the magazine under a single lock
+        if (!mutex_lock(&state_ptr->allocation_mutex)) {
+            MFATAL("Unable to obtain mutex lock for free operation! Heap corruption is likely!");
+            return;
+        }
+        const u32 flush_count = MEMORY_CACHE_MAGAZINE_SIZE / 2;
+        for (u32 i = 0; i < flush_count; ++i) {
+            dynamic_allocator_free_aligned(&state_ptr->allocator, magazine->blocks[i]);
+        }
+        mutex_unlock(&state_ptr->allocation_mutex);
+
+        memory_copy(magazine->blocks, magazine->blocks + flush_count, sizeof(void*) * (magazine->count - flush_count));
+        magazine->count -= flush_count;
+    }
+
+    magazine->blocks[magazine->count++] = block;
+}
+
+void memory_thread_cache_flush(void) {
+    if (!state_ptr) {
+        return;
+    }
+
+    stats_retire_thread();
+
+    if (!mutex_lock(&state_ptr->allocation_mutex)) {
+        MFATAL("Unable to obtain mutex lock for cache flush! Heap corruption is likely!");
+        return;
+    }
+    for (u32 i = 0; i < MEMORY_CACHE_CLASS_COUNT; ++i) {
+        memory_magazine* magazine = &thread_cache.magazines[i];
+        for (u32 j = 0; j < magazine->count; ++j) {
+            dynamic_allocator_free_aligned(&state_ptr->allocator, magazine->blocks[j]);
+        }
+        magazine->count = 0;
+    }
+    mutex_unlock(&state_ptr->allocation_mutex);
+}
+#else
+void memory_thread_cache_flush(void) {
+    stats_retire_thread();
+}
+#endif
+
+// Performs the allocation for every memory_allocate variant. Blocks are only zeroed when requested,
+// and not at all when the heap knows they sit on untouched pages
+static void* allocate_block(u64 size, u16 alignment, memory_tag tag, b8 zero, void* call_site) {
+    if (tag == MEMORY_TAG_UNKNOWN) {
+        MWARN("memory_allocate_aligned - Called using MEMORY_TAG_UNKNOWN. Re-class this allocation!");
+    }
 
+    void* block = nullptr;
+    b8 zeroed = false;
+    if (state_ptr) {
         // FIXME: Alignment
-        state_ptr->allocation_count++;
-        state_ptr->total_allocated += size;
-        state_ptr->tagged_allocations[tag] += size;
+        stats_track(tag, size, true);
 
 #if USE_CUSTOM_MEMORY_ALLOCATOR
-        block = dynamic_allocator_allocate_aligned(&state_ptr->allocator, size, alignment);
+        u32 class_index = cache_class_index(size, alignment);
+        if (class_index != INVALID_ID) {
+            block = cache_allocate(class_index);
+        } else {
+            if (!mutex_lock(&state_ptr->allocation_mutex)) {
+                MFATAL("Error obtaining mutex lock during allocation!");
+                return nullptr;
+            }
+            block = dynamic_allocator_allocate_aligned_check_zeroed(&state_ptr->allocator, size, alignment, &zeroed);
+            mutex_unlock(&state_ptr->allocation_mutex);
+        }
 #else
         block = maligned_alloc(size, alignment);
 #endif
-        mutex_unlock(&state_ptr->allocation_mutex);
     } else {
         block = malloc(size);
     }
 
     if (block) {
-        memory_zero(block, size);
+        if (zero && !zeroed) {
+            memory_zero(block, size);
+        }
+#if MEMORY_PROFILER_ENABLED
+        if (state_ptr) {
+            memory_profiler_on_allocate(block, size, tag, call_site);
+        }
+#endif
         return block;
     }
 
@@ -160,32 +686,98 @@ void* memory_allocate_aligned(u64 size, u16 alignment, memory_tag tag) {
     return nullptr;
 }
 
+void* memory_allocate(u64 size, memory_tag tag) {
+    return allocate_block(size, 1, tag, true, MEMORY_CALL_SITE());
+}
+
+void* memory_allocate_aligned(u64 size, u16 alignment, memory_tag tag) {
+    return allocate_block(size, alignment, tag, true, MEMORY_CALL_SITE());
+}
+
+void* memory_allocate_uninitialized(u64 size, memory_tag tag) {
+    return allocate_block(size, 1, tag, false, MEMORY_CALL_SITE());
+}
+
+void* memory_allocate_aligned_uninitialized(u64 size, u16 alignment, memory_tag tag) {
+    return allocate_block(size, alignment, tag, false, MEMORY_CALL_SITE());
+}
+
 void memory_allocate_report(u64 size, memory_tag tag) {
-    if (!mutex_lock(&state_ptr->allocation_mutex)) {
-        MERROR("Error obtaining mutex lock during allocation reporting!");
-        return;
+    if (state_ptr) {
+        stats_track(tag, size, true);
     }
+}
 
-    state_ptr->allocation_count++;
-    state_ptr->total_allocated += size;
-    state_ptr->tagged_allocations[tag] += size;
+#if USE_CUSTOM_MEMORY_ALLOCATOR
+// Grows a heap block without moving it. Cached blocks can only grow within their size class,
+// larger blocks grow into the free memory following them
+static b8 try_grow_in_place(void* block, u64 old_size, u64 new_size, u16 alignment) {
+    u64 osize = 0;
+    u16 oalignment = 0;
+    if (!dynamic_allocator_get_size_alignment(&state_ptr->allocator, block, &osize, &oalignment)) {
+        return false;
+    }
 
+    u32 class_index = cache_class_index(old_size, alignment);
+    if (class_index != INVALID_ID) {
+        return cache_class_index(new_size, alignment) == class_index;
+    }
+
+    if (!mutex_lock(&state_ptr->allocation_mutex)) {
+        MFATAL("Error obtaining mutex lock during reallocation!");
+        return false;
+    }
+    b8 result = dynamic_allocator_try_extend(&state_ptr->allocator, block, new_size);
     mutex_unlock(&state_ptr->allocation_mutex);
+    return result;
 }
+#endif
 
-void* memory_reallocate(void* block, u64 old_size, u64 new_size, memory_tag tag) {
-    return memory_reallocate_aligned(block, old_size, new_size, 1, tag);
-}
+// Grows in place when possible, otherwise moves the block. Only the grown part is zeroed, if requested
+static void* reallocate_block(void* block, u64 old_size, u64 new_size, u16 alignment, memory_tag tag, b8 zero, void* call_site) {
+#if USE_CUSTOM_MEMORY_ALLOCATOR
+    if (block && state_ptr && new_size > old_size && try_grow_in_place(block, old_size, new_size, alignment)) {
+        stats_track(tag, old_size, false);
+        stats_track(tag, new_size, true);
+#if MEMORY_PROFILER_ENABLED
+        memory_profiler_on_free(block, old_size, tag);
+        memory_profiler_on_allocate(block, new_size, tag, call_site);
+#endif
+        if (zero) {
+            memory_zero((u8*)block + old_size, new_size - old_size);
+        }
+        return block;
+    }
+#endif
 
-void* memory_reallocate_aligned(void* block, u64 old_size, u64 new_size, u16 alignment, memory_tag tag) {
-    void* new_block = memory_allocate_aligned(new_size, alignment, tag);
-    if (block && new_block) {
-        memory_copy(new_block, block, old_size);
+    void* new_block = allocate_block(new_size, alignment, tag, false, call_site);
+    if (!new_block) {
+        return nullptr;
+    }
+
+    u64 copy_size = block ? MMIN(old_size, new_size) : 0;
+    if (block) {
+        memory_copy(new_block, block, copy_size);
         memory_free_aligned(block, old_size, alignment, tag);
     }
+    if (zero && new_size > copy_size) {
+        memory_zero((u8*)new_block + copy_size, new_size - copy_size);
+    }
     return new_block;
 }
 
+void* memory_reallocate(void* block, u64 old_size, u64 new_size, memory_tag tag) {
+    return reallocate_block(block, old_size, new_size, 1, tag, true, MEMORY_CALL_SITE());
+}
+
+void* memory_reallocate_aligned(void* block, u64 old_size, u64 new_size, u16 alignment, memory_tag tag) {
+    return reallocate_block(block, old_size, new_size, alignment, tag, true, MEMORY_CALL_SITE());
+}
+
+void* memory_reallocate_uninitialized(void* block, u64 old_size, u64 new_size, memory_tag tag) {
+    return reallocate_block(block, old_size, new_size, 1, tag, false, MEMORY_CALL_SITE());
+}
+
 void memory_reallocate_report(u64 old_size, u64 new_size, memory_tag tag) {
     memory_free_report(old_size, tag);
     memory_allocate_report(new_size, tag);
@@ -201,32 +793,42 @@ void memory_free_aligned(void* block, u64 size, u16 alignment, memory_tag tag) {
     }
 
     if (state_ptr) {
-        if (!mutex_lock(&state_ptr->allocation_mutex)) {
-            MFATAL("Unable to obtain mutex lock for free operation! Heap corruption is likely!");
-            return;
-        }
 #if USE_CUSTOM_MEMORY_ALLOCATOR
+        // Reading the header of a block owned by the caller needs no lock
         u64 osize = 0;
         u16 oalignment = 0;
-        dynamic_allocator_get_size_alignment(&state_ptr->allocator, block, &osize, &oalignment);
-        if (osize != size) {
-            MWARN("Free size mismatch! (orig=%llu, req=%llu)", osize, size);
+        b8 owned = dynamic_allocator_get_size_alignment(&state_ptr->allocator, block, &osize, &oalignment);
+
+        u32 class_index = cache_class_index(size, alignment);
+        u64 expected_size = class_index != INVALID_ID ? cache_class_size(class_index) : size;
+        u16 expected_alignment = class_index != INVALID_ID ? MEMORY_CACHE_ALIGNMENT : alignment;
+        if (owned && osize != expected_size) {
+            MWARN("Free size mismatch! (orig=%llu, req=%llu)", osize, expected_size);
         }
-        if (oalignment != alignment) {
-            MWARN("Free alignment mismatch! (orig=%llu, req=%llu)", oalignment, alignment);
+        if (owned && oalignment != expected_alignment) {
+            MWARN("Free alignment mismatch! (orig=%llu, req=%llu)", oalignment, expected_alignment);
         }
 
-        b8 result = dynamic_allocator_free_aligned(&state_ptr->allocator, block);
+        b8 result = owned;
+        if (owned && class_index != INVALID_ID) {
+            cache_free(class_index, block);
+        } else if (owned) {
+            if (!mutex_lock(&state_ptr->allocation_mutex)) {
+                MFATAL("Unable to obtain mutex lock for free operation! Heap corruption is likely!");
+                return;
+            }
+            result = dynamic_allocator_free_aligned(&state_ptr->allocator, block);
+            mutex_unlock(&state_ptr->allocation_mutex);
+        }
 #else
         maligned_free(block);
         b8 result = true;
 #endif
 
-        state_ptr->allocation_count--;
-        state_ptr->total_allocated -= size;
-        state_ptr->tagged_allocations[tag] -= size;
-
-        mutex_unlock(&state_ptr->allocation_mutex);
+        stats_track(tag, size, false);
+#if MEMORY_PROFILER_ENABLED
+        memory_profiler_on_free(block, size, tag);
+#endif
 
         if (!result) {
             // TODO: Alignment
@@ -239,28 +841,63 @@ void memory_free_aligned(void* block, u64 size, u16 alignment, memory_tag tag) {
 }
 
 void memory_free_report(u64 size, memory_tag tag) {
-    if (!mutex_lock(&state_ptr->allocation_mutex)) {
-        MFATAL("Error obtaining mutex lock during free reporting!");
-        return;
+    if (state_ptr) {
+        stats_track(tag, size, false);
     }
+}
 
-    state_ptr->allocation_count--;
-    state_ptr->total_allocated -= size;
-    state_ptr->tagged_allocations[tag] -= size;
+void* memory_copy_large(void* dst, const void* src, u64 size) {
+    if (size < streaming_threshold) {
+        return memcpy(dst, src, size);
+    }
+    if (!streaming_kernel) {
+        streaming_kernel_select();
+    }
+    streaming_kernel->copy((u8*)dst, (const u8*)src, size);
+    return dst;
+}
 
-    mutex_unlock(&state_ptr->allocation_mutex);
+void* memory_set_large(void* block, i32 value, u64 size) {
+    if (size < streaming_threshold) {
+        return memset(block, value, size);
+    }
+    if (!streaming_kernel) {
+        streaming_kernel_select();
+    }
+    streaming_kernel->set((u8*)block, (u8)value, size);
+    return block;
+}
+
+void* memory_move(void* dst, const void* src, u64 size) {
+    return memmove(dst, src, size);
+}
+
+i32 memory_compare(const void* a, const void* b, u64 size) {
+    return memcmp(a, b, size);
 }
 
-void* memory_zero(void* block, u64 size) {
-    return memset(block, 0, size);
+void memory_set_streaming_threshold(u64 size) {
+    // Below a few cache lines the alignment prologue would dominate
+    streaming_threshold = MMAX(size, (u64)KIBIBYTES(4));
 }
 
-void* memory_copy(void* dst, const void* src, u64 size) {
-    return memcpy(dst, src, size);
+u64 memory_get_streaming_threshold(void) {
+    return streaming_threshold;
 }
 
-void* memory_set(void* block, i32 value, u64 size) {
-    return memset(block, value, size);
+const char* memory_get_streaming_kernel_name(void) {
+    if (!streaming_kernel) {
+        streaming_kernel_select();
+    }
+    return streaming_kernel->name;
+}
+
+memory_page_mode memory_get_page_mode(void) {
+    return state_ptr ? state_ptr->page_mode : MEMORY_PAGE_MODE_DEFAULT;
+}
+
+const char* memory_get_tag_name(memory_tag tag) {
+    return tag < MEMORY_TAG_MAX_TAGS ? memory_tag_strings[tag] : "INVALID     ";
 }
 
 static const char* get_unit_for_size(u64 size_bytes, f32* out_amount) {
@@ -279,19 +916,137 @@ static const char* get_unit_for_size(u64 size_bytes, f32* out_amount) {
     }
 }
 
+b8 memory_get_stats(memory_stats* out_stats) {
+    if (!state_ptr || !out_stats) {
+        return false;
+    }
+
+    i64 allocated[MEMORY_TAG_MAX_TAGS];
+    i64 counts[MEMORY_TAG_MAX_TAGS];
+    u64 total_counts[MEMORY_TAG_MAX_TAGS];
+    for (u32 i = 0; i < MEMORY_TAG_MAX_TAGS; ++i) {
+        allocated[i] = (i64)atomic_u64_load(&state_ptr->tagged_allocations[i]);
+        counts[i] = (i64)atomic_u64_load(&state_ptr->tagged_counts[i]);
+        total_counts[i] = atomic_u64_load(&state_ptr->retired_total_counts[i]);
+    }
+
+    memory_stats_shard* shard = atomic_ptr_load((void* volatile*)&stats_shards);
+    while (shard) {
+        for (u32 i = 0; i < MEMORY_TAG_MAX_TAGS; ++i) {
+            allocated[i] += (i64)atomic_u64_load(&shard->pending_bytes[i]);
+            counts[i] += (i64)atomic_u64_load(&shard->pending_counts[i]);
+            total_counts[i] += atomic_u64_load(&shard->total_counts[i]);
+        }
+        shard = shard->next;
+    }
+
+    out_stats->total_allocated = 0;
+    out_stats->allocation_count = 0;
+    for (u32 i = 0; i < MEMORY_TAG_MAX_TAGS; ++i) {
+        // Folds racing with this read can briefly make a tag look negative
+        memory_tag_stats* tag = &out_stats->tags[i];
+        tag->allocated = allocated[i] > 0 ? (u64)allocated[i] : 0;
+        tag->allocation_count = counts[i] > 0 ? (u64)counts[i] : 0;
+        tag->total_allocation_count = total_counts[i];
+        u64 peak = atomic_u64_load(&state_ptr->tagged_peaks[i]);
+        tag->peak_allocated = MMAX(peak, tag->allocated);
+
+        out_stats->total_allocated += tag->allocated;
+        out_stats->allocation_count += tag->allocation_count;
+    }
+
+    return true;
+}
+
+b8 memory_get_fragmentation(freelist_fragmentation* out_fragmentation) {
+#if USE_CUSTOM_MEMORY_ALLOCATOR
+    if (!state_ptr || !out_fragmentation || !mutex_lock(&state_ptr->allocation_mutex)) {
+        return false;
+    }
+    b8 result = dynamic_allocator_get_fragmentation(&state_ptr->allocator, out_fragmentation);
+    mutex_unlock(&state_ptr->allocation_mutex);
+    return result;
+#else
+    return false;
+#endif
+}
+
+void memory_log_fragmentation(void) {
+    freelist_fragmentation fragmentation;
+    if (!memory_get_fragmentation(&fragmentation)) {
+        MWARN("memory_log_fragmentation - Heap fragmentation is unavailable.");
+        return;
+    }
+
+    f32 free_amount = 1.0f;
+    const char* free_unit = get_unit_for_size(fragmentation.free_space, &free_amount);
+    f32 largest_amount = 1.0f;
+    const char* largest_unit = get_unit_for_size(fragmentation.largest_free_range, &largest_amount);
+
+    char buffer[2048];
+    u64 offset = snprintf(buffer, sizeof(buffer), "Heap fragmentation: %.1f%%, %.2f%s free in %llu ranges, largest %.2f%s. Free ranges by size:",
+        fragmentation.external_fragmentation * 100.0f, free_amount, free_unit, fragmentation.free_range_count, largest_amount, largest_unit);
+    for (u32 i = 0; i < FREELIST_SIZE_CLASS_COUNT && offset < sizeof(buffer); ++i) {
+        if (fragmentation.range_histogram[i]) {
+            f32 amount = 1.0f;
+            const char* unit = get_unit_for_size((u64)1 << i, &amount);
+            offset += snprintf(buffer + offset, sizeof(buffer) - offset, " %.0f%s+: %llu", amount, unit, fragmentation.range_histogram[i]);
+        }
+    }
+    MINFO("%s", buffer);
+}
+
 char* memory_get_usage_str() {
-    char buffer[1024] = "System memory usage (tagged):\n";
+    memory_stats stats;
+    if (!memory_get_stats(&stats)) {
+        return cstr_duplicate("System memory usage (tagged): unavailable\n");
+    }
+
+    char buffer[2048] = "System memory usage (tagged):\n";
     u64 offset = strlen(buffer);
 
     for (u32 i = 0; i < MEMORY_TAG_MAX_TAGS; ++i) {
         f32 amount = 1.0f;
-        const char* unit = get_unit_for_size(state_ptr->tagged_allocations[i], &amount);
-        
-        i32 length = snprintf(buffer + offset, 1024, "  %s: %.2f%s\n", memory_tag_strings[i], amount, unit);
-        offset += length;
+        const char* unit = get_unit_for_size(stats.tags[i].allocated, &amount);
+        f32 peak_amount = 1.0f;
+        const char* peak_unit = get_unit_for_size(stats.tags[i].peak_allocated, &peak_amount);
+
+        offset += snprintf(buffer + offset, sizeof(buffer) - offset, "  %s: %.2f%s (peak %.2f%s, %llu live)\n",
+            memory_tag_strings[i], amount, unit, peak_amount, peak_unit, stats.tags[i].allocation_count);
+    }
+
+    offset += snprintf(buffer + offset, sizeof(buffer) - offset, "  Total allocated: %llu\n  Allocations count: %llu\n", stats.total_allocated, stats.allocation_count);
+
+#if USE_CUSTOM_MEMORY_ALLOCATOR
+    f32 committed_amount = 1.0f;
+    const char* committed_unit = get_unit_for_size(dynamic_allocator_committed_space(&state_ptr->allocator), &committed_amount);
+    f32 reserved_amount = 1.0f;
+    const char* reserved_unit = get_unit_for_size(dynamic_allocator_total_space(&state_ptr->allocator), &reserved_amount);
+    offset += snprintf(buffer + offset, sizeof(buffer) - offset, "  Heap committed: %.2f%s / %.2f%s reserved\n", committed_amount, committed_unit, reserved_amount, reserved_unit);
+
+    freelist_fragmentation fragmentation;
+    if (memory_get_fragmentation(&fragmentation)) {
+        f32 largest_amount = 1.0f;
+        const char* largest_unit = get_unit_for_size(fragmentation.largest_free_range, &largest_amount);
+        offset += snprintf(buffer + offset, sizeof(buffer) - offset, "  Heap fragmentation: %.1f%% (%llu free ranges, largest %.2f%s)\n",
+            fragmentation.external_fragmentation * 100.0f, fragmentation.free_range_count, largest_amount, largest_unit);
     }
+#endif
 
-    snprintf(buffer + offset, 1024, "  Total allocated: %llu\n  Allocations count: %llu\n", state_ptr->total_allocated, state_ptr->allocation_count);
+    static const char* page_mode_strings[] = {"regular", "transparent huge", "huge"};
+    snprintf(buffer + offset, sizeof(buffer) - offset, "  Heap pages: %s\n", page_mode_strings[state_ptr->page_mode]);
+
+#if MEMORY_PROFILER_ENABLED
+    offset = strlen(buffer);
+    memory_profiler_site sites[5];
+    u32 site_count = memory_profiler_get_top_sites(5, sites);
+    for (u32 i = 0; i < site_count && offset < sizeof(buffer); ++i) {
+        f32 amount = 1.0f;
+        const char* unit = get_unit_for_size(sites[i].live_bytes, &amount);
+        offset += snprintf(buffer + offset, sizeof(buffer) - offset, "  Top site %p %s: %.2f%s in %llu live\n",
+            sites[i].call_site, memory_tag_strings[sites[i].tag], amount, unit, sites[i].live_count);
+    }
+#endif
 
     char* out_str = cstr_duplicate(buffer);
     return out_str;
@@ -1,11 +1,15 @@
 #pragma once
 
 #include "defines.h"
+#include "containers/freelist.h"
 
+// Allocator interface used by containers instead of the global heap.
+// context is passed back to every callback, so one set of callbacks can serve many allocators
 typedef struct frame_allocator_int {
-    void* (*allocate)(u64 size);
-    void (*free)(void* block, u64 size);
-    void (*free_all)(void);
+    void* (*allocate)(void* context, u64 size);
+    void (*free)(void* context, void* block, u64 size);
+    void (*free_all)(void* context);
+    void* context;
 } frame_allocator_int;
 
 typedef enum memory_tag {
@@ -16,9 +20,11 @@ typedef enum memory_tag {
     MEMORY_TAG_RING_QUEUE,
     MEMORY_TAG_STACK,
     MEMORY_TAG_BST,
+    MEMORY_TAG_HASHTABLE,
     MEMORY_TAG_STRING,
 
     MEMORY_TAG_LINEAR_ALLOCATOR,
+    MEMORY_TAG_POOL_ALLOCATOR,
 
     MEMORY_TAG_ENGINE,
     MEMORY_TAG_PLATFORM,
@@ -32,8 +38,44 @@ typedef enum memory_tag {
     MEMORY_TAG_MAX_TAGS
 } memory_tag;
 
-b8 memory_system_initialize();
-void memory_system_shutdown();
+typedef enum memory_page_mode {
+    // Regular pages of platform_memory_page_size bytes
+    MEMORY_PAGE_MODE_DEFAULT,
+    // Transparent huge pages. The heap is committed in huge page sized chunks, which the OS
+    // backs with a single huge page each when it has one available
+    MEMORY_PAGE_MODE_TRANSPARENT_HUGE,
+    // Huge pages from the OS pool (MAP_HUGETLB, MEM_LARGE_PAGES). The whole heap is committed at startup
+    MEMORY_PAGE_MODE_HUGE
+} memory_page_mode;
+
+typedef struct memory_system_config {
+    // The total memory size in bytes used by the internal allocator for this system.
+    // Only address space is reserved up front, pages are committed as allocations need them
+    u64 total_alloc_size;
+    // Pages backing the heap. When the requested mode is unavailable the next smaller one is used,
+    // memory_get_page_mode reports the mode in effect
+    memory_page_mode page_mode;
+} memory_system_config;
+
+typedef struct memory_tag_stats {
+    // Bytes currently allocated for the tag
+    u64 allocated;
+    // Highest amount of bytes allocated at once for the tag
+    u64 peak_allocated;
+    // Number of allocations currently alive for the tag
+    u64 allocation_count;
+    // Number of allocations ever made for the tag
+    u64 total_allocation_count;
+} memory_tag_stats;
+
+typedef struct memory_stats {
+    u64 total_allocated;
+    u64 allocation_count;
+    memory_tag_stats tags[MEMORY_TAG_MAX_TAGS];
+} memory_stats;
+
+MAPI b8 memory_system_initialize(memory_system_config config);
+MAPI void memory_system_shutdown();
 
 // Performs a memory allocation from the host of the given size.
 // The allocation is tracked for the provided tag
@@ -44,6 +86,14 @@ MAPI void* memory_allocate(u64 size, memory_tag tag);
 // NOTE: Memory allocated this way must be freed using memory_free_aligned
 MAPI void* memory_allocate_aligned(u64 size, u16 alignment, memory_tag tag);
 
+// Same as memory_allocate, but the contents of the block are undefined.
+// Use it for blocks that are entirely written right away
+MAPI void* memory_allocate_uninitialized(u64 size, memory_tag tag);
+
+// Same as memory_allocate_aligned, but the contents of the block are undefined.
+// NOTE: Memory allocated this way must be freed using memory_free_aligned
+MAPI void* memory_allocate_aligned_uninitialized(u64 size, u16 alignment, memory_tag tag);
+
 // Reports an allocation associated with the application, but made externally.
 // This can be done for items allocated within 3rd party libraries, for example,
 // to track allocations but not perform them
@@ -58,6 +108,9 @@ MAPI void* memory_reallocate(void* block, u64 old_size, u64 new_size, memory_tag
 // NOTE: Memory allocated this way must be freed using memory_free_aligned
 MAPI void* memory_reallocate_aligned(void* block, u64 old_size, u64 new_size, u16 alignment, memory_tag tag);
 
+// Same as memory_reallocate, but any memory past old_size is left uninitialized
+MAPI void* memory_reallocate_uninitialized(void* block, u64 old_size, u64 new_size, memory_tag tag);
+
 // Reports a reallocation associated with the application, but made externally.
 // This can be done for items allocated within 3rd party libraries, for example,
 // to track reallocations but not perform them
@@ -74,10 +127,120 @@ MAPI void memory_free_aligned(void* block, u64 size, u16 alignment, memory_tag t
 // to track frees but not perform them
 MAPI void memory_free_report(u64 size, memory_tag tag);
 
-MAPI void* memory_zero(void* block, u64 size);
-
-MAPI void* memory_copy(void* dst, const void* src, u64 size);
-
-MAPI void* memory_set(void* block, i32 value, u64 size);
-
-MAPI char* memory_get_usage_str();
\ No newline at end of file
+// Returns every block held in the calling thread's small allocation cache to the global allocator, and
+// folds its statistics so its stats shard can go to another thread. Threads started with thread_create call
+// this when their function returns
+MAPI void memory_thread_cache_flush(void);
+
+// Blocks up to this size are copied, zeroed or set inline at the call site
+#define MEMORY_INLINE_OPERATION_SIZE 32
+// Blocks from this size on are written with non-temporal stores unless changed with memory_set_streaming_threshold
+#define MEMORY_DEFAULT_STREAMING_THRESHOLD MEBIBYTES(4)
+
+// Out of line paths of memory_copy and memory_set for blocks larger than MEMORY_INLINE_OPERATION_SIZE.
+// Blocks at or above the streaming threshold bypass the cache, using the widest kernel the CPU supports
+MAPI void* memory_copy_large(void* dst, const void* src, u64 size);
+MAPI void* memory_set_large(void* block, i32 value, u64 size);
+
+// Copies size bytes between ranges that may overlap, such as when shifting elements within an array
+MAPI void* memory_move(void* dst, const void* src, u64 size);
+
+// Compares size bytes, returning zero when they are equal and otherwise the sign of the first difference
+MAPI i32 memory_compare(const void* a, const void* b, u64 size);
+
+// Sets the size from which memory_copy, memory_zero and memory_set bypass the cache. Pass U64_MAX to never stream
+MAPI void memory_set_streaming_threshold(u64 size);
+MAPI u64 memory_get_streaming_threshold(void);
+
+// Gets the name of the streaming kernel selected for this CPU ("avx2", "sse2" or "none")
+MAPI const char* memory_get_streaming_kernel_name(void);
+
+#if defined(__clang__) || defined(__gcc__)
+#   define MEMORY_FIXED_COPY(dst, src, size) __builtin_memcpy(dst, src, size)
+#else
+#   include <string.h>
+#   define MEMORY_FIXED_COPY(dst, src, size) memcpy(dst, src, size)
+#endif
+
+// Small blocks are moved as two possibly overlapping words of the largest size that fits,
+// so every size up to MEMORY_INLINE_OPERATION_SIZE takes a handful of loads and stores.
+// The ranges must not overlap, use memory_move for that
+MINLINE void* memory_copy(void* dst, const void* src, u64 size) {
+    if (size > MEMORY_INLINE_OPERATION_SIZE) {
+        return memory_copy_large(dst, src, size);
+    }
+    u8* d = (u8*)dst;
+    const u8* s = (const u8*)src;
+    if (size >= 16) {
+        u64 head[2], tail[2];
+        MEMORY_FIXED_COPY(head, s, 16);
+        MEMORY_FIXED_COPY(tail, s + size - 16, 16);
+        MEMORY_FIXED_COPY(d, head, 16);
+        MEMORY_FIXED_COPY(d + size - 16, tail, 16);
+    } else if (size >= 8) {
+        u64 head, tail;
+        MEMORY_FIXED_COPY(&head, s, 8);
+        MEMORY_FIXED_COPY(&tail, s + size - 8, 8);
+        MEMORY_FIXED_COPY(d, &head, 8);
+        MEMORY_FIXED_COPY(d + size - 8, &tail, 8);
+    } else if (size >= 4) {
+        u32 head, tail;
+        MEMORY_FIXED_COPY(&head, s, 4);
+        MEMORY_FIXED_COPY(&tail, s + size - 4, 4);
+        MEMORY_FIXED_COPY(d, &head, 4);
+        MEMORY_FIXED_COPY(d + size - 4, &tail, 4);
+    } else if (size) {
+        u8 first = s[0], middle = s[size / 2], last = s[size - 1];
+        d[0] = first;
+        d[size / 2] = middle;
+        d[size - 1] = last;
+    }
+    return dst;
+}
+
+MINLINE void* memory_set(void* block, i32 value, u64 size) {
+    if (size > MEMORY_INLINE_OPERATION_SIZE) {
+        return memory_set_large(block, value, size);
+    }
+    u8* d = (u8*)block;
+    u64 pattern = (u64)(u8)value * 0x0101010101010101ull;
+    if (size >= 16) {
+        MEMORY_FIXED_COPY(d, &pattern, 8);
+        MEMORY_FIXED_COPY(d + 8, &pattern, 8);
+        MEMORY_FIXED_COPY(d + size - 16, &pattern, 8);
+        MEMORY_FIXED_COPY(d + size - 8, &pattern, 8);
+    } else if (size >= 8) {
+        MEMORY_FIXED_COPY(d, &pattern, 8);
+        MEMORY_FIXED_COPY(d + size - 8, &pattern, 8);
+    } else if (size >= 4) {
+        MEMORY_FIXED_COPY(d, &pattern, 4);
+        MEMORY_FIXED_COPY(d + size - 4, &pattern, 4);
+    } else if (size) {
+        d[0] = (u8)value;
+        d[size / 2] = (u8)value;
+        d[size - 1] = (u8)value;
+    }
+    return block;
+}
+
+MINLINE void* memory_zero(void* block, u64 size) {
+    return memory_set(block, 0, size);
+}
+
+// Gathers the statistics of every tag across all threads. Values are a snapshot and may
+// be slightly behind allocations made concurrently on other threads
+MAPI b8 memory_get_stats(memory_stats* out_stats);
+
+MAPI char* memory_get_usage_str();
+
+// Gets how the free space of the heap is split up. Blocks held in thread caches count as allocated
+MAPI b8 memory_get_fragmentation(freelist_fragmentation* out_fragmentation);
+
+// Logs the heap fragmentation and a histogram of the free range sizes
+MAPI void memory_log_fragmentation(void);
+
+// Gets the kind of pages backing the heap
+MAPI memory_page_mode memory_get_page_mode(void);
+
+// Gets the display name of the tag, padded to a fixed width
+MAPI const char* memory_get_tag_name(memory_tag tag);
\ No newline at end of file
@@ -0,0 +1,446 @@
+#include "memory_profiler.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+
+#include "platform/platform.h"
+#include "threads/mutex.h"
+
+#if MEMORY_PROFILER_ENABLED
+
+#define SITE_TABLE_CAPACITY (MEMORY_PROFILER_MAX_SITES * 2)
+#define LIVE_TABLE_CAPACITY (MEMORY_PROFILER_MAX_LIVE_ALLOCATIONS * 2)
+
+// Number of sites written by memory_profiler_export_json
+#define EXPORT_SITE_COUNT 64
+
+typedef struct live_allocation {
+    void* block;
+    u64 size;
+    u32 site_index;
+} live_allocation;
+
+typedef struct trace_sample {
+    f64 time;
+    u64 live_bytes[MEMORY_TAG_MAX_TAGS];
+} trace_sample;
+
+// Every table lives in a single range obtained from the platform, so the profiler never
+// allocates through the memory system it observes
+typedef struct memory_profiler_state {
+    mutex profiler_mutex;
+    f64 start_time;
+
+    memory_profiler_tag tags[MEMORY_TAG_MAX_TAGS];
+    u64 size_histogram[MEMORY_PROFILER_HISTOGRAM_BUCKETS];
+    u64 live_size_histogram[MEMORY_PROFILER_HISTOGRAM_BUCKETS];
+    u64 untracked_count;
+
+    // Open addressing on the call site and tag. Slots with a zero total_count are empty
+    u32 site_count;
+    memory_profiler_site* sites;
+    // Open addressing on the block address with linear probing. Slots with a nullptr block are empty
+    u64 live_count;
+    live_allocation* live;
+
+    u32 sample_count;
+    u32 next_sample;
+    trace_sample* samples;
+
+    u64 memory_size;
+} memory_profiler_state;
+
+static memory_profiler_state* state_ptr;
+
+MINLINE u64 hash_pointer(const void* pointer) {
+    u64 x = (u64)pointer;
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    return x;
+}
+
+static u32 size_bucket(u64 size) {
+    u32 bucket = 0;
+    while (size > 1 && bucket < MEMORY_PROFILER_HISTOGRAM_BUCKETS - 1) {
+        size >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+// Gets the index of the site for the given call site and tag, adding it if needed. INVALID_ID when full
+static u32 site_get(void* call_site, memory_tag tag) {
+    u64 index = (hash_pointer(call_site) ^ ((u64)tag * 0x9e3779b97f4a7c15ULL)) & (SITE_TABLE_CAPACITY - 1);
+    for (;;) {
+        memory_profiler_site* site = &state_ptr->sites[index];
+        if (site->total_count == 0) {
+            if (state_ptr->site_count >= MEMORY_PROFILER_MAX_SITES) {
+                return INVALID_ID;
+            }
+            site->call_site = call_site;
+            site->tag = tag;
+            state_ptr->site_count++;
+            return (u32)index;
+        }
+        if (site->call_site == call_site && site->tag == tag) {
+            return (u32)index;
+        }
+        index = (index + 1) & (SITE_TABLE_CAPACITY - 1);
+    }
+}
+
+static b8 live_insert(void* block, u64 size, u32 site_index) {
+    if (state_ptr->live_count >= MEMORY_PROFILER_MAX_LIVE_ALLOCATIONS) {
+        return false;
+    }
+
+    u64 index = hash_pointer(block) & (LIVE_TABLE_CAPACITY - 1);
+    while (state_ptr->live[index].block) {
+        index = (index + 1) & (LIVE_TABLE_CAPACITY - 1);
+    }
+    state_ptr->live[index].block = block;
+    state_ptr->live[index].size = size;
+    state_ptr->live[index].site_index = site_index;
+    state_ptr->live_count++;
+    return true;
+}
+
+// Removes the entry of the given block, shifting later entries of its probe run back so no tombstones are needed
+static b8 live_remove(void* block, live_allocation* out_entry) {
+    const u64 mask = LIVE_TABLE_CAPACITY - 1;
+    u64 index = hash_pointer(block) & mask;
+    while (state_ptr->live[index].block != block) {
+        if (!state_ptr->live[index].block) {
+            return false;
+        }
+        index = (index + 1) & mask;
+    }
+    *out_entry = state_ptr->live[index];
+
+    u64 hole = index;
+    u64 next = (hole + 1) & mask;
+    while (state_ptr->live[next].block) {
+        u64 home = hash_pointer(state_ptr->live[next].block) & mask;
+        // Move the entry into the hole unless its home lies cyclically within (hole, next]
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            state_ptr->live[hole] = state_ptr->live[next];
+            hole = next;
+        }
+        next = (next + 1) & mask;
+    }
+    state_ptr->live[hole].block = nullptr;
+    state_ptr->live_count--;
+    return true;
+}
+
+b8 memory_profiler_initialize(void) {
+    u64 site_size = sizeof(memory_profiler_site) * SITE_TABLE_CAPACITY;
+    u64 live_size = sizeof(live_allocation) * LIVE_TABLE_CAPACITY;
+    u64 sample_size = sizeof(trace_sample) * MEMORY_PROFILER_MAX_TRACE_SAMPLES;
+    u64 total_size = get_aligned(sizeof(memory_profiler_state) + site_size + live_size + sample_size, platform_memory_page_size());
+
+    // Freshly committed pages are zeroed, which leaves every table empty
+    void* block = platform_memory_reserve(total_size);
+    if (!block || !platform_memory_commit(block, total_size)) {
+        if (block) {
+            platform_memory_release(block, total_size);
+        }
+        MERROR("memory_profiler_initialize - Unable to obtain %llu bytes for the profiler tables!", total_size);
+        return false;
+    }
+
+    memory_profiler_state* state = block;
+    state->memory_size = total_size;
+    state->sites = (memory_profiler_site*)((u8*)block + sizeof(memory_profiler_state));
+    state->live = (live_allocation*)((u8*)state->sites + site_size);
+    state->samples = (trace_sample*)((u8*)state->live + live_size);
+    state->start_time = platform_get_absolute_time();
+    if (!mutex_create(&state->profiler_mutex)) {
+        platform_memory_release(block, total_size);
+        return false;
+    }
+
+    state_ptr = state;
+    return true;
+}
+
+void memory_profiler_shutdown(void) {
+    if (state_ptr) {
+        memory_profiler_state* state = state_ptr;
+        state_ptr = nullptr;
+        mutex_destroy(&state->profiler_mutex);
+        platform_memory_release(state, state->memory_size);
+    }
+}
+
+void memory_profiler_on_allocate(void* block, u64 size, memory_tag tag, void* call_site) {
+    if (!state_ptr || !block) {
+        return;
+    }
+
+    mutex_lock(&state_ptr->profiler_mutex);
+
+    memory_profiler_tag* tag_stats = &state_ptr->tags[tag];
+    tag_stats->live_bytes += size;
+    tag_stats->live_count++;
+    tag_stats->peak_bytes = MMAX(tag_stats->peak_bytes, tag_stats->live_bytes);
+    tag_stats->peak_count = MMAX(tag_stats->peak_count, tag_stats->live_count);
+
+    u32 bucket = size_bucket(size);
+    state_ptr->size_histogram[bucket]++;
+    state_ptr->live_size_histogram[bucket]++;
+
+    u32 site_index = site_get(call_site, tag);
+    if (site_index != INVALID_ID && live_insert(block, size, site_index)) {
+        memory_profiler_site* site = &state_ptr->sites[site_index];
+        site->live_bytes += size;
+        site->live_count++;
+        site->peak_bytes = MMAX(site->peak_bytes, site->live_bytes);
+        site->total_bytes += size;
+        site->total_count++;
+    } else {
+        state_ptr->untracked_count++;
+    }
+
+    mutex_unlock(&state_ptr->profiler_mutex);
+}
+
+void memory_profiler_on_free(void* block, u64 size, memory_tag tag) {
+    if (!state_ptr || !block) {
+        return;
+    }
+
+    mutex_lock(&state_ptr->profiler_mutex);
+
+    // Blocks allocated before the profiler started are not counted, so never go below zero
+    memory_profiler_tag* tag_stats = &state_ptr->tags[tag];
+    tag_stats->live_bytes -= MMIN(tag_stats->live_bytes, size);
+    tag_stats->live_count -= MMIN(tag_stats->live_count, 1);
+
+    u32 bucket = size_bucket(size);
+    state_ptr->live_size_histogram[bucket] -= MMIN(state_ptr->live_size_histogram[bucket], 1);
+
+    live_allocation entry;
+    if (live_remove(block, &entry)) {
+        memory_profiler_site* site = &state_ptr->sites[entry.site_index];
+        site->live_bytes -= entry.size;
+        site->live_count--;
+    }
+
+    mutex_unlock(&state_ptr->profiler_mutex);
+}
+
+b8 memory_profiler_get_snapshot(memory_profiler_snapshot* out_snapshot) {
+    if (!state_ptr || !out_snapshot) {
+        return false;
+    }
+
+    mutex_lock(&state_ptr->profiler_mutex);
+    memory_copy(out_snapshot->tags, state_ptr->tags, sizeof(state_ptr->tags));
+    memory_copy(out_snapshot->size_histogram, state_ptr->size_histogram, sizeof(state_ptr->size_histogram));
+    memory_copy(out_snapshot->live_size_histogram, state_ptr->live_size_histogram, sizeof(state_ptr->live_size_histogram));
+    out_snapshot->site_count = state_ptr->site_count;
+    out_snapshot->untracked_count = state_ptr->untracked_count;
+    mutex_unlock(&state_ptr->profiler_mutex);
+    return true;
+}
+
+u32 memory_profiler_get_top_sites(u32 max_sites, memory_profiler_site* out_sites) {
+    if (!state_ptr || !out_sites || max_sites == 0) {
+        return 0;
+    }
+
+    mutex_lock(&state_ptr->profiler_mutex);
+    // Insertion into the short sorted output keeps this allocation free
+    u32 count = 0;
+    for (u32 i = 0; i < SITE_TABLE_CAPACITY; ++i) {
+        const memory_profiler_site* site = &state_ptr->sites[i];
+        if (site->total_count == 0) {
+            continue;
+        }
+        if (count == max_sites && site->live_bytes <= out_sites[count - 1].live_bytes) {
+            continue;
+        }
+
+        u32 position = count < max_sites ? count++ : count - 1;
+        while (position > 0 && out_sites[position - 1].live_bytes < site->live_bytes) {
+            out_sites[position] = out_sites[position - 1];
+            position--;
+        }
+        out_sites[position] = *site;
+    }
+    mutex_unlock(&state_ptr->profiler_mutex);
+    return count;
+}
+
+void memory_profiler_sample(void) {
+    if (!state_ptr) {
+        return;
+    }
+
+    mutex_lock(&state_ptr->profiler_mutex);
+    trace_sample* sample = &state_ptr->samples[state_ptr->next_sample];
+    sample->time = platform_get_absolute_time() - state_ptr->start_time;
+    for (u32 i = 0; i < MEMORY_TAG_MAX_TAGS; ++i) {
+        sample->live_bytes[i] = state_ptr->tags[i].live_bytes;
+    }
+    state_ptr->next_sample = (state_ptr->next_sample + 1) % MEMORY_PROFILER_MAX_TRACE_SAMPLES;
+    state_ptr->sample_count = MMIN(state_ptr->sample_count + 1, MEMORY_PROFILER_MAX_TRACE_SAMPLES);
+    mutex_unlock(&state_ptr->profiler_mutex);
+}
+
+typedef struct export_writer {
+    char* buffer;
+    u64 size;
+    u64 length;
+} export_writer;
+
+static void writer_append(export_writer* writer, const char* format, ...) {
+    char* destination = nullptr;
+    u64 remaining = 0;
+    if (writer->buffer && writer->length < writer->size) {
+        destination = writer->buffer + writer->length;
+        remaining = writer->size - writer->length;
+    }
+
+    va_list args;
+    va_start(args, format);
+    i32 written = vsnprintf(destination, remaining, format, args);
+    va_end(args);
+    if (written > 0) {
+        writer->length += (u64)written;
+    }
+}
+
+// Tag names are padded for the usage report, exports drop the padding
+static void writer_append_tag_name(export_writer* writer, memory_tag tag) {
+    const char* name = memory_get_tag_name(tag);
+    i32 length = 0;
+    for (i32 i = 0; name[i]; ++i) {
+        if (name[i] != ' ') {
+            length = i + 1;
+        }
+    }
+    writer_append(writer, "\"%.*s\"", length, name);
+}
+
+u64 memory_profiler_export_json(char* buffer, u64 buffer_size) {
+    if (buffer && buffer_size) {
+        buffer[0] = '\0';
+    }
+    if (!state_ptr) {
+        return 0;
+    }
+
+    memory_profiler_snapshot snapshot;
+    memory_profiler_get_snapshot(&snapshot);
+    memory_profiler_site sites[EXPORT_SITE_COUNT];
+    u32 site_count = memory_profiler_get_top_sites(EXPORT_SITE_COUNT, sites);
+
+    export_writer writer = {buffer, buffer_size, 0};
+    writer_append(&writer, "{\n  \"time\": %.6f,\n  \"untracked_count\": %llu,\n  \"tags\": [", platform_get_absolute_time() - state_ptr->start_time, snapshot.untracked_count);
+    for (u32 i = 0; i < MEMORY_TAG_MAX_TAGS; ++i) {
+        const memory_profiler_tag* tag = &snapshot.tags[i];
+        writer_append(&writer, "%s\n    {\"name\": ", i ? "," : "");
+        writer_append_tag_name(&writer, i);
+        writer_append(&writer, ", \"live_bytes\": %llu, \"live_count\": %llu, \"peak_bytes\": %llu, \"peak_count\": %llu}",
+            tag->live_bytes, tag->live_count, tag->peak_bytes, tag->peak_count);
+    }
+
+    writer_append(&writer, "\n  ],\n  \"size_histogram\": [");
+    b8 first_bucket = true;
+    for (u32 i = 0; i < MEMORY_PROFILER_HISTOGRAM_BUCKETS; ++i) {
+        if (snapshot.size_histogram[i]) {
+            writer_append(&writer, "%s\n    {\"min_size\": %llu, \"total_count\": %llu, \"live_count\": %llu}",
+                first_bucket ? "" : ",", (u64)1 << i, snapshot.size_histogram[i], snapshot.live_size_histogram[i]);
+            first_bucket = false;
+        }
+    }
+
+    writer_append(&writer, "\n  ],\n  \"sites\": [");
+    for (u32 i = 0; i < site_count; ++i) {
+        const memory_profiler_site* site = &sites[i];
+        writer_append(&writer, "%s\n    {\"address\": \"%p\", \"tag\": ", i ? "," : "", site->call_site);
+        writer_append_tag_name(&writer, site->tag);
+        writer_append(&writer, ", \"live_bytes\": %llu, \"live_count\": %llu, \"peak_bytes\": %llu, \"total_bytes\": %llu, \"total_count\": %llu}",
+            site->live_bytes, site->live_count, site->peak_bytes, site->total_bytes, site->total_count);
+    }
+    writer_append(&writer, "\n  ]\n}\n");
+
+    return writer.length;
+}
+
+u64 memory_profiler_export_chrome_trace(char* buffer, u64 buffer_size) {
+    if (buffer && buffer_size) {
+        buffer[0] = '\0';
+    }
+    if (!state_ptr) {
+        return 0;
+    }
+
+    export_writer writer = {buffer, buffer_size, 0};
+    writer_append(&writer, "{\"traceEvents\": [");
+
+    mutex_lock(&state_ptr->profiler_mutex);
+    u32 first = (state_ptr->next_sample + MEMORY_PROFILER_MAX_TRACE_SAMPLES - state_ptr->sample_count) % MEMORY_PROFILER_MAX_TRACE_SAMPLES;
+    for (u32 i = 0; i < state_ptr->sample_count; ++i) {
+        const trace_sample* sample = &state_ptr->samples[(first + i) % MEMORY_PROFILER_MAX_TRACE_SAMPLES];
+        // Counter events take their timestamp in microseconds
+        writer_append(&writer, "%s\n  {\"name\": \"memory\", \"ph\": \"C\", \"pid\": 0, \"tid\": 0, \"ts\": %.0f, \"args\": {",
+            i ? "," : "", sample->time * 1000000.0);
+        for (u32 tag = 0; tag < MEMORY_TAG_MAX_TAGS; ++tag) {
+            writer_append(&writer, "%s", tag ? ", " : "");
+            writer_append_tag_name(&writer, tag);
+            writer_append(&writer, ": %llu", sample->live_bytes[tag]);
+        }
+        writer_append(&writer, "}}");
+    }
+    mutex_unlock(&state_ptr->profiler_mutex);
+
+    writer_append(&writer, "\n]}\n");
+    return writer.length;
+}
+
+#else
+
+// Compiled out: the memory system never calls the hooks, and queries report nothing
+b8 memory_profiler_initialize(void) {
+    return true;
+}
+
+void memory_profiler_shutdown(void) {
+}
+
+void memory_profiler_on_allocate(void* block, u64 size, memory_tag tag, void* call_site) {
+}
+
+void memory_profiler_on_free(void* block, u64 size, memory_tag tag) {
+}
+
+b8 memory_profiler_get_snapshot(memory_profiler_snapshot* out_snapshot) {
+    return false;
+}
+
+u32 memory_profiler_get_top_sites(u32 max_sites, memory_profiler_site* out_sites) {
+    return 0;
+}
+
+void memory_profiler_sample(void) {
+}
+
+u64 memory_profiler_export_json(char* buffer, u64 buffer_size) {
+    if (buffer && buffer_size) {
+        buffer[0] = '\0';
+    }
+    return 0;
+}
+
+u64 memory_profiler_export_chrome_trace(char* buffer, u64 buffer_size) {
+    if (buffer && buffer_size) {
+        buffer[0] = '\0';
+    }
+    return 0;
+}
+
+#endif
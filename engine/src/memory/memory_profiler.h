@@ -0,0 +1,71 @@
+#pragma once
+
+#include "defines.h"
+#include "memory/memory.h"
+
+// Set to 1 to compile the allocation profiler into the memory system. When 0 the hooks in memory.c
+// compile away entirely, and the functions below only report that the profiler is unavailable
+#ifndef MEMORY_PROFILER_ENABLED
+#define MEMORY_PROFILER_ENABLED 0
+#endif
+
+// Bucket i counts allocations of [2^i, 2^(i+1)) bytes. Bucket 0 also counts empty allocations
+#define MEMORY_PROFILER_HISTOGRAM_BUCKETS 40
+// Distinct call site and tag pairs that can be attributed. Further ones count as untracked
+#define MEMORY_PROFILER_MAX_SITES 4096
+// Live allocations that can be attributed to their call site at once
+#define MEMORY_PROFILER_MAX_LIVE_ALLOCATIONS (1 << 20)
+// Trace samples kept for the Chrome trace export. Older samples are overwritten
+#define MEMORY_PROFILER_MAX_TRACE_SAMPLES 4096
+
+typedef struct memory_profiler_site {
+    // Return address of the memory_allocate call. Resolve it with addr2line or a debugger
+    void* call_site;
+    memory_tag tag;
+    u64 live_bytes;
+    u64 live_count;
+    u64 peak_bytes;
+    u64 total_bytes;
+    u64 total_count;
+} memory_profiler_site;
+
+typedef struct memory_profiler_tag {
+    u64 live_bytes;
+    u64 live_count;
+    // High-water marks, exact rather than batched like memory_get_stats
+    u64 peak_bytes;
+    u64 peak_count;
+} memory_profiler_tag;
+
+typedef struct memory_profiler_snapshot {
+    memory_profiler_tag tags[MEMORY_TAG_MAX_TAGS];
+    // Allocations ever made and allocations currently alive, per size bucket
+    u64 size_histogram[MEMORY_PROFILER_HISTOGRAM_BUCKETS];
+    u64 live_size_histogram[MEMORY_PROFILER_HISTOGRAM_BUCKETS];
+    u32 site_count;
+    // Allocations that could not be attributed to a call site because a table was full
+    u64 untracked_count;
+} memory_profiler_snapshot;
+
+// Called by the memory system
+b8 memory_profiler_initialize(void);
+void memory_profiler_shutdown(void);
+void memory_profiler_on_allocate(void* block, u64 size, memory_tag tag, void* call_site);
+void memory_profiler_on_free(void* block, u64 size, memory_tag tag);
+
+// Returns false when the profiler is compiled out or the memory system is not initialized
+MAPI b8 memory_profiler_get_snapshot(memory_profiler_snapshot* out_snapshot);
+
+// Copies up to max_sites call sites holding the most live bytes, largest first. Returns the number copied
+MAPI u32 memory_profiler_get_top_sites(u32 max_sites, memory_profiler_site* out_sites);
+
+// Records the live bytes of every tag as one Chrome trace counter sample. The engine does this once per frame
+MAPI void memory_profiler_sample(void);
+
+// Writes a snapshot as JSON into buffer, truncating to buffer_size. Returns the length of the whole
+// document without the terminator, so it can be called with a nullptr buffer first to size it
+MAPI u64 memory_profiler_export_json(char* buffer, u64 buffer_size);
+
+// Writes the recorded samples as a Chrome trace (chrome://tracing, Perfetto) of counter events.
+// Sizing works as for memory_profiler_export_json
+MAPI u64 memory_profiler_export_chrome_trace(char* buffer, u64 buffer_size);
@@ -54,4 +54,36 @@ MAPI void platform_console_write(log_level level, const char* msg);
 
 MAPI f64 platform_get_absolute_time();
 
-MAPI void platform_sleep(u64 ms);
\ No newline at end of file
+MAPI void platform_sleep(u64 ms);
+
+// Gets the number of logical processors available to the application
+MAPI u32 platform_get_processor_count(void);
+
+// Reserves a range of virtual address space without committing any physical memory to it.
+// Returns a page-aligned pointer, or nullptr on failure
+MAPI void* platform_memory_reserve(u64 size);
+
+// Commits the given page-aligned range of previously reserved address space, making it readable and writable.
+// Freshly committed pages are always zeroed by the OS
+MAPI b8 platform_memory_commit(void* block, u64 size);
+
+// Returns the physical pages backing the given page-aligned range to the OS. The address range stays reserved
+MAPI void platform_memory_decommit(void* block, u64 size);
+
+// Releases the whole range of address space obtained from platform_memory_reserve
+MAPI void platform_memory_release(void* block, u64 size);
+
+// Gets the size of a virtual memory page in bytes
+MAPI u64 platform_memory_page_size(void);
+
+// Gets the size of a huge page in bytes, or 0 when the platform does not support them
+MAPI u64 platform_memory_huge_page_size(void);
+
+// Reserves and commits a range backed by huge pages from the OS pool (MAP_HUGETLB, MEM_LARGE_PAGES).
+// size must be a multiple of the huge page size. Returns nullptr without logging when the pool cannot
+// cover the whole size or the process lacks the privilege. Release it with platform_memory_release
+MAPI void* platform_memory_allocate_huge(u64 size);
+
+// Asks the OS to back the given reserved range with transparent huge pages as it gets committed.
+// Returns false when the platform does not support it
+MAPI b8 platform_memory_advise_huge(void* block, u64 size);
\ No newline at end of file
@@ -1,3 +1,8 @@
+// Needed for pthread_tryjoin_np/pthread_timedjoin_np
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
 #include "platform.h"
 
 #ifdef PLATFORM_LINUX
@@ -32,6 +37,7 @@
 #include "core/input.h"
 #include "core/event.h"
 #include "memory/memory.h"
+#include "memory/allocators/scratch_allocator.h"
 #include "strings/string.h"
 #include "threads/thread.h"
 #include "threads/mutex.h"
@@ -47,6 +53,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <sys/sendfile.h>
 #include <sys/stat.h>
 #include <sys/sysinfo.h>
@@ -450,152 +457,210 @@ void platform_sleep(u64 ms) {
 #endif
 }
 
+u32 platform_get_processor_count(void) {
+    return (u32)get_nprocs();
+}
+
+// Memory
+
+void* platform_memory_reserve(u64 size) {
+    void* block = mmap(nullptr, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (block == MAP_FAILED) {
+        MERROR("Failed to reserve %llu bytes of address space: %s", size, strerror(errno));
+        return nullptr;
+    }
+    return block;
+}
+
+b8 platform_memory_commit(void* block, u64 size) {
+    if (mprotect(block, size, PROT_READ | PROT_WRITE) != 0) {
+        MERROR("Failed to commit %llu bytes at %p: %s", size, block, strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+void platform_memory_decommit(void* block, u64 size) {
+    // Drop the physical pages first, then make the range inaccessible again
+    madvise(block, size, MADV_DONTNEED);
+    mprotect(block, size, PROT_NONE);
+}
+
+void platform_memory_release(void* block, u64 size) {
+    if (block) {
+        munmap(block, size);
+    }
+}
+
+u64 platform_memory_page_size(void) {
+    return (u64)sysconf(_SC_PAGESIZE);
+}
+
+u64 platform_memory_huge_page_size(void) {
+    static u64 huge_page_size = 0;
+    if (huge_page_size == 0) {
+        // The default huge page size is only published through /proc/meminfo
+        huge_page_size = MEBIBYTES(2);
+        FILE* meminfo = fopen("/proc/meminfo", "r");
+        if (meminfo) {
+            char line[128];
+            unsigned long long size_kib = 0;
+            while (fgets(line, sizeof(line), meminfo)) {
+                if (sscanf(line, "Hugepagesize: %llu kB", &size_kib) == 1) {
+                    huge_page_size = size_kib * KIBIBYTES(1);
+                    break;
+                }
+            }
+            fclose(meminfo);
+        }
+    }
+    return huge_page_size;
+}
+
+void* platform_memory_allocate_huge(u64 size) {
+    // Without MAP_NORESERVE the pages are taken from the pool right away, so a short pool fails
+    // here instead of raising SIGBUS on first touch
+    void* block = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (block == MAP_FAILED) {
+        return nullptr;
+    }
+    return block;
+}
+
+b8 platform_memory_advise_huge(void* block, u64 size) {
+#ifdef MADV_HUGEPAGE
+    return madvise(block, size, MADV_HUGEPAGE) == 0;
+#else
+    return false;
+#endif
+}
+
 // Thread
 
+typedef struct thread_start_info {
+    PFN_thread_start start_func;
+    void* args;
+} thread_start_info;
+
+// Runs the thread function, then hands back what the thread cached in the memory system and its scratch arena before it exits
+static void* thread_start(void* param) {
+    thread_start_info info = *(thread_start_info*)param;
+    free(param);
+
+    u32 result = info.start_func(info.args);
+    scratch_thread_release();
+    memory_thread_cache_flush();
+    return (void*)(u64)result;
+}
 
 b8 thread_create(PFN_thread_start start_func, void* args, b8 auto_detach, thread* out_thread) {
-    // if (!out_thread) {
+    if (!start_func || !out_thread) {
         return false;
-    // }
+    }
 
-    // pthread_attr_t attr;
-    // pthread_attr_init(&attr);
-    // pthread_attr_setdetachstate(&attr, auto_detach ? PTHREAD_CREATE_DETACHED : PTHREAD_CREATE_JOINABLE);
+    thread_start_info* info = malloc(sizeof(thread_start_info));
+    if (!info) {
+        MERROR("Failed to allocate the thread start info.");
+        return false;
+    }
+    info->start_func = start_func;
+    info->args = args;
 
-    // pthread_t thread_id;
-    // int result = pthread_create(&thread_id, &attr, (void*(*)(void*))start_func, args);
-    // if (result != 0) {
-    //     MFATAL("Failed to create thread: %s", strerror(result));
-    //     return false;
-    // }
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, auto_detach ? PTHREAD_CREATE_DETACHED : PTHREAD_CREATE_JOINABLE);
 
-    // out_thread->thread_id = thread_id;
+    pthread_t thread_id;
+    int result = pthread_create(&thread_id, &attr, thread_start, info);
+    pthread_attr_destroy(&attr);
+    if (result != 0) {
+        MERROR("Failed to create thread: %s", strerror(result));
+        free(info);
+        return false;
+    }
 
-    // pthread_attr_destroy(&attr);
+    out_thread->thread_id = (u64)thread_id;
+    // A detached thread cannot be waited on, so don't keep a handle to it
+    out_thread->internal_data = auto_detach ? nullptr : (void*)thread_id;
 
-    // return true;
+    MDEBUG("Starting process on thread id: %#llx", out_thread->thread_id);
+    return true;
 }
 
 void thread_destroy(thread* t) {
-    // if (t) {
-    //     pthread_t thread_id = t->thread_id;
-    //     if (thread_id) {
-    //         pthread_cancel(thread_id);
-    //         pthread_join(thread_id, NULL);
-    //     }
-    // }
+    if (t && t->internal_data) {
+        // Release the handle without waiting, like closing it on Windows
+        pthread_detach((pthread_t)t->internal_data);
+        t->internal_data = nullptr;
+        t->thread_id = 0;
+    }
 }
 
 b8 thread_is_active(thread* t) {
-    // if (!t) {
-    //     return false;
-    // }
-
-    // pthread_t thread_id = t->thread_id;
-    // if (thread_id) {
-    //     int result = pthread_kill(thread_id, 0);
-    //     if (result == 0) {
-    //         return true;
-    //     } else if (result == ESRCH) {
-    //         return false;
-    //     } else {
-    //         MFATAL("Failed to check thread status: %s", strerror(result));
-    //         return false;
-    //     }
-    // }
+    if (t && t->internal_data) {
+        int result = pthread_tryjoin_np((pthread_t)t->internal_data, nullptr);
+        if (result == 0) {
+            // The thread has finished and is now joined, the handle is no longer valid
+            t->internal_data = nullptr;
+        }
+        return result == EBUSY;
+    }
 
     return false;
 }
 
 void thread_detach(thread* t) {
-    // if (!t) {
-    //     return;
-    // }
-
-    // pthread_t thread_id = t->thread_id;
-    // if (thread_id) {
-    //     pthread_detach(thread_id);
-    //     t->thread_id = 0;
-    // }
+    if (t && t->internal_data) {
+        pthread_detach((pthread_t)t->internal_data);
+        t->internal_data = nullptr;
+    }
 }
 
 void thread_cancel(thread* t) {
-    // if (!t) {
-    //     return;
-    // }
-
-    // pthread_t thread_id = t->thread_id;
-    // if (thread_id) {
-    //     pthread_cancel(thread_id);
-    //     t->thread_id = 0;
-    // }
+    if (t && t->internal_data) {
+        pthread_cancel((pthread_t)t->internal_data);
+        t->internal_data = nullptr;
+    }
 }
 
 b8 thread_wait(thread* t) {
-    if (!t) {
-        return false;
+    if (t && t->internal_data) {
+        int result = pthread_join((pthread_t)t->internal_data, nullptr);
+        if (result == 0) {
+            t->internal_data = nullptr;
+            return true;
+        }
+        MERROR("Failed to join thread: %s", strerror(result));
     }
 
-    // pthread_t thread_id = t->thread_id;
-    // if (thread_id) {
-    //     int result = pthread_join(thread_id, NULL);
-    //     if (result != 0) {
-    //         MFATAL("Failed to join thread: %s", strerror(result));
-    //         return false;
-    //     }
-    //     t->thread_id = 0;
-    // }
-
-    return true;
+    return false;
 }
 
-b8 thread_wait_timeout(thread* t,u64 ms) {
-    if (!t) {
-        return false;
-    }
-
-    // pthread_t thread_id = t->thread_id;
-    // if (thread_id) {
-    //     struct timespec ts;
-    //     clock_gettime(CLOCK_REALTIME, &ts);
-    //     ts.tv_sec += ms / 1000;
-    //     ts.tv_nsec += (ms % 1000) * 1000000;
-
-    //     int result = pthread_timedjoin_np(thread_id, NULL, &ts);
+b8 thread_wait_timeout(thread* t, u64 ms) {
+    if (t && t->internal_data) {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_sec += ms / 1000;
+        ts.tv_nsec += (ms % 1000) * 1000000;
+        if (ts.tv_nsec >= 1000000000) {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000;
+        }
 
-    //     if (result != 0) {
-    //         if (result == ETIMEDOUT) {
-    //             return false;
-    //         } else {
-    //             MFATAL("Failed to join thread: %s", strerror(result));
-    //             return false;
-    //         }
-    //     }
-    //     t->thread_id = 0;
-    // }
+        int result = pthread_timedjoin_np((pthread_t)t->internal_data, nullptr, &ts);
+        if (result == 0) {
+            t->internal_data = nullptr;
+            return true;
+        } else if (result != ETIMEDOUT) {
+            MERROR("Failed to join thread: %s", strerror(result));
+        }
+    }
 
-    return true;
+    return false;
 }
 
 void thread_sleep(thread* t, u64 ms) {
-    // if (!t) {
-    //     return;
-    // }
-
-    // pthread_t thread_id = t->thread_id;
-    // if (thread_id) {
-    //     struct timespec ts;
-    //     clock_gettime(CLOCK_REALTIME, &ts);
-    //     ts.tv_sec += ms / 1000;
-    //     ts.tv_nsec += (ms % 1000) * 1000000;
-
-    //     int result = pthread_timedjoin_np(thread_id, NULL, &ts);
-
-    //     if (result != 0) {
-    //         MFATAL("Failed to join thread: %s", strerror(result));
-    //         return;
-    //     }
-    // }
+    platform_sleep(ms);
 }
 
 u64 platform_current_thread_id(void) {
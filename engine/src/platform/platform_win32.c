@@ -17,6 +17,7 @@
 #include "threads/thread.h"
 #include "time/clock.h"
 #include "memory/memory.h"
+#include "memory/allocators/scratch_allocator.h"
 #include "strings/string.h"
 #include "containers/darray.h"
 #include "renderer/renderer_types.h"
@@ -353,7 +354,8 @@ void platform_sleep(u64 ms) {
     clock c;
     clock_start(&c);
     timeBeginPeriod(min_period);
-    Sleep(ms - min_period);
+    // Short waits, including the 0 ms yield spin loops use, must not wrap to an INFINITE sleep
+    Sleep(ms > min_period ? (DWORD)(ms - min_period) : 0);
     timeEndPeriod(min_period);
 
     clock_update(&c);
@@ -367,6 +369,80 @@ void platform_sleep(u64 ms) {
     }
 }
 
+u32 platform_get_processor_count(void) {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (u32)info.dwNumberOfProcessors;
+}
+
+// Memory
+
+void* platform_memory_reserve(u64 size) {
+    void* block = VirtualAlloc(nullptr, size, MEM_RESERVE, PAGE_NOACCESS);
+    if (!block) {
+        MERROR("Failed to reserve %llu bytes of address space!", size);
+    }
+    return block;
+}
+
+b8 platform_memory_commit(void* block, u64 size) {
+    if (!VirtualAlloc(block, size, MEM_COMMIT, PAGE_READWRITE)) {
+        MERROR("Failed to commit %llu bytes at %p!", size, block);
+        return false;
+    }
+    return true;
+}
+
+void platform_memory_decommit(void* block, u64 size) {
+    VirtualFree(block, size, MEM_DECOMMIT);
+}
+
+void platform_memory_release(void* block, u64 size) {
+    if (block) {
+        VirtualFree(block, 0, MEM_RELEASE);
+    }
+}
+
+u64 platform_memory_page_size(void) {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (u64)info.dwPageSize;
+}
+
+u64 platform_memory_huge_page_size(void) {
+    return (u64)GetLargePageMinimum();
+}
+
+// Large pages need the "Lock pages in memory" right granted to the user, and enabled in the process token
+static b8 enable_lock_memory_privilege(void) {
+    HANDLE token;
+    if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token)) {
+        return false;
+    }
+
+    TOKEN_PRIVILEGES privileges;
+    privileges.PrivilegeCount = 1;
+    privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+    b8 result = LookupPrivilegeValueA(nullptr, "SeLockMemoryPrivilege", &privileges.Privileges[0].Luid) &&
+                AdjustTokenPrivileges(token, FALSE, &privileges, 0, nullptr, nullptr) &&
+                GetLastError() == ERROR_SUCCESS;
+    CloseHandle(token);
+    return result;
+}
+
+void* platform_memory_allocate_huge(u64 size) {
+    if (!enable_lock_memory_privilege()) {
+        return nullptr;
+    }
+    // Large pages are always committed at once
+    return VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+}
+
+b8 platform_memory_advise_huge(void* block, u64 size) {
+    // Windows has no transparent huge pages
+    return false;
+}
+
 static window* window_from_handle(HWND hwnd) {
     u64 len = darray_length(state_ptr->windows);
     for (u64 i = 0; i < len; ++i) {
@@ -524,21 +600,46 @@ LRESULT CALLBACK win32_process_message(HWND hwnd, u32 msg, WPARAM w_param, LPARA
 
 // Thread
 
+typedef struct thread_start_info {
+    PFN_thread_start start_func;
+    void* args;
+} thread_start_info;
+
+// Runs the thread function, then hands back what the thread cached in the memory system and its scratch arena before it exits
+static DWORD WINAPI thread_start(LPVOID param) {
+    thread_start_info info = *(thread_start_info*)param;
+    free(param);
+
+    u32 result = info.start_func(info.args);
+    scratch_thread_release();
+    memory_thread_cache_flush();
+    return result;
+}
+
 b8 thread_create(PFN_thread_start start_func, void* args, b8 auto_detach, thread* out_thread) {
     if (!start_func) {
         return false;
     }
 
+    thread_start_info* info = malloc(sizeof(thread_start_info));
+    if (!info) {
+        MERROR("Failed to allocate the thread start info.");
+        return false;
+    }
+    info->start_func = start_func;
+    info->args = args;
+
     out_thread->internal_data = CreateThread(
         nullptr,
         0,
-        (LPTHREAD_START_ROUTINE)start_func,
-        args,
+        thread_start,
+        info,
         0,
         (DWORD*)&out_thread->thread_id
     );
 
     if (!out_thread->internal_data) {
+        free(info);
         return false;
     }
 
@@ -3,6 +3,7 @@
 #include "platform/platform.h"
 #include "platform/vulkan_platform.h"
 #include "vulkan_device.h"
+#include "vulkan_memory.h"
 #include "vulkan_swapchain.h"
 #include "vulkan_types.h"
 #include "renderer/renderer_types.h"
@@ -98,12 +99,18 @@ b8 vulkan_renderer_initialize(const char* app_name, u16 window_width, u16 window
 
     vulkan_device_create(&context);
 
+    if (!vulkan_memory_allocator_create(&context, VULKAN_MEMORY_DEFAULT_BLOCK_SIZE)) {
+        MERROR("Failed to create the device memory allocator.");
+        return false;
+    }
+
     initialized = true;
     return true;
 }
 
 void vulkan_renderer_shutdown(void) {
     if (initialized) {
+        vulkan_memory_allocator_destroy(&context);
         vulkan_device_destroy(&context);
 
         if (context.debug_messenger) {
@@ -4,7 +4,7 @@
 #include "vulkan_utils.h"
 
 #include "containers/darray.h"
-#include "strings/string.h"
+#include "strings/name.h"
 #include "memory/memory.h"
 #include "core/logger.h"
 
@@ -14,8 +14,8 @@ typedef struct vulkan_physical_device_requirements {
     b8 present;
     b8 compute;
     b8 transfer;
-    // darray
-    const char** device_extension_names;
+    // darray of interned names
+    name* device_extension_names;
     b8 sampler_anisotropy;
     b8 discrete_gpu;
 } vulkan_physical_device_requirements;
@@ -102,8 +102,9 @@ b8 vulkan_device_create(vulkan_context* ctx) {
     if (available_extension_count > 0) {
         available_extensions = memory_allocate(sizeof(VkExtensionProperties) * available_extension_count, MEMORY_TAG_RENDERER);
         VK_CHECK(vkEnumerateDeviceExtensionProperties(ctx->device.physical, nullptr, &available_extension_count, available_extensions));
+        name portability_subset = name_intern("VK_KHR_portability_subset");
         for (u32 i = 0; i < available_extension_count; ++i) {
-            if (cstr_equal(available_extensions[i].extensionName, "VK_KHR_portability_subset")) {
+            if (name_find(available_extensions[i].extensionName) == portability_subset) {
                 MINFO("Adding required extension 'VK_KHR_portability_subset'");
                 portability_required = true;
                 break;
@@ -297,8 +298,8 @@ static b8 select_physical_device(vulkan_context* ctx) {
     requirements.sampler_anisotropy = true;
     requirements.discrete_gpu = true;
 
-    requirements.device_extension_names = darray_create(const char*);
-    darray_push(requirements.device_extension_names, &VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+    requirements.device_extension_names = darray_create(name);
+    darray_push(requirements.device_extension_names, name_intern(VK_KHR_SWAPCHAIN_EXTENSION_NAME));
 
     VkPhysicalDevice physical_devices[32];
     VK_CHECK(vkEnumeratePhysicalDevices(ctx->instance, &physical_device_count, physical_devices));
@@ -506,18 +507,24 @@ static b8 physical_device_meets_requirements(
                 avaliable_extensions = memory_allocate(sizeof(VkExtensionProperties) * available_extension_count, MEMORY_TAG_RENDERER);
                 VK_CHECK(vkEnumerateDeviceExtensionProperties(device, nullptr, &available_extension_count, avaliable_extensions));
 
+                // Each available extension is hashed once, then matched against the required names by handle
                 u32 required_extensions_count = darray_length(requirements->device_extension_names);
-                for (u32 i = 0; i < required_extensions_count; ++i) {
-                    b8 found = false;
-                    for (u32 j = 0; j < available_extension_count; ++j) {
-                        if (cstr_equal(requirements->device_extension_names[i], avaliable_extensions[j].extensionName)) {
-                            found = true;
-                            break;
+                u64 found_mask = 0;
+                for (u32 j = 0; j < available_extension_count; ++j) {
+                    name available = name_find(avaliable_extensions[j].extensionName);
+                    if (available == INVALID_NAME) {
+                        continue;
+                    }
+                    for (u32 i = 0; i < required_extensions_count && i < 64; ++i) {
+                        if (requirements->device_extension_names[i] == available) {
+                            found_mask |= 1ull << i;
                         }
                     }
+                }
 
-                    if (!found) {
-                        MINFO("Vulkan Device: Required extension not found: '%s', skipping device!", requirements->device_extension_names[i]);
+                for (u32 i = 0; i < required_extensions_count; ++i) {
+                    if (i >= 64 || !(found_mask & (1ull << i))) {
+                        MINFO("Vulkan Device: Required extension not found: '%s', skipping device!", name_string(requirements->device_extension_names[i]));
                         memory_free(avaliable_extensions, sizeof(VkExtensionProperties) * available_extension_count, MEMORY_TAG_RENDERER);
                         return false;
                     }
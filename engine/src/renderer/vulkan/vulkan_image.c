@@ -2,6 +2,7 @@
 
 #include "core/logger.h"
 #include "memory/memory.h"
+#include "vulkan_memory.h"
 #include "vulkan_utils.h"
 
 
@@ -45,25 +46,16 @@ void vulkan_image_create(
 
     vkGetImageMemoryRequirements(ctx->device.logical, out_image->handle, &out_image->memory_requirements);
 
-    i32 memory_type = ctx->find_memory_index(out_image->memory_requirements.memoryTypeBits, memory_flags);
-    if (memory_type == -1) {
-        MERROR("Required memory type not found! Image not valid!");
+    vulkan_resource_kind kind = tiling == VK_IMAGE_TILING_OPTIMAL ? VULKAN_RESOURCE_KIND_OPTIMAL : VULKAN_RESOURCE_KIND_LINEAR;
+    if (!vulkan_memory_allocate(ctx, &out_image->memory_requirements, memory_flags, kind, &out_image->memory)) {
+        MERROR("Failed to allocate memory for image!");
+        return;
     }
 
-    VkMemoryAllocateInfo alloc_info = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
-    alloc_info.allocationSize = out_image->memory_requirements.size;
-    alloc_info.memoryTypeIndex = memory_type;
-    VkResult result = vkAllocateMemory(ctx->device.logical, &alloc_info, nullptr, &out_image->memory);
-    if (!vulkan_result_is_success(result)) {
-        MERROR("Failed to allocate memory for image with the following error: %s", vulkan_result_string(result, true));
+    if (!vulkan_memory_bind_image(ctx, out_image->handle, &out_image->memory)) {
         return;
     }
 
-    VK_CHECK(vkBindImageMemory(ctx->device.logical, out_image->handle, out_image->memory, 0));
-
-    b8 is_device_memory = (out_image->memory_flags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) == VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
-    memory_allocate_report(out_image->memory_requirements.size, is_device_memory ? MEMORY_TAG_GPU_LOCAL : MEMORY_TAG_VULKAN);
-
     if (create_view) {
         out_image->view = VK_NULL_HANDLE;
 
@@ -87,18 +79,12 @@ void vulkan_image_destroy(vulkan_context* ctx, vulkan_image* image) {
         image->view = nullptr;
     }
 
-    if (image->memory) {
-        vkFreeMemory(ctx->device.logical, image->memory, nullptr);
-        image->memory = nullptr;
-    }
-
     if (image->handle) {
         vkDestroyImage(ctx->device.logical, image->handle, nullptr);
         image->handle = nullptr;
     }
 
-    b8 is_device_memory = (image->memory_flags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) == VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
-    memory_free_report(image->memory_requirements.size, is_device_memory ? MEMORY_TAG_GPU_LOCAL : MEMORY_TAG_VULKAN);
+    vulkan_memory_free(ctx, &image->memory);
     memory_zero(&image->memory_requirements, sizeof(VkMemoryRequirements));
 }
 
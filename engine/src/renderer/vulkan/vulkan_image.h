@@ -3,7 +3,7 @@
 #include "vulkan_types.h"
 
 
-void vulkan_image_create(
+MAPI void vulkan_image_create(
     vulkan_context* ctx,
     // texture_type type,
     u32 width,
@@ -18,7 +18,7 @@ void vulkan_image_create(
     vulkan_image* out_image
 );
 
-void vulkan_image_destroy(vulkan_context* ctx, vulkan_image* image);
+MAPI void vulkan_image_destroy(vulkan_context* ctx, vulkan_image* image);
 
 void vulkan_image_transition_layout(
     vulkan_context* ctx,
@@ -0,0 +1,211 @@
+#include "vulkan_memory.h"
+
+#include "vulkan_utils.h"
+
+#include "containers/darray.h"
+#include "containers/freelist.h"
+#include "memory/memory.h"
+#include "core/logger.h"
+
+
+typedef struct vulkan_memory_block {
+    VkDeviceMemory memory;
+    u64 size;
+    u32 memory_type;
+    b8 is_device_local;
+    // Tracks the block in VULKAN_MEMORY_ALLOCATION_UNIT units
+    freelist list;
+    void* list_memory;
+    u64 list_memory_requirement;
+    u32 allocation_count;
+} vulkan_memory_block;
+
+static vulkan_memory_block* block_create(vulkan_context* ctx, u32 memory_type, u64 size) {
+    VkMemoryAllocateInfo alloc_info = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+    alloc_info.allocationSize = size;
+    alloc_info.memoryTypeIndex = memory_type;
+    VkDeviceMemory memory;
+    VkResult result = vkAllocateMemory(ctx->device.logical, &alloc_info, nullptr, &memory);
+    if (!vulkan_result_is_success(result)) {
+        MERROR("Failed to allocate a %llu byte device memory block with the following error: %s", size, vulkan_result_string(result, true));
+        return nullptr;
+    }
+
+    vulkan_memory_block* block = memory_allocate(sizeof(vulkan_memory_block), MEMORY_TAG_RENDERER);
+    if (!block) {
+        MERROR("Failed to allocate the bookkeeping of a device memory block.");
+        vkFreeMemory(ctx->device.logical, memory, nullptr);
+        return nullptr;
+    }
+    block->memory = memory;
+    block->size = size;
+    block->memory_type = memory_type;
+    block->is_device_local = (ctx->device.memory.memoryTypes[memory_type].propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) != 0;
+
+    u64 unit_count = size / VULKAN_MEMORY_ALLOCATION_UNIT;
+    freelist_create_with_flags(unit_count, FREELIST_FLAG_BEST_FIT_BIT, &block->list_memory_requirement, nullptr, nullptr);
+    block->list_memory = memory_allocate(block->list_memory_requirement, MEMORY_TAG_RENDERER);
+    if (!block->list_memory) {
+        MERROR("Failed to allocate the freelist of a %llu byte device memory block.", size);
+        memory_free(block, sizeof(vulkan_memory_block), MEMORY_TAG_RENDERER);
+        vkFreeMemory(ctx->device.logical, memory, nullptr);
+        return nullptr;
+    }
+    freelist_create_with_flags(unit_count, FREELIST_FLAG_BEST_FIT_BIT, &block->list_memory_requirement, block->list_memory, &block->list);
+
+    memory_allocate_report(size, block->is_device_local ? MEMORY_TAG_GPU_LOCAL : MEMORY_TAG_VULKAN);
+    return block;
+}
+
+static void block_destroy(vulkan_context* ctx, vulkan_memory_block* block) {
+    if (block->allocation_count) {
+        MWARN("Destroying a device memory block that still holds %u allocations.", block->allocation_count);
+    }
+
+    vkFreeMemory(ctx->device.logical, block->memory, nullptr);
+    memory_free_report(block->size, block->is_device_local ? MEMORY_TAG_GPU_LOCAL : MEMORY_TAG_VULKAN);
+
+    freelist_destroy(&block->list);
+    memory_free(block->list_memory, block->list_memory_requirement, MEMORY_TAG_RENDERER);
+    memory_free(block, sizeof(vulkan_memory_block), MEMORY_TAG_RENDERER);
+}
+
+static b8 block_allocate(vulkan_memory_block* block, u64 units, u64 alignment_units, vulkan_memory_allocation* out_allocation) {
+    u64 offset_units = 0;
+    if (!freelist_allocate_block_aligned(&block->list, units, alignment_units, &offset_units)) {
+        return false;
+    }
+
+    block->allocation_count++;
+    out_allocation->memory = block->memory;
+    out_allocation->offset = offset_units * VULKAN_MEMORY_ALLOCATION_UNIT;
+    out_allocation->size = units * VULKAN_MEMORY_ALLOCATION_UNIT;
+    out_allocation->block = block;
+    return true;
+}
+
+b8 vulkan_memory_allocator_create(vulkan_context* ctx, u64 block_size) {
+    vulkan_memory_allocator* allocator = &ctx->memory_allocator;
+    allocator->block_size = get_aligned(block_size ? block_size : VULKAN_MEMORY_DEFAULT_BLOCK_SIZE, VULKAN_MEMORY_ALLOCATION_UNIT);
+    allocator->buffer_image_granularity = ctx->device.properties.limits.bufferImageGranularity;
+
+    for (u32 i = 0; i < VK_MAX_MEMORY_TYPES; ++i) {
+        for (u32 kind = 0; kind < VULKAN_RESOURCE_KIND_MAX; ++kind) {
+            allocator->blocks[i][kind] = darray_create(vulkan_memory_block*);
+        }
+    }
+    return true;
+}
+
+void vulkan_memory_allocator_destroy(vulkan_context* ctx) {
+    vulkan_memory_allocator* allocator = &ctx->memory_allocator;
+    for (u32 i = 0; i < VK_MAX_MEMORY_TYPES; ++i) {
+        for (u32 kind = 0; kind < VULKAN_RESOURCE_KIND_MAX; ++kind) {
+            vulkan_memory_block** blocks = allocator->blocks[i][kind];
+            if (!blocks) {
+                continue;
+            }
+            u64 block_count = darray_length(blocks);
+            for (u64 b = 0; b < block_count; ++b) {
+                block_destroy(ctx, blocks[b]);
+            }
+            darray_destroy(blocks);
+            allocator->blocks[i][kind] = nullptr;
+        }
+    }
+}
+
+b8 vulkan_memory_allocate(
+    vulkan_context* ctx,
+    const VkMemoryRequirements* requirements,
+    VkMemoryPropertyFlags memory_flags,
+    vulkan_resource_kind kind,
+    vulkan_memory_allocation* out_allocation
+) {
+    vulkan_memory_allocator* allocator = &ctx->memory_allocator;
+    memory_zero(out_allocation, sizeof(vulkan_memory_allocation));
+
+    i32 memory_type = ctx->find_memory_index(requirements->memoryTypeBits, memory_flags);
+    if (memory_type == -1) {
+        MERROR("Required memory type not found! Unable to allocate device memory.");
+        return false;
+    }
+
+    // Every range starts and ends on a unit boundary, so resources only need blocks of their own
+    // when a granularity page is larger than a unit
+    u32 pool_kind = allocator->buffer_image_granularity > VULKAN_MEMORY_ALLOCATION_UNIT ? kind : VULKAN_RESOURCE_KIND_LINEAR;
+    u64 units = get_aligned(requirements->size, VULKAN_MEMORY_ALLOCATION_UNIT) / VULKAN_MEMORY_ALLOCATION_UNIT;
+    // Alignments are powers of two, so anything up to a unit is met by every unit boundary
+    u64 alignment_units = MMAX(requirements->alignment / VULKAN_MEMORY_ALLOCATION_UNIT, (u64)1);
+
+    vulkan_memory_block** blocks = allocator->blocks[memory_type][pool_kind];
+    u64 block_count = darray_length(blocks);
+    for (u64 i = 0; i < block_count; ++i) {
+        if (freelist_free_space(&blocks[i]->list) >= units && block_allocate(blocks[i], units, alignment_units, out_allocation)) {
+            return true;
+        }
+    }
+
+    // Requests larger than a block get one sized for them
+    u64 block_size = MMAX(allocator->block_size, units * VULKAN_MEMORY_ALLOCATION_UNIT);
+    vulkan_memory_block* block = block_create(ctx, (u32)memory_type, block_size);
+    if (!block) {
+        return false;
+    }
+    // A new block only joins the pool once it holds the allocation, so a failure can not leave an empty one behind
+    if (!block_allocate(block, units, alignment_units, out_allocation)) {
+        MERROR("Failed to place %llu bytes aligned to %llu in a new device memory block.", requirements->size, requirements->alignment);
+        block_destroy(ctx, block);
+        return false;
+    }
+    darray_push(allocator->blocks[memory_type][pool_kind], block);
+    return true;
+}
+
+void vulkan_memory_free(vulkan_context* ctx, vulkan_memory_allocation* allocation) {
+    vulkan_memory_block* block = allocation->block;
+    if (!block) {
+        return;
+    }
+
+    u64 units = allocation->size / VULKAN_MEMORY_ALLOCATION_UNIT;
+    if (!freelist_free_block(&block->list, units, allocation->offset / VULKAN_MEMORY_ALLOCATION_UNIT)) {
+        MERROR("vulkan_memory_free - Failed to release the range at offset %llu.", allocation->offset);
+    }
+    block->allocation_count--;
+    memory_zero(allocation, sizeof(vulkan_memory_allocation));
+
+    // Each pool keeps its first block around, later blocks go back to the driver once empty
+    if (block->allocation_count == 0) {
+        vulkan_memory_allocator* allocator = &ctx->memory_allocator;
+        for (u32 kind = 0; kind < VULKAN_RESOURCE_KIND_MAX; ++kind) {
+            vulkan_memory_block** blocks = allocator->blocks[block->memory_type][kind];
+            u64 block_count = darray_length(blocks);
+            for (u64 i = 1; i < block_count; ++i) {
+                if (blocks[i] == block) {
+                    darray_pop_at(blocks, i, nullptr);
+                    block_destroy(ctx, block);
+                    return;
+                }
+            }
+        }
+    }
+}
+
+b8 vulkan_memory_bind_image(vulkan_context* ctx, VkImage image, const vulkan_memory_allocation* allocation) {
+    VkResult result = vkBindImageMemory(ctx->device.logical, image, allocation->memory, allocation->offset);
+    if (!vulkan_result_is_success(result)) {
+        MERROR("Failed to bind image memory with the following error: %s", vulkan_result_string(result, true));
+        return false;
+    }
+    return true;
+}
+
+b8 vulkan_memory_bind_buffer(vulkan_context* ctx, VkBuffer buffer, const vulkan_memory_allocation* allocation) {
+    VkResult result = vkBindBufferMemory(ctx->device.logical, buffer, allocation->memory, allocation->offset);
+    if (!vulkan_result_is_success(result)) {
+        MERROR("Failed to bind buffer memory with the following error: %s", vulkan_result_string(result, true));
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "vulkan_types.h"
+
+// Default size of the device memory blocks allocations are taken from. Larger requests get a block of their own
+#define VULKAN_MEMORY_DEFAULT_BLOCK_SIZE MEBIBYTES(64)
+
+// Allocations are rounded to this many bytes, which keeps the bookkeeping of a block small
+#define VULKAN_MEMORY_ALLOCATION_UNIT 256
+
+MAPI b8 vulkan_memory_allocator_create(vulkan_context* ctx, u64 block_size);
+
+MAPI void vulkan_memory_allocator_destroy(vulkan_context* ctx);
+
+// Takes a range satisfying the requirements from a block of a memory type with the given properties, allocating
+// a new block when none has room. When bufferImageGranularity exceeds a unit, linear and optimal resources
+// are kept in separate blocks
+MAPI b8 vulkan_memory_allocate(
+    vulkan_context* ctx,
+    const VkMemoryRequirements* requirements,
+    VkMemoryPropertyFlags memory_flags,
+    vulkan_resource_kind kind,
+    vulkan_memory_allocation* out_allocation
+);
+
+MAPI void vulkan_memory_free(vulkan_context* ctx, vulkan_memory_allocation* allocation);
+
+MAPI b8 vulkan_memory_bind_image(vulkan_context* ctx, VkImage image, const vulkan_memory_allocation* allocation);
+
+MAPI b8 vulkan_memory_bind_buffer(vulkan_context* ctx, VkBuffer buffer, const vulkan_memory_allocation* allocation);
@@ -61,11 +61,36 @@ typedef struct vulkan_device {
 
 } vulkan_device;
 
+typedef enum vulkan_resource_kind {
+    // Buffers and linearly tiled images
+    VULKAN_RESOURCE_KIND_LINEAR,
+    // Optimally tiled images
+    VULKAN_RESOURCE_KIND_OPTIMAL,
+    VULKAN_RESOURCE_KIND_MAX
+} vulkan_resource_kind;
+
+// A range of a device memory block, handed out by the device memory allocator. Resources bind at offset
+typedef struct vulkan_memory_allocation {
+    VkDeviceMemory memory;
+    u64 offset;
+    u64 size;
+    // Block the range was taken from. Null when nothing is allocated
+    struct vulkan_memory_block* block;
+} vulkan_memory_allocation;
+
+typedef struct vulkan_memory_allocator {
+    // Size of the device memory blocks that allocations are taken from
+    u64 block_size;
+    u64 buffer_image_granularity;
+    // darray of blocks, per memory type and resource kind
+    struct vulkan_memory_block** blocks[VK_MAX_MEMORY_TYPES][VULKAN_RESOURCE_KIND_MAX];
+} vulkan_memory_allocator;
+
 typedef struct vulkan_image {
     VkImage handle;
     VkImageView view;
 
-    VkDeviceMemory memory;
+    vulkan_memory_allocation memory;
     VkMemoryPropertyFlags memory_flags;
     VkMemoryRequirements memory_requirements;
     VkFormat format;
@@ -114,6 +139,8 @@ typedef struct vulkan_context {
 
     vulkan_device device;
 
+    vulkan_memory_allocator memory_allocator;
+
     i32 (*find_memory_index)(u32 type_filter, u32 property_flags);
 } vulkan_context;
 
@@ -0,0 +1,191 @@
+#include "name.h"
+
+#include "containers/darray.h"
+#include "containers/u64_hashtable.h"
+#include "core/hash.h"
+#include "memory/memory.h"
+#include "strings/string.h"
+#include "core/logger.h"
+
+// Interned strings are packed into blocks of this size. Longer strings get a block of their own
+#define NAME_STORAGE_BLOCK_SIZE KIBIBYTES(16)
+#define NAME_INITIAL_CAPACITY 1024
+
+typedef struct name_entry {
+    const char* str;
+    u64 length;
+    u64 hash;
+    // Next name with the same hash, so hash collisions stay correct
+    name next;
+} name_entry;
+
+typedef struct name_storage_block {
+    char* memory;
+    u64 size;
+} name_storage_block;
+
+typedef struct name_system_state {
+    // darray, indexed by handle. Entry 0 is INVALID_NAME
+    name_entry* entries;
+    // First name of each hash
+    u64_hashtable_u32 lookup;
+    // darray
+    name_storage_block* blocks;
+    u64 block_used;
+} name_system_state;
+
+static b8 initialized = false;
+static name_system_state state;
+
+// U64_HASHTABLE_EMPTY_KEY can not be stored, so that one hash shares its chain with its neighbour
+static inline u64 lookup_key(u64 hash) {
+    return hash == U64_HASHTABLE_EMPTY_KEY ? hash - 1 : hash;
+}
+
+static const char* storage_copy(const char* str, u64 length) {
+    u64 required = length + 1;
+    u64 block_count = darray_length(state.blocks);
+    if (!block_count || state.block_used + required > state.blocks[block_count - 1].size) {
+        name_storage_block block;
+        block.size = MMAX(required, (u64)NAME_STORAGE_BLOCK_SIZE);
+        block.memory = memory_allocate_uninitialized(block.size, MEMORY_TAG_STRING);
+        if (!block.memory) {
+            return nullptr;
+        }
+        darray_push(state.blocks, block);
+        block_count++;
+        state.block_used = 0;
+    }
+
+    char* copy = state.blocks[block_count - 1].memory + state.block_used;
+    memory_copy(copy, str, length);
+    copy[length] = 0;
+    state.block_used += required;
+    return copy;
+}
+
+static name find(const char* str, u64 length, u64 hash) {
+    u32* first = u64_hashtable_u32_get(&state.lookup, lookup_key(hash));
+    for (name n = first ? *first : INVALID_NAME; n != INVALID_NAME; n = state.entries[n].next) {
+        const name_entry* entry = &state.entries[n];
+        if (entry->hash == hash && entry->length == length && memory_compare(entry->str, str, length) == 0) {
+            return n;
+        }
+    }
+    return INVALID_NAME;
+}
+
+b8 name_system_initialize(void) {
+    if (initialized) {
+        MWARN("name_system_initialize - Already initialized.");
+        return true;
+    }
+
+    memory_zero(&state, sizeof(name_system_state));
+    state.entries = darray_reserve(name_entry, NAME_INITIAL_CAPACITY);
+    name_entry invalid = {0};
+    darray_push(state.entries, invalid);
+    state.blocks = darray_create(name_storage_block);
+    if (!u64_hashtable_u32_create(NAME_INITIAL_CAPACITY, &state.lookup)) {
+        return false;
+    }
+
+    initialized = true;
+    return true;
+}
+
+void name_system_shutdown(void) {
+    if (!initialized) {
+        return;
+    }
+
+    u64 block_count = darray_length(state.blocks);
+    for (u64 i = 0; i < block_count; ++i) {
+        memory_free(state.blocks[i].memory, state.blocks[i].size, MEMORY_TAG_STRING);
+    }
+    darray_destroy(state.blocks);
+    darray_destroy(state.entries);
+    u64_hashtable_u32_destroy(&state.lookup);
+    initialized = false;
+}
+
+name name_intern(const char* str) {
+    if (!initialized || !str) {
+        MERROR("name_intern requires an initialized name system and a string.");
+        return INVALID_NAME;
+    }
+
+    u64 length = cstr_len(str);
+    u64 hash = hash_bytes(str, length, HASH_DEFAULT_SEED);
+    name existing = find(str, length, hash);
+    if (existing != INVALID_NAME) {
+        return existing;
+    }
+
+    u64 entry_count = darray_length(state.entries);
+    if (entry_count >= U32_MAX) {
+        MERROR("name_intern - Out of name handles.");
+        return INVALID_NAME;
+    }
+
+    name_entry entry;
+    entry.str = storage_copy(str, length);
+    if (!entry.str) {
+        MERROR("name_intern - Failed to allocate storage for '%s'.", str);
+        return INVALID_NAME;
+    }
+    entry.length = length;
+    entry.hash = hash;
+
+    // New names go to the front of their hash's chain
+    name n = (name)entry_count;
+    u32* first = u64_hashtable_u32_get(&state.lookup, lookup_key(hash));
+    entry.next = first ? *first : INVALID_NAME;
+    if (!u64_hashtable_u32_set(&state.lookup, lookup_key(hash), n)) {
+        return INVALID_NAME;
+    }
+    darray_push(state.entries, entry);
+    return n;
+}
+
+name name_find(const char* str) {
+    if (!initialized || !str) {
+        return INVALID_NAME;
+    }
+
+    u64 length = cstr_len(str);
+    return find(str, length, hash_bytes(str, length, HASH_DEFAULT_SEED));
+}
+
+static inline const name_entry* entry_get(name n) {
+    if (!initialized || n == INVALID_NAME || n >= darray_length(state.entries)) {
+        return nullptr;
+    }
+    return &state.entries[n];
+}
+
+const char* name_string(name n) {
+    const name_entry* entry = entry_get(n);
+    return entry ? entry->str : nullptr;
+}
+
+u64 name_length(name n) {
+    const name_entry* entry = entry_get(n);
+    return entry ? entry->length : 0;
+}
+
+u64 name_hash(name n) {
+    const name_entry* entry = entry_get(n);
+    return entry ? entry->hash : 0;
+}
+
+hashtable_key name_key(name n) {
+    hashtable_key key = {0};
+    const name_entry* entry = entry_get(n);
+    if (entry) {
+        key.str = entry->str;
+        key.length = entry->length;
+        key.hash = entry->hash;
+    }
+    return key;
+}
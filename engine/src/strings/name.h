@@ -0,0 +1,31 @@
+#pragma once
+
+#include "defines.h"
+#include "containers/hashtable.h"
+
+// Handle of an interned string. Equal strings always get the same handle, so names compare as integers
+typedef u32 name;
+
+#define INVALID_NAME 0
+
+MAPI b8 name_system_initialize(void);
+
+MAPI void name_system_shutdown(void);
+
+// Returns the handle of the string, interning a copy of it the first time it is seen.
+// Not thread safe, intern names while loading rather than from jobs
+MAPI name name_intern(const char* str);
+
+// Returns the handle of an already interned string, or INVALID_NAME. Does not intern it
+MAPI name name_find(const char* str);
+
+// The interned copy, which lives until the name system shuts down. nullptr for INVALID_NAME
+MAPI const char* name_string(name n);
+
+MAPI u64 name_length(name n);
+
+// The hash_string hash of the name, computed once when it was interned
+MAPI u64 name_hash(name n);
+
+// Key for the prehashed hashtable functions, so tables keyed by name strings never rehash them
+MAPI hashtable_key name_key(name n);
@@ -49,7 +49,7 @@ char* cstr_duplicate(const char* str) {
     }
 
     u64 len = cstr_len(str);
-    char* copy = memory_allocate(len + 1, MEMORY_TAG_STRING);
+    char* copy = memory_allocate_uninitialized(len + 1, MEMORY_TAG_STRING);
     memory_copy(copy, str, len);
     copy[len] = '\0';
 
@@ -155,6 +155,23 @@ char* cstr_format(const char* format, ...) {
 }
 
 char* cstr_format_v(const char* format, void* va_listp) {
+    return cstr_format_v_with_allocator(nullptr, format, va_listp);
+}
+
+char* cstr_format_with_allocator(struct frame_allocator_int* allocator, const char* format, ...) {
+    if (!format) {
+        return nullptr;
+    }
+
+    __builtin_va_list arg_ptr;
+    va_start(arg_ptr, format);
+    char* result = cstr_format_v_with_allocator(allocator, format, arg_ptr);
+    va_end(arg_ptr);
+
+    return result;
+}
+
+char* cstr_format_v_with_allocator(struct frame_allocator_int* allocator, const char* format, void* va_listp) {
     if (!format) {
         return nullptr;
     }
@@ -168,7 +185,12 @@ char* cstr_format_v(const char* format, void* va_listp) {
     i32 len = vsnprintf(nullptr, 0, format, list_copy);
     va_end(list_copy);
 
-    char* buffer = memory_allocate(len + 1, MEMORY_TAG_STRING);
+    char* buffer = nullptr;
+    if (allocator) {
+        buffer = allocator->allocate(allocator->context, len + 1);
+    } else {
+        buffer = memory_allocate_uninitialized(len + 1, MEMORY_TAG_STRING);
+    }
     if (!buffer) {
         return nullptr;
     }
@@ -376,7 +398,7 @@ void cstr_insert_char_at(char* dst, const char* src, u64 pos, char c) {
     }
 
     if (pos < src_len) {
-        memory_copy(dst + pos + 1, src + pos, sizeof(char) * remaining);
+        memory_move(dst + pos + 1, src + pos, sizeof(char) * remaining);
     }
 
     dst[pos] = c;
@@ -396,7 +418,7 @@ void cstr_insert_str_at(char* dst, const char* src, u64 pos, const char* str) {
     }
 
     if (pos < src_len) {
-        memory_copy(dst + pos + str_len, src + pos, sizeof(char) * remaining);
+        memory_move(dst + pos + str_len, src + pos, sizeof(char) * remaining);
     }
 
     memory_copy(dst + pos, str, sizeof(char) * str_len);
@@ -434,7 +456,7 @@ void cstr_remove_at(char* dst, const char* src, u64 start, u64 len) {
     }
 
     if (start < src_len) {
-        memory_copy(dst + start, src + start + len, sizeof(char) * remaining);
+        memory_move(dst + start, src + start + len, sizeof(char) * remaining);
     }
 
     dst[src_len - len] = '\0';
@@ -444,7 +466,33 @@ u64 cstr_split(const char* str, char delimiter, char*** str_darray, b8 trim_entr
     return cstr_nsplit(str, delimiter, U64_MAX, str_darray, trim_entries, include_empty);
 }
 
+u64 cstr_split_with_allocator(const char* str, char delimiter, char*** str_darray, b8 trim_entries, b8 include_empty, struct frame_allocator_int* allocator) {
+    return cstr_nsplit_with_allocator(str, delimiter, U64_MAX, str_darray, trim_entries, include_empty, allocator);
+}
+
 u64 cstr_nsplit(const char* str, char delimiter, u64 max_count, char*** str_darray, b8 trim_entries, b8 include_empty) {
+    return cstr_nsplit_with_allocator(str, delimiter, max_count, str_darray, trim_entries, include_empty, nullptr);
+}
+
+static char* split_entry_create(const char* src, u64 len, struct frame_allocator_int* allocator) {
+    char* entry = nullptr;
+    if (allocator) {
+        entry = allocator->allocate(allocator->context, sizeof(char) * (len + 1));
+    } else {
+        entry = memory_allocate_uninitialized(sizeof(char) * (len + 1), MEMORY_TAG_STRING);
+    }
+    if (!entry) {
+        return nullptr;
+    }
+
+    if (len > 0) {
+        cstr_ncopy(entry, src, len);
+    }
+    entry[len] = '\0';
+    return entry;
+}
+
+u64 cstr_nsplit_with_allocator(const char* str, char delimiter, u64 max_count, char*** str_darray, b8 trim_entries, b8 include_empty, struct frame_allocator_int* allocator) {
     if (!str || !str_darray || max_count == 0) {
         return 0;
     }
@@ -452,7 +500,8 @@ u64 cstr_nsplit(const char* str, char delimiter, u64 max_count, char*** str_darr
     char* result = nullptr;
     u64 trimmed_len = 0;
     u64 entry_count = 0;
-    char buffer[16384] = {0};
+    // Each entry is terminated before it is read, so the buffer is never cleared
+    char buffer[16384];
     u64 current_len = 0;
 
     u64 str_len = cstr_len(str);
@@ -469,11 +518,10 @@ u64 cstr_nsplit(const char* str, char delimiter, u64 max_count, char*** str_darr
             }
 
             if (trimmed_len > 0 || include_empty) {
-                char* entry = memory_allocate(sizeof(char) * (trimmed_len + 1), MEMORY_TAG_STRING);
-                if (trimmed_len > 0) {
-                    cstr_ncopy(entry, result, trimmed_len);
+                char* entry = split_entry_create(result, trimmed_len, allocator);
+                if (!entry) {
+                    return entry_count;
                 }
-                entry[trimmed_len] = '\0';
 
                 char** a = *str_darray;
                 darray_push(a, entry);
@@ -485,7 +533,6 @@ u64 cstr_nsplit(const char* str, char delimiter, u64 max_count, char*** str_darr
                 return entry_count;
             }
 
-            memory_zero(buffer, sizeof(char) * 16384);
             current_len = 0;
             continue;
         }
@@ -494,6 +541,7 @@ u64 cstr_nsplit(const char* str, char delimiter, u64 max_count, char*** str_darr
         current_len++;
     }
 
+    buffer[current_len] = '\0';
     result = buffer;
     trimmed_len = current_len;
     if (trim_entries && current_len > 0) {
@@ -502,11 +550,10 @@ u64 cstr_nsplit(const char* str, char delimiter, u64 max_count, char*** str_darr
     }
 
     if (trimmed_len > 0 || include_empty) {
-        char* entry = memory_allocate(sizeof(char) * (trimmed_len + 1), MEMORY_TAG_STRING);
-        if (trimmed_len > 0) {
-            cstr_ncopy(entry, result, trimmed_len);
+        char* entry = split_entry_create(result, trimmed_len, allocator);
+        if (!entry) {
+            return entry_count;
         }
-        entry[trimmed_len] = '\0';
 
         char** a = *str_darray;
         darray_push(a, entry);
@@ -1018,7 +1065,7 @@ const char* cstr_ext_from_path(const char* path, b8 include_dot) {
     }
 
     u64 ext_len = cstr_len(path) - start;
-    char* ext = memory_allocate(sizeof(char) * (ext_len + 1), MEMORY_TAG_STRING);
+    char* ext = memory_allocate_uninitialized(sizeof(char) * (ext_len + 1), MEMORY_TAG_STRING);
     cstr_sub(ext, path, start, ext_len); // TODO: just memory_copy ?
     return ext;
 }
@@ -2,6 +2,8 @@
 
 #include "math/math_types.h"
 
+struct frame_allocator_int;
+
 
 // Gets the number of bytes of the given string, minus the null terminator.
 // NOTE: For strings without a null terminator, use cstr_nlen instead.
@@ -43,6 +45,14 @@ MAPI char* cstr_format(const char* format, ...);
 // NOTE: This performs a dynamic allocation and should be freed by the caller.
 MAPI char* cstr_format_v(const char* format, void* va_listp);
 
+// Same as cstr_format, but the result is allocated from the given allocator, such as a scratch arena.
+// Returns nullptr when the allocator is out of memory
+MAPI char* cstr_format_with_allocator(struct frame_allocator_int* allocator, const char* format, ...);
+
+// Same as cstr_format_v, but the result is allocated from the given allocator, such as a scratch arena.
+// Returns nullptr when the allocator is out of memory
+MAPI char* cstr_format_v_with_allocator(struct frame_allocator_int* allocator, const char* format, void* va_listp);
+
 // Empties the provided string by setting the first character to 0
 MAPI char* cstr_empty(char* str);
 
@@ -107,6 +117,14 @@ MAPI u64 cstr_split(const char* str, char delimiter, char*** str_darray, b8 trim
 // NOTE: A string allocation occurs for each entry, an MUST be freed by the caller.
 MAPI u64 cstr_nsplit(const char* str, char delimiter, u64 max_count, char*** str_darray, b8 trim_entries, b8 include_empty);
 
+// Same as cstr_split, but entries are allocated from the given allocator, such as a scratch arena,
+// and are released with it instead of through cstr_cleanup_split_darray. Stops early when the allocator is out of memory
+MAPI u64 cstr_split_with_allocator(const char* str, char delimiter, char*** str_darray, b8 trim_entries, b8 include_empty, struct frame_allocator_int* allocator);
+
+// Same as cstr_nsplit, but entries are allocated from the given allocator, such as a scratch arena,
+// and are released with it instead of through cstr_cleanup_split_darray. Stops early when the allocator is out of memory
+MAPI u64 cstr_nsplit_with_allocator(const char* str, char delimiter, u64 max_count, char*** str_darray, b8 trim_entries, b8 include_empty, struct frame_allocator_int* allocator);
+
 // Clean up string allocations in str_darray, but does not free the void* itself.
 MAPI void cstr_cleanup_split_darray(char** str_darray);
 
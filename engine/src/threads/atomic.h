@@ -0,0 +1,179 @@
+#pragma once
+
+#include "defines.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Atomic operations on naturally aligned integers and pointers.
+// Loads have acquire semantics, stores have release semantics and
+// read-modify-write operations are sequentially consistent.
+
+#if defined(_MSC_VER)
+
+MINLINE u64 atomic_u64_load(volatile u64* target) {
+    u64 value = *target;
+    _ReadWriteBarrier();
+    return value;
+}
+
+MINLINE void atomic_u64_store(volatile u64* target, u64 value) {
+    _ReadWriteBarrier();
+    *target = value;
+}
+
+MINLINE u64 atomic_u64_fetch_add(volatile u64* target, u64 value) {
+    return (u64)_InterlockedExchangeAdd64((volatile long long*)target, (long long)value);
+}
+
+MINLINE u64 atomic_u64_fetch_sub(volatile u64* target, u64 value) {
+    return (u64)_InterlockedExchangeAdd64((volatile long long*)target, -(long long)value);
+}
+
+MINLINE u64 atomic_u64_exchange(volatile u64* target, u64 value) {
+    return (u64)_InterlockedExchange64((volatile long long*)target, (long long)value);
+}
+
+// Replaces target with desired if it equals *expected. On failure, *expected receives the current value
+MINLINE b8 atomic_u64_compare_exchange(volatile u64* target, u64* expected, u64 desired) {
+    u64 previous = (u64)_InterlockedCompareExchange64((volatile long long*)target, (long long)desired, (long long)*expected);
+    if (previous == *expected) {
+        return true;
+    }
+    *expected = previous;
+    return false;
+}
+
+MINLINE u32 atomic_u32_load(volatile u32* target) {
+    u32 value = *target;
+    _ReadWriteBarrier();
+    return value;
+}
+
+MINLINE void atomic_u32_store(volatile u32* target, u32 value) {
+    _ReadWriteBarrier();
+    *target = value;
+}
+
+MINLINE u32 atomic_u32_fetch_add(volatile u32* target, u32 value) {
+    return (u32)_InterlockedExchangeAdd((volatile long*)target, (long)value);
+}
+
+MINLINE u32 atomic_u32_fetch_sub(volatile u32* target, u32 value) {
+    return (u32)_InterlockedExchangeAdd((volatile long*)target, -(long)value);
+}
+
+MINLINE b8 atomic_u32_compare_exchange(volatile u32* target, u32* expected, u32 desired) {
+    u32 previous = (u32)_InterlockedCompareExchange((volatile long*)target, (long)desired, (long)*expected);
+    if (previous == *expected) {
+        return true;
+    }
+    *expected = previous;
+    return false;
+}
+
+MINLINE void* atomic_ptr_load(void* volatile* target) {
+    void* value = *target;
+    _ReadWriteBarrier();
+    return value;
+}
+
+MINLINE void atomic_ptr_store(void* volatile* target, void* value) {
+    _ReadWriteBarrier();
+    *target = value;
+}
+
+MINLINE b8 atomic_ptr_compare_exchange(void* volatile* target, void** expected, void* desired) {
+    void* previous = _InterlockedCompareExchangePointer(target, desired, *expected);
+    if (previous == *expected) {
+        return true;
+    }
+    *expected = previous;
+    return false;
+}
+
+// Full memory barrier
+MINLINE void atomic_thread_fence_seq_cst(void) {
+    _mm_mfence();
+}
+
+// Hints the CPU that the caller is spinning on a value
+MINLINE void atomic_spin_pause(void) {
+    _mm_pause();
+}
+
+#else
+
+MINLINE u64 atomic_u64_load(volatile u64* target) {
+    return __atomic_load_n(target, __ATOMIC_ACQUIRE);
+}
+
+MINLINE void atomic_u64_store(volatile u64* target, u64 value) {
+    __atomic_store_n(target, value, __ATOMIC_RELEASE);
+}
+
+MINLINE u64 atomic_u64_fetch_add(volatile u64* target, u64 value) {
+    return __atomic_fetch_add(target, value, __ATOMIC_SEQ_CST);
+}
+
+MINLINE u64 atomic_u64_fetch_sub(volatile u64* target, u64 value) {
+    return __atomic_fetch_sub(target, value, __ATOMIC_SEQ_CST);
+}
+
+MINLINE u64 atomic_u64_exchange(volatile u64* target, u64 value) {
+    return __atomic_exchange_n(target, value, __ATOMIC_SEQ_CST);
+}
+
+// Replaces target with desired if it equals *expected. On failure, *expected receives the current value
+MINLINE b8 atomic_u64_compare_exchange(volatile u64* target, u64* expected, u64 desired) {
+    return __atomic_compare_exchange_n(target, expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+MINLINE u32 atomic_u32_load(volatile u32* target) {
+    return __atomic_load_n(target, __ATOMIC_ACQUIRE);
+}
+
+MINLINE void atomic_u32_store(volatile u32* target, u32 value) {
+    __atomic_store_n(target, value, __ATOMIC_RELEASE);
+}
+
+MINLINE u32 atomic_u32_fetch_add(volatile u32* target, u32 value) {
+    return __atomic_fetch_add(target, value, __ATOMIC_SEQ_CST);
+}
+
+MINLINE u32 atomic_u32_fetch_sub(volatile u32* target, u32 value) {
+    return __atomic_fetch_sub(target, value, __ATOMIC_SEQ_CST);
+}
+
+MINLINE b8 atomic_u32_compare_exchange(volatile u32* target, u32* expected, u32 desired) {
+    return __atomic_compare_exchange_n(target, expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+MINLINE void* atomic_ptr_load(void* volatile* target) {
+    return __atomic_load_n(target, __ATOMIC_ACQUIRE);
+}
+
+MINLINE void atomic_ptr_store(void* volatile* target, void* value) {
+    __atomic_store_n(target, value, __ATOMIC_RELEASE);
+}
+
+MINLINE b8 atomic_ptr_compare_exchange(void* volatile* target, void** expected, void* desired) {
+    return __atomic_compare_exchange_n(target, expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+// Full memory barrier
+MINLINE void atomic_thread_fence_seq_cst(void) {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+// Hints the CPU that the caller is spinning on a value
+MINLINE void atomic_spin_pause(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+#endif
@@ -0,0 +1,28 @@
+#include "spinlock.h"
+
+#include "platform/platform.h"
+#include "threads/atomic.h"
+
+// Failed attempts to take the lock before the thread starts sleeping between attempts
+#define SPINLOCK_SPIN_LIMIT 128
+
+b8 spinlock_try_lock(spinlock* lock) {
+    u32 expected = 0;
+    // Reading first keeps waiters from pulling the line exclusive while the lock is held
+    return atomic_u32_load(&lock->locked) == 0 && atomic_u32_compare_exchange(&lock->locked, &expected, 1);
+}
+
+void spinlock_lock(spinlock* lock) {
+    u32 spins = 0;
+    while (!spinlock_try_lock(lock)) {
+        if (++spins < SPINLOCK_SPIN_LIMIT) {
+            atomic_spin_pause();
+        } else {
+            platform_sleep(0);
+        }
+    }
+}
+
+void spinlock_unlock(spinlock* lock) {
+    atomic_u32_store(&lock->locked, 0);
+}
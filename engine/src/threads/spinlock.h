@@ -0,0 +1,17 @@
+#pragma once
+
+#include "defines.h"
+
+// Lock for critical sections too short to be worth a trip through a platform mutex. It lives
+// inline in the owning struct, and a zeroed spinlock is unlocked
+typedef struct spinlock {
+    // 1 while a thread holds the lock
+    volatile u32 locked;
+} spinlock;
+
+MAPI b8 spinlock_try_lock(spinlock* lock);
+
+// Spins for a while, then sleeps between attempts so a holder that was preempted can finish
+MAPI void spinlock_lock(spinlock* lock);
+
+MAPI void spinlock_unlock(spinlock* lock);
@@ -0,0 +1,126 @@
+#include "concurrent_hashtable_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+#include <containers/concurrent_hashtable.h>
+#include <threads/atomic.h>
+#include <threads/thread.h>
+
+#define RACE_THREADS 4
+#define RACE_KEYS 20000
+
+typedef struct race_worker {
+    concurrent_hashtable* table;
+    volatile u32* start;
+    u64 id;
+    u32 wins;
+    // Keys where the value seen was not the one stored by the winner of that key
+    u32 mismatches;
+} race_worker;
+
+static race_worker race_workers[RACE_THREADS];
+
+u8 concurrent_hashtable_should_set_get_and_remove(void) {
+    concurrent_hashtable table;
+    // Few shards and a small size, so every shard grows
+    expect_true(concurrent_hashtable_create(sizeof(u64), 16, 3, &table));
+    expect_be(4, table.shard_count);
+
+    for (u64 i = 0; i < 5000; ++i) {
+        expect_true(concurrent_hashtable_set(&table, i, &(u64){i * 3}));
+    }
+    expect_be(5000, concurrent_hashtable_count(&table));
+
+    u64 value = 0;
+    for (u64 i = 0; i < 5000; ++i) {
+        expect_true(concurrent_hashtable_get(&table, i, &value));
+        expect_be(i * 3, value);
+    }
+    value = 42;
+    expect_false(concurrent_hashtable_get(&table, 5000, &value));
+    expect_be(42, value);
+
+    expect_true(concurrent_hashtable_remove(&table, 10));
+    expect_false(concurrent_hashtable_remove(&table, 10));
+    expect_false(concurrent_hashtable_get(&table, 10, &value));
+    expect_be(4999, concurrent_hashtable_count(&table));
+
+    // Only the first insert of a key takes effect
+    u64 existing = 0;
+    expect_true(concurrent_hashtable_insert_if_absent(&table, 10, &(u64){7}, &existing));
+    expect_false(concurrent_hashtable_insert_if_absent(&table, 10, &(u64){8}, &existing));
+    expect_be(7, existing);
+    expect_false(concurrent_hashtable_insert_if_absent(&table, 11, &(u64){8}, nullptr));
+    expect_true(concurrent_hashtable_get(&table, 11, &value));
+    expect_be(33, value);
+
+    concurrent_hashtable_destroy(&table);
+    expect_be(0, table.shards);
+    return true;
+}
+
+static u32 race_thread(void* args) {
+    race_worker* worker = args;
+    while (!atomic_u32_load(worker->start)) {
+        atomic_spin_pause();
+    }
+
+    // Every thread tries every key, starting at a different point so the threads collide throughout
+    for (u32 i = 0; i < RACE_KEYS; ++i) {
+        u64 key = (i + worker->id * (RACE_KEYS / RACE_THREADS)) % RACE_KEYS;
+        u64 existing = 0;
+        if (concurrent_hashtable_insert_if_absent(worker->table, key, &worker->id, &existing)) {
+            worker->wins++;
+        } else if (existing >= RACE_THREADS) {
+            worker->mismatches++;
+        }
+    }
+    return 0;
+}
+
+u8 concurrent_hashtable_insert_if_absent_has_one_winner_per_key(void) {
+    concurrent_hashtable table;
+    // Starts small, so shards grow while other threads are inserting
+    expect_true(concurrent_hashtable_create(sizeof(u64), 64, 0, &table));
+
+    volatile u32 start = 0;
+    thread threads[RACE_THREADS];
+    for (u32 i = 0; i < RACE_THREADS; ++i) {
+        race_workers[i].table = &table;
+        race_workers[i].start = &start;
+        race_workers[i].id = i;
+        race_workers[i].wins = 0;
+        race_workers[i].mismatches = 0;
+        expect_true(thread_create(race_thread, &race_workers[i], false, &threads[i]));
+    }
+    atomic_u32_store(&start, 1);
+    for (u32 i = 0; i < RACE_THREADS; ++i) {
+        thread_wait(&threads[i]);
+        thread_destroy(&threads[i]);
+    }
+
+    u32 total_wins = 0;
+    for (u32 i = 0; i < RACE_THREADS; ++i) {
+        total_wins += race_workers[i].wins;
+        expect_be(0, race_workers[i].mismatches);
+    }
+    expect_be(RACE_KEYS, total_wins);
+    expect_be(RACE_KEYS, concurrent_hashtable_count(&table));
+
+    // Each key holds the id of a thread that tried it
+    b8 valid = true;
+    for (u64 key = 0; key < RACE_KEYS; ++key) {
+        u64 owner = RACE_THREADS;
+        valid = valid && concurrent_hashtable_get(&table, key, &owner) && owner < RACE_THREADS;
+    }
+    expect_true(valid);
+
+    concurrent_hashtable_destroy(&table);
+    return true;
+}
+
+void concurrent_hashtable_register_tests(void) {
+    test_manager_register_test(concurrent_hashtable_should_set_get_and_remove, "Concurrent hashtable should set, get and remove");
+    test_manager_register_test(concurrent_hashtable_insert_if_absent_has_one_winner_per_key, "Concurrent hashtable insert_if_absent has one winner per key");
+}
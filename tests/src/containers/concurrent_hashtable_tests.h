@@ -0,0 +1,3 @@
+#pragma once
+
+void concurrent_hashtable_register_tests(void);
\ No newline at end of file
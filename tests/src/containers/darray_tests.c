@@ -10,16 +10,16 @@
 static linear_allocator alloc;
 static frame_allocator_int frame_allocator;
 
-static void* fn_alloc(u64 size) {
-    return linear_allocator_allocate(&alloc, size);
+static void* fn_alloc(void* context, u64 size) {
+    return linear_allocator_allocate(context, size);
 }
 
-static void fn_free(void* block, u64 size) {
+static void fn_free(void* context, void* block, u64 size) {
     // NOTE: intentional No-op here.
 }
 
-static void fn_free_all(void) {
-    linear_allocator_free_all(&alloc, true);
+static void fn_free_all(void* context) {
+    linear_allocator_free_all(context, true);
 }
 
 static void setup_frame_allocator(void) {
@@ -30,6 +30,7 @@ static void setup_frame_allocator(void) {
     frame_allocator.allocate = fn_alloc;
     frame_allocator.free = fn_free;
     frame_allocator.free_all = fn_free_all;
+    frame_allocator.context = &alloc;
 }
 
 static void destroy_frame_allocator(void) {
@@ -37,6 +38,7 @@ static void destroy_frame_allocator(void) {
     frame_allocator.allocate = 0;
     frame_allocator.free = 0;
     frame_allocator.free_all = 0;
+    frame_allocator.context = 0;
 }
 
 static u8 all_darray_tests_after_create(void) {
@@ -1219,6 +1221,152 @@ static u8 darray_float_type_test(void) {
     return true;
 }
 
+static u8 darray_uninitialized_flag_test(void) {
+    u64* arr = darray_reserve_with_flags(u64, 2, DARRAY_FLAG_UNINITIALIZED_BIT);
+    expect_not_be(arr, 0);
+    expect_be(DARRAY_FLAG_UNINITIALIZED_BIT, darray_get_flags(arr));
+    expect_be(0, darray_length(arr));
+    expect_be(2, darray_capacity(arr));
+
+    // Growth keeps the contents and the flags
+    for (u64 i = 0; i < 100; ++i) {
+        darray_push(arr, i * 3);
+    }
+    expect_be(100, darray_length(arr));
+    expect_be(DARRAY_FLAG_UNINITIALIZED_BIT, darray_get_flags(arr));
+    for (u64 i = 0; i < 100; ++i) {
+        expect_be(i * 3, arr[i]);
+    }
+
+    u64* copy = darray_duplicate(arr);
+    expect_be(100, darray_length(copy));
+    expect_be(DARRAY_FLAG_UNINITIALIZED_BIT, darray_get_flags(copy));
+    expect_be(297, copy[99]);
+
+    darray_destroy(copy);
+    darray_destroy(arr);
+
+    // Arrays created without flags still hand out zeroed slots
+    u64* zeroed = darray_reserve(u64, 8);
+    expect_be(DARRAY_FLAG_NONE_BIT, darray_get_flags(zeroed));
+    for (u64 i = 0; i < 8; ++i) {
+        expect_be(0, zeroed[i]);
+    }
+    darray_destroy(zeroed);
+
+    return true;
+}
+
+static b8 is_odd(const void* element, void* context) {
+    return (*(const u32*)element & 1) != 0;
+}
+
+static b8 is_multiple_of(const u32* value, void* context) {
+    return *value % *(u32*)context == 0;
+}
+
+static u8 darray_bulk_operations_test(void) {
+    u32 values[64];
+    for (u32 i = 0; i < 64; ++i) {
+        values[i] = i;
+    }
+
+    // A range grows the array once, to at least the required length
+    u32* arr = darray_create(u32);
+    darray_append_range(arr, values, 40);
+    expect_be(40, darray_length(arr));
+    expect_be(40, darray_capacity(arr));
+    for (u32 i = 0; i < 40; ++i) {
+        expect_be(i, arr[i]);
+    }
+
+    // [0..9, 100, 101, 102, 10..39]
+    u32 inserted[3] = {100, 101, 102};
+    darray_insert_range(arr, 10, inserted, 3);
+    expect_be(43, darray_length(arr));
+    expect_be(9, arr[9]);
+    expect_be(100, arr[10]);
+    expect_be(102, arr[12]);
+    expect_be(10, arr[13]);
+    expect_be(39, arr[42]);
+
+    // Inserting at the length appends
+    darray_insert_range(arr, darray_length(arr), &values[63], 1);
+    expect_be(44, darray_length(arr));
+    expect_be(63, arr[43]);
+
+    darray_remove_range(arr, 10, 3);
+    expect_be(41, darray_length(arr));
+    for (u32 i = 0; i < 40; ++i) {
+        expect_be(i, arr[i]);
+    }
+
+    // Out of bounds requests leave the array untouched
+    darray_remove_range(arr, 40, 2);
+    expect_be(41, darray_length(arr));
+
+    u32 removed = 0;
+    darray_swap_remove(arr, 5, &removed);
+    expect_be(5, removed);
+    expect_be(40, darray_length(arr));
+    expect_be(63, arr[5]);
+    darray_swap_remove(arr, 39, nullptr);
+    expect_be(39, darray_length(arr));
+    expect_be(38, arr[38]);
+
+    // Drops 63 along with the other odd values, keeping 0, 2, 4, ... in order
+    u64 odd_count = darray_remove_if(arr, is_odd, nullptr);
+    expect_be(19, odd_count);
+    expect_be(20, darray_length(arr));
+    for (u32 i = 0; i < 20; ++i) {
+        expect_be(i * 2, arr[i]);
+    }
+    darray_destroy(arr);
+
+    // Typed arrays
+    darray_u32 typed = darray_u32_create();
+    darray_u32_append_range(&typed, values, 64);
+    expect_be(64, typed.base.length);
+    expect_be(64, typed.base.capacity);
+    expect_be(63, typed.data[63]);
+
+    expect_true(darray_u32_insert_range(&typed, 0, inserted, 3));
+    expect_false(darray_u32_insert_range(&typed, 68, inserted, 3));
+    expect_be(67, typed.base.length);
+    expect_be(100, typed.data[0]);
+    expect_be(0, typed.data[3]);
+
+    expect_true(darray_u32_remove_range(&typed, 0, 3));
+    expect_false(darray_u32_remove_range(&typed, 60, 5));
+    expect_be(64, typed.base.length);
+    expect_be(0, typed.data[0]);
+
+    u32 value = 0;
+    expect_true(darray_u32_swap_remove(&typed, 0, &value));
+    expect_be(0, value);
+    expect_be(63, typed.data[0]);
+    expect_false(darray_u32_swap_remove(&typed, 63, &value));
+
+    // The last element pops without reading past the end
+    expect_true(darray_u32_pop_at(&typed, 62, &value));
+    expect_be(62, value);
+    expect_be(62, typed.base.length);
+
+    u32 divisor = 3;
+    expect_be(21, darray_u32_remove_if(&typed, is_multiple_of, &divisor));
+    expect_be(41, typed.base.length);
+    for (u32 i = 0; i < typed.base.length; ++i) {
+        expect_not_be(0, typed.data[i] % 3);
+    }
+    expect_be(1, typed.data[0]);
+    expect_be(2, typed.data[1]);
+    expect_be(61, typed.data[40]);
+
+    darray_u32_destroy(&typed);
+
+    return true;
+}
+
 void darray_register_tests(void) {
     test_manager_register_test(all_darray_tests_after_create, "All darray tests after create");
     test_manager_register_test(all_darray_tests_after_reserve_3, "All darray tests after reserve(3)");
@@ -1227,4 +1375,6 @@ void darray_register_tests(void) {
     test_manager_register_test(darray_all_iterator_tests, "All darray iterator tests");
     test_manager_register_test(darray_string_type_test, "darray string type tests");
     test_manager_register_test(darray_float_type_test, "darray float type tests");
+    test_manager_register_test(darray_uninitialized_flag_test, "darray uninitialized flag");
+    test_manager_register_test(darray_bulk_operations_test, "darray bulk append, insert and remove");
 }
\ No newline at end of file
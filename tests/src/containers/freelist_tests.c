@@ -325,7 +325,7 @@ u8 util_freelist_free(freelist* list, alloc_data* data, u64* currently_allocated
     return true;
 }
 
-u8 freelist_multiple_alloc_and_free_random(void) {
+static u8 util_freelist_random_alloc_and_free(freelist_flags flags) {
     freelist list;
 
     // Pick random sizes.
@@ -345,11 +345,11 @@ u8 freelist_multiple_alloc_and_free_random(void) {
 
     // Get the memory requirement
     u64 memory_requirement = 0;
-    freelist_create(total_size, &memory_requirement, 0, 0);
+    freelist_create_with_flags(total_size, flags, &memory_requirement, 0, 0);
 
     // Allocate and create the freelist.
     void* block = memory_allocate(memory_requirement, MEMORY_TAG_ENGINE);
-    freelist_create(total_size, &memory_requirement, block, &list);
+    freelist_create_with_flags(total_size, flags, &memory_requirement, block, &list);
 
     // Verify free space.
     u64 free_space = freelist_free_space(&list);
@@ -410,6 +410,217 @@ u8 freelist_multiple_alloc_and_free_random(void) {
     return true;
 }
 
+u8 freelist_multiple_alloc_and_free_random(void) {
+    return util_freelist_random_alloc_and_free(FREELIST_FLAG_NONE_BIT);
+}
+
+u8 freelist_best_fit_multiple_alloc_and_free_random(void) {
+    return util_freelist_random_alloc_and_free(FREELIST_FLAG_BEST_FIT_BIT);
+}
+
+u8 freelist_best_fit_should_pick_tightest_range(void) {
+    freelist list;
+
+    u64 memory_requirement = 0;
+    u64 total_size = 1024;
+    freelist_create_with_flags(total_size, FREELIST_FLAG_BEST_FIT_BIT, &memory_requirement, 0, 0);
+
+    void* block = memory_allocate(memory_requirement, MEMORY_TAG_ENGINE);
+    freelist_create_with_flags(total_size, FREELIST_FLAG_BEST_FIT_BIT, &memory_requirement, block, &list);
+
+    // Lay out 128, 32, 64 and 32 byte blocks, then free the 128 and 64 byte ones.
+    u64 offsets[4] = {0};
+    u64 sizes[4] = {128, 32, 64, 32};
+    for (u32 i = 0; i < 4; ++i) {
+        expect_true(freelist_allocate_block(&list, sizes[i], &offsets[i]));
+    }
+    expect_be(160, offsets[2]);
+    expect_true(freelist_free_block(&list, sizes[0], offsets[0]));
+    expect_true(freelist_free_block(&list, sizes[2], offsets[2]));
+
+    // First fit would take the hole at 0, best fit takes the 64 byte hole.
+    u64 offset = INVALID_ID;
+    expect_true(freelist_allocate_block(&list, 60, &offset));
+    expect_be(160, offset);
+
+    // An exact fit consumes the whole 128 byte hole.
+    expect_true(freelist_allocate_block(&list, 128, &offset));
+    expect_be(0, offset);
+    expect_be(total_size - 128 - 32 - 60 - 32, freelist_free_space(&list));
+
+    // Freeing everything merges back into a single range that fits the whole list.
+    expect_true(freelist_free_block(&list, 128, 0));
+    expect_true(freelist_free_block(&list, 60, 160));
+    expect_true(freelist_free_block(&list, sizes[1], offsets[1]));
+    expect_true(freelist_free_block(&list, sizes[3], offsets[3]));
+    expect_true(freelist_allocate_block(&list, total_size, &offset));
+    expect_be(0, offset);
+
+    freelist_destroy(&list);
+    expect_be(0, list.memory);
+    memory_free(block, memory_requirement, MEMORY_TAG_ENGINE);
+    return true;
+}
+
+u8 freelist_should_allocate_block_at_offset(void) {
+    freelist list;
+
+    u64 memory_requirement = 0;
+    u64 total_size = 512;
+    freelist_create(total_size, &memory_requirement, 0, 0);
+    void* block = memory_allocate(memory_requirement, MEMORY_TAG_ENGINE);
+    freelist_create(total_size, &memory_requirement, block, &list);
+
+    // Claim a range in the middle, splitting the free space in two.
+    expect_true(freelist_allocate_block_at(&list, 64, 128));
+    expect_be(total_size - 64, freelist_free_space(&list));
+
+    // Overlapping ranges can't be claimed.
+    expect_false(freelist_allocate_block_at(&list, 64, 160));
+    expect_false(freelist_allocate_block_at(&list, 64, 96));
+
+    // Ranges touching either side of the claimed one can.
+    expect_true(freelist_allocate_block_at(&list, 32, 96));
+    expect_true(freelist_allocate_block_at(&list, 32, 192));
+    expect_be(total_size - 128, freelist_free_space(&list));
+
+    // A regular allocation still takes the lowest free offset.
+    u64 offset = INVALID_ID;
+    expect_true(freelist_allocate_block(&list, 96, &offset));
+    expect_be(0, offset);
+
+    expect_true(freelist_free_block(&list, 96, 0));
+    expect_true(freelist_free_block(&list, 128, 96));
+    expect_be(total_size, freelist_free_space(&list));
+    expect_true(freelist_allocate_block_at(&list, total_size, 0));
+
+    freelist_destroy(&list);
+    memory_free(block, memory_requirement, MEMORY_TAG_ENGINE);
+    return true;
+}
+
+u8 freelist_should_report_fragmentation(void) {
+    freelist list;
+    u64 memory_requirement = 0;
+    u64 total_size = 1024;
+    freelist_create(total_size, &memory_requirement, 0, 0);
+    void* block = memory_allocate(memory_requirement, MEMORY_TAG_ENGINE);
+    freelist_create(total_size, &memory_requirement, block, &list);
+
+    freelist_fragmentation fragmentation;
+    expect_true(freelist_get_fragmentation(&list, &fragmentation));
+    expect_be(1, fragmentation.free_range_count);
+    expect_be(total_size, fragmentation.largest_free_range);
+    expect_true(fragmentation.external_fragmentation == 0.0f);
+
+    // Eight 64 byte blocks, then punch three holes between them.
+    u64 offsets[8];
+    for (u32 i = 0; i < 8; ++i) {
+        expect_true(freelist_allocate_block(&list, 64, &offsets[i]));
+    }
+    for (u32 i = 1; i < 8; i += 2) {
+        if (i != 7) {
+            expect_true(freelist_free_block(&list, 64, offsets[i]));
+        }
+    }
+
+    expect_true(freelist_get_fragmentation(&list, &fragmentation));
+    expect_be(704, fragmentation.free_space);
+    expect_be(4, fragmentation.free_range_count);
+    expect_be(512, fragmentation.largest_free_range);
+    expect_be(3, fragmentation.range_histogram[6]);
+    expect_be(1, fragmentation.range_histogram[9]);
+    f32 expected = 1.0f - 512.0f / 704.0f;
+    expect_true(fragmentation.external_fragmentation > expected - 0.001f && fragmentation.external_fragmentation < expected + 0.001f);
+
+    // Closing the holes brings it back to a single range.
+    for (u32 i = 0; i < 8; i += 2) {
+        expect_true(freelist_free_block(&list, 64, offsets[i]));
+    }
+    expect_true(freelist_free_block(&list, 64, offsets[7]));
+    expect_true(freelist_get_fragmentation(&list, &fragmentation));
+    expect_be(1, fragmentation.free_range_count);
+    expect_be(1, fragmentation.range_histogram[10]);
+    expect_true(fragmentation.external_fragmentation == 0.0f);
+
+    freelist_destroy(&list);
+    memory_free(block, memory_requirement, MEMORY_TAG_ENGINE);
+    return true;
+}
+
+u8 freelist_should_allocate_aligned_blocks(void) {
+    freelist list;
+    u64 memory_requirement = 0;
+    u64 total_size = 4096;
+    freelist_create(total_size, &memory_requirement, 0, 0);
+    void* block = memory_allocate(memory_requirement, MEMORY_TAG_ENGINE);
+    freelist_create(total_size, &memory_requirement, block, &list);
+
+    u64 first = INVALID_ID_U64;
+    expect_true(freelist_allocate_block(&list, 10, &first));
+    expect_be(0, first);
+
+    // The padding before and after the block goes back to the list.
+    u64 aligned = INVALID_ID_U64;
+    expect_true(freelist_allocate_block_aligned(&list, 100, 256, &aligned));
+    expect_be(256, aligned);
+    expect_be(total_size - 110, freelist_free_space(&list));
+
+    // The hole left before the aligned block is still usable.
+    u64 small = INVALID_ID_U64;
+    expect_true(freelist_allocate_block_aligned(&list, 16, 16, &small));
+    expect_be(16, small);
+
+    expect_true(freelist_free_block(&list, 100, aligned));
+    expect_true(freelist_free_block(&list, 16, small));
+    expect_true(freelist_free_block(&list, 10, first));
+    expect_be(total_size, freelist_free_space(&list));
+
+    freelist_fragmentation fragmentation;
+    expect_true(freelist_get_fragmentation(&list, &fragmentation));
+    expect_be(1, fragmentation.free_range_count);
+
+    freelist_destroy(&list);
+    memory_free(block, memory_requirement, MEMORY_TAG_ENGINE);
+    return true;
+}
+
+u8 freelist_should_allocate_aligned_blocks_from_exact_ranges(void) {
+    // A dedicated device memory block, counted in 256 byte units and sized exactly for a request larger than
+    // a 64 MiB block, which must still take the request at a 64 KiB alignment
+    freelist list;
+    u64 memory_requirement = 0;
+    u64 total_size = MEBIBYTES(80) / 256;
+    freelist_create_with_flags(total_size, FREELIST_FLAG_BEST_FIT_BIT, &memory_requirement, 0, 0);
+    void* block = memory_allocate(memory_requirement, MEMORY_TAG_ENGINE);
+    freelist_create_with_flags(total_size, FREELIST_FLAG_BEST_FIT_BIT, &memory_requirement, block, &list);
+
+    u64 offset = INVALID_ID_U64;
+    expect_true(freelist_allocate_block_aligned(&list, total_size, KIBIBYTES(64) / 256, &offset));
+    expect_be(0, offset);
+    expect_be(0, freelist_free_space(&list));
+    expect_true(freelist_free_block(&list, total_size, offset));
+
+    // Only [32, 48) is free. It is too small for the size plus the worst case padding, but starts aligned
+    expect_true(freelist_allocate_block_at(&list, 32, 0));
+    expect_true(freelist_allocate_block_at(&list, total_size - 48, 48));
+    expect_true(freelist_allocate_block_aligned(&list, 16, 32, &offset));
+    expect_be(32, offset);
+    expect_be(0, freelist_free_space(&list));
+
+    // [40, 56) holds no 16 units at a multiple of 32
+    expect_true(freelist_free_block(&list, 16, 32));
+    expect_true(freelist_free_block(&list, 8, 48));
+    expect_true(freelist_allocate_block_at(&list, 8, 32));
+    expect_false(freelist_allocate_block_aligned(&list, 16, 32, &offset));
+    expect_true(freelist_allocate_block_aligned(&list, 8, 8, &offset));
+    expect_be(40, offset);
+
+    freelist_destroy(&list);
+    memory_free(block, memory_requirement, MEMORY_TAG_ENGINE);
+    return true;
+}
+
 void freelist_register_tests(void) {
     test_manager_register_test(freelist_should_create_and_destroy, "Freelist should create and destroy");
     test_manager_register_test(freelist_should_allocate_one_and_free_one, "Freelist allocate and free one entry.");
@@ -417,4 +628,10 @@ void freelist_register_tests(void) {
     test_manager_register_test(freelist_should_allocate_one_and_free_multi_varying_sizes, "Freelist allocate and free multiple entries of varying sizes.");
     test_manager_register_test(freelist_should_allocate_to_full_and_fail_to_allocate_more, "Freelist allocate to full and fail when trying to allocate more.");
     test_manager_register_test(freelist_multiple_alloc_and_free_random, "Freelist should randomly allocate and free.");
+    test_manager_register_test(freelist_should_allocate_block_at_offset, "Freelist should allocate a block at a given offset.");
+    test_manager_register_test(freelist_best_fit_should_pick_tightest_range, "Freelist best fit should pick the tightest range.");
+    test_manager_register_test(freelist_best_fit_multiple_alloc_and_free_random, "Freelist best fit should randomly allocate and free.");
+    test_manager_register_test(freelist_should_report_fragmentation, "Freelist should report fragmentation.");
+    test_manager_register_test(freelist_should_allocate_aligned_blocks, "Freelist should allocate aligned blocks.");
+    test_manager_register_test(freelist_should_allocate_aligned_blocks_from_exact_ranges, "Freelist should allocate aligned blocks from ranges without room for padding.");
 }
\ No newline at end of file
@@ -4,14 +4,14 @@
 
 #include <defines.h>
 #include <containers/hashtable.h>
+#include <strings/string.h>
 
 u8 hashtable_should_create_and_destroy(void) {
     hashtable table;
     u64 element_size = sizeof(u64);
     u64 element_count = 3;
-    u64 memory[3];
 
-    hashtable_create(element_size, element_count, false, memory, &table);
+    hashtable_create(element_size, element_count, false, &table);
 
     expect_not_be(0, table.memory);
     expect_be(sizeof(u64), table.element_size);
@@ -30,9 +30,8 @@ u8 hashtable_should_set_and_get_successfully(void) {
     hashtable table;
     u64 element_size = sizeof(u64);
     u64 element_count = 3;
-    u64 memory[3];
 
-    hashtable_create(element_size, element_count, false, memory, &table);
+    hashtable_create(element_size, element_count, false, &table);
 
     expect_not_be(0, table.memory);
     expect_be(sizeof(u64), table.element_size);
@@ -63,9 +62,8 @@ u8 hashtable_should_set_and_get_ptr_successfully(void) {
     hashtable table;
     u64 element_size = sizeof(ht_test_struct*);
     u64 element_count = 3;
-    ht_test_struct* memory[3];
 
-    hashtable_create(element_size, element_count, true, memory, &table);
+    hashtable_create(element_size, element_count, true, &table);
 
     expect_not_be(0, table.memory);
     expect_be(sizeof(ht_test_struct*), table.element_size);
@@ -97,9 +95,8 @@ u8 hashtable_should_set_and_get_nonexistant(void) {
     hashtable table;
     u64 element_size = sizeof(u64);
     u64 element_count = 3;
-    u64 memory[3];
 
-    hashtable_create(element_size, element_count, false, memory, &table);
+    hashtable_create(element_size, element_count, false, &table);
 
     expect_not_be(0, table.memory);
     expect_be(sizeof(u64), table.element_size);
@@ -124,9 +121,8 @@ u8 hashtable_should_set_and_get_ptr_nonexistant(void) {
     hashtable table;
     u64 element_size = sizeof(ht_test_struct*);
     u64 element_count = 3;
-    ht_test_struct* memory[3];
 
-    hashtable_create(element_size, element_count, true, memory, &table);
+    hashtable_create(element_size, element_count, true, &table);
 
     expect_not_be(0, table.memory);
     expect_be(sizeof(ht_test_struct*), table.element_size);
@@ -158,9 +154,8 @@ u8 hashtable_should_set_and_unset_ptr(void) {
     hashtable table;
     u64 element_size = sizeof(ht_test_struct*);
     u64 element_count = 3;
-    ht_test_struct* memory[3];
 
-    hashtable_create(element_size, element_count, true, memory, &table);
+    hashtable_create(element_size, element_count, true, &table);
 
     expect_not_be(0, table.memory);
     expect_be(sizeof(ht_test_struct*), table.element_size);
@@ -204,9 +199,8 @@ u8 hashtable_try_call_non_ptr_on_ptr_table(void) {
     hashtable table;
     u64 element_size = sizeof(ht_test_struct*);
     u64 element_count = 3;
-    ht_test_struct* memory[3];
 
-    hashtable_create(element_size, element_count, true, memory, &table);
+    hashtable_create(element_size, element_count, true, &table);
 
     expect_not_be(0, table.memory);
     expect_be(sizeof(ht_test_struct*), table.element_size);
@@ -240,9 +234,8 @@ u8 hashtable_try_call_ptr_on_non_ptr_table(void) {
     hashtable table;
     u64 element_size = sizeof(ht_test_struct);
     u64 element_count = 3;
-    ht_test_struct memory[3];
 
-    hashtable_create(element_size, element_count, false, memory, &table);
+    hashtable_create(element_size, element_count, false, &table);
 
     expect_not_be(0, table.memory);
     expect_be(sizeof(ht_test_struct), table.element_size);
@@ -277,9 +270,8 @@ u8 hashtable_should_set_get_and_update_ptr_successfully(void) {
     hashtable table;
     u64 element_size = sizeof(ht_test_struct*);
     u64 element_count = 3;
-    ht_test_struct* memory[3];
 
-    hashtable_create(element_size, element_count, true, memory, &table);
+    hashtable_create(element_size, element_count, true, &table);
 
     expect_not_be(0, table.memory);
     expect_be(sizeof(ht_test_struct*), table.element_size);
@@ -318,6 +310,80 @@ u8 hashtable_should_set_get_and_update_ptr_successfully(void) {
     return true;
 }
 
+static void make_key(char* dst, u64 i) {
+    cstr_append_int(dst, "key_", (i64)i);
+}
+
+u8 hashtable_should_grow_and_keep_every_key(void) {
+    hashtable table;
+    hashtable_create(sizeof(u64), 4, false, &table);
+
+    // Far more keys than the table was sized for, so it has to grow and keys share groups
+    char key[32];
+    const u64 key_count = 5000;
+    for (u64 i = 0; i < key_count; ++i) {
+        make_key(key, i);
+        u64 value = i * 3;
+        expect_true(hashtable_set(&table, key, &value));
+    }
+    expect_be(key_count, table.count);
+    expect_true(table.element_count >= key_count);
+
+    for (u64 i = 0; i < key_count; ++i) {
+        make_key(key, i);
+        u64 value = 0;
+        expect_true(hashtable_get(&table, key, &value));
+        expect_be(i * 3, value);
+    }
+
+    // Overwriting keeps the count
+    u64 updated = 7;
+    expect_true(hashtable_set(&table, "key_10", &updated));
+    expect_be(key_count, table.count);
+    u64 value = 0;
+    hashtable_get(&table, "key_10", &value);
+    expect_be(7, value);
+
+    hashtable_destroy(&table);
+    return true;
+}
+
+u8 hashtable_should_remove_keys(void) {
+    hashtable table;
+    hashtable_create(sizeof(u64), 64, false, &table);
+
+    char key[32];
+    // Churn through many more keys than are ever stored at once, which reuses deleted slots and key storage
+    for (u64 round = 0; round < 50; ++round) {
+        for (u64 i = 0; i < 40; ++i) {
+            make_key(key, round * 40 + i);
+            expect_true(hashtable_set(&table, key, &i));
+        }
+        for (u64 i = 0; i < 40; i += 2) {
+            make_key(key, round * 40 + i);
+            expect_true(hashtable_remove(&table, key));
+            expect_false(hashtable_remove(&table, key));
+        }
+    }
+    expect_be(50 * 20, table.count);
+
+    for (u64 i = 0; i < 50 * 40; ++i) {
+        make_key(key, i);
+        u64 value = U64_MAX;
+        b8 found = hashtable_get(&table, key, &value);
+        if (i % 2) {
+            expect_true(found);
+            expect_be(i % 40, value);
+        } else {
+            expect_false(found);
+            expect_be(U64_MAX, value);
+        }
+    }
+
+    hashtable_destroy(&table);
+    return true;
+}
+
 void hashtable_register_tests(void) {
     test_manager_register_test(hashtable_should_create_and_destroy, "Hashtable should create and destroy");
     test_manager_register_test(hashtable_should_set_and_get_successfully, "Hashtable should set and get");
@@ -328,4 +394,6 @@ void hashtable_register_tests(void) {
     test_manager_register_test(hashtable_try_call_non_ptr_on_ptr_table, "Hashtable try calling non-pointer functions on pointer type table.");
     test_manager_register_test(hashtable_try_call_ptr_on_non_ptr_table, "Hashtable try calling pointer functions on non-pointer type table.");
     test_manager_register_test(hashtable_should_set_get_and_update_ptr_successfully, "Hashtable Should get pointer, update, and get again successfully.");
+    test_manager_register_test(hashtable_should_grow_and_keep_every_key, "Hashtable should grow and keep every key.");
+    test_manager_register_test(hashtable_should_remove_keys, "Hashtable should remove keys and reuse their slots.");
 }
\ No newline at end of file
@@ -0,0 +1,286 @@
+#include "mpmc_queue_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+#include <containers/mpmc_queue.h>
+#include <core/logger.h>
+#include <platform/platform.h>
+#include <threads/atomic.h>
+#include <threads/thread.h>
+
+#define MPMC_PRODUCERS 3
+#define MPMC_CONSUMERS 3
+#define MPMC_ITEMS_PER_PRODUCER 50000
+#define MPMC_BLOCKING_ITEMS_PER_PRODUCER 10000
+// Long enough that only a notify that never comes runs into it
+#define MPMC_WAIT_DEADLINE 0.5
+
+// Producer index in the top bits, sequence in the rest
+#define MPMC_ITEM(producer, sequence) (((u64)(producer) << 32) | (sequence))
+
+typedef struct mpmc_worker {
+    mpmc_queue* queue;
+    volatile u32* start;
+    u32 index;
+    u64 received;
+    u64 sum;
+    // Items from one producer that arrived out of the order they were pushed in
+    u32 reordered;
+} mpmc_worker;
+
+static mpmc_worker mpmc_producers[MPMC_PRODUCERS];
+static mpmc_worker mpmc_consumers[MPMC_CONSUMERS];
+
+static void mpmc_test_wait(void* context) {
+    platform_sleep(0);
+}
+
+// One side's hook. notify bumps the generation, which releases every thread waiting on it
+typedef struct mpmc_test_event {
+    volatile u32 generation;
+    volatile u32 notifies;
+    volatile u32 stalls;
+} mpmc_test_event;
+
+// The generation this thread last woke up on. Each test thread only waits on one event
+static MTHREAD_LOCAL u32 mpmc_seen_generation;
+
+static void mpmc_event_wait(void* context) {
+    mpmc_test_event* event = context;
+    // After the first stall the test has failed, so the rest of the run only polls
+    if (atomic_u32_load(&event->stalls)) {
+        platform_sleep(0);
+        return;
+    }
+    f64 deadline = platform_get_absolute_time() + MPMC_WAIT_DEADLINE;
+    u32 generation;
+    while ((generation = atomic_u32_load(&event->generation)) == mpmc_seen_generation) {
+        if (platform_get_absolute_time() > deadline) {
+            atomic_u32_fetch_add(&event->stalls, 1);
+            break;
+        }
+        platform_sleep(0);
+    }
+    mpmc_seen_generation = generation;
+}
+
+static void mpmc_event_notify(void* context) {
+    mpmc_test_event* event = context;
+    atomic_u32_fetch_add(&event->notifies, 1);
+    atomic_u32_fetch_add(&event->generation, 1);
+}
+
+u8 mpmc_queue_should_push_and_pop_in_order(void) {
+    mpmc_queue q;
+    MDEBUG("The following error message is intentional.");
+    expect_false(mpmc_queue_create(sizeof(u32), 6, &q));
+    // 12 bytes, so the cells are padded
+    expect_true(mpmc_queue_create(12, 4, &q));
+
+    u32 value[3] = {0};
+    expect_false(mpmc_queue_try_pop(&q, value));
+
+    // Several laps around the ring, filling it each time
+    b8 ordered = true;
+    for (u32 lap = 0; lap < 3; ++lap) {
+        for (u32 i = 0; i < 4; ++i) {
+            u32 item[3] = { lap, i, lap * i };
+            ordered = ordered && mpmc_queue_try_push(&q, item);
+        }
+        u32 item[3] = {0};
+        ordered = ordered && !mpmc_queue_try_push(&q, item);
+        ordered = ordered && mpmc_queue_length(&q) == 4;
+        for (u32 i = 0; i < 4; ++i) {
+            ordered = ordered && mpmc_queue_try_pop(&q, value) && value[0] == lap && value[1] == i && value[2] == lap * i;
+        }
+        ordered = ordered && !mpmc_queue_try_pop(&q, value);
+    }
+    expect_true(ordered);
+    expect_be(0, mpmc_queue_length(&q));
+
+    mpmc_queue_destroy(&q);
+    expect_be(0, q.cells);
+    return true;
+}
+
+static u32 mpmc_producer_thread(void* args) {
+    mpmc_worker* worker = args;
+    while (!atomic_u32_load(worker->start)) {
+        atomic_spin_pause();
+    }
+
+    for (u32 i = 0; i < MPMC_ITEMS_PER_PRODUCER; ++i) {
+        u64 item = MPMC_ITEM(worker->index, i);
+        // Alternates the blocking and the try variants
+        if (i % 2) {
+            mpmc_queue_push(worker->queue, &item);
+        } else {
+            while (!mpmc_queue_try_push(worker->queue, &item)) {
+                platform_sleep(0);
+            }
+        }
+    }
+    return 0;
+}
+
+static u32 mpmc_consumer_thread(void* args) {
+    mpmc_worker* worker = args;
+    while (!atomic_u32_load(worker->start)) {
+        atomic_spin_pause();
+    }
+
+    u64 last_sequence[MPMC_PRODUCERS];
+    b8 seen[MPMC_PRODUCERS] = {0};
+    // Every consumer takes an equal share, so none of them blocks forever on an empty queue
+    for (u32 i = 0; i < MPMC_PRODUCERS * MPMC_ITEMS_PER_PRODUCER / MPMC_CONSUMERS; ++i) {
+        u64 item;
+        mpmc_queue_pop(worker->queue, &item);
+        u32 producer = (u32)(item >> 32);
+        u64 sequence = item & 0xFFFFFFFF;
+        if (seen[producer] && sequence <= last_sequence[producer]) {
+            worker->reordered++;
+        }
+        seen[producer] = true;
+        last_sequence[producer] = sequence;
+        worker->sum += item;
+        worker->received++;
+    }
+    return 0;
+}
+
+u8 mpmc_queue_should_deliver_every_item_once_across_threads(void) {
+    mpmc_queue q;
+    // Small, so producers keep finding it full and consumers keep finding it empty
+    expect_true(mpmc_queue_create(sizeof(u64), 16, &q));
+    ring_queue_wait_hooks hooks = { mpmc_test_wait, nullptr, nullptr };
+    mpmc_queue_set_wait_hooks(&q, &hooks, &hooks);
+
+    volatile u32 start = 0;
+    thread producers[MPMC_PRODUCERS];
+    thread consumers[MPMC_CONSUMERS];
+    for (u32 i = 0; i < MPMC_CONSUMERS; ++i) {
+        mpmc_consumers[i] = (mpmc_worker){ &q, &start, i, 0, 0, 0 };
+        expect_true(thread_create(mpmc_consumer_thread, &mpmc_consumers[i], false, &consumers[i]));
+    }
+    for (u32 i = 0; i < MPMC_PRODUCERS; ++i) {
+        mpmc_producers[i] = (mpmc_worker){ &q, &start, i, 0, 0, 0 };
+        expect_true(thread_create(mpmc_producer_thread, &mpmc_producers[i], false, &producers[i]));
+    }
+    atomic_u32_store(&start, 1);
+    for (u32 i = 0; i < MPMC_PRODUCERS; ++i) {
+        thread_wait(&producers[i]);
+        thread_destroy(&producers[i]);
+    }
+    for (u32 i = 0; i < MPMC_CONSUMERS; ++i) {
+        thread_wait(&consumers[i]);
+        thread_destroy(&consumers[i]);
+    }
+
+    // Lost or duplicated items show up in the count or the sum
+    u64 expected_sum = 0;
+    for (u64 p = 0; p < MPMC_PRODUCERS; ++p) {
+        expected_sum += (p << 32) * MPMC_ITEMS_PER_PRODUCER + (u64)MPMC_ITEMS_PER_PRODUCER * (MPMC_ITEMS_PER_PRODUCER - 1) / 2;
+    }
+    u64 received = 0;
+    u64 sum = 0;
+    for (u32 i = 0; i < MPMC_CONSUMERS; ++i) {
+        received += mpmc_consumers[i].received;
+        sum += mpmc_consumers[i].sum;
+        expect_be(0, mpmc_consumers[i].reordered);
+    }
+    expect_be(MPMC_PRODUCERS * MPMC_ITEMS_PER_PRODUCER, received);
+    expect_be(expected_sum, sum);
+    expect_be(0, mpmc_queue_length(&q));
+
+    mpmc_queue_destroy(&q);
+    return true;
+}
+
+static u32 mpmc_blocking_producer_thread(void* args) {
+    mpmc_worker* worker = args;
+    for (u32 i = 0; i < MPMC_BLOCKING_ITEMS_PER_PRODUCER; ++i) {
+        u64 item = MPMC_ITEM(worker->index, i);
+        mpmc_queue_push(worker->queue, &item);
+    }
+    return 0;
+}
+
+static u32 mpmc_blocking_consumer_thread(void* args) {
+    mpmc_worker* worker = args;
+    for (u32 i = 0; i < MPMC_PRODUCERS * MPMC_BLOCKING_ITEMS_PER_PRODUCER / MPMC_CONSUMERS; ++i) {
+        u64 item;
+        mpmc_queue_pop(worker->queue, &item);
+        worker->sum += item;
+        worker->received++;
+    }
+    return 0;
+}
+
+u8 mpmc_queue_should_wake_blocked_threads_through_separate_hooks(void) {
+    static mpmc_test_event not_full;
+    static mpmc_test_event not_empty;
+    not_full = (mpmc_test_event){0};
+    not_empty = (mpmc_test_event){0};
+    mpmc_queue q;
+    // Tiny, so producers and consumers keep blocking on their own hook
+    expect_true(mpmc_queue_create(sizeof(u64), 2, &q));
+    ring_queue_wait_hooks not_full_hooks = { mpmc_event_wait, mpmc_event_notify, &not_full };
+    ring_queue_wait_hooks not_empty_hooks = { mpmc_event_wait, mpmc_event_notify, &not_empty };
+    mpmc_queue_set_wait_hooks(&q, &not_full_hooks, &not_empty_hooks);
+
+    // Nobody waits, so nothing is notified
+    u64 item = 0;
+    for (u32 i = 0; i < 8; ++i) {
+        mpmc_queue_push(&q, &item);
+        mpmc_queue_pop(&q, &item);
+    }
+    expect_be(0, not_full.notifies);
+    expect_be(0, not_empty.notifies);
+
+    thread producers[MPMC_PRODUCERS];
+    thread consumers[MPMC_CONSUMERS];
+    for (u32 i = 0; i < MPMC_CONSUMERS; ++i) {
+        mpmc_consumers[i] = (mpmc_worker){ &q, nullptr, i, 0, 0, 0 };
+        expect_true(thread_create(mpmc_blocking_consumer_thread, &mpmc_consumers[i], false, &consumers[i]));
+    }
+    for (u32 i = 0; i < MPMC_PRODUCERS; ++i) {
+        mpmc_producers[i] = (mpmc_worker){ &q, nullptr, i, 0, 0, 0 };
+        expect_true(thread_create(mpmc_blocking_producer_thread, &mpmc_producers[i], false, &producers[i]));
+    }
+    for (u32 i = 0; i < MPMC_PRODUCERS; ++i) {
+        thread_wait(&producers[i]);
+        thread_destroy(&producers[i]);
+    }
+    for (u32 i = 0; i < MPMC_CONSUMERS; ++i) {
+        thread_wait(&consumers[i]);
+        thread_destroy(&consumers[i]);
+    }
+
+    u64 expected_sum = 0;
+    for (u64 p = 0; p < MPMC_PRODUCERS; ++p) {
+        expected_sum += (p << 32) * MPMC_BLOCKING_ITEMS_PER_PRODUCER + (u64)MPMC_BLOCKING_ITEMS_PER_PRODUCER * (MPMC_BLOCKING_ITEMS_PER_PRODUCER - 1) / 2;
+    }
+    u64 received = 0;
+    u64 sum = 0;
+    for (u32 i = 0; i < MPMC_CONSUMERS; ++i) {
+        received += mpmc_consumers[i].received;
+        sum += mpmc_consumers[i].sum;
+    }
+    expect_be(MPMC_PRODUCERS * MPMC_BLOCKING_ITEMS_PER_PRODUCER, received);
+    expect_be(expected_sum, sum);
+    // Every wait was ended by a notify, not the deadline
+    expect_be(0, not_full.stalls);
+    expect_be(0, not_empty.stalls);
+    expect_be(0, q.push_waiters);
+    expect_be(0, q.pop_waiters);
+
+    mpmc_queue_destroy(&q);
+    return true;
+}
+
+void mpmc_queue_register_tests(void) {
+    test_manager_register_test(mpmc_queue_should_push_and_pop_in_order, "MPMC queue should push and pop in order");
+    test_manager_register_test(mpmc_queue_should_deliver_every_item_once_across_threads, "MPMC queue should deliver every item once across threads");
+    test_manager_register_test(mpmc_queue_should_wake_blocked_threads_through_separate_hooks, "MPMC queue should wake blocked threads through separate hooks");
+}
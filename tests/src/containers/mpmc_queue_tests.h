@@ -0,0 +1,3 @@
+#pragma once
+
+void mpmc_queue_register_tests(void);
\ No newline at end of file
@@ -0,0 +1,112 @@
+#include "queue_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+#include <containers/queue.h>
+#include <core/logger.h>
+
+// 12 bytes, so slots are not a multiple of 8 bytes apart
+typedef struct queue_test_item {
+    u32 a;
+    u32 b;
+    u32 c;
+} queue_test_item;
+
+u8 queue_should_keep_order_across_wrap_and_growth(void) {
+    queue q;
+    expect_true(queue_create(sizeof(queue_test_item), &q));
+    u32 initial_capacity = q.capacity;
+
+    // Moves the head away from slot 0, so the queue wraps before it fills up and then grows while wrapped
+    u32 next_push = 0;
+    u32 next_pop = 0;
+    for (u32 i = 0; i < initial_capacity / 2 + 1; ++i) {
+        queue_test_item item = { next_push, next_push * 2, next_push * 3 };
+        expect_true(queue_push(&q, &item));
+        next_push++;
+    }
+    queue_test_item item;
+    for (u32 i = 0; i < initial_capacity / 2; ++i) {
+        expect_true(queue_pop(&q, &item));
+        next_pop++;
+    }
+
+    b8 ordered = true;
+    for (u32 round = 0; round < 1000; ++round) {
+        // Pushes three for every two pops, so the queue keeps growing while wrapped
+        for (u32 i = 0; i < 3; ++i) {
+            item = (queue_test_item){ next_push, next_push * 2, next_push * 3 };
+            ordered = ordered && queue_push(&q, &item);
+            next_push++;
+        }
+        for (u32 i = 0; i < 2; ++i) {
+            ordered = ordered && queue_pop(&q, &item) && item.a == next_pop && item.b == next_pop * 2 && item.c == next_pop * 3;
+            next_pop++;
+        }
+    }
+    expect_true(ordered);
+    expect_be(next_push - next_pop, q.count);
+    expect_true(q.capacity > initial_capacity);
+    expect_be(0, q.capacity & (q.capacity - 1));
+
+    expect_true(queue_peek(&q, &item));
+    expect_be(next_pop, item.a);
+    while (q.count) {
+        ordered = ordered && queue_pop(&q, &item) && item.a == next_pop++;
+    }
+    expect_true(ordered);
+
+    MDEBUG("The following warning message is intentional.");
+    expect_false(queue_pop(&q, &item));
+
+    queue_destroy(&q);
+    expect_be(0, q.memory);
+    return true;
+}
+
+u8 queue_should_push_and_pop_ranges(void) {
+    queue q;
+    expect_true(queue_create(sizeof(u32), &q));
+    queue_reserve(&q, 100);
+    expect_true(q.capacity >= 100);
+
+    u32 values[300];
+    for (u32 i = 0; i < 300; ++i) {
+        values[i] = i;
+    }
+
+    // Leaves the head near the end of the buffer, so the ranges below wrap
+    u32 capacity = q.capacity;
+    expect_true(queue_push_range(&q, values, capacity - 5));
+    u32 out[300];
+    expect_be(capacity - 5, queue_pop_range(&q, out, capacity - 5));
+    expect_be(capacity - 6, out[capacity - 6]);
+
+    expect_true(queue_push_range(&q, values, 20));
+    expect_be(capacity, q.capacity);
+    // Grows while wrapped
+    expect_true(queue_push_range(&q, &values[20], 280));
+    expect_be(300, q.count);
+
+    expect_be(250, queue_pop_range(&q, out, 250));
+    b8 ordered = true;
+    for (u32 i = 0; i < 250; ++i) {
+        ordered = ordered && out[i] == i;
+    }
+    // Asking for more than is queued pops the rest
+    expect_be(50, queue_pop_range(&q, out, 300));
+    for (u32 i = 0; i < 50; ++i) {
+        ordered = ordered && out[i] == 250 + i;
+    }
+    expect_true(ordered);
+    expect_be(0, queue_pop_range(&q, out, 10));
+
+    queue_destroy(&q);
+    return true;
+}
+
+void queue_register_tests(void) {
+    test_manager_register_test(queue_should_keep_order_across_wrap_and_growth, "Queue should keep order across wrap and growth");
+    test_manager_register_test(queue_should_push_and_pop_ranges, "Queue should push and pop ranges");
+}
@@ -0,0 +1,226 @@
+#include "ring_queue_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+#include <containers/ring_queue.h>
+#include <core/logger.h>
+#include <platform/platform.h>
+#include <threads/atomic.h>
+#include <threads/thread.h>
+
+#define SPSC_ITEM_COUNT 200000
+#define SPSC_BATCH 7
+#define BLOCKING_ITEM_COUNT 50000
+// Long enough that only a notify that never comes runs into it
+#define BLOCKING_WAIT_DEADLINE 0.5
+
+typedef struct spsc_test_state {
+    ring_queue queue;
+    volatile u32 waits;
+    volatile u32 notifies;
+} spsc_test_state;
+
+static void spsc_test_wait(void* context) {
+    spsc_test_state* state = context;
+    atomic_u32_fetch_add(&state->waits, 1);
+    platform_sleep(0);
+}
+
+static void spsc_test_notify(void* context) {
+    spsc_test_state* state = context;
+    atomic_u32_fetch_add(&state->notifies, 1);
+}
+
+u8 ring_queue_should_wrap_with_any_capacity(void) {
+    ring_queue q;
+    // Not a power of two, so slots wrap through the modulo path
+    expect_true(ring_queue_create(sizeof(u32), 5, nullptr, &q));
+
+    u32 value = 0;
+    for (u32 i = 0; i < 3; ++i) {
+        expect_true(ring_queue_enqueue(&q, &i));
+    }
+    expect_true(ring_queue_dequeue(&q, &value));
+    expect_be(0, value);
+
+    u32 values[6] = { 3, 4, 5, 6, 7, 8 };
+    // Only 3 of the 6 fit, and they wrap past the end
+    expect_be(3, ring_queue_enqueue_range(&q, values, 6));
+    expect_be(5, ring_queue_length(&q));
+    MDEBUG("The following error message is intentional.");
+    expect_false(ring_queue_enqueue(&q, &values[3]));
+
+    expect_true(ring_queue_peek(&q, &value));
+    expect_be(1, value);
+    u32 out[8];
+    expect_be(5, ring_queue_dequeue_range(&q, out, 8));
+    b8 ordered = true;
+    for (u32 i = 0; i < 5; ++i) {
+        ordered = ordered && out[i] == i + 1;
+    }
+    expect_true(ordered);
+    expect_be(0, ring_queue_length(&q));
+
+    MDEBUG("The following error message is intentional.");
+    expect_false(ring_queue_dequeue(&q, &value));
+
+    // SPSC queues mask their counters, so they need a power of two
+    MDEBUG("The following error message is intentional.");
+    expect_false(ring_queue_create_with_flags(sizeof(u32), 5, nullptr, RING_QUEUE_FLAG_SPSC_BIT, &q));
+
+    ring_queue_destroy(&q);
+    return true;
+}
+
+static u32 spsc_producer(void* args) {
+    spsc_test_state* state = args;
+    // Alternates single and batched enqueues. A batch the full queue only partly took continues from where it stopped
+    u64 batch[SPSC_BATCH];
+    u64 next = 0;
+    while (next < SPSC_ITEM_COUNT) {
+        if (next % 2) {
+            ring_queue_enqueue_wait(&state->queue, &next);
+            next++;
+            continue;
+        }
+
+        u32 count = (u32)MMIN((u64)SPSC_BATCH, SPSC_ITEM_COUNT - next);
+        for (u32 i = 0; i < count; ++i) {
+            batch[i] = next + i;
+        }
+        u32 sent = ring_queue_enqueue_range(&state->queue, batch, count);
+        // A full queue blocks on the next element instead of spinning
+        if (!sent) {
+            ring_queue_enqueue_wait(&state->queue, &batch[0]);
+            sent = 1;
+        }
+        next += sent;
+    }
+    return 0;
+}
+
+u8 ring_queue_spsc_should_deliver_in_order(void) {
+    static spsc_test_state state;
+    state.waits = 0;
+    state.notifies = 0;
+    // Small, so the producer keeps running into a full queue
+    expect_true(ring_queue_create_with_flags(sizeof(u64), 64, nullptr, RING_QUEUE_FLAG_SPSC_BIT, &state.queue));
+    ring_queue_wait_hooks hooks = { spsc_test_wait, spsc_test_notify, &state };
+    ring_queue_set_wait_hooks(&state.queue, &hooks);
+
+    thread producer;
+    expect_true(thread_create(spsc_producer, &state, false, &producer));
+
+    // The consumer side mixes blocking single dequeues with batches
+    u64 expected = 0;
+    b8 ordered = true;
+    u64 out[16];
+    while (expected < SPSC_ITEM_COUNT) {
+        if (expected % 3 == 0) {
+            u64 value;
+            ordered = ordered && ring_queue_dequeue_wait(&state.queue, &value) && value == expected;
+            expected++;
+            continue;
+        }
+
+        u32 count = ring_queue_dequeue_range(&state.queue, out, 16);
+        if (!count) {
+            ring_queue_dequeue_wait(&state.queue, &out[0]);
+            count = 1;
+        }
+        for (u32 i = 0; i < count; ++i) {
+            ordered = ordered && out[i] == expected++;
+        }
+    }
+    thread_wait(&producer);
+    thread_destroy(&producer);
+
+    expect_true(ordered);
+    expect_be(SPSC_ITEM_COUNT, expected);
+    expect_be(0, ring_queue_length(&state.queue));
+    u64 value;
+    expect_false(ring_queue_dequeue(&state.queue, &value));
+    // The queue ran empty and full, so the hooks were told about it
+    expect_true(state.notifies > 0);
+
+    ring_queue_destroy(&state.queue);
+    return true;
+}
+
+typedef struct blocking_test_state {
+    ring_queue queue;
+    volatile u32 generation;
+    volatile u32 stalls;
+} blocking_test_state;
+
+// The generation this thread last woke up on
+static MTHREAD_LOCAL u32 seen_generation;
+
+// Blocks until notify has been called since this thread's previous wait. A lost wakeup shows up as a stall
+static void blocking_test_wait(void* context) {
+    blocking_test_state* state = context;
+    // After the first stall the test has failed, so the rest of the run only polls
+    if (atomic_u32_load(&state->stalls)) {
+        platform_sleep(0);
+        return;
+    }
+    f64 deadline = platform_get_absolute_time() + BLOCKING_WAIT_DEADLINE;
+    u32 generation;
+    while ((generation = atomic_u32_load(&state->generation)) == seen_generation) {
+        if (platform_get_absolute_time() > deadline) {
+            atomic_u32_fetch_add(&state->stalls, 1);
+            break;
+        }
+        platform_sleep(0);
+    }
+    seen_generation = generation;
+}
+
+static void blocking_test_notify(void* context) {
+    blocking_test_state* state = context;
+    atomic_u32_fetch_add(&state->generation, 1);
+}
+
+static u32 blocking_producer(void* args) {
+    blocking_test_state* state = args;
+    for (u64 i = 0; i < BLOCKING_ITEM_COUNT; ++i) {
+        ring_queue_enqueue_wait(&state->queue, &i);
+    }
+    return 0;
+}
+
+u8 ring_queue_spsc_should_not_lose_wakeups(void) {
+    static blocking_test_state state;
+    state.generation = 0;
+    state.stalls = 0;
+    // Tiny, so both sides keep blocking on the hook in turn
+    expect_true(ring_queue_create_with_flags(sizeof(u64), 4, nullptr, RING_QUEUE_FLAG_SPSC_BIT, &state.queue));
+    ring_queue_wait_hooks hooks = { blocking_test_wait, blocking_test_notify, &state };
+    ring_queue_set_wait_hooks(&state.queue, &hooks);
+
+    thread producer;
+    expect_true(thread_create(blocking_producer, &state, false, &producer));
+
+    b8 ordered = true;
+    for (u64 expected = 0; expected < BLOCKING_ITEM_COUNT; ++expected) {
+        u64 value;
+        ordered = ordered && ring_queue_dequeue_wait(&state.queue, &value) && value == expected;
+    }
+    thread_wait(&producer);
+    thread_destroy(&producer);
+
+    expect_true(ordered);
+    expect_be(0, ring_queue_length(&state.queue));
+    // Every wait was ended by a notify, not the deadline
+    expect_be(0, state.stalls);
+
+    ring_queue_destroy(&state.queue);
+    return true;
+}
+
+void ring_queue_register_tests(void) {
+    test_manager_register_test(ring_queue_should_wrap_with_any_capacity, "Ring queue should wrap with any capacity");
+    test_manager_register_test(ring_queue_spsc_should_deliver_in_order, "Ring queue SPSC mode should deliver in order across threads");
+    test_manager_register_test(ring_queue_spsc_should_not_lose_wakeups, "Ring queue SPSC mode should not lose wakeups while blocked");
+}
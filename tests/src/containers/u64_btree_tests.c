@@ -0,0 +1,146 @@
+#include "u64_btree_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+#include <containers/u64_btree.h>
+
+#define CHURN_KEY_RANGE 4096
+
+u8 u64_btree_sorted_inserts_stay_balanced(void) {
+    u64_btree tree;
+    expect_true(u64_btree_create(&tree));
+
+    // Increasing ids, the pattern that turned the old BST into a list
+    const u64 key_count = 100000;
+    for (u64 i = 0; i < key_count; ++i) {
+        expect_true(u64_btree_insert(&tree, i, (bst_node_value){ .u64 = i * 2 }));
+    }
+    expect_be(key_count, tree.count);
+    // Appending fills nodes, so 30 keys per leaf and 30 children per node need 4 levels
+    expect_be(4, tree.height);
+
+    b8 found = true;
+    for (u64 i = 0; i < key_count; ++i) {
+        bst_node_value* value = u64_btree_find(&tree, i);
+        found = found && value && value->u64 == i * 2;
+    }
+    expect_true(found);
+    expect_be(0, u64_btree_find(&tree, key_count));
+
+    // Overwriting keeps the count
+    expect_true(u64_btree_insert(&tree, 7, (bst_node_value){ .u64 = 1 }));
+    expect_be(key_count, tree.count);
+    expect_be(1, u64_btree_find(&tree, 7)->u64);
+
+    // Removing everything merges the tree back down to nothing. Descending removals start at the
+    // rightmost nodes, which appending left nearly empty
+    for (u64 i = 1; i < key_count; i += 2) {
+        found = found && u64_btree_remove(&tree, i);
+    }
+    for (u64 i = key_count; i >= 2; i -= 2) {
+        found = found && u64_btree_remove(&tree, i - 2);
+    }
+    expect_true(found);
+    expect_be(0, tree.count);
+    expect_be(0, tree.root);
+    expect_be(0, pool_allocator_allocated_count(&tree.node_pool));
+
+    u64_btree_destroy(&tree);
+    return true;
+}
+
+u8 u64_btree_should_match_reference_under_churn(void) {
+    u64_btree tree;
+    expect_true(u64_btree_create(&tree));
+
+    // A flag per key in the range tracks what the tree should hold
+    static u8 present[CHURN_KEY_RANGE];
+    for (u32 i = 0; i < CHURN_KEY_RANGE; ++i) {
+        present[i] = 0;
+    }
+
+    u32 state = 0x12345678u;
+    u64 expected_count = 0;
+    b8 consistent = true;
+    for (u32 i = 0; i < 200000; ++i) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        u64 key = state % CHURN_KEY_RANGE;
+        // Inserts slightly outnumber removals, so the tree both grows and shrinks through every shape
+        if ((state >> 20) % 8 < 5) {
+            expected_count += present[key] ? 0 : 1;
+            present[key] = 1;
+            consistent = consistent && u64_btree_insert(&tree, key, (bst_node_value){ .u64 = key + 1 });
+        } else {
+            consistent = consistent && u64_btree_remove(&tree, key) == present[key];
+            expected_count -= present[key];
+            present[key] = 0;
+        }
+    }
+    expect_true(consistent);
+    expect_be(expected_count, tree.count);
+
+    // Iteration visits exactly the stored keys, in order
+    u64_btree_iterator it;
+    u64 visited = 0;
+    u64 previous = 0;
+    for (u64_btree_begin(&tree, &it); u64_btree_iterator_valid(&it); u64_btree_iterator_next(&it)) {
+        u64 key = u64_btree_iterator_key(&it);
+        consistent = consistent && present[key] && (visited == 0 || key > previous) && u64_btree_iterator_value(&it)->u64 == key + 1;
+        previous = key;
+        visited++;
+    }
+    expect_true(consistent);
+    expect_be(expected_count, visited);
+
+    u64_btree_clear(&tree);
+    expect_be(0, tree.count);
+    expect_be(0, u64_btree_find(&tree, previous));
+    u64_btree_begin(&tree, &it);
+    expect_false(u64_btree_iterator_valid(&it));
+
+    u64_btree_destroy(&tree);
+    return true;
+}
+
+u8 u64_btree_range_should_stop_at_bounds(void) {
+    u64_btree tree;
+    expect_true(u64_btree_create(&tree));
+
+    // Even keys only, so range bounds fall both on and between keys
+    for (u64 i = 0; i < 1000; ++i) {
+        expect_true(u64_btree_insert(&tree, i * 2, (bst_node_value){ .u64 = i }));
+    }
+
+    u64_btree_iterator it;
+    u64 count = 0;
+    u64 first = 0;
+    u64 last = 0;
+    for (u64_btree_range(&tree, 101, 400, &it); u64_btree_iterator_valid(&it); u64_btree_iterator_next(&it)) {
+        if (count == 0) {
+            first = u64_btree_iterator_key(&it);
+        }
+        last = u64_btree_iterator_key(&it);
+        count++;
+    }
+    expect_be(102, first);
+    expect_be(400, last);
+    expect_be(150, count);
+
+    // Ranges past the last key or between two keys are empty
+    u64_btree_range(&tree, 1999, U64_MAX, &it);
+    expect_false(u64_btree_iterator_valid(&it));
+    u64_btree_range(&tree, 5, 5, &it);
+    expect_false(u64_btree_iterator_valid(&it));
+
+    u64_btree_destroy(&tree);
+    return true;
+}
+
+void u64_btree_register_tests(void) {
+    test_manager_register_test(u64_btree_sorted_inserts_stay_balanced, "u64 btree sorted inserts stay balanced");
+    test_manager_register_test(u64_btree_should_match_reference_under_churn, "u64 btree should match a reference under churn");
+    test_manager_register_test(u64_btree_range_should_stop_at_bounds, "u64 btree range should stop at its bounds");
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void u64_btree_register_tests(void);
\ No newline at end of file
@@ -0,0 +1,88 @@
+#include "u64_hashtable_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+#include <containers/u64_hashtable.h>
+
+u8 u64_hashtable_should_set_get_and_grow(void) {
+    u64_hashtable_u64 table;
+    expect_true(u64_hashtable_u64_create(4, &table));
+    u32 initial_capacity = table.base.capacity;
+
+    // Sequential ids, as entity and resource handles usually are
+    const u64 key_count = 10000;
+    for (u64 i = 0; i < key_count; ++i) {
+        expect_true(u64_hashtable_u64_set(&table, i, i * 7));
+    }
+    expect_be(key_count, table.base.count);
+    expect_true(table.base.capacity > initial_capacity);
+
+    for (u64 i = 0; i < key_count; ++i) {
+        u64* value = u64_hashtable_u64_get(&table, i);
+        expect_not_be(0, value);
+        expect_be(i * 7, *value);
+    }
+    expect_be(0, u64_hashtable_u64_get(&table, key_count));
+
+    // Overwriting keeps the count
+    expect_true(u64_hashtable_u64_set(&table, 5, 1));
+    expect_be(key_count, table.base.count);
+    u64 value = 0;
+    expect_true(u64_hashtable_u64_try_get(&table, 5, &value));
+    expect_be(1, value);
+
+    MDEBUG("The following error message is intentional.");
+    expect_false(u64_hashtable_u64_set(&table, U64_HASHTABLE_EMPTY_KEY, 1));
+    expect_be(0, u64_hashtable_u64_get(&table, U64_HASHTABLE_EMPTY_KEY));
+
+    u64_hashtable_u64_destroy(&table);
+    expect_be(0, table.base.slots);
+    expect_be(0, table.base.capacity);
+
+    return true;
+}
+
+u8 u64_hashtable_should_remove_without_breaking_probe_runs(void) {
+    u64_hashtable_ptr table;
+    expect_true(u64_hashtable_ptr_create(1000, &table));
+
+    // Random keys spread over the whole table, so removals shift entries across the wrap at the end
+    u64 keys[1000];
+    u64 state = 0x9E3779B97F4A7C15ull;
+    for (u32 i = 0; i < 1000; ++i) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        keys[i] = state;
+        expect_true(u64_hashtable_ptr_set(&table, keys[i], &keys[i]));
+    }
+
+    for (u32 i = 0; i < 1000; i += 3) {
+        expect_true(u64_hashtable_ptr_remove(&table, keys[i]));
+        expect_false(u64_hashtable_ptr_remove(&table, keys[i]));
+    }
+
+    for (u32 i = 0; i < 1000; ++i) {
+        void** value = u64_hashtable_ptr_get(&table, keys[i]);
+        if (i % 3 == 0) {
+            expect_be(0, value);
+        } else {
+            expect_not_be(0, value);
+            expect_be(&keys[i], *value);
+        }
+    }
+    expect_be(1000 - 334, table.base.count);
+
+    u64_hashtable_ptr_clear(&table);
+    expect_be(0, table.base.count);
+    expect_be(0, u64_hashtable_ptr_get(&table, keys[1]));
+
+    u64_hashtable_ptr_destroy(&table);
+    return true;
+}
+
+void u64_hashtable_register_tests(void) {
+    test_manager_register_test(u64_hashtable_should_set_get_and_grow, "u64 hashtable should set, get and grow");
+    test_manager_register_test(u64_hashtable_should_remove_without_breaking_probe_runs, "u64 hashtable should remove keys without losing others");
+}
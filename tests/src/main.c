@@ -1,20 +1,48 @@
 #include "test_manager.h"
 
 #include "strings/string_tests.h"
+#include "strings/name_tests.h"
 #include "memory/dynamic_allocator_tests.h"
+#include "memory/linear_allocator_tests.h"
+#include "memory/memory_tests.h"
+#include "memory/memory_profiler_tests.h"
+#include "memory/pool_allocator_tests.h"
+#include "memory/scratch_allocator_tests.h"
 #include "containers/darray_tests.h"
 #include "containers/freelist_tests.h"
 #include "containers/hashtable_tests.h"
+#include "containers/queue_tests.h"
+#include "containers/ring_queue_tests.h"
+#include "containers/mpmc_queue_tests.h"
+#include "containers/u64_hashtable_tests.h"
+#include "containers/concurrent_hashtable_tests.h"
+#include "containers/u64_btree_tests.h"
+#include "threads/spinlock_tests.h"
+#include "renderer/vulkan_memory_tests.h"
 
 
 int main() {
     test_manager_init();
 
     string_register_tests();
+    name_register_tests();
     dynamic_allocator_register_tests();
+    linear_allocator_register_tests();
+    memory_register_tests();
+    memory_profiler_register_tests();
+    pool_allocator_register_tests();
+    scratch_allocator_register_tests();
     darray_register_tests();
     freelist_register_tests();
     hashtable_register_tests();
+    queue_register_tests();
+    ring_queue_register_tests();
+    mpmc_queue_register_tests();
+    u64_hashtable_register_tests();
+    concurrent_hashtable_register_tests();
+    u64_btree_register_tests();
+    spinlock_register_tests();
+    vulkan_memory_register_tests();
 
     test_manager_run_tests();
 
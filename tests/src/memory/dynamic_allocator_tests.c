@@ -6,6 +6,7 @@
 
 #include <memory/allocators/dynamic_allocator.h>
 #include <memory/memory.h>
+#include <platform/platform.h>
 
 u8 dynamic_allocator_should_create_and_destroy(void) {
     dynamic_allocator alloc;
@@ -35,7 +36,7 @@ u8 dynamic_allocator_single_allocation_all_space(void) {
     const u64 allocator_size = 1024;
     const u64 alignment = 1;
     // Total size needed, including headers.
-    const u64 total_allocator_size = allocator_size + (dynamic_allocator_header_size() + alignment);
+    const u64 total_allocator_size = dynamic_allocator_block_footprint(allocator_size, alignment);
     // Get the memory requirement
     b8 result = dynamic_allocator_create(total_allocator_size, &memory_requirement, 0, 0);
     expect_true(result);
@@ -76,7 +77,8 @@ u8 dynamic_allocator_multi_allocation_all_space(void) {
 
     const u64 allocator_size = 1024;
     const u64 alignment = 1;
-    u64 header_size = (dynamic_allocator_header_size() + alignment);
+    // Per block overhead of the 256 byte blocks used below.
+    u64 header_size = dynamic_allocator_block_footprint(256, alignment) - 256;
     // Total size needed, including headers.
     const u64 total_allocator_size = allocator_size + (header_size * 3);
 
@@ -150,7 +152,8 @@ u8 dynamic_allocator_multi_allocation_over_allocate(void) {
 
     const u64 allocator_size = 1024;
     const u64 alignment = 1;
-    u64 header_size = (dynamic_allocator_header_size() + alignment);
+    // Per block overhead of the 256 byte blocks used below.
+    u64 header_size = dynamic_allocator_block_footprint(256, alignment) - 256;
     // Total size needed, including headers.
     const u64 total_allocator_size = allocator_size + (header_size * 3);
 
@@ -212,7 +215,8 @@ u8 dynamic_allocator_multi_allocation_most_space_request_too_big(void) {
 
     const u64 allocator_size = 1024;
     const u64 alignment = 1;
-    u64 header_size = (dynamic_allocator_header_size() + alignment);
+    // Per block overhead of the 256 byte blocks used below.
+    u64 header_size = dynamic_allocator_block_footprint(256, alignment) - 256;
     // Total size needed, including headers.
     const u64 total_allocator_size = allocator_size + (header_size * 3);
 
@@ -274,7 +278,7 @@ u8 dynamic_allocator_single_alloc_aligned(void) {
     const u64 allocator_size = 1024;
     const u64 alignment = 16;
     // Total size needed, including headers.
-    const u64 total_allocator_size = allocator_size + (dynamic_allocator_header_size() + alignment);
+    const u64 total_allocator_size = dynamic_allocator_block_footprint(allocator_size, alignment);
     // Get the memory requirement
     b8 result = dynamic_allocator_create(total_allocator_size, &memory_requirement, 0, 0);
     expect_true(result);
@@ -327,7 +331,6 @@ u8 dynamic_allocator_multiple_alloc_aligned_different_alignments(void) {
     dynamic_allocator alloc;
     u64 memory_requirement = 0;
     u64 currently_allocated = 0;
-    const u64 header_size = dynamic_allocator_header_size();
 
     const u32 alloc_data_count = 4;
     alloc_data alloc_datas[4];
@@ -338,7 +341,7 @@ u8 dynamic_allocator_multiple_alloc_aligned_different_alignments(void) {
     // Total size needed, including headers.
     u64 total_allocator_size = 0;
     for (u32 i = 0; i < alloc_data_count; ++i) {
-        total_allocator_size += alloc_datas[i].alignment + header_size + alloc_datas[i].size;
+        total_allocator_size += dynamic_allocator_block_footprint(alloc_datas[i].size, alloc_datas[i].alignment);
     }
 
     // Get the memory requirement
@@ -368,7 +371,7 @@ u8 dynamic_allocator_multiple_alloc_aligned_different_alignments(void) {
         expect_be(alloc_datas[idx].size, block_size);
 
         // Track it.
-        currently_allocated += (alloc_datas[idx].size + header_size + alloc_datas[idx].alignment);
+        currently_allocated += dynamic_allocator_block_footprint(alloc_datas[idx].size, alloc_datas[idx].alignment);
 
         // Verify free space
         free_space = dynamic_allocator_free_space(&alloc);
@@ -390,7 +393,7 @@ u8 dynamic_allocator_multiple_alloc_aligned_different_alignments(void) {
         expect_be(alloc_datas[idx].size, block_size);
 
         // Track it.
-        currently_allocated += (alloc_datas[idx].size + header_size + alloc_datas[idx].alignment);
+        currently_allocated += dynamic_allocator_block_footprint(alloc_datas[idx].size, alloc_datas[idx].alignment);
 
         // Verify free space
         free_space = dynamic_allocator_free_space(&alloc);
@@ -412,7 +415,7 @@ u8 dynamic_allocator_multiple_alloc_aligned_different_alignments(void) {
         expect_be(alloc_datas[idx].size, block_size);
 
         // Track it.
-        currently_allocated += (alloc_datas[idx].size + header_size + alloc_datas[idx].alignment);
+        currently_allocated += dynamic_allocator_block_footprint(alloc_datas[idx].size, alloc_datas[idx].alignment);
 
         // Verify free space
         free_space = dynamic_allocator_free_space(&alloc);
@@ -434,7 +437,7 @@ u8 dynamic_allocator_multiple_alloc_aligned_different_alignments(void) {
         expect_be(alloc_datas[idx].size, block_size);
 
         // Track it.
-        currently_allocated += (alloc_datas[idx].size + header_size + alloc_datas[idx].alignment);
+        currently_allocated += dynamic_allocator_block_footprint(alloc_datas[idx].size, alloc_datas[idx].alignment);
 
         // Verify free space
         free_space = dynamic_allocator_free_space(&alloc);
@@ -448,7 +451,7 @@ u8 dynamic_allocator_multiple_alloc_aligned_different_alignments(void) {
         u32 idx = 1;
         dynamic_allocator_free_aligned(&alloc, alloc_datas[idx].block);
         alloc_datas[idx].block = 0;
-        currently_allocated -= (alloc_datas[idx].size + header_size + alloc_datas[idx].alignment);
+        currently_allocated -= dynamic_allocator_block_footprint(alloc_datas[idx].size, alloc_datas[idx].alignment);
 
         // Verify free space.
         free_space = dynamic_allocator_free_space(&alloc);
@@ -459,7 +462,7 @@ u8 dynamic_allocator_multiple_alloc_aligned_different_alignments(void) {
         u32 idx = 3;
         dynamic_allocator_free_aligned(&alloc, alloc_datas[idx].block);
         alloc_datas[idx].block = 0;
-        currently_allocated -= (alloc_datas[idx].size + header_size + alloc_datas[idx].alignment);
+        currently_allocated -= dynamic_allocator_block_footprint(alloc_datas[idx].size, alloc_datas[idx].alignment);
 
         // Verify free space.
         free_space = dynamic_allocator_free_space(&alloc);
@@ -471,7 +474,7 @@ u8 dynamic_allocator_multiple_alloc_aligned_different_alignments(void) {
         u32 idx = 2;
         dynamic_allocator_free_aligned(&alloc, alloc_datas[idx].block);
         alloc_datas[idx].block = 0;
-        currently_allocated -= (alloc_datas[idx].size + header_size + alloc_datas[idx].alignment);
+        currently_allocated -= dynamic_allocator_block_footprint(alloc_datas[idx].size, alloc_datas[idx].alignment);
 
         // Verify free space.
         free_space = dynamic_allocator_free_space(&alloc);
@@ -483,7 +486,7 @@ u8 dynamic_allocator_multiple_alloc_aligned_different_alignments(void) {
         u32 idx = 0;
         dynamic_allocator_free_aligned(&alloc, alloc_datas[idx].block);
         alloc_datas[idx].block = 0;
-        currently_allocated -= (alloc_datas[idx].size + header_size + alloc_datas[idx].alignment);
+        currently_allocated -= dynamic_allocator_block_footprint(alloc_datas[idx].size, alloc_datas[idx].alignment);
 
         // Verify free space.
         free_space = dynamic_allocator_free_space(&alloc);
@@ -553,7 +556,7 @@ u8 util_free(dynamic_allocator* allocator, alloc_data* data, u64* currently_allo
 //     // Total size needed, including headers.
 //     u64 total_allocator_size = 0;
 //     for (u32 i = 0; i < alloc_data_count; ++i) {
-//         total_allocator_size += alloc_datas[i].alignment + header_size + alloc_datas[i].size;
+//         total_allocator_size += dynamic_allocator_block_footprint(alloc_datas[i].size, alloc_datas[i].alignment);
 //     }
 
 //     // Get the memory requirement
@@ -622,7 +625,7 @@ u8 util_free(dynamic_allocator* allocator, alloc_data* data, u64* currently_allo
 //     // Total size needed, including headers.
 //     u64 total_allocator_size = 0;
 //     for (u32 i = 0; i < alloc_data_count; ++i) {
-//         total_allocator_size += alloc_datas[i].alignment + header_size + alloc_datas[i].size;
+//         total_allocator_size += dynamic_allocator_block_footprint(alloc_datas[i].size, alloc_datas[i].alignment);
 //     }
 //     MINFO("Total allocator size: %llu", total_allocator_size);
 
@@ -701,6 +704,134 @@ u8 util_free(dynamic_allocator* allocator, alloc_data* data, u64* currently_allo
 //     return true;
 // }
 
+u8 dynamic_allocator_lazy_commit_follows_usage(void) {
+    dynamic_allocator alloc;
+    u64 memory_requirement = 0;
+    const u64 allocator_size = MEBIBYTES(64);
+    const u64 granularity = DYNAMIC_ALLOCATOR_COMMIT_GRANULARITY;
+
+    b8 result = dynamic_allocator_create_with_flags(allocator_size, DYNAMIC_ALLOCATOR_FLAG_LAZY_COMMIT_BIT, &memory_requirement, 0, 0);
+    expect_true(result);
+
+    // Only address space is reserved, nothing should be committed yet.
+    void* memory = platform_memory_reserve(memory_requirement);
+    expect_not_be(0, memory);
+    result = dynamic_allocator_create_with_flags(allocator_size, DYNAMIC_ALLOCATOR_FLAG_LAZY_COMMIT_BIT, &memory_requirement, memory, &alloc);
+    expect_true(result);
+    expect_be(allocator_size, dynamic_allocator_free_space(&alloc));
+    expect_be(0, dynamic_allocator_committed_space(&alloc));
+
+    // A small allocation commits a single granule, and is writable.
+    u8* small = dynamic_allocator_allocate(&alloc, 64);
+    expect_not_be(0, small);
+    small[0] = 1;
+    small[63] = 1;
+    expect_be(granularity, dynamic_allocator_committed_space(&alloc));
+
+    // A large allocation commits only the granules it covers.
+    u64 large_size = MEBIBYTES(40);
+    u8* large = dynamic_allocator_allocate(&alloc, large_size);
+    expect_not_be(0, large);
+    large[0] = 1;
+    large[large_size - 1] = 1;
+    u64 committed = dynamic_allocator_committed_space(&alloc);
+    expect_true(committed >= large_size);
+    expect_true(committed <= large_size + granularity * 2);
+
+    // Freeing the large block leaves more than the threshold unused, so it gets decommitted.
+    dynamic_allocator_free(&alloc, large);
+    expect_be(granularity, dynamic_allocator_committed_space(&alloc));
+    expect_be(1, small[0]);
+
+    // Reallocating over the decommitted range commits it again.
+    large = dynamic_allocator_allocate(&alloc, large_size);
+    expect_not_be(0, large);
+    large[large_size - 1] = 1;
+    dynamic_allocator_free(&alloc, large);
+    dynamic_allocator_free(&alloc, small);
+    expect_be(allocator_size, dynamic_allocator_free_space(&alloc));
+
+    dynamic_allocator_destroy(&alloc);
+    expect_be(0, alloc.memory);
+    platform_memory_release(memory, memory_requirement);
+    return true;
+}
+
+u8 dynamic_allocator_should_extend_in_place(void) {
+    dynamic_allocator alloc;
+    u64 memory_requirement = 0;
+    const u64 allocator_size = 4096;
+    dynamic_allocator_create(allocator_size, &memory_requirement, 0, 0);
+    void* memory = memory_allocate(memory_requirement, MEMORY_TAG_ENGINE);
+    expect_true(dynamic_allocator_create(allocator_size, &memory_requirement, memory, &alloc));
+
+    u8* first = dynamic_allocator_allocate_aligned(&alloc, 100, 16);
+    expect_not_be(0, first);
+    for (u32 i = 0; i < 100; ++i) {
+        first[i] = (u8)i;
+    }
+
+    // Nothing follows the block yet, so it can grow where it is.
+    expect_true(dynamic_allocator_try_extend(&alloc, first, 300));
+    u64 size = 0;
+    u16 alignment = 0;
+    expect_true(dynamic_allocator_get_size_alignment(&alloc, first, &size, &alignment));
+    expect_be(300, size);
+    expect_be(16, alignment);
+    expect_be(99, first[99]);
+    u64 used = allocator_size - dynamic_allocator_free_space(&alloc);
+    expect_be(dynamic_allocator_block_footprint(300, 16), used);
+
+    // Once another block follows it, growing past that block fails and leaves it intact.
+    void* second = dynamic_allocator_allocate(&alloc, 64);
+    expect_not_be(0, second);
+    expect_false(dynamic_allocator_try_extend(&alloc, first, 400));
+    expect_true(dynamic_allocator_get_size_alignment(&alloc, first, &size, &alignment));
+    expect_be(300, size);
+
+    // Freeing the whole grown block returns all of its space.
+    expect_true(dynamic_allocator_free_aligned(&alloc, first));
+    expect_true(dynamic_allocator_free(&alloc, second));
+    expect_be(allocator_size, dynamic_allocator_free_space(&alloc));
+
+    dynamic_allocator_destroy(&alloc);
+    memory_free(memory, memory_requirement, MEMORY_TAG_ENGINE);
+    return true;
+}
+
+u8 dynamic_allocator_should_report_fragmentation(void) {
+    dynamic_allocator alloc;
+    u64 memory_requirement = 0;
+    const u64 allocator_size = 4096;
+    dynamic_allocator_create(allocator_size, &memory_requirement, 0, 0);
+    void* memory = memory_allocate(memory_requirement, MEMORY_TAG_ENGINE);
+    expect_true(dynamic_allocator_create(allocator_size, &memory_requirement, memory, &alloc));
+
+    void* first = dynamic_allocator_allocate(&alloc, 256);
+    void* second = dynamic_allocator_allocate(&alloc, 256);
+    void* third = dynamic_allocator_allocate(&alloc, 256);
+    expect_true(dynamic_allocator_free(&alloc, second));
+
+    // The hole left by the second block and the space after the third one.
+    freelist_fragmentation fragmentation;
+    expect_true(dynamic_allocator_get_fragmentation(&alloc, &fragmentation));
+    expect_be(dynamic_allocator_free_space(&alloc), fragmentation.free_space);
+    expect_be(2, fragmentation.free_range_count);
+    expect_true(fragmentation.largest_free_range > allocator_size - 3 * (256 + 32));
+    expect_true(fragmentation.largest_free_range < fragmentation.free_space);
+    expect_true(fragmentation.external_fragmentation > 0.0f);
+
+    expect_true(dynamic_allocator_free(&alloc, first));
+    expect_true(dynamic_allocator_free(&alloc, third));
+    expect_true(dynamic_allocator_get_fragmentation(&alloc, &fragmentation));
+    expect_be(1, fragmentation.free_range_count);
+    expect_be(allocator_size, fragmentation.largest_free_range);
+
+    dynamic_allocator_destroy(&alloc);
+    memory_free(memory, memory_requirement, MEMORY_TAG_ENGINE);
+    return true;
+}
+
 void dynamic_allocator_register_tests(void) {
     test_manager_register_test(dynamic_allocator_should_create_and_destroy, "Dynamic allocator should create and destroy");
     test_manager_register_test(dynamic_allocator_single_allocation_all_space, "Dynamic allocator single alloc for all space");
@@ -709,6 +840,9 @@ void dynamic_allocator_register_tests(void) {
     test_manager_register_test(dynamic_allocator_multi_allocation_most_space_request_too_big, "Dynamic allocator should try to over allocate with not enough space, but not 0 space remaining.");
     test_manager_register_test(dynamic_allocator_single_alloc_aligned, "Dynamic allocator single aligned allocation");
     test_manager_register_test(dynamic_allocator_multiple_alloc_aligned_different_alignments, "Dynamic allocator multiple aligned allocations with different alignments");
+    test_manager_register_test(dynamic_allocator_lazy_commit_follows_usage, "Dynamic allocator lazy commit follows usage");
+    test_manager_register_test(dynamic_allocator_should_extend_in_place, "Dynamic allocator should extend in place");
+    test_manager_register_test(dynamic_allocator_should_report_fragmentation, "Dynamic allocator should report fragmentation");
     // test_manager_register_test(dynamic_allocator_multiple_alloc_aligned_different_alignments_random, "Dynamic allocator multiple aligned allocations with different alignments in random order.");
     // test_manager_register_test(dynamic_allocator_multiple_alloc_and_free_aligned_different_alignments_random, "Dynamic allocator randomization test.");
 }
\ No newline at end of file
@@ -0,0 +1,203 @@
+#include "linear_allocator_tests.h"
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <defines.h>
+
+#include <memory/allocators/linear_allocator.h>
+#include <threads/atomic.h>
+#include <threads/thread.h>
+
+#define STRESS_THREADS 4
+#define STRESS_ARENA_SIZE MEBIBYTES(1)
+#define STRESS_MAX_BLOCKS 40000
+
+typedef struct stress_block {
+    u8* block;
+    u32 size;
+} stress_block;
+
+typedef struct stress_worker {
+    linear_allocator* allocator;
+    volatile u32* start;
+    u8 tag;
+    u32 block_count;
+    stress_block blocks[STRESS_MAX_BLOCKS];
+} stress_worker;
+
+static u8 stress_arena[STRESS_ARENA_SIZE];
+static stress_worker stress_workers[STRESS_THREADS];
+
+u8 linear_allocator_should_align_allocations(void) {
+    // Starts on a 128 byte boundary, so the padding below does not depend on where the arena was placed
+    u8* memory = (u8*)get_aligned((u64)stress_arena, 128);
+    linear_allocator allocator;
+    linear_allocator_create(KIBIBYTES(1), memory, &allocator);
+
+    u8* a = linear_allocator_allocate(&allocator, 3);
+    expect_be(memory, a);
+    u8* b = linear_allocator_allocate_aligned(&allocator, 10, 64);
+    expect_be(0, (u64)b % 64);
+    expect_be(b + 10 - memory, linear_allocator_get_marker(&allocator));
+
+    // Padding counts against the space left
+    expect_be(0, linear_allocator_allocate_aligned(&allocator, KIBIBYTES(1) - 64, 128));
+    expect_not_be(0, linear_allocator_allocate_aligned(&allocator, KIBIBYTES(1) - 128, 128));
+
+    linear_allocator_destroy(&allocator);
+    return true;
+}
+
+static u32 stress_thread(void* args) {
+    stress_worker* worker = args;
+    linear_allocator_chunk chunk;
+    linear_allocator_chunk_begin(worker->allocator, KIBIBYTES(2), &chunk);
+
+    while (!atomic_u32_load(worker->start)) {
+        atomic_spin_pause();
+    }
+
+    u32 seed = worker->tag;
+    while (worker->block_count < STRESS_MAX_BLOCKS) {
+        seed = seed * 1664525u + 1013904223u;
+        u32 size = 1 + (seed >> 8) % 96;
+        u8* block;
+        switch (worker->block_count % 3) {
+            case 0:
+                block = linear_allocator_allocate(worker->allocator, size);
+                break;
+            case 1:
+                block = linear_allocator_allocate_aligned(worker->allocator, size, 32);
+                break;
+            default:
+                block = linear_allocator_chunk_allocate(&chunk, size, 8);
+                break;
+        }
+        if (!block) {
+            break;
+        }
+        for (u32 i = 0; i < size; ++i) {
+            block[i] = worker->tag;
+        }
+        worker->blocks[worker->block_count].block = block;
+        worker->blocks[worker->block_count].size = size;
+        worker->block_count++;
+    }
+    return 0;
+}
+
+u8 linear_allocator_concurrent_threads_get_disjoint_blocks(void) {
+    linear_allocator allocator;
+    linear_allocator_create_with_flags(STRESS_ARENA_SIZE, stress_arena, LINEAR_ALLOCATOR_FLAG_CONCURRENT_BIT, &allocator);
+
+    volatile u32 start = 0;
+    thread threads[STRESS_THREADS];
+    for (u32 i = 0; i < STRESS_THREADS; ++i) {
+        stress_workers[i].allocator = &allocator;
+        stress_workers[i].start = &start;
+        stress_workers[i].tag = (u8)(i + 1);
+        stress_workers[i].block_count = 0;
+        expect_true(thread_create(stress_thread, &stress_workers[i], false, &threads[i]));
+    }
+    atomic_u32_store(&start, 1);
+    for (u32 i = 0; i < STRESS_THREADS; ++i) {
+        thread_wait(&threads[i]);
+        thread_destroy(&threads[i]);
+    }
+
+    // Any overlap between two threads' blocks shows up as the other thread's tag
+    u64 total_blocks = 0;
+    b8 intact = true;
+    for (u32 i = 0; i < STRESS_THREADS; ++i) {
+        stress_worker* worker = &stress_workers[i];
+        total_blocks += worker->block_count;
+        for (u32 b = 0; b < worker->block_count; ++b) {
+            stress_block* block = &worker->blocks[b];
+            intact = intact && block->block >= stress_arena && block->block + block->size <= stress_arena + STRESS_ARENA_SIZE;
+            for (u32 j = 0; j < block->size; ++j) {
+                intact = intact && block->block[j] == worker->tag;
+            }
+        }
+    }
+    expect_true(intact);
+    expect_true(total_blocks > 0);
+    // Allocations that do not fit are never published, so the position never passes the end
+    expect_true(linear_allocator_get_marker(&allocator) <= STRESS_ARENA_SIZE);
+
+    linear_allocator_destroy(&allocator);
+    return true;
+}
+
+#define OVERSIZED_ATTEMPTS 64
+#define SMALL_BLOCKS_PER_THREAD 2000
+
+typedef struct contention_worker {
+    linear_allocator* allocator;
+    volatile u32* start;
+    u32 failures;
+} contention_worker;
+
+static contention_worker contention_workers[STRESS_THREADS];
+
+static u32 small_allocation_thread(void* args) {
+    contention_worker* worker = args;
+    while (!atomic_u32_load(worker->start)) {
+        atomic_spin_pause();
+    }
+    for (u32 i = 0; i < SMALL_BLOCKS_PER_THREAD; ++i) {
+        if (!linear_allocator_allocate(worker->allocator, 16)) {
+            worker->failures++;
+        }
+    }
+    return 0;
+}
+
+static u32 oversized_allocation_thread(void* args) {
+    contention_worker* worker = args;
+    while (!atomic_u32_load(worker->start)) {
+        atomic_spin_pause();
+    }
+    for (u32 i = 0; i < OVERSIZED_ATTEMPTS; ++i) {
+        if (!linear_allocator_allocate(worker->allocator, STRESS_ARENA_SIZE)) {
+            worker->failures++;
+        }
+    }
+    return 0;
+}
+
+u8 linear_allocator_oversized_requests_do_not_fail_others(void) {
+    linear_allocator allocator;
+    linear_allocator_create_with_flags(STRESS_ARENA_SIZE, stress_arena, LINEAR_ALLOCATOR_FLAG_CONCURRENT_BIT, &allocator);
+    // Near the end of the arena, as at the end of a frame
+    expect_not_be(0, linear_allocator_allocate(&allocator, STRESS_ARENA_SIZE / 2));
+
+    volatile u32 start = 0;
+    thread threads[STRESS_THREADS];
+    for (u32 i = 0; i < STRESS_THREADS; ++i) {
+        contention_workers[i].allocator = &allocator;
+        contention_workers[i].start = &start;
+        contention_workers[i].failures = 0;
+        expect_true(thread_create(i == 0 ? oversized_allocation_thread : small_allocation_thread, &contention_workers[i], false, &threads[i]));
+    }
+    atomic_u32_store(&start, 1);
+    for (u32 i = 0; i < STRESS_THREADS; ++i) {
+        thread_wait(&threads[i]);
+        thread_destroy(&threads[i]);
+    }
+
+    // Every small block fits, whatever the oversized requests were doing at the time
+    expect_be(OVERSIZED_ATTEMPTS, contention_workers[0].failures);
+    for (u32 i = 1; i < STRESS_THREADS; ++i) {
+        expect_be(0, contention_workers[i].failures);
+    }
+    expect_be(STRESS_ARENA_SIZE / 2 + (STRESS_THREADS - 1) * SMALL_BLOCKS_PER_THREAD * 16, linear_allocator_get_marker(&allocator));
+
+    linear_allocator_destroy(&allocator);
+    return true;
+}
+
+void linear_allocator_register_tests(void) {
+    test_manager_register_test(linear_allocator_should_align_allocations, "Linear allocator should align allocations");
+    test_manager_register_test(linear_allocator_concurrent_threads_get_disjoint_blocks, "Linear allocator gives concurrent threads disjoint blocks");
+    test_manager_register_test(linear_allocator_oversized_requests_do_not_fail_others, "Linear allocator oversized requests do not fail concurrent ones");
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void linear_allocator_register_tests(void);
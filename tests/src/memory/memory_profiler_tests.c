@@ -0,0 +1,128 @@
+#include "memory_profiler_tests.h"
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <defines.h>
+
+#include <memory/memory.h>
+#include <memory/memory_profiler.h>
+#include <strings/string.h>
+
+#if MEMORY_PROFILER_ENABLED
+
+// Keeps every allocation of the test on one call site
+static MNOINLINE void* allocate_from_single_site(u64 size) {
+    return memory_allocate(size, MEMORY_TAG_GAME);
+}
+
+u8 memory_profiler_should_attribute_call_sites(void) {
+    memory_system_config config = {0};
+    config.total_alloc_size = MEBIBYTES(64);
+    expect_true(memory_system_initialize(config));
+
+    void* blocks[3];
+    for (u32 i = 0; i < 3; ++i) {
+        blocks[i] = allocate_from_single_site(KIBIBYTES(4));
+    }
+    void* other = memory_allocate(100, MEMORY_TAG_STRING);
+
+    memory_profiler_snapshot snapshot;
+    expect_true(memory_profiler_get_snapshot(&snapshot));
+    expect_be(KIBIBYTES(12), snapshot.tags[MEMORY_TAG_GAME].live_bytes);
+    expect_be(3, snapshot.tags[MEMORY_TAG_GAME].live_count);
+    expect_be(1, snapshot.tags[MEMORY_TAG_STRING].live_count);
+    // 4 KiB lands in bucket 12, 100 B in bucket 6
+    expect_be(3, snapshot.live_size_histogram[12]);
+    expect_be(1, snapshot.live_size_histogram[6]);
+    expect_be(0, snapshot.untracked_count);
+
+    memory_profiler_site sites[4];
+    u32 site_count = memory_profiler_get_top_sites(4, sites);
+    expect_be(2, site_count);
+    expect_be(MEMORY_TAG_GAME, sites[0].tag);
+    expect_be(KIBIBYTES(12), sites[0].live_bytes);
+    expect_be(3, sites[0].live_count);
+    expect_be(MEMORY_TAG_STRING, sites[1].tag);
+
+    // Frees lower the live values, the peaks stay
+    for (u32 i = 0; i < 3; ++i) {
+        memory_free(blocks[i], KIBIBYTES(4), MEMORY_TAG_GAME);
+    }
+    expect_true(memory_profiler_get_snapshot(&snapshot));
+    expect_be(0, snapshot.tags[MEMORY_TAG_GAME].live_bytes);
+    expect_be(KIBIBYTES(12), snapshot.tags[MEMORY_TAG_GAME].peak_bytes);
+    expect_be(3, snapshot.tags[MEMORY_TAG_GAME].peak_count);
+    expect_be(3, snapshot.size_histogram[12]);
+    expect_be(0, snapshot.live_size_histogram[12]);
+
+    site_count = memory_profiler_get_top_sites(4, sites);
+    expect_be(MEMORY_TAG_STRING, sites[0].tag);
+    expect_be(MEMORY_TAG_GAME, sites[1].tag);
+    expect_be(0, sites[1].live_bytes);
+    expect_be(KIBIBYTES(12), sites[1].peak_bytes);
+    expect_be(3, sites[1].total_count);
+
+    memory_free(other, 100, MEMORY_TAG_STRING);
+    memory_system_shutdown();
+    return true;
+}
+
+u8 memory_profiler_should_export_json_and_trace(void) {
+    memory_system_config config = {0};
+    config.total_alloc_size = MEBIBYTES(64);
+    expect_true(memory_system_initialize(config));
+
+    void* block = memory_allocate(KIBIBYTES(1), MEMORY_TAG_RENDERER);
+    memory_profiler_sample();
+    memory_profiler_sample();
+
+    // Sizing call first, then the actual export. Allocating the buffer adds a site, so leave headroom
+    u64 length = memory_profiler_export_json(nullptr, 0);
+    expect_true(length > 0);
+    u64 json_size = length + 1024;
+    char* json = memory_allocate(json_size, MEMORY_TAG_STRING);
+    length = memory_profiler_export_json(json, json_size);
+    expect_true(length < json_size);
+    expect_be(length, cstr_len(json));
+    expect_not_be(U64_MAX, cstr_index_of_str(json, "\"name\": \"RENDERER\", \"live_bytes\": 1024"));
+    expect_not_be(U64_MAX, cstr_index_of_str(json, "\"sites\": ["));
+    memory_free(json, json_size, MEMORY_TAG_STRING);
+
+    // A truncated export stays terminated
+    char small[16];
+    expect_true(memory_profiler_export_json(small, sizeof(small)) > sizeof(small));
+    expect_be(15, cstr_len(small));
+
+    length = memory_profiler_export_chrome_trace(nullptr, 0);
+    char* trace = memory_allocate(length + 1, MEMORY_TAG_STRING);
+    memory_profiler_export_chrome_trace(trace, length + 1);
+    expect_be(0, cstr_index_of_str(trace, "{\"traceEvents\": ["));
+    expect_not_be(U64_MAX, cstr_index_of_str(trace, "\"ph\": \"C\""));
+    expect_not_be(U64_MAX, cstr_index_of_str(trace, "\"RENDERER\": 1024"));
+    memory_free(trace, length + 1, MEMORY_TAG_STRING);
+
+    memory_free(block, KIBIBYTES(1), MEMORY_TAG_RENDERER);
+    memory_system_shutdown();
+    return true;
+}
+
+#else
+
+u8 memory_profiler_should_attribute_call_sites(void) {
+    // Compiled out, the queries report nothing
+    memory_profiler_snapshot snapshot;
+    expect_false(memory_profiler_get_snapshot(&snapshot));
+    return BYPASS;
+}
+
+u8 memory_profiler_should_export_json_and_trace(void) {
+    expect_be(0, memory_profiler_export_json(nullptr, 0));
+    return BYPASS;
+}
+
+#endif
+
+void memory_profiler_register_tests(void) {
+    test_manager_register_test(memory_profiler_should_attribute_call_sites, "Memory profiler attributes call sites");
+    test_manager_register_test(memory_profiler_should_export_json_and_trace, "Memory profiler exports JSON and Chrome traces");
+}
@@ -0,0 +1,280 @@
+#include "memory_tests.h"
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <defines.h>
+
+#include <memory/memory.h>
+#include <strings/string.h>
+#include <threads/thread.h>
+
+u8 memory_stats_track_tags_and_peaks(void) {
+    memory_system_config config = {0};
+    config.total_alloc_size = MEBIBYTES(64);
+    expect_true(memory_system_initialize(config));
+
+    memory_stats stats;
+    expect_true(memory_get_stats(&stats));
+    expect_be(0, stats.total_allocated);
+    expect_be(0, stats.allocation_count);
+
+    void* small = memory_allocate(100, MEMORY_TAG_STRING);
+    void* large = memory_allocate(MEBIBYTES(1), MEMORY_TAG_DARRAY);
+    memory_allocate_report(4096, MEMORY_TAG_VULKAN);
+
+    expect_true(memory_get_stats(&stats));
+    expect_be(100, stats.tags[MEMORY_TAG_STRING].allocated);
+    expect_be(1, stats.tags[MEMORY_TAG_STRING].allocation_count);
+    expect_be(MEBIBYTES(1), stats.tags[MEMORY_TAG_DARRAY].allocated);
+    expect_be(4096, stats.tags[MEMORY_TAG_VULKAN].allocated);
+    expect_be(100 + MEBIBYTES(1) + 4096, stats.total_allocated);
+    expect_be(3, stats.allocation_count);
+
+    // Frees lower the live values, but keep the peak and the total count
+    memory_free(large, MEBIBYTES(1), MEMORY_TAG_DARRAY);
+    memory_free(small, 100, MEMORY_TAG_STRING);
+    memory_free_report(4096, MEMORY_TAG_VULKAN);
+
+    expect_true(memory_get_stats(&stats));
+    expect_be(0, stats.total_allocated);
+    expect_be(0, stats.allocation_count);
+    expect_be(MEBIBYTES(1), stats.tags[MEMORY_TAG_DARRAY].peak_allocated);
+    expect_be(1, stats.tags[MEMORY_TAG_DARRAY].total_allocation_count);
+    expect_be(1, stats.tags[MEMORY_TAG_STRING].total_allocation_count);
+
+    memory_system_shutdown();
+    return true;
+}
+
+u8 memory_stats_record_peaks_within_a_batch(void) {
+    memory_system_config config = {0};
+    config.total_alloc_size = MEBIBYTES(64);
+    expect_true(memory_system_initialize(config));
+
+    // Well under the batch limits, so nothing is folded into the shared counters on the way up or down
+    void* blocks[8];
+    for (u32 i = 0; i < 8; ++i) {
+        blocks[i] = memory_allocate(KIBIBYTES(4), MEMORY_TAG_GAME);
+    }
+    for (u32 i = 0; i < 8; ++i) {
+        memory_free(blocks[i], KIBIBYTES(4), MEMORY_TAG_GAME);
+    }
+
+    memory_stats stats;
+    expect_true(memory_get_stats(&stats));
+    expect_be(0, stats.tags[MEMORY_TAG_GAME].allocated);
+    expect_be(KIBIBYTES(32), stats.tags[MEMORY_TAG_GAME].peak_allocated);
+
+    // A smaller spike afterwards leaves the peak alone
+    void* block = memory_allocate(KIBIBYTES(16), MEMORY_TAG_GAME);
+    memory_free(block, KIBIBYTES(16), MEMORY_TAG_GAME);
+    expect_true(memory_get_stats(&stats));
+    expect_be(KIBIBYTES(32), stats.tags[MEMORY_TAG_GAME].peak_allocated);
+
+    memory_system_shutdown();
+    return true;
+}
+
+u8 memory_zeroes_reused_blocks_only_when_asked(void) {
+    memory_system_config config = {0};
+    config.total_alloc_size = MEBIBYTES(64);
+    expect_true(memory_system_initialize(config));
+
+    // A block on fresh pages comes back zeroed either way
+    u64 size = MEBIBYTES(2);
+    u8* block = memory_allocate(size, MEMORY_TAG_GAME);
+    expect_be(0, block[0]);
+    expect_be(0, block[size - 1]);
+
+    // Dirty it, then make sure the heap zeroes it when it is handed out again
+    memory_set(block, 0xAB, size);
+    memory_free(block, size, MEMORY_TAG_GAME);
+    block = memory_allocate(size, MEMORY_TAG_GAME);
+    for (u64 i = 0; i < size; i += 4096) {
+        expect_be(0, block[i]);
+    }
+    expect_be(0, block[size - 1]);
+
+    // Uninitialized reallocation keeps the old contents
+    memory_set(block, 0xCD, size);
+    u8* grown = memory_reallocate_uninitialized(block, size, size * 2, MEMORY_TAG_GAME);
+    expect_not_be(0, grown);
+    expect_be(0xCD, grown[0]);
+    expect_be(0xCD, grown[size - 1]);
+
+    // Zeroing reallocation clears only the new tail
+    u8* regrown = memory_reallocate(grown, size * 2, size * 3, MEMORY_TAG_GAME);
+    expect_be(0xCD, regrown[size - 1]);
+    expect_be(0, regrown[size * 2]);
+    expect_be(0, regrown[size * 3 - 1]);
+    memory_free(regrown, size * 3, MEMORY_TAG_GAME);
+
+    memory_system_shutdown();
+    return true;
+}
+
+u8 memory_heap_falls_back_to_available_pages(void) {
+    // Whichever mode the machine supports, the heap must come up and work the same
+    for (u32 requested = MEMORY_PAGE_MODE_DEFAULT; requested <= MEMORY_PAGE_MODE_HUGE; ++requested) {
+        memory_system_config config = {0};
+        config.total_alloc_size = MEBIBYTES(64);
+        config.page_mode = requested;
+        expect_true(memory_system_initialize(config));
+        expect_true(memory_get_page_mode() <= requested);
+
+        u64 size = MEBIBYTES(3);
+        u8* block = memory_allocate(size, MEMORY_TAG_GAME);
+        expect_not_be(0, block);
+        expect_be(0, block[size - 1]);
+        memory_set(block, 0x5A, size);
+        u8* small = memory_allocate(64, MEMORY_TAG_GAME);
+        expect_not_be(0, small);
+
+        char* usage = memory_get_usage_str();
+        expect_not_be(U64_MAX, cstr_index_of_str(usage, "Heap pages: "));
+        cstr_free(usage);
+
+        memory_free(small, 64, MEMORY_TAG_GAME);
+        memory_free(block, size, MEMORY_TAG_GAME);
+        memory_system_shutdown();
+    }
+    return true;
+}
+
+#define CACHE_TEST_BLOCK_COUNT 200
+
+static u32 allocate_and_free_small_blocks(void* args) {
+    void* blocks[CACHE_TEST_BLOCK_COUNT];
+    for (u32 i = 0; i < CACHE_TEST_BLOCK_COUNT; ++i) {
+        blocks[i] = memory_allocate(16 << (i % 7), MEMORY_TAG_GAME);
+    }
+    for (u32 i = 0; i < CACHE_TEST_BLOCK_COUNT; ++i) {
+        memory_free(blocks[i], 16 << (i % 7), MEMORY_TAG_GAME);
+    }
+    return 0;
+}
+
+u8 memory_thread_cache_returns_on_thread_exit(void) {
+    memory_system_config config = {0};
+    config.total_alloc_size = MEBIBYTES(64);
+    expect_true(memory_system_initialize(config));
+
+    freelist_fragmentation before;
+    expect_true(memory_get_fragmentation(&before));
+
+    // The freed blocks sit in the worker's cache until the thread exits
+    thread worker;
+    expect_true(thread_create(allocate_and_free_small_blocks, nullptr, false, &worker));
+    expect_true(thread_wait(&worker));
+
+    freelist_fragmentation after;
+    expect_true(memory_get_fragmentation(&after));
+    expect_be(before.free_space, after.free_space);
+
+    memory_stats stats;
+    expect_true(memory_get_stats(&stats));
+    expect_be(0, stats.tags[MEMORY_TAG_GAME].allocated);
+    expect_be(CACHE_TEST_BLOCK_COUNT, stats.tags[MEMORY_TAG_GAME].total_allocation_count);
+
+    memory_system_shutdown();
+    return true;
+}
+
+#define CHURN_TEST_THREAD_COUNT 64
+
+u8 memory_stats_survive_thread_churn(void) {
+    memory_system_config config = {0};
+    config.total_alloc_size = MEBIBYTES(64);
+    expect_true(memory_system_initialize(config));
+
+    // Each thread hands its stats shard back on exit, and the counts it made stay in the totals
+    for (u32 i = 0; i < CHURN_TEST_THREAD_COUNT; ++i) {
+        thread worker;
+        expect_true(thread_create(allocate_and_free_small_blocks, nullptr, false, &worker));
+        expect_true(thread_wait(&worker));
+        thread_destroy(&worker);
+    }
+
+    memory_stats stats;
+    expect_true(memory_get_stats(&stats));
+    expect_be(0, stats.tags[MEMORY_TAG_GAME].allocated);
+    expect_be(0, stats.tags[MEMORY_TAG_GAME].allocation_count);
+    expect_be(CACHE_TEST_BLOCK_COUNT * CHURN_TEST_THREAD_COUNT, stats.tags[MEMORY_TAG_GAME].total_allocation_count);
+
+    // A thread that flushes and keeps going picks a shard up again without losing its counts
+    void* block = memory_allocate(64, MEMORY_TAG_GAME);
+    memory_thread_cache_flush();
+    memory_free(block, 64, MEMORY_TAG_GAME);
+    expect_true(memory_get_stats(&stats));
+    expect_be(0, stats.tags[MEMORY_TAG_GAME].allocated);
+    expect_be(CACHE_TEST_BLOCK_COUNT * CHURN_TEST_THREAD_COUNT + 1, stats.tags[MEMORY_TAG_GAME].total_allocation_count);
+
+    memory_system_shutdown();
+    return true;
+}
+
+#define OPERATION_TEST_BUFFER_SIZE KIBIBYTES(16)
+
+static u8 operation_src[OPERATION_TEST_BUFFER_SIZE];
+static u8 operation_dst[OPERATION_TEST_BUFFER_SIZE];
+
+// Copies, sets and zeroes a block, checking every byte of it and the guard bytes around it
+static b8 check_memory_operations(u64 offset, u64 size) {
+    memory_set(operation_dst, 0xEE, OPERATION_TEST_BUFFER_SIZE);
+    memory_copy(operation_dst + offset, operation_src + offset / 2, size);
+    for (u64 i = 0; i < OPERATION_TEST_BUFFER_SIZE; ++i) {
+        u8 expected = (i >= offset && i < offset + size) ? operation_src[offset / 2 + i - offset] : 0xEE;
+        if (operation_dst[i] != expected) {
+            return false;
+        }
+    }
+
+    memory_set(operation_dst + offset, 0x5A, size);
+    memory_zero(operation_dst + offset + size / 2, size - size / 2);
+    for (u64 i = 0; i < OPERATION_TEST_BUFFER_SIZE; ++i) {
+        u8 expected = 0xEE;
+        if (i >= offset && i < offset + size) {
+            expected = i < offset + size / 2 ? 0x5A : 0;
+        }
+        if (operation_dst[i] != expected) {
+            return false;
+        }
+    }
+    return true;
+}
+
+u8 memory_operations_handle_every_size_and_alignment(void) {
+    for (u64 i = 0; i < OPERATION_TEST_BUFFER_SIZE; ++i) {
+        operation_src[i] = (u8)(i * 31 + 7);
+    }
+
+    // Stream from the lowest threshold, so the vector kernels run on unaligned heads and tails too
+    u64 threshold = memory_get_streaming_threshold();
+    memory_set_streaming_threshold(0);
+    expect_be(KIBIBYTES(4), memory_get_streaming_threshold());
+    expect_not_be(0, memory_get_streaming_kernel_name());
+
+    u64 sizes[] = {0, 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 32, 33, 64, 1000, KIBIBYTES(4) - 1, KIBIBYTES(4), KIBIBYTES(4) + 129, KIBIBYTES(12) + 3};
+    u64 offsets[] = {0, 1, 13, 32, 63};
+    b8 all_match = true;
+    for (u32 s = 0; s < sizeof(sizes) / sizeof(u64); ++s) {
+        for (u32 o = 0; o < sizeof(offsets) / sizeof(u64); ++o) {
+            all_match = all_match && check_memory_operations(offsets[o], sizes[s]);
+        }
+    }
+
+    memory_set_streaming_threshold(threshold);
+    expect_true(all_match);
+    expect_be(threshold, memory_get_streaming_threshold());
+    return true;
+}
+
+void memory_register_tests(void) {
+    test_manager_register_test(memory_stats_track_tags_and_peaks, "Memory stats track tags and peaks");
+    test_manager_register_test(memory_stats_record_peaks_within_a_batch, "Memory stats record peaks that drain within a batch");
+    test_manager_register_test(memory_zeroes_reused_blocks_only_when_asked, "Memory zeroes reused blocks only when asked");
+    test_manager_register_test(memory_heap_falls_back_to_available_pages, "Memory heap falls back to available page sizes");
+    test_manager_register_test(memory_operations_handle_every_size_and_alignment, "Memory copy, set and zero handle every size and alignment");
+    test_manager_register_test(memory_thread_cache_returns_on_thread_exit, "Memory thread caches return to the heap on thread exit");
+    test_manager_register_test(memory_stats_survive_thread_churn, "Memory stats survive thread churn");
+}
@@ -0,0 +1,212 @@
+#include "pool_allocator_tests.h"
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <defines.h>
+
+#include <containers/u64_bst.h>
+#include <memory/allocators/pool_allocator.h>
+#include <memory/memory.h>
+#include <threads/atomic.h>
+#include <threads/thread.h>
+
+u8 pool_allocator_should_create_and_destroy(void) {
+    pool_allocator pool;
+    expect_true(pool_allocator_create(24, 8, 16, POOL_ALLOCATOR_FLAG_NONE_BIT, &pool));
+    expect_be(24, pool.object_size);
+    expect_be(0, pool.chunk_count);
+
+    pool_allocator_destroy(&pool);
+    expect_be(0, pool.object_size);
+    expect_be(0, pool.chunks);
+    return true;
+}
+
+u8 pool_allocator_should_grow_and_reuse_objects(void) {
+    pool_allocator pool;
+    const u64 objects_per_chunk = 8;
+    expect_true(pool_allocator_create(20, 16, objects_per_chunk, POOL_ALLOCATOR_FLAG_NONE_BIT, &pool));
+    // Sizes are rounded up to the alignment.
+    expect_be(32, pool.object_size);
+
+    // Allocate past a single chunk.
+    void* objects[20] = {0};
+    for (u32 i = 0; i < 20; ++i) {
+        objects[i] = pool_allocator_allocate(&pool);
+        expect_not_be(0, objects[i]);
+        expect_be(0, (u64)objects[i] % 16);
+        memory_set(objects[i], (i32)i, pool.object_size);
+    }
+    expect_be(3, pool.chunk_count);
+    expect_be(20, pool_allocator_allocated_count(&pool));
+
+    // Objects must not overlap.
+    for (u32 i = 0; i < 20; ++i) {
+        expect_be(i, ((u8*)objects[i])[pool.object_size - 1]);
+    }
+
+    // The most recently freed object is handed out first.
+    pool_allocator_free(&pool, objects[5]);
+    expect_be(19, pool_allocator_allocated_count(&pool));
+    void* reused = pool_allocator_allocate(&pool);
+    expect_true(reused == objects[5]);
+
+    // Freeing everything keeps the chunks around.
+    pool_allocator_free_all(&pool);
+    expect_be(0, pool_allocator_allocated_count(&pool));
+    for (u32 i = 0; i < 20; ++i) {
+        expect_not_be(0, pool_allocator_allocate(&pool));
+    }
+    expect_be(3, pool.chunk_count);
+
+    pool_allocator_destroy(&pool);
+    return true;
+}
+
+u8 pool_allocator_should_back_bst_nodes(void) {
+    pool_allocator pool;
+    expect_true(pool_allocator_create(sizeof(bst_node), 8, 64, POOL_ALLOCATOR_FLAG_NONE_BIT, &pool));
+    frame_allocator_int allocator;
+    pool_allocator_get_interface(&pool, &allocator);
+
+    bst_node* root = nullptr;
+    for (u64 i = 0; i < 100; ++i) {
+        bst_node_value value;
+        value.u64 = i * 10;
+        root = u64_bst_insert_with_allocator(root, (i * 37) % 101, value, &allocator);
+    }
+    expect_be(100, pool_allocator_allocated_count(&pool));
+
+    const bst_node* node = u64_bst_find(root, (42 * 37) % 101);
+    expect_not_be(0, node);
+    expect_be(420, node->value.u64);
+
+    root = u64_bst_delete_with_allocator(root, (42 * 37) % 101, &allocator);
+    expect_be(99, pool_allocator_allocated_count(&pool));
+    expect_true(u64_bst_find(root, (42 * 37) % 101) == 0);
+
+    // Larger requests than the object size are refused.
+    expect_true(allocator.allocate(allocator.context, sizeof(bst_node) + 1) == 0);
+
+    u64_bst_clear_with_allocator(root, &allocator);
+    expect_be(0, pool_allocator_allocated_count(&pool));
+
+    pool_allocator_destroy(&pool);
+    return true;
+}
+
+typedef struct limited_interface {
+    frame_allocator_int* pool;
+    u32 remaining;
+} limited_interface;
+
+// Forwards to the pool until the limit runs out, then refuses like a pool asked for too much
+static void* limited_allocate(void* context, u64 size) {
+    limited_interface* limited = context;
+    if (!limited->remaining) {
+        return nullptr;
+    }
+    limited->remaining--;
+    return limited->pool->allocate(limited->pool->context, size);
+}
+
+static void limited_free(void* context, void* block, u64 size) {
+    limited_interface* limited = context;
+    limited->pool->free(limited->pool->context, block, size);
+}
+
+u8 pool_allocator_refusals_should_fail_bst_inserts(void) {
+    pool_allocator pool;
+    expect_true(pool_allocator_create(sizeof(bst_node), 8, 64, POOL_ALLOCATOR_FLAG_NONE_BIT, &pool));
+    frame_allocator_int pool_interface;
+    pool_allocator_get_interface(&pool, &pool_interface);
+    limited_interface limited = { &pool_interface, 10 };
+    frame_allocator_int allocator = { limited_allocate, limited_free, nullptr, &limited };
+
+    bst_node* root = nullptr;
+    for (u64 i = 0; i < 10; ++i) {
+        bst_node_value value;
+        value.u64 = i;
+        root = u64_bst_insert_with_allocator(root, (i * 7) % 11, value, &allocator);
+        expect_not_be(0, root);
+    }
+
+    // The refused insert reports the failure and leaves the tree as it was
+    MDEBUG("The following error message is intentional.");
+    bst_node_value value;
+    value.u64 = 100;
+    expect_true(u64_bst_insert_with_allocator(root, 100, value, &allocator) == 0);
+    expect_true(u64_bst_find(root, 100) == 0);
+    expect_be(10, pool_allocator_allocated_count(&pool));
+    for (u64 i = 0; i < 10; ++i) {
+        const bst_node* node = u64_bst_find(root, (i * 7) % 11);
+        expect_not_be(0, node);
+        expect_be(i, node->value.u64);
+    }
+
+    // An empty tree stays empty
+    MDEBUG("The following error message is intentional.");
+    expect_true(u64_bst_insert_with_allocator(nullptr, 1, value, &allocator) == 0);
+
+    u64_bst_clear_with_allocator(root, &allocator);
+    expect_be(0, pool_allocator_allocated_count(&pool));
+    pool_allocator_destroy(&pool);
+    return true;
+}
+
+#define POOL_TEST_THREADS 4
+#define POOL_TEST_ITERATIONS 20000
+
+typedef struct pool_thread_test {
+    pool_allocator pool;
+    volatile u32 corrupted;
+} pool_thread_test;
+
+static u32 pool_thread_work(void* args) {
+    pool_thread_test* test = args;
+    pool_allocator* pool = &test->pool;
+    void* held[16] = {0};
+    for (u32 i = 0; i < POOL_TEST_ITERATIONS; ++i) {
+        u32 slot = i % 16;
+        if (held[slot]) {
+            // Catch another thread writing over an object this thread holds.
+            if (*(u64*)held[slot] != (u64)held[slot]) {
+                atomic_u32_fetch_add(&test->corrupted, 1);
+            }
+            pool_allocator_free(pool, held[slot]);
+        }
+        held[slot] = pool_allocator_allocate(pool);
+        *(u64*)held[slot] = (u64)held[slot];
+    }
+    for (u32 i = 0; i < 16; ++i) {
+        pool_allocator_free(pool, held[i]);
+    }
+    return 0;
+}
+
+u8 pool_allocator_thread_caches_should_be_thread_safe(void) {
+    pool_thread_test test = {0};
+    expect_true(pool_allocator_create(sizeof(u64) * 4, 8, 128, POOL_ALLOCATOR_FLAG_THREAD_CACHE_BIT, &test.pool));
+
+    thread threads[POOL_TEST_THREADS];
+    for (u32 i = 0; i < POOL_TEST_THREADS; ++i) {
+        expect_true(thread_create(pool_thread_work, &test, false, &threads[i]));
+    }
+    for (u32 i = 0; i < POOL_TEST_THREADS; ++i) {
+        thread_wait(&threads[i]);
+        thread_destroy(&threads[i]);
+    }
+    expect_be(0, test.corrupted);
+    expect_be(0, pool_allocator_allocated_count(&test.pool));
+
+    pool_allocator_destroy(&test.pool);
+    return true;
+}
+
+void pool_allocator_register_tests(void) {
+    test_manager_register_test(pool_allocator_should_create_and_destroy, "Pool allocator should create and destroy");
+    test_manager_register_test(pool_allocator_should_grow_and_reuse_objects, "Pool allocator should grow and reuse objects");
+    test_manager_register_test(pool_allocator_should_back_bst_nodes, "Pool allocator should back BST nodes");
+    test_manager_register_test(pool_allocator_refusals_should_fail_bst_inserts, "Pool allocator refusals should fail BST inserts without changing the tree");
+    test_manager_register_test(pool_allocator_thread_caches_should_be_thread_safe, "Pool allocator thread caches should be thread safe");
+}
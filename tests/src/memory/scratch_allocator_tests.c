@@ -0,0 +1,126 @@
+#include "scratch_allocator_tests.h"
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <defines.h>
+
+#include <containers/darray.h>
+#include <memory/allocators/scratch_allocator.h>
+#include <memory/memory.h>
+#include <strings/string.h>
+#include <threads/thread.h>
+
+u8 scratch_should_roll_back_nested_scopes(void) {
+    u64 start = 0;
+    u64 capacity = 0;
+    scratch_arena outer = scratch_begin();
+    expect_not_be(0, outer.allocator);
+    scratch_get_usage(&start, &capacity);
+    expect_true(capacity > 0);
+
+    u8* a = scratch_allocate(&outer, 100);
+    expect_not_be(0, a);
+    // Blocks are rounded up to keep every allocation aligned
+    expect_be(0, (u64)a % SCRATCH_ARENA_ALIGNMENT);
+
+    u64 used = 0;
+    scratch_get_usage(&used, 0);
+    expect_be(start + 112, used);
+
+    scratch_arena inner = scratch_begin();
+    u8* b = scratch_allocate(&inner, 1000);
+    expect_not_be(0, b);
+    expect_be(0, (u64)b % SCRATCH_ARENA_ALIGNMENT);
+    expect_true(b >= a + 112);
+    scratch_end(inner);
+
+    scratch_get_usage(&used, 0);
+    expect_be(start + 112, used);
+
+    // The inner scope's memory is handed out again
+    scratch_arena again = scratch_begin();
+    expect_be(b, scratch_allocate(&again, 16));
+    scratch_end(again);
+
+    scratch_end(outer);
+    scratch_get_usage(&used, 0);
+    expect_be(start, used);
+
+    return true;
+}
+
+u8 scratch_should_return_null_when_full(void) {
+    u64 capacity = 0;
+    scratch_arena scratch = scratch_begin();
+    scratch_get_usage(0, &capacity);
+
+    expect_be(0, scratch_allocate(&scratch, capacity + 1));
+
+    // A failed allocation leaves the scope usable
+    void* block = scratch_allocate(&scratch, 64);
+    expect_not_be(0, block);
+
+    scratch_end(scratch);
+    return true;
+}
+
+u8 scratch_should_back_string_helpers(void) {
+    u64 start = 0;
+    scratch_get_usage(&start, 0);
+
+    scratch_arena scratch = scratch_begin();
+    char* formatted = cstr_format_with_allocator(scratch.allocator, "%s-%d", "frame", 42);
+    expect_not_be(0, formatted);
+    expect_true(cstr_equal("frame-42", formatted));
+
+    char** entries = darray_create_with_allocator(char*, scratch.allocator);
+    u64 count = cstr_split_with_allocator(" a , bb ,,ccc", ',', &entries, true, false, scratch.allocator);
+    expect_be(3, count);
+    expect_be(3, darray_length(entries));
+    expect_true(cstr_equal("a", entries[0]));
+    expect_true(cstr_equal("bb", entries[1]));
+    expect_true(cstr_equal("ccc", entries[2]));
+
+    // Everything, including the darray, goes away with the scope
+    scratch_end(scratch);
+
+    u64 used = 0;
+    scratch_get_usage(&used, 0);
+    expect_be(start, used);
+
+    return true;
+}
+
+static u32 scratch_thread_work(void* args) {
+    u8** out_block = args;
+    scratch_arena scratch = scratch_begin();
+    *out_block = scratch_allocate(&scratch, 32);
+    scratch_end(scratch);
+    scratch_thread_release();
+    return 0;
+}
+
+u8 scratch_should_be_separate_per_thread(void) {
+    scratch_arena scratch = scratch_begin();
+    u8* block = scratch_allocate(&scratch, 32);
+    expect_not_be(0, block);
+
+    u8* thread_block = nullptr;
+    thread t;
+    expect_true(thread_create(scratch_thread_work, &thread_block, false, &t));
+    thread_wait(&t);
+    thread_destroy(&t);
+
+    expect_not_be(0, thread_block);
+    expect_not_be(block, thread_block);
+
+    scratch_end(scratch);
+    return true;
+}
+
+void scratch_allocator_register_tests(void) {
+    test_manager_register_test(scratch_should_roll_back_nested_scopes, "Scratch rolls back nested scopes");
+    test_manager_register_test(scratch_should_return_null_when_full, "Scratch returns nullptr when full");
+    test_manager_register_test(scratch_should_back_string_helpers, "Scratch backs string helpers");
+    test_manager_register_test(scratch_should_be_separate_per_thread, "Scratch is separate per thread");
+}
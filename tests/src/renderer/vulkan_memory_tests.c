@@ -0,0 +1,263 @@
+#include "vulkan_memory_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+#include <containers/darray.h>
+#include <core/logger.h>
+#include <memory/memory.h>
+#include <renderer/vulkan/vulkan_image.h>
+#include <renderer/vulkan/vulkan_memory.h>
+#include <renderer/vulkan/vulkan_types.h>
+
+// Small, so a few requests fill a block
+#define TEST_BLOCK_SIZE MEBIBYTES(1)
+
+static vulkan_context context;
+
+static i32 test_find_memory_index(u32 type_filter, u32 property_flags) {
+    for (u32 i = 0; i < context.device.memory.memoryTypeCount; ++i) {
+        if (type_filter & (1 << i) && (context.device.memory.memoryTypes[i].propertyFlags & property_flags) == property_flags) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Creates a headless device on a CPU implementation such as lavapipe or SwiftShader. False when none is installed
+static b8 test_device_create(void) {
+    memory_zero(&context, sizeof(vulkan_context));
+    context.find_memory_index = test_find_memory_index;
+
+    VkApplicationInfo app_info = { VK_STRUCTURE_TYPE_APPLICATION_INFO };
+    app_info.pApplicationName = "Vulkan memory tests";
+    app_info.apiVersion = VK_MAKE_API_VERSION(0, 1, 0, 0);
+    VkInstanceCreateInfo instance_info = { VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO };
+    instance_info.pApplicationInfo = &app_info;
+    if (vkCreateInstance(&instance_info, nullptr, &context.instance) != VK_SUCCESS) {
+        MWARN("No Vulkan implementation found, skipping.");
+        return false;
+    }
+
+    VkPhysicalDevice devices[8];
+    u32 device_count = 8;
+    vkEnumeratePhysicalDevices(context.instance, &device_count, devices);
+    for (u32 i = 0; i < device_count && !context.device.physical; ++i) {
+        vkGetPhysicalDeviceProperties(devices[i], &context.device.properties);
+        if (context.device.properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_CPU) {
+            context.device.physical = devices[i];
+        }
+    }
+    if (!context.device.physical) {
+        MWARN("No CPU Vulkan device found, skipping.");
+        vkDestroyInstance(context.instance, nullptr);
+        return false;
+    }
+    vkGetPhysicalDeviceMemoryProperties(context.device.physical, &context.device.memory);
+
+    f32 priority = 1.0f;
+    VkDeviceQueueCreateInfo queue_info = { VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO };
+    queue_info.queueFamilyIndex = 0;
+    queue_info.queueCount = 1;
+    queue_info.pQueuePriorities = &priority;
+    VkDeviceCreateInfo device_info = { VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO };
+    device_info.queueCreateInfoCount = 1;
+    device_info.pQueueCreateInfos = &queue_info;
+    if (vkCreateDevice(context.device.physical, &device_info, nullptr, &context.device.logical) != VK_SUCCESS) {
+        MWARN("Failed to create a device on %s, skipping.", context.device.properties.deviceName);
+        vkDestroyInstance(context.instance, nullptr);
+        return false;
+    }
+    return true;
+}
+
+static void test_device_destroy(void) {
+    vulkan_memory_allocator_destroy(&context);
+    vkDestroyDevice(context.device.logical, nullptr);
+    vkDestroyInstance(context.instance, nullptr);
+    memory_zero(&context, sizeof(vulkan_context));
+}
+
+static u64 pool_block_count(vulkan_resource_kind kind) {
+    i32 memory_type = test_find_memory_index(~0u, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    return darray_length(context.memory_allocator.blocks[memory_type][kind]);
+}
+
+static b8 allocate(u64 size, u64 alignment, vulkan_resource_kind kind, vulkan_memory_allocation* out_allocation) {
+    VkMemoryRequirements requirements = { size, alignment, ~0u };
+    return vulkan_memory_allocate(&context, &requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, kind, out_allocation);
+}
+
+u8 vulkan_memory_should_allocate_and_free_ranges(void) {
+    if (!test_device_create()) {
+        return BYPASS;
+    }
+    expect_true(vulkan_memory_allocator_create(&context, TEST_BLOCK_SIZE));
+
+    // Sizes are rounded up to whole units, and the ranges share one block
+    vulkan_memory_allocation allocations[3];
+    for (u32 i = 0; i < 3; ++i) {
+        expect_true(allocate(1000, 4, VULKAN_RESOURCE_KIND_LINEAR, &allocations[i]));
+        expect_be(1024, allocations[i].size);
+        expect_be(0, allocations[i].offset % VULKAN_MEMORY_ALLOCATION_UNIT);
+        expect_true(allocations[i].memory == allocations[0].memory);
+    }
+    expect_true((allocations[0].offset + allocations[0].size <= allocations[1].offset || allocations[1].offset + allocations[1].size <= allocations[0].offset));
+    expect_true((allocations[1].offset + allocations[1].size <= allocations[2].offset || allocations[2].offset + allocations[2].size <= allocations[1].offset));
+    expect_be(1, pool_block_count(VULKAN_RESOURCE_KIND_LINEAR));
+
+    // A freed range is handed out again
+    u64 freed_offset = allocations[1].offset;
+    vulkan_memory_free(&context, &allocations[1]);
+    expect_true(allocations[1].block == nullptr);
+    expect_true(allocate(1000, 4, VULKAN_RESOURCE_KIND_LINEAR, &allocations[1]));
+    expect_be(freed_offset, allocations[1].offset);
+
+    // The ranges are real device memory a buffer can be bound to
+    VkBufferCreateInfo buffer_info = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+    buffer_info.size = 1000;
+    buffer_info.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+    buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    VkBuffer buffer;
+    expect_be(VK_SUCCESS, vkCreateBuffer(context.device.logical, &buffer_info, nullptr, &buffer));
+    VkMemoryRequirements requirements;
+    vkGetBufferMemoryRequirements(context.device.logical, buffer, &requirements);
+    vulkan_memory_allocation buffer_allocation;
+    expect_true(vulkan_memory_allocate(&context, &requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VULKAN_RESOURCE_KIND_LINEAR, &buffer_allocation));
+    expect_true(vulkan_memory_bind_buffer(&context, buffer, &buffer_allocation));
+    vkDestroyBuffer(context.device.logical, buffer, nullptr);
+    vulkan_memory_free(&context, &buffer_allocation);
+
+    for (u32 i = 0; i < 3; ++i) {
+        vulkan_memory_free(&context, &allocations[i]);
+    }
+    // The first block of a pool stays around once empty
+    expect_be(1, pool_block_count(VULKAN_RESOURCE_KIND_LINEAR));
+
+    test_device_destroy();
+    return true;
+}
+
+u8 vulkan_memory_should_align_ranges(void) {
+    if (!test_device_create()) {
+        return BYPASS;
+    }
+    expect_true(vulkan_memory_allocator_create(&context, TEST_BLOCK_SIZE));
+
+    vulkan_memory_allocation first;
+    expect_true(allocate(256, 4, VULKAN_RESOURCE_KIND_LINEAR, &first));
+    expect_be(0, first.offset);
+
+    // Alignments above a unit skip ahead to the next aligned offset
+    vulkan_memory_allocation aligned;
+    expect_true(allocate(1000, KIBIBYTES(64), VULKAN_RESOURCE_KIND_LINEAR, &aligned));
+    expect_be(KIBIBYTES(64), aligned.offset);
+    expect_true(aligned.memory == first.memory);
+
+    // The gap the alignment skipped still takes requests that fit it
+    vulkan_memory_allocation gap;
+    expect_true(allocate(KIBIBYTES(32), 16, VULKAN_RESOURCE_KIND_LINEAR, &gap));
+    expect_true((gap.offset >= first.size && gap.offset + gap.size <= aligned.offset));
+
+    // A range as large as its alignment takes the aligned upper half of the block
+    vulkan_memory_allocation whole;
+    expect_true(allocate(KIBIBYTES(512), KIBIBYTES(512), VULKAN_RESOURCE_KIND_LINEAR, &whole));
+    expect_be(KIBIBYTES(512), whole.offset);
+
+    vulkan_memory_free(&context, &whole);
+    vulkan_memory_free(&context, &gap);
+    vulkan_memory_free(&context, &aligned);
+    vulkan_memory_free(&context, &first);
+
+    test_device_destroy();
+    return true;
+}
+
+u8 vulkan_memory_should_release_empty_blocks(void) {
+    if (!test_device_create()) {
+        return BYPASS;
+    }
+    expect_true(vulkan_memory_allocator_create(&context, TEST_BLOCK_SIZE));
+
+    // Four quarters fill the first block, the fifth opens a second one
+    vulkan_memory_allocation quarters[5];
+    for (u32 i = 0; i < 5; ++i) {
+        expect_true(allocate(TEST_BLOCK_SIZE / 4, 4, VULKAN_RESOURCE_KIND_LINEAR, &quarters[i]));
+    }
+    expect_be(2, pool_block_count(VULKAN_RESOURCE_KIND_LINEAR));
+    expect_true(quarters[4].memory != quarters[0].memory);
+
+    // The second block goes back to the driver as soon as it is empty
+    vulkan_memory_free(&context, &quarters[4]);
+    expect_be(1, pool_block_count(VULKAN_RESOURCE_KIND_LINEAR));
+
+    // Requests larger than a block get a dedicated block of their own size, released the same way
+    vulkan_memory_allocation oversized;
+    expect_true(allocate(TEST_BLOCK_SIZE * 3, 4, VULKAN_RESOURCE_KIND_LINEAR, &oversized));
+    expect_be(TEST_BLOCK_SIZE * 3, oversized.size);
+    expect_be(0, oversized.offset);
+    expect_true(oversized.memory != quarters[0].memory);
+    expect_be(2, pool_block_count(VULKAN_RESOURCE_KIND_LINEAR));
+    vulkan_memory_free(&context, &oversized);
+    expect_be(1, pool_block_count(VULKAN_RESOURCE_KIND_LINEAR));
+
+    for (u32 i = 0; i < 4; ++i) {
+        vulkan_memory_free(&context, &quarters[i]);
+    }
+    expect_be(1, pool_block_count(VULKAN_RESOURCE_KIND_LINEAR));
+
+    test_device_destroy();
+    return true;
+}
+
+u8 vulkan_memory_should_pool_by_resource_kind(void) {
+    if (!test_device_create()) {
+        return BYPASS;
+    }
+
+    // Granularity pages no larger than a unit let buffers and optimal images share blocks
+    context.device.properties.limits.bufferImageGranularity = VULKAN_MEMORY_ALLOCATION_UNIT;
+    expect_true(vulkan_memory_allocator_create(&context, TEST_BLOCK_SIZE));
+    vulkan_memory_allocation linear;
+    vulkan_memory_allocation optimal;
+    expect_true(allocate(1000, 4, VULKAN_RESOURCE_KIND_LINEAR, &linear));
+    expect_true(allocate(1000, 4, VULKAN_RESOURCE_KIND_OPTIMAL, &optimal));
+    expect_true(linear.memory == optimal.memory);
+    expect_be(0, pool_block_count(VULKAN_RESOURCE_KIND_OPTIMAL));
+    vulkan_memory_free(&context, &optimal);
+    vulkan_memory_free(&context, &linear);
+    vulkan_memory_allocator_destroy(&context);
+
+    // Larger pages split them, whatever the device reports. Raising the granularity is always safe
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(context.device.physical, &properties);
+    context.device.properties.limits.bufferImageGranularity = MMAX(properties.limits.bufferImageGranularity, (u64)KIBIBYTES(4));
+    expect_true(vulkan_memory_allocator_create(&context, TEST_BLOCK_SIZE));
+    expect_true(allocate(1000, 4, VULKAN_RESOURCE_KIND_LINEAR, &linear));
+
+    // An optimally tiled image created through the renderer lands in a pool of its own
+    vulkan_image image;
+    vulkan_image_create(
+        &context, 64, 64, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true, VK_IMAGE_ASPECT_COLOR_BIT, 1, &image);
+    expect_true(image.memory.block != nullptr);
+    expect_true(image.view != nullptr);
+    expect_true(image.memory.memory != linear.memory);
+    expect_be(0, image.memory.offset % image.memory_requirements.alignment);
+    expect_be(1, pool_block_count(VULKAN_RESOURCE_KIND_LINEAR));
+    expect_be(1, pool_block_count(VULKAN_RESOURCE_KIND_OPTIMAL));
+
+    vulkan_image_destroy(&context, &image);
+    expect_true(image.memory.block == nullptr);
+    vulkan_memory_free(&context, &linear);
+
+    test_device_destroy();
+    return true;
+}
+
+void vulkan_memory_register_tests(void) {
+    test_manager_register_test(vulkan_memory_should_allocate_and_free_ranges, "Vulkan memory should allocate and free ranges of a block");
+    test_manager_register_test(vulkan_memory_should_align_ranges, "Vulkan memory should align ranges");
+    test_manager_register_test(vulkan_memory_should_release_empty_blocks, "Vulkan memory should release empty blocks");
+    test_manager_register_test(vulkan_memory_should_pool_by_resource_kind, "Vulkan memory should pool by resource kind above the unit granularity");
+}
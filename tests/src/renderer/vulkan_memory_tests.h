@@ -0,0 +1,3 @@
+#pragma once
+
+void vulkan_memory_register_tests(void);
\ No newline at end of file
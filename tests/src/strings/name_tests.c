@@ -0,0 +1,70 @@
+#include "name_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+#include <containers/hashtable.h>
+#include <core/hash.h>
+#include <strings/name.h>
+#include <strings/string.h>
+
+static u8 name_should_intern_once(void) {
+    expect_true(name_system_initialize());
+
+    // A copy on the stack, so equal handles come from equal contents and not equal pointers
+    char buffer[] = "VK_KHR_swapchain";
+    name swapchain = name_intern("VK_KHR_swapchain");
+    name dynamic_rendering = name_intern("VK_KHR_dynamic_rendering");
+    expect_not_be(INVALID_NAME, swapchain);
+    expect_not_be(swapchain, dynamic_rendering);
+    expect_be(swapchain, name_intern(buffer));
+    expect_be(swapchain, name_find(buffer));
+    expect_be(INVALID_NAME, name_find("VK_KHR_portability_subset"));
+
+    expect_true(cstr_equal("VK_KHR_swapchain", name_string(swapchain)));
+    expect_be(16, name_length(swapchain));
+    expect_be(hash_string("VK_KHR_swapchain"), name_hash(swapchain));
+    expect_be(0, name_string(INVALID_NAME));
+
+    // The empty string is a name like any other
+    name empty = name_intern("");
+    expect_not_be(INVALID_NAME, empty);
+    expect_be(empty, name_find(""));
+
+    name_system_shutdown();
+    return true;
+}
+
+static u8 name_should_key_prehashed_lookups(void) {
+    expect_true(name_system_initialize());
+
+    hashtable table;
+    hashtable_create(sizeof(u64), 8, false, &table);
+
+    name texture = name_intern("textures/stone.png");
+    hashtable_key key = name_key(texture);
+    u64 value = 42;
+    expect_true(hashtable_set_prehashed(&table, &key, &value));
+
+    // Prehashed and plain string lookups find the same entry
+    u64 out_value = 0;
+    expect_true(hashtable_get(&table, "textures/stone.png", &out_value));
+    expect_be(42, out_value);
+    hashtable_key from_str = hashtable_key_from_str("textures/stone.png");
+    expect_be(key.hash, from_str.hash);
+    out_value = 0;
+    expect_true(hashtable_get_prehashed(&table, &from_str, &out_value));
+    expect_be(42, out_value);
+
+    expect_true(hashtable_remove_prehashed(&table, &key));
+    expect_false(hashtable_get(&table, "textures/stone.png", &out_value));
+
+    hashtable_destroy(&table);
+    name_system_shutdown();
+    return true;
+}
+
+void name_register_tests(void) {
+    test_manager_register_test(name_should_intern_once, "Names should intern equal strings to one handle");
+    test_manager_register_test(name_should_key_prehashed_lookups, "Names should key prehashed hashtable lookups");
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void name_register_tests(void);
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include <containers/darray.h>
 #include <core/logger.h>
+#include <memory/allocators/scratch_allocator.h>
 #include <strings/string.h>
 #include <time/clock.h>
 
@@ -53,8 +54,8 @@ void test_manager_run_tests(void) {
             ++failed;
         }
 
-        // TODO: allocation every time ...
-        char* status = cstr_format(failed ? "*** %d FAILED ***": "SUCCESS", failed);
+        scratch_arena scratch = scratch_begin();
+        char* status = cstr_format_with_allocator(scratch.allocator, failed ? "*** %d FAILED ***": "SUCCESS", failed);
         clock_update(&total_time);
         MINFO("Executed %d of %d (skipped %d) %s (%.6f sec / %.6f sec total)",
             i + 1,
@@ -63,7 +64,11 @@ void test_manager_run_tests(void) {
             status,
             test_time.elapsed,
             total_time.elapsed);
-        cstr_free(status);
+        if (!scratch.allocator) {
+            // Without a scratch arena the string came from the heap
+            cstr_free(status);
+        }
+        scratch_end(scratch);
     }
 
     clock_stop(&total_time);
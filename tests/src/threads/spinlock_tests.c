@@ -0,0 +1,85 @@
+#include "spinlock_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+#include <platform/platform.h>
+#include <threads/atomic.h>
+#include <threads/spinlock.h>
+#include <threads/thread.h>
+
+#define CONTENTION_THREADS 4
+#define CONTENTION_ITERATIONS 20000
+
+typedef struct contention_state {
+    spinlock lock;
+    volatile u32 start;
+    // Threads inside the critical section, only ever 0 or 1 while the lock works
+    volatile u32 holders;
+    u32 overlaps;
+    // Plain read-modify-write, so increments get lost if two threads are ever inside together
+    u64 counter;
+} contention_state;
+
+static contention_state contention;
+
+u8 spinlock_try_lock_should_fail_while_held(void) {
+    spinlock lock = {0};
+    expect_true(spinlock_try_lock(&lock));
+    expect_false(spinlock_try_lock(&lock));
+    spinlock_unlock(&lock);
+    expect_true(spinlock_try_lock(&lock));
+    spinlock_unlock(&lock);
+
+    spinlock_lock(&lock);
+    expect_false(spinlock_try_lock(&lock));
+    spinlock_unlock(&lock);
+    expect_be(0, lock.locked);
+    return true;
+}
+
+static u32 contention_thread(void* args) {
+    while (!atomic_u32_load(&contention.start)) {
+        atomic_spin_pause();
+    }
+
+    for (u32 i = 0; i < CONTENTION_ITERATIONS; ++i) {
+        spinlock_lock(&contention.lock);
+        if (atomic_u32_fetch_add(&contention.holders, 1) != 0) {
+            contention.overlaps++;
+        }
+        u64 value = contention.counter;
+        // Gives up the time slice while holding the lock now and then, so the other threads
+        // run into a held lock even on a single core
+        if ((i & 63) == 0) {
+            platform_sleep(0);
+        }
+        contention.counter = value + 1;
+        atomic_u32_fetch_sub(&contention.holders, 1);
+        spinlock_unlock(&contention.lock);
+    }
+    return 0;
+}
+
+u8 spinlock_should_exclude_other_threads(void) {
+    contention = (contention_state){0};
+    thread threads[CONTENTION_THREADS];
+    for (u32 i = 0; i < CONTENTION_THREADS; ++i) {
+        expect_true(thread_create(contention_thread, nullptr, false, &threads[i]));
+    }
+    atomic_u32_store(&contention.start, 1);
+    for (u32 i = 0; i < CONTENTION_THREADS; ++i) {
+        thread_wait(&threads[i]);
+        thread_destroy(&threads[i]);
+    }
+
+    expect_be(0, contention.overlaps);
+    expect_be((u64)CONTENTION_THREADS * CONTENTION_ITERATIONS, contention.counter);
+    expect_be(0, contention.lock.locked);
+    return true;
+}
+
+void spinlock_register_tests(void) {
+    test_manager_register_test(spinlock_try_lock_should_fail_while_held, "Spinlock try_lock should fail while held");
+    test_manager_register_test(spinlock_should_exclude_other_threads, "Spinlock should exclude other threads");
+}
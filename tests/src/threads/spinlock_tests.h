@@ -0,0 +1,3 @@
+#pragma once
+
+void spinlock_register_tests(void);